@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2016 by the OpenOCD project
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Offline decoder for OpenOCD's binary trace ring (the 'trace_ring'
+ * command).  Reads the ring file, orders the records by sequence number
+ * and pretty-prints them, oldest first.  With -c the output is Chrome
+ * trace-event JSON instead: load it at chrome://tracing (or in Perfetto)
+ * to see queue flushes and other profiled scopes as duration bars with
+ * the gaps between them plainly visible.
+ *
+ * Build with:  gcc -Wall -o tracedump tracedump.c
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* file layout; must stay in sync with src/helper/binarytrace.h */
+#define TRACE_RING_MAGIC	0x4352544f	/* "OTRC" */
+#define TRACE_RING_VERSION	1
+
+struct trace_ring_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t record_size;
+	uint32_t capacity;	/* number of record slots */
+};
+
+struct trace_ring_record {
+	uint64_t timestamp_us;
+	uint64_t seq;		/* 0 marks a never-written slot */
+	uint32_t arg[2];
+	uint16_t subsys;
+	uint16_t event;
+	uint32_t reserved;
+};
+
+static const char *subsys_names[] = {
+	"jtag", "target", "server", "flash", "profile",
+};
+
+#define TRACE_SUBSYS_PROFILE	4
+#define TRACE_EV_PROFILE_SCOPE	1
+
+/* must stay in sync with src/helper/profiling.h */
+static const char *profile_scope_names[] = {
+	"jtag_execute_queue",
+	"mem_ap read",
+	"mem_ap write",
+	"gdb packet",
+	"flash write",
+};
+
+static const char *profile_scope_name(uint32_t scope)
+{
+	if (scope < sizeof(profile_scope_names) / sizeof(profile_scope_names[0]))
+		return profile_scope_names[scope];
+	return "?";
+}
+
+static const char *subsys_name(uint16_t subsys)
+{
+	if (subsys < sizeof(subsys_names) / sizeof(subsys_names[0]))
+		return subsys_names[subsys];
+	return "?";
+}
+
+static int record_cmp(const void *a, const void *b)
+{
+	const struct trace_ring_record *ra = a;
+	const struct trace_ring_record *rb = b;
+
+	if (ra->seq < rb->seq)
+		return -1;
+	if (ra->seq > rb->seq)
+		return 1;
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct trace_ring_header header;
+	struct trace_ring_record *records;
+	FILE *f;
+	uint32_t i, used;
+
+	const char *filename;
+	int chrome = 0;
+
+	if (argc == 3 && strcmp(argv[1], "-c") == 0) {
+		chrome = 1;
+		filename = argv[2];
+	} else if (argc == 2) {
+		filename = argv[1];
+	} else {
+		fprintf(stderr, "usage: %s [-c] <ringfile>\n", argv[0]);
+		return 1;
+	}
+
+	f = fopen(filename, "rb");
+	if (f == NULL) {
+		fprintf(stderr, "%s: %s\n", filename, strerror(errno));
+		return 1;
+	}
+
+	if (fread(&header, sizeof(header), 1, f) != 1) {
+		fprintf(stderr, "%s: short read on header\n", filename);
+		return 1;
+	}
+	if (header.magic != TRACE_RING_MAGIC) {
+		fprintf(stderr, "%s: not a trace ring file\n", filename);
+		return 1;
+	}
+	if (header.version != TRACE_RING_VERSION
+			|| header.record_size != sizeof(struct trace_ring_record)) {
+		fprintf(stderr, "%s: unsupported ring version/layout\n", filename);
+		return 1;
+	}
+
+	records = calloc(header.capacity, sizeof(*records));
+	if (records == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	if (fread(records, sizeof(*records), header.capacity, f)
+			!= header.capacity) {
+		fprintf(stderr, "%s: short read on records\n", filename);
+		return 1;
+	}
+	fclose(f);
+
+	/* drop unused slots, then replay in sequence order */
+	used = 0;
+	for (i = 0; i < header.capacity; i++)
+		if (records[i].seq != 0)
+			records[used++] = records[i];
+	qsort(records, used, sizeof(*records), record_cmp);
+
+	if (chrome) {
+		/* Chrome trace-event JSON.  Profile-scope records carry their
+		 * duration, so they become "X" (complete) events anchored at
+		 * interval start; everything else becomes an instant mark. */
+		printf("[\n");
+		for (i = 0; i < used; i++) {
+			struct trace_ring_record *rec = &records[i];
+
+			if (i > 0)
+				printf(",\n");
+
+			if (rec->subsys == TRACE_SUBSYS_PROFILE
+					&& rec->event == TRACE_EV_PROFILE_SCOPE) {
+				printf("{\"name\":\"%s\",\"ph\":\"X\","
+					"\"ts\":%llu,\"dur\":%u,"
+					"\"pid\":1,\"tid\":1}",
+					profile_scope_name(rec->arg[0]),
+					(unsigned long long)(rec->timestamp_us - rec->arg[1]),
+					rec->arg[1]);
+			} else {
+				printf("{\"name\":\"%s/ev%u\",\"ph\":\"i\","
+					"\"ts\":%llu,\"s\":\"g\",\"pid\":1,\"tid\":1,"
+					"\"args\":{\"arg0\":%u,\"arg1\":%u}}",
+					subsys_name(rec->subsys), rec->event,
+					(unsigned long long)rec->timestamp_us,
+					rec->arg[0], rec->arg[1]);
+			}
+		}
+		printf("\n]\n");
+	} else {
+		for (i = 0; i < used; i++) {
+			struct trace_ring_record *rec = &records[i];
+
+			printf("%12llu.%06llu  #%-10llu %-8s ev %-4u "
+				"0x%08x 0x%08x\n",
+				(unsigned long long)(rec->timestamp_us / 1000000),
+				(unsigned long long)(rec->timestamp_us % 1000000),
+				(unsigned long long)rec->seq,
+				subsys_name(rec->subsys), rec->event,
+				rec->arg[0], rec->arg[1]);
+		}
+	}
+
+	free(records);
+	return 0;
+}
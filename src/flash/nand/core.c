@@ -508,6 +508,10 @@ int nand_erase(struct nand_device *nand, int first_block, int last_block)
 	if ((first_block < 0) || (last_block >= nand->num_blocks))
 		return ERROR_COMMAND_SYNTAX_ERROR;
 
+	retval = nand_program_flush(nand);
+	if (ERROR_OK != retval)
+		return retval;
+
 	/* make sure we know if a block is bad before erasing it */
 	for (i = first_block; i <= last_block; i++) {
 		if (nand->blocks[i].is_bad == -1) {
@@ -659,6 +663,7 @@ int nand_write_page(struct nand_device *nand, uint32_t page,
 	uint8_t *oob, uint32_t oob_size)
 {
 	uint32_t block;
+	int retval;
 
 	if (!nand->device)
 		return ERROR_NAND_DEVICE_NOT_PROBED;
@@ -667,6 +672,12 @@ int nand_write_page(struct nand_device *nand, uint32_t page,
 	if (nand->blocks[block].is_erased == 1)
 		nand->blocks[block].is_erased = 0;
 
+	/* controller paths need not go through nand_page_command(), so a
+	 * program deferred by the previous page is flushed here */
+	retval = nand_program_flush(nand);
+	if (ERROR_OK != retval)
+		return retval;
+
 	if (nand->use_raw || nand->controller->write_page == NULL)
 		return nand_write_page_raw(nand, page, data, data_size, oob, oob_size);
 	else
@@ -677,9 +688,15 @@ int nand_read_page(struct nand_device *nand, uint32_t page,
 	uint8_t *data, uint32_t data_size,
 	uint8_t *oob, uint32_t oob_size)
 {
+	int retval;
+
 	if (!nand->device)
 		return ERROR_NAND_DEVICE_NOT_PROBED;
 
+	retval = nand_program_flush(nand);
+	if (ERROR_OK != retval)
+		return retval;
+
 	if (nand->use_raw || nand->controller->read_page == NULL)
 		return nand_read_page_raw(nand, page, data, data_size, oob, oob_size);
 	else
@@ -689,9 +706,15 @@ int nand_read_page(struct nand_device *nand, uint32_t page,
 int nand_page_command(struct nand_device *nand, uint32_t page,
 	uint8_t cmd, bool oob_only)
 {
+	int retval;
+
 	if (!nand->device)
 		return ERROR_NAND_DEVICE_NOT_PROBED;
 
+	retval = nand_program_flush(nand);
+	if (ERROR_OK != retval)
+		return retval;
+
 	if (oob_only && NAND_CMD_READ0 == cmd && nand->page_size <= 512)
 		cmd = NAND_CMD_READOOB;
 
@@ -820,12 +843,19 @@ int nand_write_data_page(struct nand_device *nand, uint8_t *data, uint32_t size)
 	return retval;
 }
 
-int nand_write_finish(struct nand_device *nand)
+/* Wait for a page program deferred by nand_write_finish() and check its
+ * status.  Deferring the check lets the host fetch and format the next
+ * page while the device programs the previous one; any operation that
+ * touches the device has to flush first.
+ */
+int nand_program_flush(struct nand_device *nand)
 {
 	int retval;
 	uint8_t status;
 
-	nand->controller->command(nand, NAND_CMD_PAGEPROG);
+	if (!nand->program_pending)
+		return ERROR_OK;
+	nand->program_pending = 0;
 
 	retval = nand->controller->nand_ready ?
 		nand->controller->nand_ready(nand, 100) :
@@ -848,6 +878,19 @@ int nand_write_finish(struct nand_device *nand)
 	return ERROR_OK;
 }
 
+int nand_write_finish(struct nand_device *nand)
+{
+	nand->controller->command(nand, NAND_CMD_PAGEPROG);
+
+	/* Let the program run while the caller prepares the next page;
+	 * the ready wait and status check are deferred until the next
+	 * operation touches the device, or until an explicit
+	 * nand_program_flush() at the end of a write sequence. */
+	nand->program_pending = 1;
+
+	return ERROR_OK;
+}
+
 int nand_write_page_raw(struct nand_device *nand, uint32_t page,
 	uint8_t *data, uint32_t data_size,
 	uint8_t *oob, uint32_t oob_size)
@@ -69,6 +69,10 @@ struct nand_device {
 	int page_size;
 	int erase_size;
 	int use_raw;
+	/** True while a page program started by nand_write_finish() still
+	 * awaits its ready wait and status check; see nand_program_flush().
+	 */
+	int program_pending;
 	int num_blocks;
 	struct nand_block *blocks;
 	struct nand_device *next;
@@ -203,6 +207,7 @@ int nand_write_data_page(struct nand_device *nand,
 			 uint8_t *data, uint32_t size);
 
 int nand_write_finish(struct nand_device *nand);
+int nand_program_flush(struct nand_device *nand);
 
 int nand_read_page_raw(struct nand_device *nand, uint32_t page,
 		       uint8_t *data, uint32_t data_size, uint8_t *oob, uint32_t oob_size);
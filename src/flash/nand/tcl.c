@@ -28,6 +28,7 @@
 #include "core.h"
 #include "imp.h"
 #include "fileio.h"
+#include <helper/progress.h>
 #include <target/target.h>
 
 /* to be removed */
@@ -252,10 +253,12 @@ COMMAND_HANDLER(handle_nand_write_command)
 		return retval;
 
 	uint32_t total_bytes = s.size;
+	progress_start("nand_write", total_bytes);
 	while (s.size > 0) {
 		int bytes_read = nand_fileio_read(nand, &s);
 		if (bytes_read <= 0) {
 			command_print(CMD_CTX, "error while reading file");
+			progress_done();
 			return nand_fileio_cleanup(&s);
 		}
 		s.size -= bytes_read;
@@ -266,9 +269,21 @@ COMMAND_HANDLER(handle_nand_write_command)
 			command_print(CMD_CTX, "failed writing file %s "
 				"to NAND flash %s at offset 0x%8.8" PRIx32,
 				CMD_ARGV[1], CMD_ARGV[0], s.address);
+			progress_done();
 			return nand_fileio_cleanup(&s);
 		}
 		s.address += s.page_size;
+		progress_add(bytes_read);
+	}
+	progress_done();
+
+	/* the status check of the last page program is still deferred */
+	retval = nand_program_flush(nand);
+	if (ERROR_OK != retval) {
+		command_print(CMD_CTX, "failed writing file %s "
+			"to NAND flash %s at offset 0x%8.8" PRIx32,
+			CMD_ARGV[1], CMD_ARGV[0], s.address - s.page_size);
+		return nand_fileio_cleanup(&s);
 	}
 
 	if (nand_fileio_finish(&s) == ERROR_OK) {
@@ -64,6 +64,9 @@
 
 #include "imp.h"
 #include <helper/time_support.h>
+#include <helper/binarybuffer.h>
+#include <target/algorithm.h>
+#include <target/armv7m.h>
 
 #define REG_NAME_WIDTH  (12)
 
@@ -2130,6 +2133,195 @@ static int sam4_page_write(struct sam4_bank_private *pPrivate, unsigned pagenum,
 	return ERROR_OK;
 }
 
+/* EEFC page-program FIFO kernel for target_run_flash_async_algorithm().
+ *
+ * Copies one page from the circular buffer into the write latch, issues
+ * the page command and advances the read pointer *before* waiting for
+ * FRDY, so the host uploads the next page while the previous one
+ * programs.  The page command's error flags are checked once FRDY sets;
+ * on error rp is zeroed to abort.  Thumb-1 only.
+ *
+ * Params:
+ * r0 - EEFC controller address (in), final FSR value (out)
+ * r1 - page count
+ * r2 - workarea start
+ * r3 - workarea end
+ * r4 - page latch (write) address
+ * r8 - first page number
+ * r9 - page size
+ * r10 - FCR command word (0x5A << 24 | page command)
+ * Clobbered:
+ * r5 - rp
+ * r6 - tmp
+ * r7 - tmp
+ */
+static const uint8_t sam4_page_write_code[] = {
+	/* wait_fifo: */
+		0x16, 0x68,		/* ldr    r6, [r2, #0]    */
+		0x00, 0x2E,		/* cmp    r6, #0          */
+		0x21, 0xD0,		/* beq    exit            */
+		0x55, 0x68,		/* ldr    r5, [r2, #4]    */
+		0xB5, 0x42,		/* cmp    r5, r6          */
+		0xF9, 0xD0,		/* beq    wait_fifo       */
+		0x4F, 0x46,		/* mov    r7, r9          */
+	/* copy: */
+		0x2E, 0x68,		/* ldr    r6, [r5, #0]    */
+		0x26, 0x60,		/* str    r6, [r4, #0]    */
+		0x04, 0x35,		/* adds   r5, #4          */
+		0x04, 0x34,		/* adds   r4, #4          */
+		0x04, 0x3F,		/* subs   r7, #4          */
+		0xF9, 0xD1,		/* bne    copy            */
+		0x9D, 0x42,		/* cmp    r5, r3          */
+		0x01, 0xD3,		/* bcc    no_wrap         */
+		0x15, 0x46,		/* mov    r5, r2          */
+		0x08, 0x35,		/* adds   r5, #8          */
+	/* no_wrap: */
+				/* free the fifo slot before programming, the
+				 * host refills it while the page burns */
+		0x55, 0x60,		/* str    r5, [r2, #4]    */
+		0x46, 0x46,		/* mov    r6, r8          */
+		0x36, 0x02,		/* lsls   r6, r6, #8      */
+		0x57, 0x46,		/* mov    r7, r10         */
+		0x3E, 0x43,		/* orrs   r6, r7          */
+		0x46, 0x60,		/* str    r6, [r0, #4]    */
+		0x46, 0x46,		/* mov    r6, r8          */
+		0x01, 0x36,		/* adds   r6, #1          */
+		0xB0, 0x46,		/* mov    r8, r6          */
+	/* busy: */
+		0x86, 0x68,		/* ldr    r6, [r0, #8]    */
+		0x77, 0x08,		/* lsrs   r7, r6, #1      */
+		0xFC, 0xD3,		/* bcc    busy            */
+		0x06, 0x27,		/* movs   r7, #6          */
+		0x3E, 0x42,		/* tst    r6, r7          */
+		0x02, 0xD1,		/* bne    error           */
+		0x01, 0x39,		/* subs   r1, #1          */
+		0xDD, 0xD1,		/* bne    wait_fifo       */
+		0x01, 0xE0,		/* b      exit            */
+	/* error: */
+		0x00, 0x27,		/* movs   r7, #0          */
+		0x57, 0x60,		/* str    r7, [r2, #4]    */
+	/* exit: */
+		0x30, 0x46,		/* mov    r0, r6          */
+		0x00, 0xBE,		/* bkpt   #0              */
+};
+
+/**
+ * Programs a run of full, consecutive pages through the FIFO kernel so
+ * the host-to-target transfer overlaps the EEFC program time.  Returns
+ * ERROR_TARGET_RESOURCE_NOT_AVAILABLE when no suitable working area
+ * exists; the caller then falls back to sam4_page_write().
+ * @param pPrivate - info about the bank
+ * @param firstpage - first page number to program
+ * @param numpages - number of full pages, taken from buf
+ * @param buf - page data, numpages * page_size bytes
+ */
+static int sam4_page_write_block(struct sam4_bank_private *pPrivate,
+	unsigned firstpage,
+	unsigned numpages,
+	const uint8_t *buf)
+{
+	struct target *target = pPrivate->pChip->target;
+	struct working_area *write_algorithm;
+	struct working_area *source;
+	uint32_t buffer_pages = 4;
+	uint32_t fsr, fmr;
+	struct reg_param reg_params[8];
+	struct armv7m_algorithm armv7m_info;
+	int r;
+
+	/* the controller must be idle before the kernel issues its first
+	 * command unchecked */
+	r = target_read_u32(target,
+			pPrivate->controller_address + offset_EFC_FSR, &fsr);
+	if (r != ERROR_OK)
+		return r;
+	if (!(fsr & 1))
+		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+
+	/* set FWS (flash wait states) once for the whole run, not per page */
+	r = target_read_u32(target, pPrivate->controller_address, &fmr);
+	if (r != ERROR_OK)
+		return r;
+	fmr &= 0xfffff0ff;
+	fmr |= (pPrivate->flash_wait_states << 8);
+	r = target_write_u32(target, pPrivate->controller_address, fmr);
+	if (r != ERROR_OK)
+		return r;
+
+	r = target_load_algorithm_image(target, sam4_page_write_code,
+			sizeof(sam4_page_write_code), &write_algorithm);
+	if (r != ERROR_OK)
+		return r;
+
+	/* fifo of whole pages plus the wp/rp header */
+	while (target_alloc_working_area_try(target,
+			buffer_pages * pPrivate->page_size + 8, &source) != ERROR_OK) {
+		buffer_pages /= 2;
+		if (buffer_pages < 2) {
+			target_free_working_area(target, write_algorithm);
+			return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+		}
+	}
+
+	armv7m_info.common_magic = ARMV7M_COMMON_MAGIC;
+	armv7m_info.core_mode = ARM_MODE_THREAD;
+
+	init_reg_param(&reg_params[0], "r0", 32, PARAM_IN_OUT);	/* EEFC base (in), FSR (out) */
+	init_reg_param(&reg_params[1], "r1", 32, PARAM_OUT);	/* page count */
+	init_reg_param(&reg_params[2], "r2", 32, PARAM_OUT);	/* buffer start */
+	init_reg_param(&reg_params[3], "r3", 32, PARAM_OUT);	/* buffer end */
+	init_reg_param(&reg_params[4], "r4", 32, PARAM_OUT);	/* page latch address */
+	init_reg_param(&reg_params[5], "r8", 32, PARAM_IN_OUT);	/* page number */
+	init_reg_param(&reg_params[6], "r9", 32, PARAM_OUT);	/* page size */
+	init_reg_param(&reg_params[7], "r10", 32, PARAM_OUT);	/* FCR command word */
+
+	buf_set_u32(reg_params[0].value, 0, 32, pPrivate->controller_address);
+	buf_set_u32(reg_params[1].value, 0, 32, numpages);
+	buf_set_u32(reg_params[2].value, 0, 32, source->address);
+	buf_set_u32(reg_params[3].value, 0, 32, source->address + source->size);
+	buf_set_u32(reg_params[4].value, 0, 32,
+		pPrivate->base_address + firstpage * pPrivate->page_size);
+	buf_set_u32(reg_params[5].value, 0, 32, firstpage);
+	buf_set_u32(reg_params[6].value, 0, 32, pPrivate->page_size);
+	buf_set_u32(reg_params[7].value, 0, 32,
+		(0x5A << 24) | AT91C_EFC_FCMD_WP);
+
+	r = target_run_flash_async_algorithm(target, buf, numpages,
+			pPrivate->page_size,
+			0, NULL,
+			8, reg_params,
+			source->address, source->size,
+			write_algorithm->address, 0,
+			&armv7m_info);
+
+	if (r == ERROR_FLASH_OPERATION_FAILED) {
+		uint32_t status = buf_get_u32(reg_params[0].value, 0, 32);
+		unsigned pagenum = buf_get_u32(reg_params[5].value, 0, 32);
+
+		/* the kernel pre-increments the page number */
+		LOG_ERROR("SAM4: Error programming page %u, FSR: 0x%08x",
+			pagenum ? pagenum - 1 : 0, (unsigned int)(status));
+		if (status & (1 << 2))
+			LOG_ERROR("SAM4: Page is locked");
+		if (status & (1 << 1))
+			LOG_ERROR("SAM4: Flash Command error");
+	}
+
+	target_free_working_area(target, source);
+	target_free_working_area(target, write_algorithm);
+
+	destroy_reg_param(&reg_params[0]);
+	destroy_reg_param(&reg_params[1]);
+	destroy_reg_param(&reg_params[2]);
+	destroy_reg_param(&reg_params[3]);
+	destroy_reg_param(&reg_params[4]);
+	destroy_reg_param(&reg_params[5]);
+	destroy_reg_param(&reg_params[6]);
+	destroy_reg_param(&reg_params[7]);
+
+	return r;
+}
+
 static int sam4_write(struct flash_bank *bank,
 	const uint8_t *buffer,
 	uint32_t offset,
@@ -2249,6 +2441,21 @@ static int sam4_write(struct flash_bank *bank,
 	LOG_DEBUG("Full Page Loop: cur=%d, end=%d, count = 0x%08x",
 		(int)page_cur, (int)page_end, (unsigned int)(count));
 
+	/* overlapped on-target page loop; needs a working area, otherwise
+	 * fall through to one host round trip per page */
+	n = count / pPrivate->page_size;
+	if ((unsigned)(n) > (page_end - page_cur))
+		n = page_end - page_cur;
+	if (n > 1) {
+		r = sam4_page_write_block(pPrivate, page_cur, n, buffer);
+		if (r == ERROR_OK) {
+			count -= n * pPrivate->page_size;
+			buffer += n * pPrivate->page_size;
+			page_cur += n;
+		} else if (r != ERROR_TARGET_RESOURCE_NOT_AVAILABLE)
+			goto done;
+	}
+
 	while ((page_cur < page_end) &&
 			(count >= pPrivate->page_size)) {
 		r = sam4_page_write(pPrivate, page_cur, buffer);
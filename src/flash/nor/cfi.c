@@ -1139,6 +1139,36 @@ static uint32_t cfi_command_val(struct flash_bank *bank, uint8_t cmd)
 	}
 }
 
+/* Allocate the data buffer for a block write handler.  Start from what
+ * the working area can actually spare instead of a fixed 32 kB guess,
+ * halving on failure down to a 32 byte minimum, so a partially occupied
+ * working area no longer forces the slow word-programming fallback. */
+static int cfi_alloc_write_buffer(struct flash_bank *bank, uint32_t count,
+	struct working_area **source, uint32_t *buffer_size)
+{
+	struct target *target = bank->target;
+	uint32_t size = target_get_working_area_avail(target);
+
+	/* no point in a buffer larger than the remaining data */
+	if (size > count)
+		size = count;
+	size &= ~(uint32_t)(bank->bus_width - 1);
+
+	*source = NULL;
+	while (size >= 32) {
+		if (target_alloc_working_area_try(target, size, source) == ERROR_OK) {
+			*buffer_size = size;
+			return ERROR_OK;
+		}
+		size /= 2;
+		size &= ~(uint32_t)(bank->bus_width - 1);
+	}
+
+	LOG_WARNING("no working area available for a write buffer, "
+		"can't do block memory writes");
+	return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+}
+
 static int cfi_intel_write_block(struct flash_bank *bank, const uint8_t *buffer,
 	uint32_t address, uint32_t count)
 {
@@ -1147,7 +1177,7 @@ static int cfi_intel_write_block(struct flash_bank *bank, const uint8_t *buffer,
 	struct arm_algorithm arm_algo;
 	struct working_area *write_algorithm;
 	struct working_area *source = NULL;
-	uint32_t buffer_size = 32768;
+	uint32_t buffer_size;
 	uint32_t write_command_val, busy_pattern_val, error_pattern_val;
 
 	/* algorithm register usage:
@@ -1285,19 +1315,10 @@ static int cfi_intel_write_block(struct flash_bank *bank, const uint8_t *buffer,
 		goto cleanup;
 	}
 
-	/* Get a workspace buffer for the data to flash starting with 32k size.
-	 * Half size until buffer would be smaller 256 Bytes then fail back */
-	/* FIXME Why 256 bytes, why not 32 bytes (smallest flash write page */
-	while (target_alloc_working_area_try(target, buffer_size, &source) != ERROR_OK) {
-		buffer_size /= 2;
-		if (buffer_size <= 256) {
-			LOG_WARNING(
-				"no large enough working area available, can't do block memory writes");
-			retval = ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
-			goto cleanup;
-		}
-	}
-	;
+	/* Get a workspace buffer for the data to flash */
+	retval = cfi_alloc_write_buffer(bank, count, &source, &buffer_size);
+	if (retval != ERROR_OK)
+		goto cleanup;
 
 	/* setup algo registers */
 	init_reg_param(&reg_params[0], "r0", 32, PARAM_OUT);
@@ -1341,7 +1362,9 @@ static int cfi_intel_write_block(struct flash_bank *bank, const uint8_t *buffer,
 				write_algorithm->address,
 				write_algorithm->address + target_code_size -
 				sizeof(uint32_t),
-				10000,	/* 10s should be enough for max. 32k of data */
+				/* 10s covered the old fixed 32k buffer; scale
+				 * the budget along with the buffer size */
+				10000 + thisrun_count / 3,
 				&arm_algo);
 
 		/* On failure try a fall back to direct word writes */
@@ -1402,7 +1425,7 @@ static int cfi_spansion_write_block_mips(struct flash_bank *bank, const uint8_t
 	struct mips32_algorithm mips32_info;
 	struct working_area *write_algorithm;
 	struct working_area *source;
-	uint32_t buffer_size = 32768;
+	uint32_t buffer_size;
 	uint32_t status;
 	int retval = ERROR_OK;
 
@@ -1528,19 +1551,13 @@ static int cfi_spansion_write_block_mips(struct flash_bank *bank, const uint8_t
 
 	/* the following code still assumes target code is fixed 24*4 bytes */
 
-	while (target_alloc_working_area_try(target, buffer_size, &source) != ERROR_OK) {
-		buffer_size /= 2;
-		if (buffer_size <= 256) {
-			/* we already allocated the writing code, but failed to get a
-			 * buffer, free the algorithm */
-			target_free_working_area(target, write_algorithm);
-
-			LOG_WARNING(
-				"not enough working area available, can't do block memory writes");
-			return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
-		}
+	retval = cfi_alloc_write_buffer(bank, count, &source, &buffer_size);
+	if (retval != ERROR_OK) {
+		/* we already allocated the writing code, but failed to get a
+		 * buffer, free the algorithm */
+		target_free_working_area(target, write_algorithm);
+		return retval;
 	}
-	;
 
 	init_reg_param(&reg_params[0], "r4", 32, PARAM_OUT);
 	init_reg_param(&reg_params[1], "r5", 32, PARAM_OUT);
@@ -1573,7 +1590,7 @@ static int cfi_spansion_write_block_mips(struct flash_bank *bank, const uint8_t
 		retval = target_run_algorithm(target, 0, NULL, 10, reg_params,
 				write_algorithm->address,
 				write_algorithm->address + ((target_code_size) - 4),
-				10000, &mips32_info);
+				10000 + thisrun_count / 3, &mips32_info);
 		if (retval != ERROR_OK)
 			break;
 
@@ -1617,7 +1634,7 @@ static int cfi_spansion_write_block(struct flash_bank *bank, const uint8_t *buff
 	struct armv7m_algorithm armv7m_algo;
 	struct working_area *write_algorithm;
 	struct working_area *source;
-	uint32_t buffer_size = 32768;
+	uint32_t buffer_size;
 	uint32_t status;
 	int retval = ERROR_OK;
 
@@ -1908,19 +1925,13 @@ static int cfi_spansion_write_block(struct flash_bank *bank, const uint8_t *buff
 
 	/* the following code still assumes target code is fixed 24*4 bytes */
 
-	while (target_alloc_working_area_try(target, buffer_size, &source) != ERROR_OK) {
-		buffer_size /= 2;
-		if (buffer_size <= 256) {
-			/* we already allocated the writing code, but failed to get a
-			 * buffer, free the algorithm */
-			target_free_working_area(target, write_algorithm);
-
-			LOG_WARNING(
-				"not enough working area available, can't do block memory writes");
-			return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
-		}
+	retval = cfi_alloc_write_buffer(bank, count, &source, &buffer_size);
+	if (retval != ERROR_OK) {
+		/* we already allocated the writing code, but failed to get a
+		 * buffer, free the algorithm */
+		target_free_working_area(target, write_algorithm);
+		return retval;
 	}
-	;
 
 	init_reg_param(&reg_params[0], "r0", 32, PARAM_OUT);
 	init_reg_param(&reg_params[1], "r1", 32, PARAM_OUT);
@@ -1953,7 +1964,7 @@ static int cfi_spansion_write_block(struct flash_bank *bank, const uint8_t *buff
 		retval = target_run_algorithm(target, 0, NULL, 10, reg_params,
 				write_algorithm->address,
 				write_algorithm->address + ((target_code_size) - 4),
-				10000, arm_algo);
+				10000 + thisrun_count / 3, arm_algo);
 		if (retval != ERROR_OK)
 			break;
 
@@ -2548,6 +2559,136 @@ static int cfi_query_string(struct flash_bank *bank, int address)
 	return ERROR_OK;
 }
 
+/* Probe cache payload: a snapshot of the driver state once the query
+ * dance and all fixups are done.  The pointer members of the embedded
+ * cfi_flash_bank copy are meaningless on disk and are rewritten with
+ * fresh allocations on restore.  The snapshot is followed by the
+ * erase_region_info array, the pri_ext blob and the bank sector list. */
+struct cfi_probe_cache {
+	struct cfi_flash_bank cfi;
+	uint32_t pri_ext_size;
+	int num_sectors;
+};
+
+static uint32_t cfi_pri_ext_size(struct cfi_flash_bank *cfi_info)
+{
+	if (cfi_info->pri_ext == NULL)
+		return 0;
+
+	switch (cfi_info->pri_id) {
+		case 0x0001:
+		case 0x0003:
+			return sizeof(struct cfi_intel_pri_ext);
+		case 0x0002:
+			/* the Atmel table is translated to the Spansion layout */
+			return sizeof(struct cfi_spansion_pri_ext);
+		default:
+			return 0;
+	}
+}
+
+static void cfi_probe_cache_store(struct flash_bank *bank)
+{
+	struct cfi_flash_bank *cfi_info = bank->driver_priv;
+
+	if (!flash_probe_cache_active())
+		return;
+
+	uint32_t region_size = cfi_info->num_erase_regions
+		* sizeof(*cfi_info->erase_region_info);
+	uint32_t pri_ext_size = cfi_pri_ext_size(cfi_info);
+	uint32_t sectors_size = bank->num_sectors * sizeof(struct flash_sector);
+	uint32_t payload_size = sizeof(struct cfi_probe_cache)
+		+ region_size + pri_ext_size + sectors_size;
+
+	uint8_t *payload = malloc(payload_size);
+	if (payload == NULL)
+		return;
+
+	struct cfi_probe_cache *cache = (struct cfi_probe_cache *)payload;
+	cache->cfi = *cfi_info;
+	cache->pri_ext_size = pri_ext_size;
+	cache->num_sectors = bank->num_sectors;
+
+	uint8_t *pos = payload + sizeof(*cache);
+	memcpy(pos, cfi_info->erase_region_info, region_size);
+	pos += region_size;
+	memcpy(pos, cfi_info->pri_ext, pri_ext_size);
+	pos += pri_ext_size;
+	memcpy(pos, bank->sectors, sectors_size);
+
+	flash_probe_cache_store(bank, payload, payload_size);
+	free(payload);
+}
+
+/* Restore geometry and timing from the probe cache.  Called with the
+ * manufacturer/device ID freshly read back from the chip, which is the
+ * validation that the cached entry still describes this device. */
+static int cfi_probe_cache_restore(struct flash_bank *bank)
+{
+	struct cfi_flash_bank *cfi_info = bank->driver_priv;
+	void *payload;
+	uint32_t payload_size;
+
+	if (flash_probe_cache_load(bank, &payload, &payload_size) != ERROR_OK)
+		return ERROR_FAIL;
+
+	struct cfi_probe_cache *cache = payload;
+	if (payload_size < sizeof(*cache))
+		goto stale;
+	uint32_t region_size = cache->cfi.num_erase_regions
+		* sizeof(*cfi_info->erase_region_info);
+	uint32_t sectors_size = cache->num_sectors * sizeof(struct flash_sector);
+	if (payload_size != sizeof(*cache) + region_size
+			+ cache->pri_ext_size + sectors_size)
+		goto stale;
+
+	/* the cheap ID re-read must match what was cached */
+	if (cache->cfi.manufacturer != cfi_info->manufacturer
+			|| cache->cfi.device_id != cfi_info->device_id)
+		goto stale;
+
+	/* bank options influencing the interpretation must match too */
+	if (cache->cfi.x16_as_x8 != cfi_info->x16_as_x8
+			|| cache->cfi.jedec_probe != cfi_info->jedec_probe
+			|| cache->cfi.endianness != cfi_info->endianness)
+		goto stale;
+
+	uint8_t *pos = (uint8_t *)payload + sizeof(*cache);
+	uint32_t *regions = NULL;
+	void *pri_ext = NULL;
+	struct flash_sector *sectors = NULL;
+	if (region_size) {
+		regions = malloc(region_size);
+		memcpy(regions, pos, region_size);
+	}
+	pos += region_size;
+	if (cache->pri_ext_size) {
+		pri_ext = malloc(cache->pri_ext_size);
+		memcpy(pri_ext, pos, cache->pri_ext_size);
+	}
+	pos += cache->pri_ext_size;
+	sectors = malloc(sectors_size);
+	memcpy(sectors, pos, sectors_size);
+
+	*cfi_info = cache->cfi;
+	cfi_info->erase_region_info = regions;
+	cfi_info->pri_ext = pri_ext;
+	cfi_info->alt_ext = NULL;
+	bank->num_sectors = cache->num_sectors;
+	bank->sectors = sectors;
+	cfi_info->probed = 1;
+	free(payload);
+
+	LOG_DEBUG("flash bank '%s' restored from probe cache", bank->name);
+	return ERROR_OK;
+
+stale:
+	LOG_DEBUG("stale probe cache entry for bank '%s' ignored", bank->name);
+	free(payload);
+	return ERROR_FAIL;
+}
+
 static int cfi_probe(struct flash_bank *bank)
 {
 	struct cfi_flash_bank *cfi_info = bank->driver_priv;
@@ -2629,6 +2770,11 @@ static int cfi_probe(struct flash_bank *bank)
 	if (retval != ERROR_OK)
 		return retval;
 
+	/* with a probe cache entry validated by the ID just read back,
+	 * skip the CFI query dance and reuse the stored geometry */
+	if (cfi_probe_cache_restore(bank) == ERROR_OK)
+		return ERROR_OK;
+
 	/* check device/manufacturer ID for known non-CFI flashes. */
 	cfi_fixup_non_cfi(bank);
 
@@ -2881,6 +3027,8 @@ static int cfi_probe(struct flash_bank *bank)
 
 	cfi_info->probed = 1;
 
+	cfi_probe_cache_store(bank);
+
 	return ERROR_OK;
 }
 
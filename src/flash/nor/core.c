@@ -27,6 +27,8 @@
 #include <flash/common.h>
 #include <flash/nor/core.h>
 #include <flash/nor/imp.h>
+#include <helper/profiling.h>
+#include <helper/progress.h>
 #include <target/image.h>
 
 /**
@@ -38,13 +40,53 @@
 
 static struct flash_bank *flash_banks;
 
+/* directory holding on-disk probe cache entries; NULL leaves the cache off */
+static char *flash_probe_cache_dir;
+/* set while "flash probe -force" runs, so drivers do a full interrogation */
+static bool flash_probe_cache_bypass;
+
+/* Upper bound on the scratch buffer used by flash_write_unlock() to feed
+ * a run of image sections to the driver.  Runs larger than this are
+ * streamed through the buffer in pieces instead of being flattened into
+ * one contiguous allocation the size of the whole image. */
+#define FLASH_WRITE_CHUNK_SIZE (1024 * 1024)
+
 int flash_driver_erase(struct flash_bank *bank, int first, int last)
 {
-	int retval;
+	int retval = ERROR_OK;
+	int run_first, run_last, i;
+
+	if (bank->sectors == NULL)
+		return bank->driver->erase(bank, first, last);
+
+	/* The per-sector erase state is maintained as a write-through cache:
+	 * successful erases set it here, flash_driver_write() clears it for
+	 * the sectors it touches, and it is dropped whenever the target may
+	 * have modified flash behind our back (reset, resumed application).
+	 * Sectors known to be blank are skipped instead of erased again. */
+	run_first = first;
+	while (run_first <= last) {
+		if (bank->sectors[run_first].is_erased == 1) {
+			LOG_DEBUG("sector %d already erased, skipping", run_first);
+			run_first++;
+			continue;
+		}
 
-	retval = bank->driver->erase(bank, first, last);
-	if (retval != ERROR_OK)
-		LOG_ERROR("failed erasing sectors %d to %d", first, last);
+		run_last = run_first;
+		while (run_last < last && bank->sectors[run_last + 1].is_erased != 1)
+			run_last++;
+
+		retval = bank->driver->erase(bank, run_first, run_last);
+		if (retval != ERROR_OK) {
+			LOG_ERROR("failed erasing sectors %d to %d", run_first, run_last);
+			return retval;
+		}
+
+		for (i = run_first; i <= run_last; i++)
+			bank->sectors[i].is_erased = 1;
+
+		run_first = run_last + 1;
+	}
 
 	return retval;
 }
@@ -84,8 +126,23 @@ int flash_driver_write(struct flash_bank *bank,
 	uint8_t *buffer, uint32_t offset, uint32_t count)
 {
 	int retval;
+	int64_t profile_start = profile_enter();
+
+	/* the written sectors are no longer blank; clear the cached state
+	 * up front, because a failed write may still have programmed part
+	 * of the range */
+	if (bank->sectors) {
+		int i;
+		for (i = 0; i < bank->num_sectors; i++) {
+			struct flash_sector *sector = &bank->sectors[i];
+			if (offset < sector->offset + sector->size
+					&& offset + count > sector->offset)
+				sector->is_erased = 0;
+		}
+	}
 
 	retval = bank->driver->write(bank, buffer, offset, count);
+	profile_leave(PROFILE_FLASH_WRITE, profile_start);
 	if (retval != ERROR_OK) {
 		LOG_ERROR(
 			"error writing to flash at address 0x%08" PRIx32 " at offset 0x%8.8" PRIx32,
@@ -120,8 +177,36 @@ int default_flash_read(struct flash_bank *bank,
 	return target_read_buffer(bank->target, offset + bank->base, count, buffer);
 }
 
+static int flash_target_event_handler(struct target *target,
+	enum target_event event, void *priv)
+{
+	struct flash_bank *bank;
+	int i;
+
+	/* a reset or a resumed application can modify flash behind our
+	 * back; drop the cached sector erase state of affected banks */
+	if (event != TARGET_EVENT_RESET_ASSERT && event != TARGET_EVENT_RESUMED)
+		return ERROR_OK;
+
+	for (bank = flash_banks; bank; bank = bank->next) {
+		if (bank->target != target || bank->sectors == NULL)
+			continue;
+		for (i = 0; i < bank->num_sectors; i++)
+			bank->sectors[i].is_erased = -1;
+	}
+
+	return ERROR_OK;
+}
+
 void flash_bank_add(struct flash_bank *bank)
 {
+	static bool event_handler_registered;
+
+	if (!event_handler_registered) {
+		target_register_event_callback(flash_target_event_handler, NULL);
+		event_handler_registered = true;
+	}
+
 	/* put flash bank in linked list */
 	unsigned bank_num = 0;
 	if (flash_banks) {
@@ -137,6 +222,13 @@ void flash_bank_add(struct flash_bank *bank)
 		flash_banks = bank;
 
 	bank->bank_number = bank_num;
+
+	/* a new bank changes the memory layout reported to gdb */
+	if (bank->target) {
+		free(bank->target->memory_map);
+		bank->target->memory_map = NULL;
+		bank->target->memory_map_length = 0;
+	}
 }
 
 struct flash_bank *flash_bank_list(void)
@@ -144,6 +236,138 @@ struct flash_bank *flash_bank_list(void)
 	return flash_banks;
 }
 
+/* On-disk probe cache.  The framework owns the file handling and the
+ * header that ties an entry to its bank configuration; the payload is an
+ * opaque driver-defined blob.  Drivers are expected to validate the
+ * payload against a cheap device ID re-read before trusting it. */
+
+#define FLASH_PROBE_CACHE_MAGIC		0x4f435043	/* "OCPC" */
+#define FLASH_PROBE_CACHE_VERSION	1
+
+struct flash_probe_cache_header {
+	uint32_t magic;
+	uint32_t version;
+	char driver[16];
+	uint32_t base;
+	uint32_t size;
+	uint32_t chip_width;
+	uint32_t bus_width;
+	uint32_t payload_size;
+};
+
+void flash_probe_cache_set_dir(const char *dir)
+{
+	free(flash_probe_cache_dir);
+	flash_probe_cache_dir = dir ? strdup(dir) : NULL;
+}
+
+void flash_probe_cache_set_bypass(bool bypass)
+{
+	flash_probe_cache_bypass = bypass;
+}
+
+bool flash_probe_cache_active(void)
+{
+	return flash_probe_cache_dir != NULL;
+}
+
+static FILE *flash_probe_cache_open(struct flash_bank *bank, const char *mode)
+{
+	char *path = alloc_printf("%s/%s.probe", flash_probe_cache_dir, bank->name);
+	if (path == NULL)
+		return NULL;
+	FILE *file = fopen(path, mode);
+	free(path);
+	return file;
+}
+
+static void flash_probe_cache_fill_header(struct flash_bank *bank,
+	struct flash_probe_cache_header *header)
+{
+	memset(header, 0, sizeof(*header));
+	header->magic = FLASH_PROBE_CACHE_MAGIC;
+	header->version = FLASH_PROBE_CACHE_VERSION;
+	strncpy(header->driver, bank->driver->name, sizeof(header->driver) - 1);
+	header->base = bank->base;
+	header->size = bank->size;
+	header->chip_width = bank->chip_width;
+	header->bus_width = bank->bus_width;
+}
+
+int flash_probe_cache_load(struct flash_bank *bank, void **payload,
+	uint32_t *payload_size)
+{
+	struct flash_probe_cache_header header, expected;
+
+	if (!flash_probe_cache_active() || flash_probe_cache_bypass)
+		return ERROR_FAIL;
+
+	FILE *file = flash_probe_cache_open(bank, "rb");
+	if (file == NULL)
+		return ERROR_FAIL;
+
+	if (fread(&header, sizeof(header), 1, file) != 1) {
+		fclose(file);
+		return ERROR_FAIL;
+	}
+
+	/* a stale entry from another configuration of the same bank name
+	 * must not be trusted */
+	flash_probe_cache_fill_header(bank, &expected);
+	expected.payload_size = header.payload_size;
+	if (memcmp(&header, &expected, sizeof(header)) != 0) {
+		LOG_DEBUG("probe cache entry for bank '%s' does not match "
+			"the bank configuration", bank->name);
+		fclose(file);
+		return ERROR_FAIL;
+	}
+
+	void *data = malloc(header.payload_size);
+	if (data == NULL) {
+		fclose(file);
+		return ERROR_FAIL;
+	}
+	if (fread(data, 1, header.payload_size, file) != header.payload_size) {
+		free(data);
+		fclose(file);
+		return ERROR_FAIL;
+	}
+	fclose(file);
+
+	*payload = data;
+	*payload_size = header.payload_size;
+	return ERROR_OK;
+}
+
+int flash_probe_cache_store(struct flash_bank *bank, const void *payload,
+	uint32_t payload_size)
+{
+	struct flash_probe_cache_header header;
+
+	if (!flash_probe_cache_active())
+		return ERROR_FAIL;
+
+	FILE *file = flash_probe_cache_open(bank, "wb");
+	if (file == NULL) {
+		LOG_WARNING("could not write probe cache entry for bank '%s'",
+			bank->name);
+		return ERROR_FAIL;
+	}
+
+	flash_probe_cache_fill_header(bank, &header);
+	header.payload_size = payload_size;
+	if (fwrite(&header, sizeof(header), 1, file) != 1
+			|| fwrite(payload, 1, payload_size, file) != payload_size) {
+		LOG_WARNING("could not write probe cache entry for bank '%s'",
+			bank->name);
+		fclose(file);
+		return ERROR_FAIL;
+	}
+	fclose(file);
+
+	return ERROR_OK;
+}
+
 struct flash_bank *get_flash_bank_by_num_noprobe(int num)
 {
 	struct flash_bank *p;
@@ -317,20 +541,55 @@ int default_flash_blank_check(struct flash_bank *bank)
 		return ERROR_TARGET_NOT_HALTED;
 	}
 
-	for (i = 0; i < bank->num_sectors; i++) {
+	/* Check runs of contiguous sectors in a single algorithm invocation;
+	 * a freshly erased bank then needs one run of the on-target kernel
+	 * instead of one download-and-run cycle per sector. Only when a run
+	 * turns out not to be blank do we drop to per-sector checks to find
+	 * the programmed sectors. */
+	i = 0;
+	while (i < bank->num_sectors) {
 		uint32_t address = bank->base + bank->sectors[i].offset;
 		uint32_t size = bank->sectors[i].size;
+		int last = i;
+
+		while (last + 1 < bank->num_sectors
+				&& bank->sectors[last + 1].offset ==
+					bank->sectors[last].offset + bank->sectors[last].size) {
+			size += bank->sectors[last + 1].size;
+			last++;
+		}
 
 		retval = target_blank_check_memory(target, address, size, &blank);
 		if (retval != ERROR_OK) {
 			fast_check = 0;
 			break;
 		}
-		if (blank == 0xFF)
-			bank->sectors[i].is_erased = 1;
-		else
-			bank->sectors[i].is_erased = 0;
 		fast_check = 1;
+
+		if (blank == 0xFF || last == i) {
+			for (; i <= last; i++)
+				bank->sectors[i].is_erased = (blank == 0xFF) ? 1 : 0;
+			continue;
+		}
+
+		/* The run contains at least one programmed sector; check each
+		 * sector of the run on its own. */
+		for (; i <= last; i++) {
+			address = bank->base + bank->sectors[i].offset;
+			size = bank->sectors[i].size;
+
+			retval = target_blank_check_memory(target, address, size, &blank);
+			if (retval != ERROR_OK) {
+				fast_check = 0;
+				break;
+			}
+			if (blank == 0xFF)
+				bank->sectors[i].is_erased = 1;
+			else
+				bank->sectors[i].is_erased = 0;
+		}
+		if (!fast_check)
+			break;
 	}
 
 	if (!fast_check) {
@@ -541,7 +800,7 @@ static int compare_section(const void *a, const void *b)
 }
 
 int flash_write_unlock(struct target *target, struct image *image,
-	uint32_t *written, int erase, bool unlock)
+	uint32_t *written, int erase, bool unlock, bool diff_mode)
 {
 	int retval = ERROR_OK;
 
@@ -556,12 +815,11 @@ int flash_write_unlock(struct target *target, struct image *image,
 	if (written)
 		*written = 0;
 
-	if (erase) {
-		/* assume all sectors need erasing - stops any problems
-		 * when flash_write is called multiple times */
-
-		flash_set_dirty();
-	}
+	/* Repeated calls are safe without invalidating the whole erase state
+	 * cache up front: flash_driver_write() clears the state of every
+	 * sector it programs, so a second write of the same range erases
+	 * again, while sectors known blank (from a previous erase or an
+	 * erase_check) are skipped by flash_driver_erase(). */
 
 	/* allocate padding array */
 	padding = calloc(image->num_sections, sizeof(*padding));
@@ -577,6 +835,13 @@ int flash_write_unlock(struct target *target, struct image *image,
 	qsort(sections, image->num_sections, sizeof(struct imagesection *),
 		compare_section);
 
+	/* progress is accounted in image bytes; padding and sector
+	 * rounding ride along with the chunk that contains them */
+	uint64_t image_bytes = 0;
+	for (i = 0; i < image->num_sections; i++)
+		image_bytes += image->sections[i].size;
+	progress_start("flash_write", image_bytes);
+
 	/* loop until we reach end of the image */
 	while (section < image->num_sections) {
 		uint32_t buffer_size;
@@ -604,6 +869,17 @@ int flash_write_unlock(struct target *target, struct image *image,
 			continue;
 		}
 
+		/* Differential mode needs per-sector CRCs of the mapped
+		 * contents; fall back to writing everything when the bank
+		 * cannot provide them. */
+		bool run_diff = diff_mode;
+		if (run_diff && (c->num_sectors == 0
+				|| c->driver->read != default_flash_read)) {
+			LOG_WARNING("differential write not possible on bank '%s'; "
+				"writing all sectors", c->name);
+			run_diff = false;
+		}
+
 		/* collect consecutive sections which fall into the same bank */
 		section_last = section;
 		padding[section] = 0;
@@ -675,74 +951,184 @@ int flash_write_unlock(struct target *target, struct image *image,
 			run_size += delta;
 		}
 
-		/* allocate buffer */
-		buffer = malloc(run_size);
+		/* allocate buffer; large runs are streamed through a bounded
+		 * buffer rather than flattened into one contiguous allocation */
+		buffer_size = run_size;
+		if (buffer_size > FLASH_WRITE_CHUNK_SIZE)
+			buffer_size = FLASH_WRITE_CHUNK_SIZE;
+		buffer = malloc(buffer_size);
 		if (buffer == NULL) {
 			LOG_ERROR("Out of memory for flash bank buffer");
 			retval = ERROR_FAIL;
 			goto done;
 		}
-		buffer_size = 0;
-
-		/* read sections to the buffer */
-		while (buffer_size < run_size) {
-			size_t size_read;
-
-			size_read = run_size - buffer_size;
-			if (size_read > sections[section]->size - section_offset)
-				size_read = sections[section]->size - section_offset;
-
-			/* KLUDGE!
-			 *
-			 * #¤%#"%¤% we have to figure out the section # from the sorted
-			 * list of pointers to sections to invoke image_read_section()...
-			 */
-			intptr_t diff = (intptr_t)sections[section] - (intptr_t)image->sections;
-			int t_section_num = diff / sizeof(struct imagesection);
-
-			LOG_DEBUG("image_read_section: section = %d, t_section_num = %d, "
-					"section_offset = %d, buffer_size = %d, size_read = %d",
-				(int)section, (int)t_section_num, (int)section_offset,
-				(int)buffer_size, (int)size_read);
-			retval = image_read_section(image, t_section_num, section_offset,
-					size_read, buffer + buffer_size, &size_read);
-			if (retval != ERROR_OK || size_read == 0) {
-				free(buffer);
-				goto done;
-			}
-
-			/* see if we need to pad the section */
-			while (padding[section]--)
-				(buffer + buffer_size)[size_read++] = c->default_padded_value;
-
-			buffer_size += size_read;
-			section_offset += size_read;
-
-			if (section_offset >= sections[section]->size) {
-				section++;
-				section_offset = 0;
-			}
-		}
 
 		retval = ERROR_OK;
 
 		if (unlock)
 			retval = flash_unlock_address_range(target, run_address, run_size);
 		if (retval == ERROR_OK) {
-			if (erase) {
+			if (erase && !run_diff) {
 				/* calculate and erase sectors */
 				retval = flash_erase_address_range(target,
 						true, run_address, run_size);
 			}
 		}
+		if (retval != ERROR_OK) {
+			free(buffer);
+			goto done;
+		}
+
+		/* fill the buffer from image sections and synthesized padding,
+		 * handing each chunk to the driver as it completes */
+		uint32_t run_done = 0;
+		uint32_t pad_pending = 0;
+		uint32_t diff_skipped = 0;
+		/* run offset below which no further erase may happen; data
+		 * before it was either already programmed or kept as-is */
+		uint32_t erased_up_to = run_address - c->base;
+		while (run_done < run_size) {
+			uint32_t chunk_size = 0;
+			uint32_t chunk_limit = buffer_size;
+			uint32_t chunk_offset = run_address - c->base + run_done;
+			uint32_t chunk_image_bytes = 0;
+			int diff_sector = -1;
+
+			if (run_diff) {
+				/* bound the chunk to the end of its sector, so a
+				 * whole chunk can be skipped when it is unchanged */
+				for (i = 0; i < c->num_sectors; i++) {
+					uint32_t end = c->sectors[i].offset
+						+ c->sectors[i].size;
+					if (chunk_offset < end) {
+						diff_sector = i;
+						chunk_limit = end - chunk_offset;
+						break;
+					}
+				}
+				if (diff_sector < 0 || chunk_limit > buffer_size) {
+					/* sector missing or larger than the
+					 * buffer; write it the regular way */
+					diff_sector = -1;
+					chunk_limit = buffer_size;
+				}
+				if (chunk_limit > run_size - run_done)
+					chunk_limit = run_size - run_done;
+			}
+
+			while (chunk_size < chunk_limit && run_done + chunk_size < run_size) {
+				size_t size_read = chunk_limit - chunk_size;
+				if (size_read > run_size - run_done - chunk_size)
+					size_read = run_size - run_done - chunk_size;
+
+				/* pad out the gap behind the last consumed section */
+				if (pad_pending > 0) {
+					if (size_read > pad_pending)
+						size_read = pad_pending;
+					memset(buffer + chunk_size, c->default_padded_value, size_read);
+					pad_pending -= size_read;
+					chunk_size += size_read;
+					continue;
+				}
+
+				if (size_read > sections[section]->size - section_offset)
+					size_read = sections[section]->size - section_offset;
+
+				/* KLUDGE!
+				 *
+				 * #¤%#"%¤% we have to figure out the section # from the sorted
+				 * list of pointers to sections to invoke image_read_section()...
+				 */
+				intptr_t diff = (intptr_t)sections[section] - (intptr_t)image->sections;
+				int t_section_num = diff / sizeof(struct imagesection);
+
+				LOG_DEBUG("image_read_section: section = %d, t_section_num = %d, "
+						"section_offset = %d, chunk_size = %d, size_read = %d",
+					(int)section, (int)t_section_num, (int)section_offset,
+					(int)chunk_size, (int)size_read);
+				retval = image_read_section(image, t_section_num, section_offset,
+						size_read, buffer + chunk_size, &size_read);
+				if (retval != ERROR_OK || size_read == 0) {
+					free(buffer);
+					goto done;
+				}
+
+				chunk_size += size_read;
+				section_offset += size_read;
+				chunk_image_bytes += size_read;
+
+				if (section_offset >= sections[section]->size) {
+					/* see if we need to pad the section */
+					pad_pending = padding[section];
+					section++;
+					section_offset = 0;
+				}
+			}
+
+			if (diff_sector >= 0) {
+				/* the chunk covers its sector's remainder; skip
+				 * it when the flash already holds this data */
+				uint32_t file_crc, flash_crc;
+
+				retval = image_calculate_checksum(buffer,
+						chunk_size, &file_crc);
+				if (retval == ERROR_OK)
+					retval = target_checksum_memory(target,
+							c->base + chunk_offset,
+							chunk_size, &flash_crc);
+				if (retval != ERROR_OK)
+					break;
+
+				if (file_crc == flash_crc) {
+					diff_skipped += chunk_size;
+					run_done += chunk_size;
+					erased_up_to = chunk_offset + chunk_size;
+					progress_add(chunk_image_bytes);
+					continue;
+				}
+			}
+
+			if (run_diff) {
+				/* erase the not yet erased sectors this chunk
+				 * touches; unchanged sectors were stepped over
+				 * above and stay untouched */
+				uint32_t need_end = chunk_offset + chunk_size;
+				int first = -1, last = -1;
+
+				for (i = 0; i < c->num_sectors; i++) {
+					uint32_t s_off = c->sectors[i].offset;
+					uint32_t s_end = s_off + c->sectors[i].size;
+					if (s_end <= erased_up_to || s_off >= need_end)
+						continue;
+					if (first < 0)
+						first = i;
+					last = i;
+				}
+				if (first >= 0) {
+					retval = flash_driver_erase(c, first, last);
+					if (retval != ERROR_OK)
+						break;
+					erased_up_to = c->sectors[last].offset
+						+ c->sectors[last].size;
+				}
+			}
 
-		if (retval == ERROR_OK) {
 			/* write flash sectors */
-			retval = flash_driver_write(c, buffer, run_address - c->base, run_size);
+			retval = flash_driver_write(c, buffer,
+					chunk_offset, chunk_size);
+			if (retval != ERROR_OK)
+				break;
+
+			run_done += chunk_size;
+			progress_add(chunk_image_bytes);
 		}
 
 		free(buffer);
 
+		if (run_diff && diff_skipped > 0)
+			LOG_INFO("differential write: %" PRIu32 " bytes of %" PRIu32
+				" already matched", diff_skipped, run_size);
+
 		if (retval != ERROR_OK) {
 			/* abort operation */
 			goto done;
@@ -753,6 +1139,7 @@ int flash_write_unlock(struct target *target, struct image *image,
 	}
 
 done:
+	progress_done();
 	free(sections);
 	free(padding);
 
@@ -762,5 +1149,5 @@ done:
 int flash_write(struct target *target, struct image *image,
 	uint32_t *written, int erase)
 {
-	return flash_write_unlock(target, image, written, erase, false);
+	return flash_write_unlock(target, image, written, erase, false, false);
 }
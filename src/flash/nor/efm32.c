@@ -663,23 +663,24 @@ static int efm32x_write_block(struct flash_bank *bank, const uint8_t *buf,
 			0x71, 0x1b, 0x00, 0x00
 	};
 
-	/* flash write code */
-	if (target_alloc_working_area(target, sizeof(efm32x_flash_write_code),
-			&write_algorithm) != ERROR_OK) {
+	/* flash write code; reuses a still-resident copy across calls */
+	ret = target_load_algorithm_image(target, efm32x_flash_write_code,
+			sizeof(efm32x_flash_write_code), &write_algorithm);
+	if (ret == ERROR_TARGET_RESOURCE_NOT_AVAILABLE) {
 		LOG_WARNING("no working area available, can't do block memory writes");
 		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
-	};
-
-	ret = target_write_buffer(target, write_algorithm->address,
-			sizeof(efm32x_flash_write_code), efm32x_flash_write_code);
+	}
 	if (ret != ERROR_OK)
 		return ret;
 
-	/* memory buffer */
+	/* memory buffer; accept even a tiny fifo - the stub polling
+	 * on-target beats one host round trip per word by so much that a
+	 * few dozen words of buffer are still a clear win when other
+	 * working-area users leave little room */
 	while (target_alloc_working_area_try(target, buffer_size, &source) != ERROR_OK) {
 		buffer_size /= 2;
 		buffer_size &= ~3UL; /* Make sure it's 4 byte aligned */
-		if (buffer_size <= 256) {
+		if (buffer_size <= 32) {
 			/* we already allocated the writing code, but failed to get a
 			 * buffer, free the algorithm */
 			target_free_working_area(target, write_algorithm);
@@ -44,8 +44,22 @@ int flash_driver_write(struct flash_bank *bank,
 int flash_driver_read(struct flash_bank *bank,
 		uint8_t *buffer, uint32_t offset, uint32_t count);
 
-/* write (optional verify) an image to flash memory of the given target */
+/* Write (optional verify) an image to flash memory of the given target.
+ * With diff_mode, sectors whose on-target CRC already matches the image
+ * contents are neither erased nor programmed. */
 int flash_write_unlock(struct target *target, struct image *image,
-		uint32_t *written, int erase, bool unlock);
+		uint32_t *written, int erase, bool unlock, bool diff_mode);
+
+/* On-disk probe cache, enabled by "flash probe_cache".  A driver probe
+ * may store a blob describing the interrogated geometry and timing, and
+ * reuse it on later sessions after validating it against a cheap device
+ * ID re-read.  Loading honors the "flash probe -force" bypass. */
+void flash_probe_cache_set_dir(const char *dir);
+void flash_probe_cache_set_bypass(bool bypass);
+bool flash_probe_cache_active(void);
+int flash_probe_cache_load(struct flash_bank *bank, void **payload,
+		uint32_t *payload_size);
+int flash_probe_cache_store(struct flash_bank *bank, const void *payload,
+		uint32_t payload_size);
 
 #endif /* FLASH_NOR_IMP_H */
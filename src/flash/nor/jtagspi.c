@@ -20,6 +20,7 @@
 #include "imp.h"
 #include <jtag/jtag.h>
 #include <flash/nor/spi.h>
+#include <flash/nor/sfdp.h>
 #include <helper/time_support.h>
 
 #define JTAGSPI_MAX_TIMEOUT 3000
@@ -28,6 +29,8 @@
 struct jtagspi_flash_bank {
 	struct jtag_tap *tap;
 	const struct flash_device *dev;
+	/* filled from SFDP when the device is not in the table */
+	struct flash_device dev_desc;
 	int probed;
 	uint32_t ir;
 	uint32_t dr_len;
@@ -79,11 +82,11 @@ static void flip_u8(uint8_t *in, uint8_t *out, int len)
 }
 
 static int jtagspi_cmd(struct flash_bank *bank, uint8_t cmd,
-		uint32_t *addr, uint8_t *data, int len)
+		uint32_t *addr, int dummy, uint8_t *data, int len)
 {
 	struct jtagspi_flash_bank *info = bank->driver_priv;
 	struct scan_field fields[3];
-	uint8_t cmd_buf[4];
+	uint8_t cmd_buf[8];
 	uint8_t *data_buf;
 	int is_read, lenb, n;
 
@@ -96,7 +99,10 @@ static int jtagspi_cmd(struct flash_bank *bank, uint8_t cmd,
 		h_u24_to_be(cmd_buf + 1, *addr);
 		fields[n].num_bits += 24;
 	}
-	flip_u8(cmd_buf, cmd_buf, 4);
+	/* dummy clocks between the address and the data phase */
+	memset(cmd_buf + 4, 0, sizeof(cmd_buf) - 4);
+	fields[n].num_bits += dummy;
+	flip_u8(cmd_buf, cmd_buf, DIV_ROUND_UP(fields[n].num_bits, 8));
 	fields[n].out_value = cmd_buf;
 	fields[n].in_value = NULL;
 	n++;
@@ -137,6 +143,26 @@ static int jtagspi_cmd(struct flash_bank *bank, uint8_t cmd,
 	return ERROR_OK;
 }
 
+static int jtagspi_read_sfdp_block(struct flash_bank *bank, uint32_t addr,
+	uint32_t words, uint32_t *buffer)
+{
+	uint8_t *buf = malloc(words * 4);
+	int retval;
+
+	if (buf == NULL)
+		return ERROR_FAIL;
+
+	/* 8 dummy clocks follow the SFDP address */
+	retval = jtagspi_cmd(bank, SPIFLASH_READ_SFDP, &addr, 8,
+			buf, -(int)(words * 4 * 8));
+	if (retval == ERROR_OK) {
+		for (uint32_t k = 0; k < words; k++)
+			buffer[k] = le_to_h_u32(buf + 4 * k);
+	}
+	free(buf);
+	return retval;
+}
+
 static int jtagspi_probe(struct flash_bank *bank)
 {
 	struct jtagspi_flash_bank *info = bank->driver_priv;
@@ -154,7 +180,7 @@ static int jtagspi_probe(struct flash_bank *bank)
 	}
 	info->tap = bank->target->tap;
 
-	jtagspi_cmd(bank, SPIFLASH_READ_ID, NULL, in_buf, -24);
+	jtagspi_cmd(bank, SPIFLASH_READ_ID, NULL, 0, in_buf, -24);
 	/* the table in spi.c has the manufacturer byte (first) as the lsb */
 	id = le_to_h_u24(in_buf);
 
@@ -166,8 +192,16 @@ static int jtagspi_probe(struct flash_bank *bank)
 		}
 
 	if (!(info->dev)) {
-		LOG_ERROR("Unknown flash device (ID 0x%08" PRIx32 ")", id);
-		return ERROR_FAIL;
+		/* not in the table; perhaps the device describes itself */
+		memset(&info->dev_desc, 0, sizeof(info->dev_desc));
+		if (spi_sfdp(bank, jtagspi_read_sfdp_block,
+				&info->dev_desc) == ERROR_OK) {
+			info->dev_desc.device_id = id;
+			info->dev = &info->dev_desc;
+		} else {
+			LOG_ERROR("Unknown flash device (ID 0x%08" PRIx32 ")", id);
+			return ERROR_FAIL;
+		}
 	}
 
 	LOG_INFO("Found flash device \'%s\' (ID 0x%08" PRIx32 ")",
@@ -200,7 +234,7 @@ static int jtagspi_probe(struct flash_bank *bank)
 static void jtagspi_read_status(struct flash_bank *bank, uint32_t *status)
 {
 	uint8_t buf;
-	jtagspi_cmd(bank, SPIFLASH_READ_STATUS, NULL, &buf, -8);
+	jtagspi_cmd(bank, SPIFLASH_READ_STATUS, NULL, 0, &buf, -8);
 	*status = buf;
 	/* LOG_DEBUG("status=0x%08" PRIx32, *status); */
 }
@@ -229,7 +263,7 @@ static int jtagspi_write_enable(struct flash_bank *bank)
 {
 	uint32_t status;
 
-	jtagspi_cmd(bank, SPIFLASH_WRITE_ENABLE, NULL, NULL, 0);
+	jtagspi_cmd(bank, SPIFLASH_WRITE_ENABLE, NULL, 0, NULL, 0);
 	jtagspi_read_status(bank, &status);
 	if ((status & SPIFLASH_WE_BIT) == 0) {
 		LOG_ERROR("Cannot enable write to flash. Status=0x%08" PRIx32, status);
@@ -247,7 +281,7 @@ static int jtagspi_bulk_erase(struct flash_bank *bank)
 	retval = jtagspi_write_enable(bank);
 	if (retval != ERROR_OK)
 		return retval;
-	jtagspi_cmd(bank, info->dev->chip_erase_cmd, NULL, NULL, 0);
+	jtagspi_cmd(bank, info->dev->chip_erase_cmd, NULL, 0, NULL, 0);
 	retval = jtagspi_wait(bank, bank->num_sectors*JTAGSPI_MAX_TIMEOUT);
 	LOG_INFO("took %lld ms", timeval_ms() - t0);
 	return retval;
@@ -262,7 +296,8 @@ static int jtagspi_sector_erase(struct flash_bank *bank, int sector)
 	retval = jtagspi_write_enable(bank);
 	if (retval != ERROR_OK)
 		return retval;
-	jtagspi_cmd(bank, info->dev->erase_cmd, &bank->sectors[sector].offset, NULL, 0);
+	jtagspi_cmd(bank, info->dev->erase_cmd, &bank->sectors[sector].offset,
+		0, NULL, 0);
 	retval = jtagspi_wait(bank, JTAGSPI_MAX_TIMEOUT);
 	LOG_INFO("sector %d took %lld ms", sector, timeval_ms() - t0);
 	return retval;
@@ -342,18 +377,20 @@ static int jtagspi_read(struct flash_bank *bank, uint8_t *buffer, uint32_t offse
 		return ERROR_FLASH_BANK_NOT_PROBED;
 	}
 
-	jtagspi_cmd(bank, SPIFLASH_READ, &offset, buffer, -count*8);
+	jtagspi_cmd(bank, info->dev->read_cmd, &offset, info->dev->read_dummy,
+		buffer, -count*8);
 	return ERROR_OK;
 }
 
 static int jtagspi_page_write(struct flash_bank *bank, const uint8_t *buffer, uint32_t offset, uint32_t count)
 {
+	struct jtagspi_flash_bank *info = bank->driver_priv;
 	int retval;
 
 	retval = jtagspi_write_enable(bank);
 	if (retval != ERROR_OK)
 		return retval;
-	jtagspi_cmd(bank, SPIFLASH_PAGE_PROGRAM, &offset, (uint8_t *) buffer, count*8);
+	jtagspi_cmd(bank, info->dev->pprog_cmd, &offset, 0, (uint8_t *) buffer, count*8);
 	return jtagspi_wait(bank, JTAGSPI_MAX_TIMEOUT);
 }
 
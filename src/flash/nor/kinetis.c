@@ -106,6 +106,7 @@
 #define FTFx_CMD_BLOCKSTAT  0x00
 #define FTFx_CMD_SECTSTAT   0x01
 #define FTFx_CMD_LWORDPROG  0x06
+#define FTFx_CMD_BLOCKERASE 0x08
 #define FTFx_CMD_SECTERASE  0x09
 #define FTFx_CMD_SECTWRITE  0x0b
 #define FTFx_CMD_MASSERASE  0x44
@@ -650,67 +651,81 @@ COMMAND_HANDLER(kinetis_disable_wdog_handler)
 }
 
 
-/* Kinetis Program-LongWord Microcodes */
+/* Kinetis Program-LongWord Microcode
+ *
+ * FIFO kernel for target_run_flash_async_algorithm(): longwords stream
+ * into the circular buffer while the FTFx is busy, so the command
+ * sequencing overlaps the USB/JTAG transfer instead of costing a full
+ * host round trip per longword.  Thumb-1 only; runs on KL parts too.
+ *
+ * Params:
+ * r0 - FTFx_FSTAT address (in), final FSTAT value (out)
+ * r1 - longword count
+ * r2 - workarea start
+ * r3 - workarea end
+ * r4 - target address
+ * Clobbered:
+ * r5 - rp
+ * r6 - tmp
+ * r7 - tmp
+ */
 static const uint8_t kinetis_flash_write_code[] = {
-	/* Params:
-	 * r0 - workarea buffer
-	* r1 - target address
-	* r2 - wordcount
-	* Clobbered:
-	* r4 - tmp
-	* r5 - tmp
-	* r6 - tmp
-	* r7 - tmp
-	*/
-
-							/* .L1: */
-						/* for(register uint32_t i=0;i<wcount;i++){ */
-	0x04, 0x1C,					/* mov    r4, r0          */
-	0x00, 0x23,					/* mov    r3, #0          */
-							/* .L2: */
-	0x0E, 0x1A,					/* sub    r6, r1, r0      */
-	0xA6, 0x19,					/* add    r6, r4, r6      */
-	0x93, 0x42,					/* cmp    r3, r2          */
-	0x16, 0xD0,					/* beq    .L9             */
-							/* .L5: */
-						/* while((FTFx_FSTAT&FTFA_FSTAT_CCIF_MASK) != FTFA_FSTAT_CCIF_MASK){}; */
-	0x0B, 0x4D,					/* ldr    r5, .L10        */
-	0x2F, 0x78,					/* ldrb   r7, [r5]        */
-	0x7F, 0xB2,					/* sxtb   r7, r7          */
-	0x00, 0x2F,					/* cmp    r7, #0          */
-	0xFA, 0xDA,					/* bge    .L5             */
-						/* FTFx_FSTAT = FTFA_FSTAT_ACCERR_MASK|FTFA_FSTAT_FPVIOL_MASK|FTFA_FSTAT_RDCO */
-	0x70, 0x27,					/* mov    r7, #112        */
-	0x2F, 0x70,					/* strb   r7, [r5]        */
-						/* FTFx_FCCOB3 = faddr; */
-	0x09, 0x4F,					/* ldr    r7, .L10+4      */
-	0x3E, 0x60,					/* str    r6, [r7]        */
-	0x06, 0x27,					/* mov    r7, #6          */
-						/* FTFx_FCCOB0 = 0x06;  */
-	0x08, 0x4E,					/* ldr    r6, .L10+8      */
-	0x37, 0x70,					/* strb   r7, [r6]        */
-						/* FTFx_FCCOB7 = *pLW;  */
-	0x80, 0xCC,					/* ldmia  r4!, {r7}       */
-	0x08, 0x4E,					/* ldr    r6, .L10+12     */
-	0x37, 0x60,					/* str    r7, [r6]        */
-						/* FTFx_FSTAT = FTFA_FSTAT_CCIF_MASK; */
-	0x80, 0x27,					/* mov    r7, #128        */
-	0x2F, 0x70,					/* strb   r7, [r5]        */
-							/* .L4: */
-						/* while((FTFx_FSTAT&FTFA_FSTAT_CCIF_MASK) != FTFA_FSTAT_CCIF_MASK){}; */
-	0x2E, 0x78,					/* ldrb    r6, [r5]       */
-	0x77, 0xB2,					/* sxtb    r7, r6         */
-	0x00, 0x2F,					/* cmp     r7, #0         */
-	0xFB, 0xDA,					/* bge     .L4            */
-	0x01, 0x33,					/* add     r3, r3, #1     */
-	0xE4, 0xE7,					/* b       .L2            */
-							/* .L9: */
-	0x00, 0xBE,					/* bkpt #0                */
-							/* .L10: */
-	0x00, 0x00, 0x02, 0x40,		/* .word    1073872896    */
-	0x04, 0x00, 0x02, 0x40,		/* .word    1073872900    */
-	0x07, 0x00, 0x02, 0x40,		/* .word    1073872903    */
-	0x08, 0x00, 0x02, 0x40,		/* .word    1073872904    */
+	/* wait_fifo: */
+		0x16, 0x68,		/* ldr    r6, [r2, #0]    */
+		0x00, 0x2E,		/* cmp    r6, #0          */
+		0x22, 0xD0,		/* beq    exit            */
+		0x55, 0x68,		/* ldr    r5, [r2, #4]    */
+		0xB5, 0x42,		/* cmp    r5, r6          */
+		0xF9, 0xD0,		/* beq    wait_fifo       */
+	/* busy: */
+				/* wait for the previous command; its error
+				 * flags are valid once CCIF sets */
+		0x06, 0x78,		/* ldrb   r6, [r0, #0]    */
+		0x76, 0xB2,		/* sxtb   r6, r6          */
+		0x00, 0x2E,		/* cmp    r6, #0          */
+		0xFB, 0xDA,		/* bge    busy            */
+		0x70, 0x27,		/* movs   r7, #0x70       */
+		0x3E, 0x42,		/* tst    r6, r7          */
+		0x16, 0xD1,		/* bne    error           */
+				/* FCCOB3..0 = faddr | FTFx_CMD_LWORDPROG<<24 */
+		0x0E, 0x4F,		/* ldr    r7, .L_cmd      */
+		0x27, 0x43,		/* orrs   r7, r4          */
+		0x47, 0x60,		/* str    r7, [r0, #4]    */
+				/* FCCOB7..4 = *rp */
+		0x2E, 0x68,		/* ldr    r6, [r5, #0]    */
+		0x86, 0x60,		/* str    r6, [r0, #8]    */
+				/* FSTAT = CCIF launches the command */
+		0x80, 0x26,		/* movs   r6, #0x80       */
+		0x06, 0x70,		/* strb   r6, [r0, #0]    */
+		0x04, 0x35,		/* adds   r5, #4          */
+		0x04, 0x34,		/* adds   r4, #4          */
+		0x9D, 0x42,		/* cmp    r5, r3          */
+		0x01, 0xD3,		/* bcc    no_wrap         */
+		0x15, 0x46,		/* mov    r5, r2          */
+		0x08, 0x35,		/* adds   r5, #8          */
+	/* no_wrap: */
+		0x55, 0x60,		/* str    r5, [r2, #4]    */
+		0x01, 0x39,		/* subs   r1, r1, #1      */
+		0x00, 0x29,		/* cmp    r1, #0          */
+		0x00, 0xD0,		/* beq    last            */
+		0xE0, 0xE7,		/* b      wait_fifo       */
+	/* last: */
+				/* wait for the final command to finish */
+		0x06, 0x78,		/* ldrb   r6, [r0, #0]    */
+		0x76, 0xB2,		/* sxtb   r6, r6          */
+		0x00, 0x2E,		/* cmp    r6, #0          */
+		0xFB, 0xDA,		/* bge    last            */
+		0x01, 0xE0,		/* b      exit            */
+	/* error: */
+		0x00, 0x26,		/* movs   r6, #0          */
+		0x56, 0x60,		/* str    r6, [r2, #4]    */
+	/* exit: */
+		0x06, 0x78,		/* ldrb   r6, [r0, #0]    */
+		0x30, 0x46,		/* mov    r0, r6          */
+		0x00, 0xBE,		/* bkpt   #0              */
+		0xC0, 0x46,		/* nop    (align)         */
+	/* .L_cmd: */
+		0x00, 0x00, 0x00, 0x06,	/* .word  FTFx_CMD_LWORDPROG<<24 */
 };
 
 /* Program LongWord Block Write */
@@ -723,21 +738,11 @@ static int kinetis_write_block(struct flash_bank *bank, const uint8_t *buffer,
 	struct working_area *source;
 	struct kinetis_flash_bank *kinfo = bank->driver_priv;
 	uint32_t address = kinfo->prog_base + offset;
-	struct reg_param reg_params[3];
+	struct reg_param reg_params[5];
 	struct armv7m_algorithm armv7m_info;
+	uint8_t fstat_clear = 0x70;
 	int retval = ERROR_OK;
 
-	/* Params:
-	 * r0 - workarea buffer
-	 * r1 - target address
-	 * r2 - wordcount
-	 * Clobbered:
-	 * r4 - tmp
-	 * r5 - tmp
-	 * r6 - tmp
-	 * r7 - tmp
-	 */
-
 	/* Increase buffer_size if needed */
 	if (buffer_size < (target->working_area_size/2))
 		buffer_size = (target->working_area_size/2);
@@ -751,19 +756,17 @@ static int kinetis_write_block(struct flash_bank *bank, const uint8_t *buffer,
 	}
 
 	/* allocate working area with flash programming code */
-	if (target_alloc_working_area(target, sizeof(kinetis_flash_write_code),
-			&write_algorithm) != ERROR_OK) {
+	retval = target_load_algorithm_image(target, kinetis_flash_write_code,
+			sizeof(kinetis_flash_write_code), &write_algorithm);
+	if (retval == ERROR_TARGET_RESOURCE_NOT_AVAILABLE) {
 		LOG_WARNING("no working area available, can't do block memory writes");
 		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
 	}
-
-	retval = target_write_buffer(target, write_algorithm->address,
-		sizeof(kinetis_flash_write_code), kinetis_flash_write_code);
 	if (retval != ERROR_OK)
 		return retval;
 
 	/* memory buffer */
-	while (target_alloc_working_area(target, buffer_size, &source) != ERROR_OK) {
+	while (target_alloc_working_area_try(target, buffer_size, &source) != ERROR_OK) {
 		buffer_size /= 4;
 		if (buffer_size <= 256) {
 			/* free working area, write algorithm already allocated */
@@ -774,37 +777,56 @@ static int kinetis_write_block(struct flash_bank *bank, const uint8_t *buffer,
 		}
 	}
 
+	/* clear stale ACCERR/FPVIOL/RDCOLERR; the kernel treats any of them
+	 * as a command failure and aborts */
+	retval = target_write_memory(target, FTFx_FSTAT, 1, 1, &fstat_clear);
+	if (retval != ERROR_OK) {
+		target_free_working_area(target, source);
+		target_free_working_area(target, write_algorithm);
+		return retval;
+	}
+
 	armv7m_info.common_magic = ARMV7M_COMMON_MAGIC;
 	armv7m_info.core_mode = ARM_MODE_THREAD;
 
-	init_reg_param(&reg_params[0], "r0", 32, PARAM_OUT); /* *pLW (*buffer) */
-	init_reg_param(&reg_params[1], "r1", 32, PARAM_OUT); /* faddr */
-	init_reg_param(&reg_params[2], "r2", 32, PARAM_OUT); /* number of words to program */
-
-	/* write code buffer and use Flash programming code within kinetis       */
-	/* Set breakpoint to 0 with time-out of 1000 ms                          */
-	while (wcount > 0) {
-		uint32_t thisrun_count = (wcount > (buffer_size / 4)) ? (buffer_size / 4) : wcount;
-
-		retval = target_write_buffer(target, source->address, thisrun_count * 4, buffer);
-		if (retval != ERROR_OK)
-			break;
-
-		buf_set_u32(reg_params[0].value, 0, 32, source->address);
-		buf_set_u32(reg_params[1].value, 0, 32, address);
-		buf_set_u32(reg_params[2].value, 0, 32, thisrun_count);
-
-		retval = target_run_algorithm(target, 0, NULL, 3, reg_params,
-				write_algorithm->address, 0, 100000, &armv7m_info);
-		if (retval != ERROR_OK) {
-			LOG_ERROR("Error executing kinetis Flash programming algorithm");
+	init_reg_param(&reg_params[0], "r0", 32, PARAM_IN_OUT);	/* FTFx_FSTAT (in), status (out) */
+	init_reg_param(&reg_params[1], "r1", 32, PARAM_OUT);	/* longword count */
+	init_reg_param(&reg_params[2], "r2", 32, PARAM_OUT);	/* buffer start */
+	init_reg_param(&reg_params[3], "r3", 32, PARAM_OUT);	/* buffer end */
+	init_reg_param(&reg_params[4], "r4", 32, PARAM_IN_OUT);	/* target address */
+
+	buf_set_u32(reg_params[0].value, 0, 32, FTFx_FSTAT);
+	buf_set_u32(reg_params[1].value, 0, 32, wcount);
+	buf_set_u32(reg_params[2].value, 0, 32, source->address);
+	buf_set_u32(reg_params[3].value, 0, 32, source->address + source->size);
+	buf_set_u32(reg_params[4].value, 0, 32, address);
+
+	retval = target_run_flash_async_algorithm(target, buffer, wcount, 4,
+			0, NULL,
+			5, reg_params,
+			source->address, source->size,
+			write_algorithm->address, 0,
+			&armv7m_info);
+
+	if (retval == ERROR_FLASH_OPERATION_FAILED) {
+		uint8_t fstat = buf_get_u32(reg_params[0].value, 0, 32);
+
+		LOG_ERROR("flash write failed at address 0x%"PRIx32", FSTAT: %02X",
+				buf_get_u32(reg_params[4].value, 0, 32), fstat);
+
+		if (fstat & 0x10)
+			LOG_ERROR("flash memory write protected");
+		if (fstat & 0x20)
+			LOG_ERROR("flash memory not erased before writing or access error");
+	} else if (retval == ERROR_OK) {
+		uint8_t fstat = buf_get_u32(reg_params[0].value, 0, 32);
+
+		/* the kernel only checks a command's error flags before
+		 * launching the next one; check the final command here */
+		if ((fstat & 0xf0) != 0x80) {
+			LOG_ERROR("ftfx command failed FSTAT: %02X", fstat);
 			retval = ERROR_FLASH_OPERATION_FAILED;
-			break;
 		}
-
-		buffer += thisrun_count * 4;
-		address += thisrun_count * 4;
-		wcount -= thisrun_count;
 	}
 
 	target_free_working_area(target, source);
@@ -813,6 +835,8 @@ static int kinetis_write_block(struct flash_bank *bank, const uint8_t *buffer,
 	destroy_reg_param(&reg_params[0]);
 	destroy_reg_param(&reg_params[1]);
 	destroy_reg_param(&reg_params[2]);
+	destroy_reg_param(&reg_params[3]);
+	destroy_reg_param(&reg_params[4]);
 
 	return retval;
 }
@@ -1024,11 +1048,29 @@ static int kinetis_erase(struct flash_bank *bank, int first, int last)
 	if ((first > bank->num_sectors) || (last > bank->num_sectors))
 		return ERROR_FLASH_OPERATION_FAILED;
 
-	/*
-	 * FIXME: TODO: use the 'Erase Flash Block' command if the
-	 * requested erase is PFlash or NVM and encompasses the entire
-	 * block.  Should be quicker.
-	 */
+	/* If the requested range covers the entire block, a single 'Erase
+	 * Flash Block' command replaces one command/status round trip per
+	 * sector.  Not valid for FlexNVM partitioned for EEPROM backup,
+	 * but such a bank rejects the erase with FPVIOL and we fall back. */
+	if (first == 0 && last == bank->num_sectors - 1) {
+		uint8_t ftfx_fstat;
+
+		result = kinetis_ftfx_command(bank->target, FTFx_CMD_BLOCKERASE, kinfo->prog_base,
+				0, 0, 0, 0,  0, 0, 0, 0,  &ftfx_fstat);
+
+		if (result == ERROR_OK) {
+			for (i = first; i <= last; i++)
+				bank->sectors[i].is_erased = 1;
+
+			kinetis_invalidate_flash_cache(bank);
+			LOG_WARNING
+				("flash configuration field erased, please reset the device");
+			return ERROR_OK;
+		}
+
+		LOG_DEBUG("block erase failed, falling back to sector erase");
+	}
+
 	for (i = first; i <= last; i++) {
 		uint8_t ftfx_fstat;
 		/* set command and sector address */
@@ -823,9 +823,11 @@ static int nrf51_ll_flash_write(struct nrf51_info *chip, uint32_t offset, const
 	LOG_DEBUG("Writing buffer to flash offset=0x%"PRIx32" bytes=0x%"PRIx32, offset, bytes);
 	assert(bytes % 4 == 0);
 
-	/* allocate working area with flash programming code */
-	if (target_alloc_working_area(target, sizeof(nrf51_flash_write_code),
-			&write_algorithm) != ERROR_OK) {
+	/* flash programming code; a copy still resident from the previous
+	 * region's write (code then UICR) skips the download */
+	retval = target_load_algorithm_image(target, nrf51_flash_write_code,
+			sizeof(nrf51_flash_write_code), &write_algorithm);
+	if (retval == ERROR_TARGET_RESOURCE_NOT_AVAILABLE) {
 		LOG_WARNING("no working area available, falling back to slow memory writes");
 
 		for (; bytes > 0; bytes -= 4) {
@@ -843,19 +845,15 @@ static int nrf51_ll_flash_write(struct nrf51_info *chip, uint32_t offset, const
 
 		return ERROR_OK;
 	}
+	if (retval != ERROR_OK)
+		return retval;
 
 	LOG_WARNING("using fast async flash loader. This is currently supported");
 	LOG_WARNING("only with ST-Link and CMSIS-DAP. If you have issues, add");
 	LOG_WARNING("\"set WORKAREASIZE 0\" before sourcing nrf51.cfg to disable it");
 
-	retval = target_write_buffer(target, write_algorithm->address,
-				sizeof(nrf51_flash_write_code),
-				nrf51_flash_write_code);
-	if (retval != ERROR_OK)
-		return retval;
-
 	/* memory buffer */
-	while (target_alloc_working_area(target, buffer_size, &source) != ERROR_OK) {
+	while (target_alloc_working_area_try(target, buffer_size, &source) != ERROR_OK) {
 		buffer_size /= 2;
 		buffer_size &= ~3UL; /* Make sure it's 4 byte aligned */
 		if (buffer_size <= 256) {
@@ -425,13 +425,6 @@ static int pic32mx_write_block(struct flash_bank *bank, const uint8_t *buffer,
 	struct pic32mx_flash_bank *pic32mx_info = bank->driver_priv;
 	struct mips32_algorithm mips32_info;
 
-	/* flash write code */
-	if (target_alloc_working_area(target, sizeof(pic32mx_flash_write_code),
-			&write_algorithm) != ERROR_OK) {
-		LOG_WARNING("no working area available, can't do block memory writes");
-		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
-	};
-
 	/* Change values for counters and row size, depending on variant */
 	if (pic32mx_info->dev_type == MX_1_2) {
 		/* 128 byte row */
@@ -449,10 +442,17 @@ static int pic32mx_write_block(struct flash_bank *bank, const uint8_t *buffer,
 		row_size = 512;
 	}
 
+	/* flash write code; a still-resident copy from a previous section's
+	 * write skips the download */
 	uint8_t code[sizeof(pic32mx_flash_write_code)];
 	target_buffer_set_u32_array(target, code, ARRAY_SIZE(pic32mx_flash_write_code),
 			pic32mx_flash_write_code);
-	retval = target_write_buffer(target, write_algorithm->address, sizeof(code), code);
+	retval = target_load_algorithm_image(target, code, sizeof(code),
+			&write_algorithm);
+	if (retval == ERROR_TARGET_RESOURCE_NOT_AVAILABLE) {
+		LOG_WARNING("no working area available, can't do block memory writes");
+		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+	}
 	if (retval != ERROR_OK)
 		return retval;
 
@@ -489,6 +489,10 @@ static int pic32mx_write_block(struct flash_bank *bank, const uint8_t *buffer,
 	} else
 		row_offset = 0;
 
+	/* Each chunk is two host interactions: the buffer upload goes out
+	 * through the EJTAG fastdata channel (mips_m4k routes word writes
+	 * of this size through mips32_pracc_fastdata_xfer), then one
+	 * algorithm run programs it row by row on-target. */
 	while (count > 0) {
 		uint32_t status;
 		uint32_t thisrun_count;
@@ -0,0 +1,159 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by George Harris                                   *
+ *   george@luminairecoffee.com                                            *
+ *                                                                         *
+ *   Copyright (C) 2010 by Antonio Borneo                                  *
+ *   borneo.antonio@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.           *
+ ***************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "imp.h"
+#include "spi.h"
+#include "sfdp.h"
+
+#define SFDP_MAGIC			0x50444653	/* "SFDP" in little endian */
+#define SFDP_BASIC_ID_LSB	0x00		/* basic flash parameter table */
+#define SFDP_BASIC_ID_MSB	0xFF
+#define SFDP_MAX_BFPT_DWORDS	16
+
+/* decode one erase type from the basic table: low byte is the size as a
+ * power of two, high byte the opcode; 0 means the type is unused */
+static void sfdp_erase_type(uint16_t field, uint32_t *size, uint8_t *cmd)
+{
+	uint8_t exp = field & 0xFF;
+
+	if (exp == 0 || exp > 31) {
+		*size = 0;
+		*cmd = 0;
+	} else {
+		*size = 1UL << exp;
+		*cmd = field >> 8;
+	}
+}
+
+int spi_sfdp(struct flash_bank *bank, sfdp_read_fn read_sfdp_block,
+	struct flash_device *dev)
+{
+	uint32_t header[2];
+	uint32_t param[2];
+	uint32_t bfpt[SFDP_MAX_BFPT_DWORDS];
+	uint32_t nph, ptr, erase_size;
+	uint8_t len, erase_cmd;
+	int retval;
+
+	retval = read_sfdp_block(bank, 0, 2, header);
+	if (retval != ERROR_OK)
+		return retval;
+	if (header[0] != SFDP_MAGIC) {
+		LOG_DEBUG("no SFDP signature (read 0x%08" PRIx32 ")", header[0]);
+		return ERROR_FLASH_BANK_NOT_PROBED;
+	}
+
+	/* walk the parameter headers looking for the basic table */
+	nph = ((header[1] >> 16) & 0xFF) + 1;
+	ptr = 0;
+	len = 0;
+	for (uint32_t k = 0; k < nph; k++) {
+		retval = read_sfdp_block(bank, 8 + 8 * k, 2, param);
+		if (retval != ERROR_OK)
+			return retval;
+		if ((param[0] & 0xFF) == SFDP_BASIC_ID_LSB
+				&& (nph == 1 || (param[1] >> 24) == SFDP_BASIC_ID_MSB
+					|| (param[1] >> 24) == 0)) {
+			len = (param[0] >> 24) & 0xFF;
+			ptr = param[1] & 0xFFFFFF;
+			break;
+		}
+	}
+	if (len < 9 || (ptr & 3)) {
+		LOG_DEBUG("no usable SFDP basic flash parameter table");
+		return ERROR_FLASH_BANK_NOT_PROBED;
+	}
+	if (len > SFDP_MAX_BFPT_DWORDS)
+		len = SFDP_MAX_BFPT_DWORDS;
+
+	retval = read_sfdp_block(bank, ptr, len, bfpt);
+	if (retval != ERROR_OK)
+		return retval;
+
+	/* density, in bits: either n-1 directly or, with the top bit set,
+	 * a power of two for devices of 4 Gbit and up */
+	if (bfpt[1] & 0x80000000) {
+		uint32_t exp = bfpt[1] & 0x7FFFFFFF;
+		if (exp < 13 || exp > 34) {
+			LOG_DEBUG("SFDP density out of range");
+			return ERROR_FLASH_BANK_NOT_PROBED;
+		}
+		dev->size_in_bytes = 1UL << (exp - 3);
+	} else
+		dev->size_in_bytes = (bfpt[1] + 1) >> 3;
+
+	/* pick the largest of the (up to four) erase types as the sector;
+	 * larger blocks erase far faster per byte */
+	dev->sectorsize = 0;
+	for (int k = 0; k < 4; k++) {
+		sfdp_erase_type((bfpt[7 + k / 2] >> (16 * (k & 1))) & 0xFFFF,
+			&erase_size, &erase_cmd);
+		if (erase_size > dev->sectorsize
+				&& erase_size <= dev->size_in_bytes) {
+			dev->sectorsize = erase_size;
+			dev->erase_cmd = erase_cmd;
+		}
+	}
+	if (dev->sectorsize == 0) {
+		LOG_DEBUG("SFDP table lists no usable erase type");
+		return ERROR_FLASH_BANK_NOT_PROBED;
+	}
+
+	/* not in SFDP; 0xC7 is universally implemented */
+	dev->chip_erase_cmd = 0xC7;
+
+	/* page size appears with JESD216A, default to 256 before that */
+	if (len >= 11)
+		dev->pagesize = 1UL << ((bfpt[10] >> 4) & 0xF);
+	else
+		dev->pagesize = 256;
+	dev->pprog_cmd = SPIFLASH_PAGE_PROGRAM;
+
+	/* every SFDP device implements 1-1-1 fast read with 8 dummies */
+	dev->read_cmd = SPIFLASH_FAST_READ;
+	dev->read_dummy = 8;
+
+	/* 1-1-4 fast read, for controllers able to drive it */
+	if (bfpt[0] & (1 << 22)) {
+		dev->qread_cmd = (bfpt[2] >> 24) & 0xFF;
+		dev->qread_dummy = ((bfpt[2] >> 16) & 0x1F)
+			+ ((bfpt[2] >> 21) & 0x7);
+	} else {
+		dev->qread_cmd = 0;
+		dev->qread_dummy = 0;
+	}
+
+	dev->name = "SFDP flash";
+
+	LOG_DEBUG("SFDP: size %lu bytes, %lu byte sectors (erase 0x%02x), "
+		"page %" PRIu32 ", read 0x%02x/%u, qread 0x%02x/%u",
+		dev->size_in_bytes, dev->sectorsize, dev->erase_cmd,
+		dev->pagesize, dev->read_cmd, dev->read_dummy,
+		dev->qread_cmd, dev->qread_dummy);
+
+	return ERROR_OK;
+}
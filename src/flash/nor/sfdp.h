@@ -0,0 +1,44 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by George Harris                                   *
+ *   george@luminairecoffee.com                                            *
+ *                                                                         *
+ *   Copyright (C) 2010 by Antonio Borneo                                  *
+ *   borneo.antonio@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ ***************************************************************************/
+
+#ifndef SFDP_H
+#define SFDP_H
+
+/* per JESD216 'Serial Flash Discoverable Parameters' */
+
+/** Read a block of 32 bit words from the SFDP address space of a device.
+ * The data is returned in host byte order, i.e. the implementation has to
+ * convert the little-endian SFDP stream.
+ *
+ * @param bank Flash bank to read from.
+ * @param addr Byte address in SFDP space, 32 bit aligned.
+ * @param words Number of 32 bit words to read.
+ * @param buffer Receives the words.
+ */
+typedef int (*sfdp_read_fn)(struct flash_bank *bank, uint32_t addr,
+	uint32_t words, uint32_t *buffer);
+
+/** Probe a device via its SFDP tables and fill in @a dev from the basic
+ * flash parameter table: size, sector/erase geometry, page size and the
+ * fast read opcodes the device supports.  @a dev is left untouched when
+ * the device does not implement SFDP.
+ */
+int spi_sfdp(struct flash_bank *bank, sfdp_read_fn read_sfdp_block,
+	struct flash_device *dev);
+
+#endif /* SFDP_H */
@@ -24,6 +24,11 @@
 /* data structure to maintain flash ids from different vendors */
 struct flash_device {
 	char *name;
+	uint8_t read_cmd;
+	uint8_t read_dummy;	/* dummy clocks following the read address */
+	uint8_t qread_cmd;	/* 1-1-4 fast read opcode, 0 if not available */
+	uint8_t qread_dummy;	/* dummy plus mode clocks for qread_cmd */
+	uint8_t pprog_cmd;
 	uint8_t erase_cmd;
 	uint8_t chip_erase_cmd;
 	uint32_t device_id;
@@ -32,9 +37,16 @@ struct flash_device {
 	unsigned long size_in_bytes;
 };
 
+/* Table entries keep the universally supported commands; faster read
+ * opcodes are filled in when the device reports them via SFDP. */
 #define FLASH_ID(n, es, ces, id, psize, ssize, size) \
 {	                        \
 	.name = n,              \
+	.read_cmd = SPIFLASH_READ, \
+	.read_dummy = 0,        \
+	.qread_cmd = 0,         \
+	.qread_dummy = 0,       \
+	.pprog_cmd = SPIFLASH_PAGE_PROGRAM, \
 	.erase_cmd = es,        \
 	.chip_erase_cmd = ces,  \
 	.device_id = id,        \
@@ -56,3 +68,4 @@ extern const struct flash_device flash_devices[];
 #define SPIFLASH_PAGE_PROGRAM	0x02 /* Page Program */
 #define SPIFLASH_FAST_READ		0x0B /* Fast Read */
 #define SPIFLASH_READ			0x03 /* Normal Read */
+#define SPIFLASH_READ_SFDP		0x5A /* Read SFDP (JESD216) */
@@ -498,7 +498,7 @@ static int stm32x_write_block(struct flash_bank *bank, const uint8_t *buffer,
 		uint32_t offset, uint32_t count)
 {
 	struct target *target = bank->target;
-	uint32_t buffer_size = 16384;
+	uint32_t buffer_size;
 	struct working_area *write_algorithm;
 	struct working_area *source;
 	uint32_t address = bank->base + offset;
@@ -559,7 +559,14 @@ static int stm32x_write_block(struct flash_bank *bank, const uint8_t *buffer,
 	if (retval != ERROR_OK)
 		return retval;
 
-	/* memory buffer */
+	/* memory buffer, sized from the free working area; a deeper FIFO
+	 * lets the wire transfer overlap more of the programming time */
+	buffer_size = target_get_working_area_avail(target);
+	if (buffer_size > count * 2 + 8)
+		buffer_size = count * 2 + 8;	/* data plus FIFO pointers */
+	buffer_size &= ~3;
+	if (buffer_size < 256)
+		buffer_size = 256;
 	while (target_alloc_working_area_try(target, buffer_size, &source) != ERROR_OK) {
 		buffer_size /= 2;
 		if (buffer_size <= 256) {
@@ -73,12 +73,17 @@
 		return __r;					\
 }
 
-#define SMI_SET_SW_MODE()	SMI_WRITE_REG(SMI_CR1, \
-	SMI_READ_REG(SMI_CR1) | SMI_SW_MODE)
-#define SMI_SET_HWWB_MODE() SMI_WRITE_REG(SMI_CR1, \
-	(SMI_READ_REG(SMI_CR1) | SMI_WB_MODE) & ~SMI_SW_MODE)
-#define SMI_SET_HW_MODE()	SMI_WRITE_REG(SMI_CR1, \
-	SMI_READ_REG(SMI_CR1) & ~(SMI_SW_MODE | SMI_WB_MODE))
+/* The mode bits share SMI_CR1 with static configuration (prescalers)
+ * set up by the board init code.  Mode switches happen several times
+ * per programmed page, so instead of a read-modify-write over the wire
+ * each time, the constant part is captured once per top level
+ * operation with SMI_READ_CR1() and a switch only costs the write. */
+#define SMI_READ_CR1()		(stmsmi_info->saved_cr1 = SMI_READ_REG(SMI_CR1))
+#define SMI_SET_MODE(mode)	SMI_WRITE_REG(SMI_CR1, \
+	(stmsmi_info->saved_cr1 & ~(SMI_SW_MODE | SMI_WB_MODE)) | (mode))
+#define SMI_SET_SW_MODE()	SMI_SET_MODE(SMI_SW_MODE)
+#define SMI_SET_HWWB_MODE()	SMI_SET_MODE(SMI_WB_MODE)
+#define SMI_SET_HW_MODE()	SMI_SET_MODE(0)
 #define SMI_CLEAR_TFF()		SMI_WRITE_REG(SMI_SR, ~SMI_TFF)
 
 #define SMI_BANK_SIZE      (0x01000000)
@@ -120,6 +125,7 @@ struct stmsmi_flash_bank {
 	int probed;
 	uint32_t io_base;
 	uint32_t bank_num;
+	uint32_t saved_cr1;	/* see SMI_READ_CR1() */
 	const struct flash_device *dev;
 };
 
@@ -350,6 +356,8 @@ static int stmsmi_erase(struct flash_bank *bank, int first, int last)
 		}
 	}
 
+	SMI_READ_CR1();
+
 	for (sector = first; sector <= last; sector++) {
 		retval = smi_erase_sector(bank, sector);
 		if (retval != ERROR_OK)
@@ -433,6 +441,8 @@ static int stmsmi_write(struct flash_bank *bank, const uint8_t *buffer,
 		}
 	}
 
+	SMI_READ_CR1();
+
 	page_size = stmsmi_info->dev->pagesize;
 
 	/* unaligned buffer head */
@@ -500,6 +510,8 @@ static int read_flash_id(struct flash_bank *bank, uint32_t *id)
 	if (retval != ERROR_OK)
 		return retval;
 
+	SMI_READ_CR1();
+
 	/* enter in SW mode */
 	SMI_SET_SW_MODE();
 
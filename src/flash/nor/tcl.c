@@ -137,23 +137,45 @@ COMMAND_HANDLER(handle_flash_probe_command)
 {
 	struct flash_bank *p;
 	int retval;
+	unsigned name_index = 0;
+	bool force = false;
 
-	if (CMD_ARGC != 1)
+	if (CMD_ARGC >= 1 && strcmp(CMD_ARGV[0], "-force") == 0) {
+		force = true;
+		name_index = 1;
+	}
+
+	if (CMD_ARGC != name_index + 1)
 		return ERROR_COMMAND_SYNTAX_ERROR;
 
-	retval = CALL_COMMAND_HANDLER(flash_command_get_bank_maybe_probe, 0, &p, false);
+	retval = CALL_COMMAND_HANDLER(flash_command_get_bank_maybe_probe,
+			name_index, &p, false);
 	if (retval != ERROR_OK)
 		return retval;
 
 	if (p) {
+		/* -force makes the driver interrogate the device even when a
+		 * probe cache entry exists, refreshing the entry */
+		if (force)
+			flash_probe_cache_set_bypass(true);
 		retval = p->driver->probe(p);
-		if (retval == ERROR_OK)
+		if (force)
+			flash_probe_cache_set_bypass(false);
+		if (retval == ERROR_OK) {
 			command_print(CMD_CTX,
 				"flash '%s' found at 0x%8.8" PRIx32,
 				p->driver->name,
 				p->base);
+
+			/* reprobing may have changed the sector layout
+			 * reported to gdb */
+			free(p->target->memory_map);
+			p->target->memory_map = NULL;
+			p->target->memory_map_length = 0;
+		}
 	} else {
-		command_print(CMD_CTX, "flash bank '#%s' is out of bounds", CMD_ARGV[0]);
+		command_print(CMD_CTX, "flash bank '#%s' is out of bounds",
+			CMD_ARGV[name_index]);
 		retval = ERROR_FAIL;
 	}
 
@@ -372,6 +394,7 @@ COMMAND_HANDLER(handle_flash_write_image_command)
 	/* flash auto-erase is disabled by default*/
 	int auto_erase = 0;
 	bool auto_unlock = false;
+	bool diff_mode = false;
 
 	while (CMD_ARGC) {
 		if (strcmp(CMD_ARGV[0], "erase") == 0) {
@@ -384,6 +407,14 @@ COMMAND_HANDLER(handle_flash_write_image_command)
 			CMD_ARGV++;
 			CMD_ARGC--;
 			command_print(CMD_CTX, "auto unlock enabled");
+		} else if (strcmp(CMD_ARGV[0], "diff") == 0) {
+			/* unchanged sectors are skipped, changed ones must
+			 * still be erased before programming */
+			diff_mode = true;
+			auto_erase = 1;
+			CMD_ARGV++;
+			CMD_ARGC--;
+			command_print(CMD_CTX, "differential write enabled");
 		} else
 			break;
 	}
@@ -413,7 +444,8 @@ COMMAND_HANDLER(handle_flash_write_image_command)
 	if (retval != ERROR_OK)
 		return retval;
 
-	retval = flash_write_unlock(target, &image, &written, auto_erase, auto_unlock);
+	retval = flash_write_unlock(target, &image, &written, auto_erase,
+			auto_unlock, diff_mode);
 	if (retval != ERROR_OK) {
 		image_close(&image);
 		return retval;
@@ -430,6 +462,175 @@ COMMAND_HANDLER(handle_flash_write_image_command)
 	return retval;
 }
 
+COMMAND_HANDLER(handle_flash_gang_write_command)
+{
+	struct image image;
+	int retval;
+
+	/* flash auto-erase is disabled by default*/
+	int auto_erase = 0;
+	bool auto_unlock = false;
+	bool diff_mode = false;
+
+	while (CMD_ARGC) {
+		if (strcmp(CMD_ARGV[0], "erase") == 0) {
+			auto_erase = 1;
+			CMD_ARGV++;
+			CMD_ARGC--;
+			command_print(CMD_CTX, "auto erase enabled");
+		} else if (strcmp(CMD_ARGV[0], "unlock") == 0) {
+			auto_unlock = true;
+			CMD_ARGV++;
+			CMD_ARGC--;
+			command_print(CMD_CTX, "auto unlock enabled");
+		} else if (strcmp(CMD_ARGV[0], "diff") == 0) {
+			diff_mode = true;
+			auto_erase = 1;
+			CMD_ARGV++;
+			CMD_ARGC--;
+			command_print(CMD_CTX, "differential write enabled");
+		} else
+			break;
+	}
+
+	if (CMD_ARGC < 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC >= 2) {
+		image.base_address_set = 1;
+		COMMAND_PARSE_NUMBER(llong, CMD_ARGV[1], image.base_address);
+	} else {
+		image.base_address_set = 0;
+		image.base_address = 0x0;
+	}
+
+	image.start_address_set = 0;
+
+	/* the image is opened once and replicated to every target that
+	 * has flash configured */
+	retval = image_open(&image, CMD_ARGV[0], (CMD_ARGC == 3) ? CMD_ARGV[2] : NULL);
+	if (retval != ERROR_OK)
+		return retval;
+
+	struct duration bench;
+	duration_start(&bench);
+
+	int boards = 0;
+	int failed = 0;
+	uint64_t total_written = 0;
+	struct target *target;
+
+	for (target = all_targets; target; target = target->next) {
+		struct flash_bank *c;
+		uint32_t written = 0;
+
+		/* only targets with configured flash take part */
+		for (c = flash_bank_list(); c; c = c->next) {
+			if (c->target == target)
+				break;
+		}
+		if (c == NULL)
+			continue;
+
+		boards++;
+
+		if (!target_was_examined(target) ||
+				(target->state != TARGET_HALTED)) {
+			command_print(CMD_CTX, "%s: FAIL (target not halted)",
+				target_name(target));
+			failed++;
+			continue;
+		}
+
+		retval = flash_write_unlock(target, &image, &written,
+				auto_erase, auto_unlock, diff_mode);
+		if (retval == ERROR_OK) {
+			command_print(CMD_CTX, "%s: OK (%" PRIu32 " bytes)",
+				target_name(target), written);
+			total_written += written;
+		} else {
+			command_print(CMD_CTX, "%s: FAIL (error %d)",
+				target_name(target), retval);
+			failed++;
+		}
+	}
+
+	image_close(&image);
+
+	if (boards == 0) {
+		command_print(CMD_CTX, "no targets with configured flash banks");
+		return ERROR_FAIL;
+	}
+
+	if (duration_measure(&bench) == ERROR_OK)
+		command_print(CMD_CTX, "gang write: %d of %d targets programmed, "
+			"%" PRIu64 " bytes total in %fs (%0.3f KiB/s)",
+			boards - failed, boards, total_written,
+			duration_elapsed(&bench),
+			duration_kbps(&bench, total_written));
+
+	return failed ? ERROR_FAIL : ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_flash_gang_erase_command)
+{
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	struct duration bench;
+	duration_start(&bench);
+
+	int banks = 0;
+	int failed = 0;
+
+	for (int i = 0; i < flash_get_bank_count(); i++) {
+		struct flash_bank *p;
+		int retval = get_flash_bank_by_num(i, &p);
+
+		banks++;
+
+		if (retval != ERROR_OK) {
+			command_print(CMD_CTX, "bank %d: FAIL (probe failed)", i);
+			failed++;
+			continue;
+		}
+
+		if (!target_was_examined(p->target) ||
+				(p->target->state != TARGET_HALTED)) {
+			command_print(CMD_CTX, "%s: FAIL (target not halted)",
+				p->name);
+			failed++;
+			continue;
+		}
+
+		struct duration bank_bench;
+		duration_start(&bank_bench);
+
+		retval = flash_driver_erase(p, 0, p->num_sectors - 1);
+		if (retval == ERROR_OK) {
+			duration_measure(&bank_bench);
+			command_print(CMD_CTX, "%s: OK (%d sectors in %fs)",
+				p->name, p->num_sectors,
+				duration_elapsed(&bank_bench));
+		} else {
+			command_print(CMD_CTX, "%s: FAIL (error %d)",
+				p->name, retval);
+			failed++;
+		}
+	}
+
+	if (banks == 0) {
+		command_print(CMD_CTX, "no flash banks configured");
+		return ERROR_FAIL;
+	}
+
+	if (duration_measure(&bench) == ERROR_OK)
+		command_print(CMD_CTX, "gang erase: %d of %d banks erased in %fs",
+			banks - failed, banks, duration_elapsed(&bench));
+
+	return failed ? ERROR_FAIL : ERROR_OK;
+}
+
 COMMAND_HANDLER(handle_flash_fill_command)
 {
 	int err = ERROR_OK;
@@ -505,6 +706,9 @@ COMMAND_HANDLER(handle_flash_fill_command)
 	struct duration bench;
 	duration_start(&bench);
 
+	uint32_t chunk_checksum = 0;
+	bool chunk_checksum_valid = false;
+
 	for (wrote = 0; wrote < (count*wordsize); wrote += cur_size) {
 		struct flash_bank *bank;
 
@@ -519,6 +723,36 @@ COMMAND_HANDLER(handle_flash_fill_command)
 			goto done;
 		}
 
+		/* Verify by checksum so the chunk is not read back over the
+		 * wire; only a mismatch costs a readback, to pinpoint the
+		 * failing byte.  The full-chunk checksum never changes, so
+		 * compute it once. */
+		uint32_t host_crc;
+		uint32_t target_crc;
+
+		if (cur_size == chunksize && chunk_checksum_valid)
+			host_crc = chunk_checksum;
+		else {
+			err = image_calculate_checksum(chunk, cur_size, &host_crc);
+			if (err != ERROR_OK) {
+				retval = err;
+				goto done;
+			}
+			if (cur_size == chunksize) {
+				chunk_checksum = host_crc;
+				chunk_checksum_valid = true;
+			}
+		}
+
+		err = target_checksum_memory(target, address + wrote, cur_size, &target_crc);
+		if (err != ERROR_OK) {
+			retval = err;
+			goto done;
+		}
+
+		if (target_crc == host_crc)
+			continue;
+
 		err = flash_driver_read(bank, readback, address - bank->base + wrote, cur_size);
 		if (err != ERROR_OK) {
 			retval = err;
@@ -536,6 +770,12 @@ COMMAND_HANDLER(handle_flash_fill_command)
 				goto done;
 			}
 		}
+
+		LOG_ERROR("Checksum mismatch at address 0x%08" PRIx32
+			", but readback matches; transport error suspected",
+			address + wrote);
+		retval = ERROR_FAIL;
+		goto done;
 	}
 
 	if ((retval == ERROR_OK) && (duration_measure(&bench) == ERROR_OK)) {
@@ -678,6 +918,13 @@ COMMAND_HANDLER(handle_flash_verify_bank_command)
 	size_t read_cnt;
 	size_t filesize;
 	int differ;
+	bool crc_mode = false;
+
+	if (CMD_ARGC > 0 && strcmp(CMD_ARGV[0], "crc") == 0) {
+		crc_mode = true;
+		CMD_ARGV++;
+		CMD_ARGC--;
+	}
 
 	if (CMD_ARGC != 3)
 		return ERROR_COMMAND_SYNTAX_ERROR;
@@ -725,6 +972,68 @@ COMMAND_HANDLER(handle_flash_verify_bank_command)
 		return ERROR_FAIL;
 	}
 
+	/* Compare per-sector CRCs computed by the on-target checksum kernel
+	 * against CRCs of the file, instead of reading the whole bank back
+	 * over the adapter.  Only 4 bytes per sector cross the wire. */
+	if (crc_mode) {
+		int i;
+
+		/* the on-target kernel checksums the memory mapped contents */
+		if (p->driver->read != default_flash_read) {
+			LOG_ERROR("flash bank %u is not memory mapped; "
+				"CRC verify is not possible", p->bank_number);
+			free(buffer_file);
+			return ERROR_FAIL;
+		}
+
+		differ = 0;
+		for (i = 0; i < p->num_sectors; i++) {
+			uint32_t start = p->sectors[i].offset;
+			uint32_t end = start + p->sectors[i].size;
+			uint32_t file_crc, flash_crc;
+
+			/* intersect the sector with the file coverage */
+			if (start < offset)
+				start = offset;
+			if (end > offset + filesize)
+				end = offset + filesize;
+			if (start >= end)
+				continue;
+
+			retval = image_calculate_checksum(buffer_file + start - offset,
+					end - start, &file_crc);
+			if (retval != ERROR_OK)
+				break;
+
+			retval = target_checksum_memory(p->target, p->base + start,
+					end - start, &flash_crc);
+			if (retval != ERROR_OK)
+				break;
+
+			if (file_crc != flash_crc) {
+				command_print(CMD_CTX, "sector %d differs: "
+					"CRC 0x%8.8" PRIx32 " in flash, "
+					"0x%8.8" PRIx32 " in file",
+					i, flash_crc, file_crc);
+				differ++;
+			}
+			keep_alive();
+		}
+		free(buffer_file);
+
+		if (retval != ERROR_OK)
+			return retval;
+
+		if (duration_measure(&bench) == ERROR_OK)
+			command_print(CMD_CTX, "verified %ld bytes of file %s against"
+				" flash bank %u at offset 0x%8.8" PRIx32 " in %fs (%0.3f KiB/s)",
+				(long)read_cnt, CMD_ARGV[1], p->bank_number, offset,
+				duration_elapsed(&bench), duration_kbps(&bench, read_cnt));
+
+		command_print(CMD_CTX, "contents %s", differ ? "differ" : "match");
+		return differ ? ERROR_FAIL : ERROR_OK;
+	}
+
 	buffer_flash = malloc(filesize);
 	if (buffer_flash == NULL) {
 		LOG_ERROR("Out of memory");
@@ -804,7 +1113,7 @@ static const struct command_registration flash_exec_command_handlers[] = {
 		.name = "probe",
 		.handler = handle_flash_probe_command,
 		.mode = COMMAND_EXEC,
-		.usage = "bank_id",
+		.usage = "['-force'] bank_id",
 		.help = "Identify a flash bank.",
 	},
 	{
@@ -880,11 +1189,28 @@ static const struct command_registration flash_exec_command_handlers[] = {
 		.name = "write_image",
 		.handler = handle_flash_write_image_command,
 		.mode = COMMAND_EXEC,
-		.usage = "[erase] [unlock] filename [offset [file_type]]",
+		.usage = "[erase] [unlock] [diff] filename [offset [file_type]]",
 		.help = "Write an image to flash.  Optionally first unprotect "
 			"and/or erase the region to be used.  Allow optional "
 			"offset from beginning of bank (defaults to zero)",
 	},
+	{
+		.name = "gang_write",
+		.handler = handle_flash_gang_write_command,
+		.mode = COMMAND_EXEC,
+		.usage = "[erase] [unlock] [diff] filename [offset [file_type]]",
+		.help = "Write one image to the flash of every configured "
+			"target, opening the image only once; reports "
+			"per-target pass/fail and an aggregate summary.",
+	},
+	{
+		.name = "gang_erase",
+		.handler = handle_flash_gang_erase_command,
+		.mode = COMMAND_EXEC,
+		.usage = "",
+		.help = "Erase every sector of every configured flash bank; "
+			"reports per-bank pass/fail and an aggregate summary.",
+	},
 	{
 		.name = "read_bank",
 		.handler = handle_flash_read_bank_command,
@@ -898,10 +1224,12 @@ static const struct command_registration flash_exec_command_handlers[] = {
 		.name = "verify_bank",
 		.handler = handle_flash_verify_bank_command,
 		.mode = COMMAND_EXEC,
-		.usage = "bank_id filename offset",
+		.usage = "['crc'] bank_id filename offset",
 		.help = "Read binary data from flash bank and file, "
 			"starting at specified byte offset from the "
-			"beginning of the bank. Compare the contents.",
+			"beginning of the bank. Compare the contents. "
+			"With 'crc', compare per-sector CRCs computed "
+			"on the target instead of reading back the data.",
 	},
 	{
 		.name = "protect",
@@ -1052,6 +1380,16 @@ static int jim_flash_list(Jim_Interp *interp, int argc, Jim_Obj * const *argv)
 	return JIM_OK;
 }
 
+COMMAND_HANDLER(handle_flash_probe_cache_command)
+{
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	flash_probe_cache_set_dir(CMD_ARGV[0]);
+
+	return ERROR_OK;
+}
+
 COMMAND_HANDLER(handle_flash_init_command)
 {
 	if (CMD_ARGC != 0)
@@ -1079,6 +1417,14 @@ static const struct command_registration flash_config_command_handlers[] = {
 		.help = "Define a new bank with the given name, "
 			"using the specified NOR flash driver.",
 	},
+	{
+		.name = "probe_cache",
+		.mode = COMMAND_CONFIG,
+		.handler = handle_flash_probe_cache_command,
+		.usage = "directory",
+		.help = "Cache flash probe results on disk in the given "
+			"directory, validated on reuse by a device ID re-read.",
+	},
 	{
 		.name = "init",
 		.mode = COMMAND_CONFIG,
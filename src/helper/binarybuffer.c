@@ -99,7 +99,20 @@ bool buf_cmp_mask(const void *_buf1, const void *_buf2,
 
 	const uint8_t *buf1 = _buf1, *buf2 = _buf2, *mask = _mask;
 	unsigned last = size / 8;
-	for (unsigned i = 0; i < last; i++) {
+	unsigned i = 0;
+
+	/* word-at-a-time masked compare; memcpy keeps it alignment-safe
+	 * and compiles to plain loads */
+	for (; i + sizeof(uint64_t) <= last; i += sizeof(uint64_t)) {
+		uint64_t w1, w2, wm;
+		memcpy(&w1, buf1 + i, sizeof(w1));
+		memcpy(&w2, buf2 + i, sizeof(w2));
+		memcpy(&wm, mask + i, sizeof(wm));
+		if ((w1 ^ w2) & wm)
+			return true;
+	}
+
+	for (; i < last; i++) {
 		if (buf_cmp_masked(buf1[i], buf2[i], mask[i]))
 			return true;
 	}
@@ -146,11 +159,41 @@ void *buf_set_buf(const void *_src, unsigned src_start,
 	 * len is a multiple of 8bit so we can simple copy
 	 * the buffer */
 	if ((sq == 0) && (dq == 0) &&  (lq == 0)) {
-		for (i = 0; i < lb; i++)
-			*dst++ = *src++;
+		memcpy(dst, src, lb);
 		return _dst;
 	}
 
+	/* bulk path for unaligned copies: bring the destination onto a
+	 * byte boundary, then compose each full destination byte from at
+	 * most two source bytes; only head and tail fall back to the bit
+	 * loop */
+	if (len >= 16) {
+		while (dq != 0) {
+			if (((*src >> sq) & 1) == 1)
+				*dst |= 1 << dq;
+			else
+				*dst &= ~(1 << dq);
+			if (sq++ == 7) {
+				sq = 0;
+				src++;
+			}
+			if (dq++ == 7) {
+				dq = 0;
+				dst++;
+			}
+			len--;
+		}
+
+		while (len >= 8) {
+			uint8_t byte = *src >> sq;
+			if (sq != 0)
+				byte |= src[1] << (8 - sq);
+			*dst++ = byte;
+			src++;
+			len -= 8;
+		}
+	}
+
 	/* fallback to slow bit copy */
 	for (i = 0; i < len; i++) {
 		if (((*src >> (sq&7)) & 1) == 1)
@@ -216,8 +259,24 @@ char *buf_to_str(const void *_buf, unsigned buf_len, unsigned radix)
 	unsigned str_len = ceil_f_to_u32(DIV_ROUND_UP(buf_len, 8) * factor);
 	char *str = calloc(str_len + 1, 1);
 
+	const char * const DIGITS = "0123456789ABCDEF";
+
 	const uint8_t *buf = _buf;
 	int b256_len = DIV_ROUND_UP(buf_len, 8);
+
+	if (radix == 16) {
+		/* each byte maps onto exactly two digits, so skip the
+		 * base-256 long division that the other radixes need */
+		for (int i = b256_len - 1; i >= 0; i--) {
+			uint32_t tmp = buf[i];
+			if (((unsigned)i == (buf_len / 8)) && (buf_len % 8))
+				tmp &= (0xff >> (8 - (buf_len % 8)));
+			str[str_len - 2 * i - 2] = DIGITS[tmp >> 4];
+			str[str_len - 2 * i - 1] = DIGITS[tmp & 0xf];
+		}
+		return str;
+	}
+
 	for (int i = b256_len - 1; i >= 0; i--) {
 		uint32_t tmp = buf[i];
 		if (((unsigned)i == (buf_len / 8)) && (buf_len % 8))
@@ -231,13 +290,20 @@ char *buf_to_str(const void *_buf, unsigned buf_len, unsigned radix)
 		}
 	}
 
-	const char * const DIGITS = "0123456789ABCDEF";
 	for (unsigned j = 0; j < str_len; j++)
 		str[j] = DIGITS[(int)str[j]];
 
 	return str;
 }
 
+/* ASCII to hex digit value plus one; zero marks a non-hex character */
+static const uint8_t hex_digit_values[256] = {
+	['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5,
+	['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+	['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+	['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+};
+
 /** identify radix, and skip radix-prefix (0, 0x or 0X) */
 static void str_radix_guess(const char **_str, unsigned *_str_len,
 	unsigned *_radix)
@@ -287,27 +353,46 @@ int str_to_buf(const char *str, unsigned str_len,
 	/* go through zero terminated buffer
 	 * input digits (ASCII) */
 	unsigned i;
-	for (i = 0; charbuf[i]; i++) {
-		uint32_t tmp = charbuf[i];
-		if ((tmp >= '0') && (tmp <= '9'))
-			tmp = (tmp - '0');
-		else if ((tmp >= 'a') && (tmp <= 'f'))
-			tmp = (tmp - 'a' + 10);
-		else if ((tmp >= 'A') && (tmp <= 'F'))
-			tmp = (tmp - 'A' + 10);
-		else
-			continue;	/* skip characters other than [0-9,a-f,A-F] */
-
-		if (tmp >= radix)
-			continue;	/* skip digits invalid for the current radix */
 
-		/* base-256 digits */
-		for (unsigned j = 0; j < b256_len; j++) {
-			tmp += (uint32_t)b256_buf[j] * radix;
-			b256_buf[j] = (uint8_t)(tmp & 0xFF);
-			tmp >>= 8;
+	if (radix == 16) {
+		/* hex digits map straight onto nibbles, so convert with a
+		 * table lookup per character instead of a base-256 long
+		 * multiplication per digit; multi-megabyte strings from
+		 * scripted memory fills go through here */
+		unsigned nibbles = 0;
+
+		i = strlen(charbuf);
+		for (unsigned j = i; j > 0; j--) {
+			int tmp = hex_digit_values[(uint8_t)charbuf[j - 1]] - 1;
+			if (tmp < 0)
+				continue;	/* skip characters other than [0-9,a-f,A-F] */
+			if ((nibbles / 2) < b256_len)
+				b256_buf[nibbles / 2] |= tmp << (4 * (nibbles & 1));
+			nibbles++;
 		}
+	} else {
+		for (i = 0; charbuf[i]; i++) {
+			uint32_t tmp = charbuf[i];
+			if ((tmp >= '0') && (tmp <= '9'))
+				tmp = (tmp - '0');
+			else if ((tmp >= 'a') && (tmp <= 'f'))
+				tmp = (tmp - 'a' + 10);
+			else if ((tmp >= 'A') && (tmp <= 'F'))
+				tmp = (tmp - 'A' + 10);
+			else
+				continue;	/* skip characters other than [0-9,a-f,A-F] */
+
+			if (tmp >= radix)
+				continue;	/* skip digits invalid for the current radix */
+
+			/* base-256 digits */
+			for (unsigned j = 0; j < b256_len; j++) {
+				tmp += (uint32_t)b256_buf[j] * radix;
+				b256_buf[j] = (uint8_t)(tmp & 0xFF);
+				tmp >>= 8;
+			}
 
+		}
 	}
 
 	uint8_t *buf = _buf;
@@ -386,14 +471,21 @@ int unhexify(char *bin, const char *hex, int count)
 
 int hexify(char *hex, const char *bin, int count, int out_maxlen)
 {
+	static const char hex_digits[] = "0123456789abcdef";
 	int i, cmd_len = 0;
 
 	/* May use a length, or a null-terminated string as input. */
 	if (count == 0)
 		count = strlen(bin);
 
-	for (i = 0; i < count; i++)
-		cmd_len += snprintf(hex + cmd_len, out_maxlen - cmd_len, "%02x", bin[i] & 0xff);
+	/* two table lookups per byte; this runs over every byte of every
+	 * gdb memory reply, so no snprintf here */
+	for (i = 0; i < count && cmd_len + 2 < out_maxlen; i++) {
+		hex[cmd_len++] = hex_digits[(bin[i] >> 4) & 0xf];
+		hex[cmd_len++] = hex_digits[bin[i] & 0xf];
+	}
+	if (cmd_len < out_maxlen)
+		hex[cmd_len] = 0;
 
 	return cmd_len;
 }
@@ -49,13 +49,25 @@ static inline void buf_set_u32(uint8_t *_buffer,
 		buffer[2] = (value >> 16) & 0xff;
 		buffer[1] = (value >> 8) & 0xff;
 		buffer[0] = (value >> 0) & 0xff;
+	} else if (first / 8 == (first + num - 1) / 8) {
+		/* the field fits in one byte (short IR values, ACK bits):
+		 * single read-modify-write */
+		uint8_t mask = ((1u << num) - 1) << (first % 8);
+
+		buffer[first / 8] = (buffer[first / 8] & ~mask)
+			| ((value << (first % 8)) & mask);
 	} else {
-		for (unsigned i = first; i < first + num; i++) {
-			if (((value >> (i - first)) & 1) == 1)
-				buffer[i / 8] |= 1 << (i % 8);
-			else
-				buffer[i / 8] &= ~(1 << (i % 8));
-		}
+		/* the field spans up to five bytes; do byte-wide
+		 * read-modify-writes instead of a per-bit loop */
+		uint64_t mask = (num < 32) ? (((uint64_t)1 << num) - 1) : 0xffffffff;
+		uint64_t bits = ((uint64_t)value & mask) << (first % 8);
+		unsigned nbytes = (first % 8 + num + 7) / 8;
+
+		buffer += first / 8;
+		mask <<= first % 8;
+		for (unsigned i = 0; i < nbytes; i++)
+			buffer[i] = (buffer[i] & ~(uint8_t)(mask >> (8 * i)))
+				| (uint8_t)(bits >> (8 * i));
 	}
 }
 
@@ -116,13 +128,23 @@ static inline uint32_t buf_get_u32(const uint8_t *_buffer,
 				(((uint32_t)buffer[2]) << 16) |
 				(((uint32_t)buffer[1]) << 8) |
 				(((uint32_t)buffer[0]) << 0);
+	} else if (first / 8 == (first + num - 1) / 8) {
+		/* the field fits in one byte (short DR fields, ACK bits) */
+		return (uint32_t)(buffer[first / 8] >> (first % 8))
+			& (((uint32_t)1 << num) - 1);
 	} else {
-		uint32_t result = 0;
-		for (unsigned i = first; i < first + num; i++) {
-			if (((buffer[i / 8] >> (i % 8)) & 1) == 1)
-				result |= 1 << (i - first);
-		}
-		return result;
+		/* the field spans up to five bytes; gather them and shift
+		 * once instead of testing every bit */
+		unsigned nbytes = (first % 8 + num + 7) / 8;
+		uint64_t acc = 0;
+
+		buffer += first / 8;
+		for (unsigned i = 0; i < nbytes; i++)
+			acc |= (uint64_t)buffer[i] << (8 * i);
+		acc >>= first % 8;
+		if (num < 32)
+			acc &= (((uint64_t)1 << num) - 1);
+		return (uint32_t)acc;
 	}
 }
 
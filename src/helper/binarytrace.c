@@ -0,0 +1,173 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by the OpenOCD project                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ ***************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "binarytrace.h"
+#include "types.h"
+#include "time_support.h"
+#include "command.h"
+#include "log.h"
+
+#include <fcntl.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+bool trace_ring_active;
+
+static struct trace_ring_header *ring_header;
+static struct trace_ring_record *ring_records;
+static uint32_t ring_capacity;
+static uint64_t ring_seq;
+static size_t ring_map_size;
+static int ring_fd = -1;
+
+static int64_t timestamp_us(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+void trace_ring_write(uint16_t subsys, uint16_t event,
+		uint32_t arg0, uint32_t arg1)
+{
+	struct trace_ring_record *rec;
+
+	if (ring_records == NULL)
+		return;
+
+	rec = &ring_records[ring_seq % ring_capacity];
+	rec->timestamp_us = timestamp_us();
+	rec->subsys = subsys;
+	rec->event = event;
+	rec->arg[0] = arg0;
+	rec->arg[1] = arg1;
+	/* write the sequence number last, so a record torn by a crash
+	 * still carries its previous generation and is dropped by the
+	 * decoder */
+	rec->seq = ++ring_seq;
+}
+
+void trace_ring_close(void)
+{
+#ifdef HAVE_SYS_MMAN_H
+	trace_ring_active = false;
+
+	if (ring_header != NULL) {
+		munmap(ring_header, ring_map_size);
+		ring_header = NULL;
+		ring_records = NULL;
+	}
+	if (ring_fd >= 0) {
+		close(ring_fd);
+		ring_fd = -1;
+	}
+	ring_capacity = 0;
+	ring_seq = 0;
+	ring_map_size = 0;
+#endif
+}
+
+int trace_ring_open(const char *filename, uint32_t size)
+{
+#ifdef HAVE_SYS_MMAN_H
+	void *map;
+	uint32_t capacity;
+
+	trace_ring_close();
+
+	capacity = size / sizeof(struct trace_ring_record);
+	if (capacity < 64)
+		capacity = 64;
+	ring_map_size = sizeof(struct trace_ring_header)
+		+ (size_t)capacity * sizeof(struct trace_ring_record);
+
+	ring_fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (ring_fd < 0) {
+		LOG_ERROR("couldn't open trace ring file '%s'", filename);
+		return ERROR_FAIL;
+	}
+
+	/* ftruncate zero-fills, which marks every slot unused */
+	if (ftruncate(ring_fd, ring_map_size) != 0) {
+		LOG_ERROR("couldn't size trace ring file '%s'", filename);
+		trace_ring_close();
+		return ERROR_FAIL;
+	}
+
+	map = mmap(NULL, ring_map_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED, ring_fd, 0);
+	if (map == MAP_FAILED) {
+		LOG_ERROR("couldn't map trace ring file '%s'", filename);
+		trace_ring_close();
+		return ERROR_FAIL;
+	}
+
+	ring_header = map;
+	ring_header->magic = TRACE_RING_MAGIC;
+	ring_header->version = TRACE_RING_VERSION;
+	ring_header->record_size = sizeof(struct trace_ring_record);
+	ring_header->capacity = capacity;
+	ring_records = (struct trace_ring_record *)(ring_header + 1);
+	ring_capacity = capacity;
+	ring_seq = 0;
+	trace_ring_active = true;
+
+	LOG_INFO("binary trace ring '%s', %u record slots", filename, capacity);
+
+	return ERROR_OK;
+#else
+	LOG_ERROR("binary trace ring requires mmap support");
+	return ERROR_FAIL;
+#endif
+}
+
+COMMAND_HANDLER(handle_trace_ring_command)
+{
+	if (CMD_ARGC < 1 || CMD_ARGC > 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC == 1 && strcmp(CMD_ARGV[0], "disable") == 0) {
+		trace_ring_close();
+		return ERROR_OK;
+	}
+
+	uint32_t size = 1024 * 1024;
+	if (CMD_ARGC == 2)
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], size);
+
+	return trace_ring_open(CMD_ARGV[0], size);
+}
+
+static const struct command_registration binarytrace_command_handlers[] = {
+	{
+		.name = "trace_ring",
+		.handler = handle_trace_ring_command,
+		.mode = COMMAND_ANY,
+		.help = "write fixed-size binary trace records to an mmap'd "
+			"ring file, decoded offline with contrib/tracedump; "
+			"'disable' closes the ring",
+		.usage = "['disable'|filename [size]]",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+int binarytrace_register_commands(struct command_context *cmd_ctx)
+{
+	return register_commands(cmd_ctx, NULL, binarytrace_command_handlers);
+}
@@ -0,0 +1,97 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by the OpenOCD project                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ ***************************************************************************/
+
+#ifndef BINARYTRACE_H
+#define BINARYTRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+struct command_context;
+
+/**
+ * @file
+ * Structured binary trace ring.
+ *
+ * Fixed-size records (timestamp, subsystem, event, two payload words)
+ * are written to an mmap'd ring file.  Unlike formatted -d3 text
+ * logging this is cheap enough to leave enabled on production setups
+ * without perturbing timing, and the ring survives a crash; records
+ * are decoded offline with contrib/tracedump.c.
+ */
+
+#define TRACE_RING_MAGIC	0x4352544f	/* "OTRC" */
+#define TRACE_RING_VERSION	1
+
+/* file layout; must stay in sync with contrib/tracedump.c */
+struct trace_ring_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t record_size;
+	uint32_t capacity;	/* number of record slots */
+};
+
+struct trace_ring_record {
+	uint64_t timestamp_us;
+	uint64_t seq;		/* 0 marks a never-written slot */
+	uint32_t arg[2];
+	uint16_t subsys;
+	uint16_t event;
+	uint32_t reserved;
+};
+
+enum trace_subsys_id {
+	TRACE_SUBSYS_JTAG,
+	TRACE_SUBSYS_TARGET,
+	TRACE_SUBSYS_SERVER,
+	TRACE_SUBSYS_FLASH,
+	TRACE_SUBSYS_PROFILE,
+	TRACE_SUBSYS_NUM
+};
+
+/* event ids are subsystem-local */
+enum trace_jtag_event_id {
+	TRACE_EV_JTAG_QUEUE_RUN = 1,
+};
+
+enum trace_target_event_id {
+	TRACE_EV_TARGET_EVENT = 1,	/* arg0 = enum target_event, arg1 = target number */
+};
+
+enum trace_profile_event_id {
+	/* written when a profiled scope is left; arg0 = the scope id,
+	 * arg1 = elapsed microseconds, so the record carries both ends
+	 * of the interval ('tracedump -c' turns these into Chrome
+	 * trace-event durations) */
+	TRACE_EV_PROFILE_SCOPE = 1,
+};
+
+extern bool trace_ring_active;
+
+int trace_ring_open(const char *filename, uint32_t size);
+void trace_ring_close(void);
+void trace_ring_write(uint16_t subsys, uint16_t event,
+		uint32_t arg0, uint32_t arg1);
+
+/** Emit one record; while no ring is open this costs one branch. */
+static inline void trace_ring_emit(uint16_t subsys, uint16_t event,
+		uint32_t arg0, uint32_t arg1)
+{
+	if (trace_ring_active)
+		trace_ring_write(subsys, event, arg0, arg1);
+}
+
+int binarytrace_register_commands(struct command_context *cmd_ctx);
+
+#endif	/* BINARYTRACE_H */
@@ -51,31 +51,45 @@ static int run_command(struct command_context *context,
 
 struct log_capture_state {
 	Jim_Interp *interp;
-	Jim_Obj *output;
+	/* captured output accumulates in a plain buffer grown
+	 * geometrically, and only becomes a Tcl object once capture
+	 * finishes; appending to a string object per line would copy
+	 * the whole accumulated result over and over */
+	char *buffer;
+	size_t length;
+	size_t alloc;
 };
 
 static void tcl_output(void *privData, const char *file, unsigned line,
 	const char *function, const char *string)
 {
 	struct log_capture_state *state = privData;
-	Jim_AppendString(state->interp, state->output, string, strlen(string));
+	size_t len = strlen(string);
+
+	if (state->length + len > state->alloc) {
+		size_t new_alloc = state->alloc ? state->alloc : 4096;
+		while (new_alloc < state->length + len)
+			new_alloc *= 2;
+		char *new_buffer = realloc(state->buffer, new_alloc);
+		if (new_buffer == NULL)
+			return;	/* drop the output rather than the session */
+		state->buffer = new_buffer;
+		state->alloc = new_alloc;
+	}
+	memcpy(state->buffer + state->length, string, len);
+	state->length += len;
 }
 
 static struct log_capture_state *command_log_capture_start(Jim_Interp *interp)
 {
-	/* capture log output and return it. A garbage collect can
-	 * happen, so we need a reference count to this object */
-	Jim_Obj *tclOutput = Jim_NewStringObj(interp, "", 0);
-	if (NULL == tclOutput)
-		return NULL;
-
 	struct log_capture_state *state = malloc(sizeof(*state));
 	if (NULL == state)
 		return NULL;
 
 	state->interp = interp;
-	Jim_IncrRefCount(tclOutput);
-	state->output = tclOutput;
+	state->buffer = NULL;
+	state->length = 0;
+	state->alloc = 0;
 
 	log_add_callback(tcl_output, state);
 
@@ -101,17 +115,15 @@ static void command_log_capture_finish(struct log_capture_state *state)
 
 	log_remove_callback(tcl_output, state);
 
-	int length;
-	Jim_GetString(state->output, &length);
-
-	if (length > 0)
-		Jim_SetResult(state->interp, state->output);
+	if (state->length > 0)
+		Jim_SetResult(state->interp,
+			Jim_NewStringObj(state->interp, state->buffer, state->length));
 	else {
 		/* No output captured, use tcl return value (which could
 		 * be empty too). */
 	}
-	Jim_DecrRefCount(state->interp, state->output);
 
+	free(state->buffer);
 	free(state);
 }
 
@@ -194,8 +206,10 @@ struct command_context *current_command_context(Jim_Interp *interp)
 static int script_command_run(Jim_Interp *interp,
 	int argc, Jim_Obj * const *argv, struct command *c, bool capture)
 {
-	target_call_timer_callbacks_now();
-	LOG_USER_N("%s", "");	/* Keep GDB connection alive*/
+	/* Service due timer callbacks (target polling, GDB keep-alive via
+	 * keep_alive()) so they keep their cadence while scripts execute,
+	 * without forcing a poll on every dispatched command. */
+	target_call_timer_callbacks();
 
 	unsigned nwords;
 	char **words = script_command_args_alloc(argc, argv, &nwords);
@@ -232,6 +246,45 @@ static struct command *command_root(struct command *c)
 	return c;
 }
 
+/* Hash index over all registered command names.  Every dispatched
+ * command resolves its name (and subcommand names) through
+ * command_find(), so with hundreds of registered commands the former
+ * linked-list walk with one strcmp per node showed up in script-heavy
+ * use.  Commands hashing to the same bucket chain through hash_next;
+ * a lookup filters on the parent pointer, which identifies one sibling
+ * list because all contexts share a single command tree. */
+#define COMMAND_HASH_BUCKETS 256
+
+static struct command *command_hash_table[COMMAND_HASH_BUCKETS];
+
+static unsigned int command_name_hash(const char *name)
+{
+	unsigned int hash = 5381;
+	while (*name)
+		hash = (hash * 33) + (unsigned char)*name++;
+	return hash;
+}
+
+static void command_hash_insert(struct command *c)
+{
+	unsigned int bucket;
+
+	c->name_hash = command_name_hash(c->name);
+	bucket = c->name_hash % COMMAND_HASH_BUCKETS;
+	c->hash_next = command_hash_table[bucket];
+	command_hash_table[bucket] = c;
+}
+
+static void command_hash_remove(struct command *c)
+{
+	struct command **p = &command_hash_table[c->name_hash % COMMAND_HASH_BUCKETS];
+
+	while ((*p != NULL) && (*p != c))
+		p = &(*p)->hash_next;
+	if (*p != NULL)
+		*p = c->hash_next;
+}
+
 /**
  * Find a command by name from a list of commands.
  * @returns Returns the named command if it exists in the list.
@@ -239,8 +292,17 @@ static struct command *command_root(struct command *c)
  */
 static struct command *command_find(struct command *head, const char *name)
 {
-	for (struct command *cc = head; cc; cc = cc->next) {
-		if (strcmp(cc->name, name) == 0)
+	if (head == NULL)
+		return NULL;
+
+	/* every command in one sibling list shares head's parent */
+	struct command *parent = head->parent;
+	unsigned int hash = command_name_hash(name);
+
+	for (struct command *cc = command_hash_table[hash % COMMAND_HASH_BUCKETS];
+			cc; cc = cc->hash_next) {
+		if ((cc->parent == parent) && (cc->name_hash == hash) &&
+				(strcmp(cc->name, name) == 0))
 			return cc;
 	}
 	return NULL;
@@ -293,6 +355,8 @@ static void command_free(struct command *c)
 {
 	/** @todo if command has a handler, unregister its jim command! */
 
+	command_hash_remove(c);
+
 	while (NULL != c->children) {
 		struct command *tmp = c->children;
 		c->children = tmp->next;
@@ -345,6 +409,7 @@ static struct command *command_new(struct command_context *cmd_ctx,
 	c->mode = cr->mode;
 
 	command_add_child(command_list_for_parent(cmd_ctx, parent), c);
+	command_hash_insert(c);
 
 	return c;
 
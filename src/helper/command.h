@@ -172,6 +172,10 @@ struct command {
 	void *jim_handler_data;
 	enum command_mode mode;
 	struct command *next;
+	/* name-hash index bookkeeping, maintained by the command registry:
+	 * cached hash of name, and the chain link in the lookup table */
+	unsigned int name_hash;
+	struct command *hash_next;
 };
 
 /**
@@ -33,6 +33,56 @@ static char **config_file_names;
 static size_t num_script_dirs;
 static char **script_search_dirs;
 
+/* Cache of resolved script paths.  A board config chains a dozen
+ * includes, and each `source [find ...]` resolves its file twice (once
+ * for find, once again on open), probing every search directory with a
+ * syscall per miss.  Remember where a name was found; each hit is
+ * re-verified with a single open, so stale entries heal themselves. */
+struct found_file {
+	struct found_file *next;
+	char *name;
+	char *full_path;
+};
+
+static struct found_file *found_files;
+
+static struct found_file **found_file_lookup(const char *name)
+{
+	struct found_file **p = &found_files;
+
+	while ((*p != NULL) && (strcmp((*p)->name, name) != 0))
+		p = &(*p)->next;
+	return p;
+}
+
+static void found_file_add(const char *name, const char *full_path)
+{
+	struct found_file *f = malloc(sizeof(struct found_file));
+
+	if (f == NULL)
+		return;
+	f->name = strdup(name);
+	f->full_path = strdup(full_path);
+	if (!f->name || !f->full_path) {
+		free(f->name);
+		free(f->full_path);
+		free(f);
+		return;
+	}
+	f->next = found_files;
+	found_files = f;
+}
+
+static void found_file_remove(struct found_file **p)
+{
+	struct found_file *f = *p;
+
+	*p = f->next;
+	free(f->name);
+	free(f->full_path);
+	free(f);
+}
+
 void add_script_search_dir(const char *dir)
 {
 	num_script_dirs++;
@@ -41,6 +91,10 @@ void add_script_search_dir(const char *dir)
 	script_search_dirs[num_script_dirs-1] = strdup(dir);
 	script_search_dirs[num_script_dirs] = NULL;
 
+	/* a new directory can change how names resolve */
+	while (found_files != NULL)
+		found_file_remove(&found_files);
+
 	LOG_DEBUG("adding %s", dir);
 }
 
@@ -62,6 +116,19 @@ char *find_file(const char *file)
 	char const *mode = "r";
 	char *full_path;
 
+	/* serve repeated lookups from the cache, one open to re-verify */
+	struct found_file **cached = found_file_lookup(file);
+	if (*cached != NULL) {
+		fp = fopen((*cached)->full_path, mode);
+		if (fp) {
+			fclose(fp);
+			return alloc_printf("%s", (*cached)->full_path);
+		}
+		/* the file went away; drop the entry and search again */
+		found_file_remove(cached);
+		fp = NULL;
+	}
+
 	/* Check absolute and relative to current working dir first.
 	 * This keeps full_path reporting belowing working. */
 	full_path = alloc_printf("%s", file);
@@ -81,6 +148,7 @@ char *find_file(const char *file)
 
 	if (fp) {
 		fclose(fp);
+		found_file_add(file, full_path);
 		LOG_DEBUG("found %s", full_path);
 		return full_path;
 	}
@@ -32,12 +32,21 @@
 #include "configuration.h"
 #include "fileio.h"
 
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
 struct fileio_internal {
 	char *url;
 	size_t size;
 	enum fileio_type type;
 	enum fileio_access access;
 	FILE *file;
+	/* fileio_map() state: the window, its length and whether it came
+	 * from malloc (fallback) rather than mmap */
+	void *map;
+	size_t map_size;
+	bool map_malloced;
 };
 
 static inline int fileio_close_local(struct fileio_internal *fileio);
@@ -117,6 +126,9 @@ int fileio_open(struct fileio *fileio_p,
 	fileio->type = type;
 	fileio->access = access_type;
 	fileio->url = strdup(url);
+	fileio->map = NULL;
+	fileio->map_size = 0;
+	fileio->map_malloced = false;
 
 	retval = fileio_open_local(fileio);
 
@@ -146,11 +158,27 @@ static inline int fileio_close_local(struct fileio_internal *fileio)
 	return ERROR_OK;
 }
 
+static void fileio_unmap_local(struct fileio_internal *fileio)
+{
+	if (fileio->map == NULL)
+		return;
+#ifdef HAVE_SYS_MMAN_H
+	if (!fileio->map_malloced)
+		munmap(fileio->map, fileio->map_size);
+	else
+#endif
+		free(fileio->map);
+	fileio->map = NULL;
+	fileio->map_size = 0;
+	fileio->map_malloced = false;
+}
+
 int fileio_close(struct fileio *fileio_p)
 {
 	int retval;
 	struct fileio_internal *fileio = fileio_p->fp;
 
+	fileio_unmap_local(fileio);
 	retval = fileio_close_local(fileio);
 
 	free(fileio->url);
@@ -190,6 +218,58 @@ int fileio_read(struct fileio *fileio_p, size_t size, void *buffer,
 	return fileio_local_read(fileio, size, buffer, size_read);
 }
 
+int fileio_map(struct fileio *fileio_p, const void **window, size_t *size)
+{
+	struct fileio_internal *fileio = fileio_p->fp;
+
+	if (fileio->map == NULL) {
+		if (fileio->size == 0)
+			return ERROR_FILEIO_OPERATION_FAILED;
+
+#ifdef HAVE_SYS_MMAN_H
+		void *map = mmap(NULL, fileio->size, PROT_READ, MAP_PRIVATE,
+				fileno(fileio->file), 0);
+		if (map != MAP_FAILED) {
+			fileio->map = map;
+			fileio->map_malloced = false;
+		}
+#endif
+		if (fileio->map == NULL) {
+			/* no mmap (or it failed, e.g. for a pipe); fall back
+			 * to reading the whole file into a buffer once,
+			 * preserving the stream position */
+			long pos = ftell(fileio->file);
+			size_t size_read;
+			void *map = malloc(fileio->size);
+
+			if (map == NULL)
+				return ERROR_FILEIO_OPERATION_FAILED;
+			if ((pos < 0) ||
+					(fseek(fileio->file, 0, SEEK_SET) != 0) ||
+					(fileio_local_read(fileio, fileio->size,
+						map, &size_read) != ERROR_OK) ||
+					(size_read != fileio->size) ||
+					(fseek(fileio->file, pos, SEEK_SET) != 0)) {
+				free(map);
+				return ERROR_FILEIO_OPERATION_FAILED;
+			}
+			fileio->map = map;
+			fileio->map_malloced = true;
+		}
+		fileio->map_size = fileio->size;
+	}
+
+	*window = fileio->map;
+	*size = fileio->map_size;
+	return ERROR_OK;
+}
+
+int fileio_unmap(struct fileio *fileio_p)
+{
+	fileio_unmap_local(fileio_p->fp);
+	return ERROR_OK;
+}
+
 int fileio_read_u32(struct fileio *fileio_p, uint32_t *data)
 {
 	uint8_t buf[4];
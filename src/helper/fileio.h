@@ -60,6 +60,13 @@ int fileio_read(struct fileio *fileio,
 int fileio_write(struct fileio *fileio,
 		size_t size, const void *buffer, size_t *size_written);
 
+/* Expose the whole file as a read-only memory window, backed by
+ * mmap(2) where the platform has it and by a single buffered read of
+ * the file otherwise.  The window stays valid until fileio_unmap() or
+ * fileio_close(); repeated calls return the same window. */
+int fileio_map(struct fileio *fileio, const void **window, size_t *size);
+int fileio_unmap(struct fileio *fileio);
+
 int fileio_read_u32(struct fileio *fileio, uint32_t *data);
 int fileio_write_u32(struct fileio *fileio, uint32_t data);
 int fileio_size(struct fileio *fileio, size_t *size);
@@ -47,6 +47,23 @@ int debug_level = -1;
 static FILE *log_output;
 static struct log_callback *log_callbacks;
 
+/* Optional staging buffer for debug-level lines.  Formatting still
+ * happens on the calling path (the arguments don't outlive the call),
+ * but the write and flush syscalls are batched so that raising
+ * debug_level perturbs the timing of the code under test less. */
+static char *log_buffer;
+static size_t log_buffer_size;
+static size_t log_buffer_used;
+
+static void log_buffer_flush(void)
+{
+	if (log_buffer_used == 0)
+		return;
+	fwrite(log_buffer, 1, log_buffer_used, log_output);
+	fflush(log_output);
+	log_buffer_used = 0;
+}
+
 static long long last_time;
 static long long current_time;
 
@@ -124,6 +141,7 @@ static void log_puts(enum log_levels level,
 	char *f;
 	if (level == LOG_LVL_OUTPUT) {
 		/* do not prepend any headers, just print out what we were given and return */
+		log_buffer_flush();
 		fputs(string, log_output);
 		fflush(log_output);
 		return;
@@ -141,6 +159,34 @@ static void log_puts(enum log_levels level,
 			struct mallinfo info;
 			info = mallinfo();
 #endif
+			if ((level == LOG_LVL_DEBUG) && (log_buffer != NULL)) {
+				/* stage the line; the per-line write and flush
+				 * syscalls dominate the cost of -d3 */
+				int attempt;
+				for (attempt = 0; attempt < 2; attempt++) {
+					size_t room = log_buffer_size - log_buffer_used;
+					int written = snprintf(log_buffer + log_buffer_used, room,
+						"%s%d %d %s:%d %s()"
+#ifdef _DEBUG_FREE_SPACE_
+						" %d"
+#endif
+						": %s", log_strings[level + 1], count, t, file, line, function,
+#ifdef _DEBUG_FREE_SPACE_
+						info.fordblks,
+#endif
+						string);
+					if ((written >= 0) && ((size_t)written < room)) {
+						log_buffer_used += written;
+						/* debug lines are never forwarded
+						 * to the log callbacks */
+						return;
+					}
+					/* no room left; retry against an empty buffer */
+					log_buffer_flush();
+				}
+				/* line larger than the whole buffer, write it out */
+			}
+			log_buffer_flush();
 			fprintf(log_output, "%s%d %d %s:%d %s()"
 #ifdef _DEBUG_FREE_SPACE_
 				" %d"
@@ -153,6 +199,7 @@ static void log_puts(enum log_levels level,
 		} else {
 			/* if we are using gdb through pipes then we do not want any output
 			 * to the pipe otherwise we get repeated strings */
+			log_buffer_flush();
 			fprintf(log_output, "%s%s",
 				(level > LOG_LVL_USER) ? log_strings[level + 1] : "", string);
 		}
@@ -230,6 +277,7 @@ COMMAND_HANDLER(handle_debug_level_command)
 			return ERROR_COMMAND_SYNTAX_ERROR;
 		}
 		debug_level = new_level;
+		log_buffer_flush();
 	} else if (CMD_ARGC > 1)
 		return ERROR_COMMAND_SYNTAX_ERROR;
 
@@ -243,13 +291,46 @@ COMMAND_HANDLER(handle_log_output_command)
 	if (CMD_ARGC == 1) {
 		FILE *file = fopen(CMD_ARGV[0], "w");
 
-		if (file)
+		if (file) {
+			log_buffer_flush();
 			log_output = file;
+		}
 	}
 
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(handle_log_buffering_command)
+{
+	if (CMD_ARGC == 1) {
+		unsigned size_kb;
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], size_kb);
+
+		log_buffer_flush();
+		free(log_buffer);
+		log_buffer = NULL;
+		log_buffer_size = 0;
+
+		if (size_kb > 0) {
+			log_buffer = malloc(size_kb * 1024);
+			if (log_buffer == NULL) {
+				LOG_ERROR("not enough memory for the log buffer");
+				return ERROR_FAIL;
+			}
+			log_buffer_size = size_kb * 1024;
+		}
+	} else if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (log_buffer != NULL)
+		command_print(CMD_CTX, "debug log buffering: %u kB",
+			(unsigned)(log_buffer_size / 1024));
+	else
+		command_print(CMD_CTX, "debug log buffering: off");
+
+	return ERROR_OK;
+}
+
 static struct command_registration log_command_handlers[] = {
 	{
 		.name = "log_output",
@@ -267,6 +348,15 @@ static struct command_registration log_command_handlers[] = {
 			"2 (default) adds other info; 3 adds debugging.",
 		.usage = "number",
 	},
+	{
+		.name = "log_buffering",
+		.handler = handle_log_buffering_command,
+		.mode = COMMAND_ANY,
+		.help = "Buffer debug-level log lines in memory and write them "
+			"out in batches instead of flushing each line; "
+			"size is in kB, 0 disables buffering.",
+		.usage = "[size_kb]",
+	},
 	COMMAND_REGISTRATION_DONE
 };
 
@@ -300,6 +390,7 @@ void log_init(void)
 
 int set_log_output(struct command_context *cmd_ctx, FILE *output)
 {
+	log_buffer_flush();
 	log_output = output;
 	return ERROR_OK;
 }
@@ -405,6 +496,10 @@ char *alloc_printf(const char *format, ...)
  */
 void keep_alive()
 {
+	/* long-running operations call in here regularly, which bounds how
+	 * long staged debug lines can sit in memory */
+	log_buffer_flush();
+
 	current_time = timeval_ms();
 	if (current_time-last_time > 1000) {
 		extern int gdb_actual_connections;
@@ -0,0 +1,208 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by the OpenOCD project                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ ***************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "profiling.h"
+#include "binarytrace.h"
+#include "time_support.h"
+#include "command.h"
+#include "log.h"
+
+/* log2 microsecond buckets: 1us .. ~8s, everything longer in the last */
+#define PROFILE_BUCKETS 24
+
+struct profile_scope {
+	const char *name;
+	uint64_t count;
+	uint64_t total_us;
+	uint64_t max_us;
+	uint64_t buckets[PROFILE_BUCKETS];
+};
+
+static struct profile_scope profile_scopes[PROFILE_NUM_SCOPES] = {
+	[PROFILE_JTAG_EXECUTE_QUEUE] = { .name = "jtag_execute_queue" },
+	[PROFILE_MEM_AP_READ] = { .name = "mem_ap read" },
+	[PROFILE_MEM_AP_WRITE] = { .name = "mem_ap write" },
+	[PROFILE_GDB_PACKET] = { .name = "gdb packet" },
+	[PROFILE_FLASH_WRITE] = { .name = "flash write" },
+};
+
+bool profiling_enabled;
+
+static int64_t timestamp_us(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+int64_t profile_enter(void)
+{
+	if (!profiling_enabled)
+		return -1;
+	return timestamp_us();
+}
+
+void profile_leave(enum profile_scope_id scope, int64_t start)
+{
+	if (start < 0)
+		return;
+
+	int64_t elapsed = timestamp_us() - start;
+	if (elapsed < 0)
+		elapsed = 0;
+
+	/* feed the timeline trace as well; one record per scope interval */
+	trace_ring_emit(TRACE_SUBSYS_PROFILE, TRACE_EV_PROFILE_SCOPE,
+		scope, (uint32_t)elapsed);
+
+	struct profile_scope *s = &profile_scopes[scope];
+	unsigned bucket = 0;
+
+	while ((bucket < PROFILE_BUCKETS - 1) &&
+			((int64_t)1 << bucket) < elapsed)
+		bucket++;
+
+	s->count++;
+	s->total_us += elapsed;
+	if ((uint64_t)elapsed > s->max_us)
+		s->max_us = elapsed;
+	s->buckets[bucket]++;
+}
+
+const char *profile_scope_name(enum profile_scope_id scope)
+{
+	return profile_scopes[scope].name;
+}
+
+void profile_scope_totals(enum profile_scope_id scope,
+		uint64_t *count, uint64_t *total_us)
+{
+	*count = profile_scopes[scope].count;
+	*total_us = profile_scopes[scope].total_us;
+}
+
+static void profiling_reset(void)
+{
+	for (unsigned i = 0; i < PROFILE_NUM_SCOPES; i++) {
+		struct profile_scope *s = &profile_scopes[i];
+		s->count = 0;
+		s->total_us = 0;
+		s->max_us = 0;
+		memset(s->buckets, 0, sizeof(s->buckets));
+	}
+}
+
+COMMAND_HANDLER(handle_timing_enable_command)
+{
+	profiling_enabled = true;
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_timing_disable_command)
+{
+	profiling_enabled = false;
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_timing_reset_command)
+{
+	profiling_reset();
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_timing_report_command)
+{
+	if (!profiling_enabled)
+		command_print(CMD_CTX, "timing capture is disabled ('timing enable' starts it)");
+
+	for (unsigned i = 0; i < PROFILE_NUM_SCOPES; i++) {
+		struct profile_scope *s = &profile_scopes[i];
+
+		if (s->count == 0)
+			continue;
+
+		command_print(CMD_CTX,
+			"%s: %" PRIu64 " calls, total %" PRIu64 ".%03" PRIu64 " ms, "
+			"avg %" PRIu64 " us, max %" PRIu64 " us",
+			s->name, s->count,
+			s->total_us / 1000, s->total_us % 1000,
+			s->total_us / s->count, s->max_us);
+
+		for (unsigned b = 0; b < PROFILE_BUCKETS; b++) {
+			if (s->buckets[b] == 0)
+				continue;
+			if (b < PROFILE_BUCKETS - 1)
+				command_print(CMD_CTX, "  <= %10" PRIu64 " us: %" PRIu64,
+					(uint64_t)1 << b, s->buckets[b]);
+			else
+				command_print(CMD_CTX, "   > %10" PRIu64 " us: %" PRIu64,
+					(uint64_t)1 << (b - 1), s->buckets[b]);
+		}
+	}
+
+	return ERROR_OK;
+}
+
+static const struct command_registration timing_subcommand_handlers[] = {
+	{
+		.name = "enable",
+		.handler = handle_timing_enable_command,
+		.mode = COMMAND_ANY,
+		.help = "start capturing per-scope wall time",
+		.usage = "",
+	},
+	{
+		.name = "disable",
+		.handler = handle_timing_disable_command,
+		.mode = COMMAND_ANY,
+		.help = "stop capturing per-scope wall time",
+		.usage = "",
+	},
+	{
+		.name = "report",
+		.handler = handle_timing_report_command,
+		.mode = COMMAND_ANY,
+		.help = "print call counts, totals and latency histograms "
+			"for the instrumented scopes",
+		.usage = "",
+	},
+	{
+		.name = "reset",
+		.handler = handle_timing_reset_command,
+		.mode = COMMAND_ANY,
+		.help = "clear all captured timing data",
+		.usage = "",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+static const struct command_registration timing_command_handlers[] = {
+	{
+		.name = "timing",
+		.mode = COMMAND_ANY,
+		.help = "wall-time profiling of OpenOCD internal hot paths",
+		.usage = "",
+		.chain = timing_subcommand_handlers,
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+int profiling_register_commands(struct command_context *cmd_ctx)
+{
+	return register_commands(cmd_ctx, NULL, timing_command_handlers);
+}
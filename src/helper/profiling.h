@@ -0,0 +1,57 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by the OpenOCD project                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ ***************************************************************************/
+
+#ifndef PROFILING_H
+#define PROFILING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+struct command_context;
+
+/**
+ * @file
+ * Lightweight scoped wall-time profiler for OpenOCD's own hot paths.
+ *
+ * A handful of agreed scopes are instrumented with enter/leave marks;
+ * per-scope call counts, totals and a log2 latency histogram are
+ * aggregated in memory and dumped with the 'timing report' command.
+ * While disabled (the default) an instrumented path pays one branch.
+ */
+
+enum profile_scope_id {
+	PROFILE_JTAG_EXECUTE_QUEUE,
+	PROFILE_MEM_AP_READ,
+	PROFILE_MEM_AP_WRITE,
+	PROFILE_GDB_PACKET,
+	PROFILE_FLASH_WRITE,
+	PROFILE_NUM_SCOPES
+};
+
+extern bool profiling_enabled;
+
+/** Take a timestamp at scope entry; returns -1 while profiling is off. */
+int64_t profile_enter(void);
+/** Account the time since @a start to @a scope; no-op if @a start < 0. */
+void profile_leave(enum profile_scope_id scope, int64_t start);
+
+/** Name of @a scope as printed by 'timing report'. */
+const char *profile_scope_name(enum profile_scope_id scope);
+/** Snapshot @a scope's accumulated call count and total time. */
+void profile_scope_totals(enum profile_scope_id scope,
+		uint64_t *count, uint64_t *total_us);
+
+int profiling_register_commands(struct command_context *cmd_ctx);
+
+#endif	/* PROFILING_H */
@@ -0,0 +1,152 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by the OpenOCD project                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ ***************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdbool.h>
+
+#include "progress.h"
+#include "time_support.h"
+#include "log.h"
+
+/* minimum interval between intermediate reports */
+#define PROGRESS_INTERVAL_MS 500
+
+struct progress_callback {
+	progress_callback_fn fn;
+	void *priv;
+	struct progress_callback *next;
+};
+
+static struct progress_callback *progress_callbacks;
+
+static const char *progress_op;
+static uint64_t progress_total;
+static uint64_t progress_bytes;
+static unsigned progress_depth;
+static int64_t progress_start_time;
+static int64_t progress_last_report;
+
+int progress_add_callback(progress_callback_fn fn, void *priv)
+{
+	struct progress_callback *cb;
+
+	/* prevent the same callback to be registered more than once, just for sure */
+	for (cb = progress_callbacks; cb; cb = cb->next) {
+		if (cb->fn == fn && cb->priv == priv)
+			return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+
+	cb = malloc(sizeof(struct progress_callback));
+	if (cb == NULL)
+		return ERROR_BUF_TOO_SMALL;
+
+	cb->fn = fn;
+	cb->priv = priv;
+	cb->next = progress_callbacks;
+	progress_callbacks = cb;
+
+	return ERROR_OK;
+}
+
+int progress_remove_callback(progress_callback_fn fn, void *priv)
+{
+	struct progress_callback *cb, **p;
+
+	for (p = &progress_callbacks; (cb = *p); p = &(*p)->next) {
+		if (cb->fn == fn && cb->priv == priv) {
+			*p = cb->next;
+			free(cb);
+			return ERROR_OK;
+		}
+	}
+
+	/* no such item */
+	return ERROR_COMMAND_SYNTAX_ERROR;
+}
+
+static void progress_report(bool console)
+{
+	int64_t now = timeval_ms();
+	int64_t elapsed = now - progress_start_time;
+	uint64_t done = progress_bytes;
+	struct progress_callback *cb;
+
+	/* padding and sector rounding may push the count past the
+	 * announced total; don't report more than 100% */
+	if (done > progress_total)
+		done = progress_total;
+
+	if (console) {
+		unsigned percent = 100;
+		uint64_t kbps = 0;
+
+		if (progress_total > 0)
+			percent = (unsigned)(done * 100 / progress_total);
+		if (elapsed > 0)
+			kbps = (done * 1000) / ((uint64_t)elapsed * 1024);
+
+		LOG_USER("%s: %" PRIu64 " of %" PRIu64 " bytes "
+			"(%u%%, %" PRIu64 " KiB/s)",
+			progress_op, done, progress_total, percent, kbps);
+	}
+
+	for (cb = progress_callbacks; cb; cb = cb->next)
+		cb->fn(progress_op, done, progress_total, cb->priv);
+
+	progress_last_report = now;
+}
+
+void progress_start(const char *op, uint64_t total)
+{
+	if (progress_depth++ > 0)
+		return;	/* collapsed into the operation already running */
+
+	progress_op = op;
+	progress_total = total;
+	progress_bytes = 0;
+	progress_start_time = timeval_ms();
+	progress_last_report = progress_start_time;
+
+	/* announce the operation to observers; the console stays quiet
+	 * until there is something to say */
+	progress_report(false);
+}
+
+void progress_add(uint64_t bytes)
+{
+	if (progress_depth != 1)
+		return;	/* inner operation, accounted by the outermost one */
+
+	progress_bytes += bytes;
+
+	if (timeval_ms() - progress_last_report >= PROGRESS_INTERVAL_MS)
+		progress_report(true);
+}
+
+void progress_done(void)
+{
+	if (progress_depth == 0)
+		return;
+	if (--progress_depth > 0)
+		return;
+
+	/* observers always get the final state; skip the console line for
+	 * operations that finished before the first intermediate report */
+	progress_report(timeval_ms() - progress_start_time
+			>= PROGRESS_INTERVAL_MS);
+	progress_op = NULL;
+}
@@ -0,0 +1,48 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by the OpenOCD project                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ ***************************************************************************/
+
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <stdint.h>
+
+/**
+ * @file
+ * Progress reporting for long-running operations.
+ *
+ * A long-running path brackets its work with progress_start() and
+ * progress_done(), and accounts completed bytes to progress_add() as
+ * it goes.  The state is printed to the console at a throttled rate
+ * and pushed to registered observers (e.g. the tcl server's async
+ * notifications) so a UI can show real completion instead of guessing.
+ *
+ * Operations nest: while one is active, inner start/add/done calls
+ * are collapsed into it, so a flash write does not fight with the
+ * target-layer writes it performs internally.
+ */
+
+typedef void (*progress_callback_fn)(const char *op, uint64_t done,
+		uint64_t total, void *priv);
+
+int progress_add_callback(progress_callback_fn fn, void *priv);
+int progress_remove_callback(progress_callback_fn fn, void *priv);
+
+/** Begin an operation expected to move @a total bytes in all. */
+void progress_start(const char *op, uint64_t total);
+/** Account @a bytes more completed work to the current operation. */
+void progress_add(uint64_t bytes);
+/** End the current operation, emitting a final report. */
+void progress_done(void);
+
+#endif	/* PROGRESS_H */
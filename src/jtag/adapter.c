@@ -430,6 +430,39 @@ COMMAND_HANDLER(handle_adapter_nsrst_assert_width_command)
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(handle_adapter_stats_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC == 1) {
+		if (strcmp(CMD_ARGV[0], "clear") != 0)
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		jtag_clear_interface_stats();
+		return ERROR_OK;
+	}
+
+	const struct jtag_interface_stats *stats = jtag_get_interface_stats();
+
+	command_print(CMD_CTX, "transactions: %" PRId64, stats->transactions);
+	command_print(CMD_CTX, "payload bytes: %" PRId64, stats->payload_bytes);
+	command_print(CMD_CTX, "wire bytes: %" PRId64, stats->wire_bytes);
+	command_print(CMD_CTX, "total latency: %" PRId64 " us", stats->latency_us);
+	if (stats->transactions)
+		command_print(CMD_CTX, "average latency: %" PRId64 " us",
+				stats->latency_us / stats->transactions);
+
+	for (unsigned i = 0; i < JTAG_STATS_LATENCY_BUCKETS; i++) {
+		if (stats->latency_histogram[i] == 0)
+			continue;
+		command_print(CMD_CTX, "latency [%" PRId64 " us, %" PRId64 " us): %" PRId64,
+				(i == 0) ? 0 : (int64_t)1 << i, (int64_t)1 << (i + 1),
+				stats->latency_histogram[i]);
+	}
+
+	return ERROR_OK;
+}
+
 COMMAND_HANDLER(handle_adapter_khz_command)
 {
 	if (CMD_ARGC > 1)
@@ -476,6 +509,16 @@ static const struct command_registration interface_command_handlers[] = {
 		.help = "Returns the name of the currently "
 			"selected adapter (driver)",
 	},
+	{
+		.name = "adapter_stats",
+		.handler = handle_adapter_stats_command,
+		.mode = COMMAND_ANY,
+		.help = "Display cumulative adapter transfer statistics: "
+			"transactions, payload and wire bytes, and a "
+			"round-trip latency histogram.  "
+			"'adapter_stats clear' resets the counters.",
+		.usage = "[clear]",
+	},
 	{
 		.name = "adapter_nsrst_delay",
 		.handler = handle_adapter_nsrst_delay_command,
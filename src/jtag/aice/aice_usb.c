@@ -3099,6 +3099,11 @@ static int aice_usb_set_address_dim(uint32_t coreid, uint32_t address)
 	return aice_execute_dim(coreid, instructions, 4);
 }
 
+static int aice_bulk_read_mem(uint32_t coreid, uint32_t addr, uint32_t count,
+		uint8_t *buffer);
+static int aice_bulk_write_mem(uint32_t coreid, uint32_t addr, uint32_t count,
+		const uint8_t *buffer);
+
 static int aice_usb_read_memory_unit(uint32_t coreid, uint32_t addr, uint32_t size,
 		uint32_t count, uint8_t *buffer)
 {
@@ -3109,6 +3114,12 @@ static int aice_usb_read_memory_unit(uint32_t coreid, uint32_t addr, uint32_t si
 	if (NDS_MEMORY_ACC_CPU == core_info[coreid].access_channel)
 		aice_usb_set_address_dim(coreid, addr);
 
+	/* runs of aligned words go through FASTREAD_MEM in 256-word
+	 * bursts instead of one READ_MEM command per word */
+	if ((NDS_MEMORY_ACC_BUS == core_info[coreid].access_channel) &&
+			(size == 4) && ((addr & 3) == 0) && (count > 1))
+		return aice_bulk_read_mem(coreid, addr, count, buffer);
+
 	uint32_t value;
 	size_t i;
 	read_mem_func_t read_mem_func;
@@ -3228,6 +3239,23 @@ static int aice_usb_write_memory_unit(uint32_t coreid, uint32_t addr, uint32_t s
 	if (NDS_MEMORY_ACC_CPU == core_info[coreid].access_channel)
 		aice_usb_set_address_dim(coreid, addr);
 
+	/* runs of aligned words go through FASTWRITE_MEM in 256-word
+	 * bursts instead of one WRITE_MEM command per word */
+	if ((NDS_MEMORY_ACC_BUS == core_info[coreid].access_channel) &&
+			(size == 4) && ((addr & 3) == 0) && (count > 1))
+		return aice_bulk_write_mem(coreid, addr, count, buffer);
+
+	/* WRITE_MEM/WRITE_MEM_H/WRITE_MEM_B append to the packet buffer
+	 * in PACK mode, so the remaining per-unit loops can pipeline many
+	 * commands into each bulk-out transfer instead of waiting for an
+	 * ack per unit.  Leave BATCH mode alone if the caller set it up. */
+	bool packed = false;
+	if ((AICE_COMMAND_MODE_NORMAL == aice_command_mode) &&
+			(NDS_MEMORY_ACC_BUS == core_info[coreid].access_channel)) {
+		aice_command_mode = AICE_COMMAND_MODE_PACK;
+		packed = true;
+	}
+
 	size_t i;
 	write_mem_func_t write_mem_func;
 
@@ -3276,6 +3304,13 @@ static int aice_usb_write_memory_unit(uint32_t coreid, uint32_t addr, uint32_t s
 			break;
 	}
 
+	if (packed) {
+		int retval = aice_usb_packet_flush();
+		aice_command_mode = AICE_COMMAND_MODE_NORMAL;
+		if (retval != ERROR_OK)
+			return ERROR_FAIL;
+	}
+
 	return ERROR_OK;
 }
 
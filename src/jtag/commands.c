@@ -38,15 +38,29 @@
 struct cmd_queue_page {
 	struct cmd_queue_page *next;
 	void *address;
+	size_t size;
 	size_t used;
 };
 
 #define CMD_QUEUE_PAGE_SIZE (1024 * 1024)
+
+/* The command queue arena.  Pages are retained across queue resets and
+ * recycled by rewriting their bump pointer, so steady-state queue build-up
+ * between flushes performs no heap allocation at all.  The list only grows
+ * when a queue exceeds the high-water mark of all earlier queues.
+ */
 static struct cmd_queue_page *cmd_queue_pages;
-static struct cmd_queue_page *cmd_queue_pages_tail;
+/* Page currently being carved up; NULL means "start over at the head". */
+static struct cmd_queue_page *cmd_queue_page_current;
 
 struct jtag_command *jtag_command_queue;
 static struct jtag_command **next_command_pointer = &jtag_command_queue;
+static int jtag_command_queue_length;
+
+int jtag_command_queue_get_length(void)
+{
+	return jtag_command_queue_length;
+}
 
 void jtag_queue_command(struct jtag_command *cmd)
 {
@@ -60,11 +74,11 @@ void jtag_queue_command(struct jtag_command *cmd)
 
 	/* store location where the next command pointer will be stored */
 	next_command_pointer = &cmd->next;
+	jtag_command_queue_length++;
 }
 
 void *cmd_queue_alloc(size_t size)
 {
-	struct cmd_queue_page **p_page = &cmd_queue_pages;
 	int offset;
 	uint8_t *t;
 
@@ -100,30 +114,49 @@ void *cmd_queue_alloc(size_t size)
 	size = (size + ALIGN_SIZE - 1) & (~(ALIGN_SIZE - 1));
 	/* Done... */
 
-	if (*p_page) {
-		p_page = &cmd_queue_pages_tail;
-		if (CMD_QUEUE_PAGE_SIZE - (*p_page)->used < size)
-			p_page = &((*p_page)->next);
+	/* After a reset, recycle the retained pages from the head. */
+	if (!cmd_queue_page_current && cmd_queue_pages) {
+		cmd_queue_page_current = cmd_queue_pages;
+		cmd_queue_page_current->used = 0;
+	}
+
+	/* Move on to the next (possibly recycled) page when the current
+	 * one cannot satisfy the request. */
+	while (cmd_queue_page_current &&
+			cmd_queue_page_current->size - cmd_queue_page_current->used < size) {
+		struct cmd_queue_page *next = cmd_queue_page_current->next;
+		if (!next || next->size < size)
+			break;
+		next->used = 0;
+		cmd_queue_page_current = next;
 	}
 
-	if (!*p_page) {
-		*p_page = malloc(sizeof(struct cmd_queue_page));
-		(*p_page)->used = 0;
-		size_t alloc_size = (size < CMD_QUEUE_PAGE_SIZE) ?
+	if (!cmd_queue_page_current ||
+			cmd_queue_page_current->size - cmd_queue_page_current->used < size) {
+		struct cmd_queue_page *page = malloc(sizeof(struct cmd_queue_page));
+		page->used = 0;
+		page->size = (size < CMD_QUEUE_PAGE_SIZE) ?
 					CMD_QUEUE_PAGE_SIZE : size;
-		(*p_page)->address = malloc(alloc_size);
-		(*p_page)->next = NULL;
-		cmd_queue_pages_tail = *p_page;
+		page->address = malloc(page->size);
+		if (cmd_queue_page_current) {
+			/* Keep recyclable pages ordered as allocated. */
+			page->next = cmd_queue_page_current->next;
+			cmd_queue_page_current->next = page;
+		} else {
+			page->next = cmd_queue_pages;
+			cmd_queue_pages = page;
+		}
+		cmd_queue_page_current = page;
 	}
 
-	offset = (*p_page)->used;
-	(*p_page)->used += size;
+	offset = cmd_queue_page_current->used;
+	cmd_queue_page_current->used += size;
 
-	t = (*p_page)->address;
+	t = cmd_queue_page_current->address;
 	return t + offset;
 }
 
-static void cmd_queue_free(void)
+void cmd_queue_free(void)
 {
 	struct cmd_queue_page *page = cmd_queue_pages;
 
@@ -135,15 +168,18 @@ static void cmd_queue_free(void)
 	}
 
 	cmd_queue_pages = NULL;
-	cmd_queue_pages_tail = NULL;
+	cmd_queue_page_current = NULL;
 }
 
 void jtag_command_queue_reset(void)
 {
-	cmd_queue_free();
+	/* O(1) bulk reset: pages stay allocated for the next queue and are
+	 * rewound lazily by cmd_queue_alloc(). */
+	cmd_queue_page_current = NULL;
 
 	jtag_command_queue = NULL;
 	next_command_pointer = &jtag_command_queue;
+	jtag_command_queue_length = 0;
 }
 
 enum scan_type jtag_scan_type(const struct scan_command *cmd)
@@ -229,11 +265,19 @@ int jtag_read_buffer(uint8_t *buffer, const struct scan_command *cmd)
 		 */
 		if (cmd->fields[i].in_value) {
 			int num_bits = cmd->fields[i].num_bits;
-			uint8_t *captured = buf_set_buf(buffer, bit_count,
-					malloc(DIV_ROUND_UP(num_bits, 8)), 0, num_bits);
+			uint8_t *in_value = cmd->fields[i].in_value;
+
+			/* extract the bits straight into in_value; no
+			 * intermediate allocation and copy */
+			buf_set_buf(buffer, bit_count, in_value, 0, num_bits);
+
+			/* mask out bits that don't belong to the value,
+			 * like buf_cpy() used to do */
+			if (num_bits % 8)
+				in_value[num_bits / 8] &= (1 << (num_bits % 8)) - 1;
 
 #ifdef _DEBUG_JTAG_IO_
-			char *char_buf = buf_to_str(captured,
+			char *char_buf = buf_to_str(in_value,
 					(num_bits > DEBUG_JTAG_IOZ)
 						? DEBUG_JTAG_IOZ
 						: num_bits, 16);
@@ -242,11 +286,6 @@ int jtag_read_buffer(uint8_t *buffer, const struct scan_command *cmd)
 					i, num_bits, char_buf);
 			free(char_buf);
 #endif
-
-			if (cmd->fields[i].in_value)
-				buf_cpy(captured, cmd->fields[i].in_value, num_bits);
-
-			free(captured);
 		}
 		bit_count += cmd->fields[i].num_bits;
 	}
@@ -166,10 +166,14 @@ struct jtag_command {
 extern struct jtag_command *jtag_command_queue;
 
 void *cmd_queue_alloc(size_t size);
+void cmd_queue_free(void);
 
 void jtag_queue_command(struct jtag_command *cmd);
 void jtag_command_queue_reset(void);
 
+/** @returns the number of commands currently queued and not yet flushed. */
+int jtag_command_queue_get_length(void);
+
 enum scan_type jtag_scan_type(const struct scan_command *cmd);
 int jtag_scan_size(const struct scan_command *cmd);
 int jtag_read_buffer(uint8_t *buffer, const struct scan_command *cmd);
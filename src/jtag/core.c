@@ -37,6 +37,9 @@
 #include "interface.h"
 #include <transport/transport.h>
 #include <helper/jep106.h>
+#include <helper/time_support.h>
+#include <helper/profiling.h>
+#include <helper/binarytrace.h>
 
 #ifdef HAVE_STRINGS_H
 #include <strings.h>
@@ -97,6 +100,7 @@ tap_state_t cmd_queue_cur_state = TAP_RESET;
 
 static bool jtag_verify_capture_ir = true;
 static int jtag_verify = 1;
+static bool jtag_ir_scan_cache;
 
 /* how long the OpenOCD should wait before attempting JTAG communication after reset lines
  *deasserted (in ms) */
@@ -371,11 +375,55 @@ static void jtag_add_ir_scan_noverify_callback(struct jtag_tap *active,
 	jtag_add_ir_scan_noverify(active, in_fields, state);
 }
 
+/**
+ * Check whether an IR scan would be a no-op: the addressed TAP already
+ * holds the requested instruction and every other enabled TAP is in
+ * BYPASS, so shifting the chain again would latch identical state.
+ */
+static bool jtag_ir_scan_is_redundant(struct jtag_tap *active,
+	const struct scan_field *in_fields)
+{
+	if (!active || active->bypass || !active->cur_instr_valid)
+		return false;
+
+	if (!in_fields->out_value || in_fields->in_value)
+		return false;
+
+	if (in_fields->num_bits != active->ir_length)
+		return false;
+
+	/* buf_cmp() only reports differences confined to the trailing
+	 * partial byte; compare explicitly so a different instruction can
+	 * never be judged identical and wrongly elided */
+	unsigned full_bytes = active->ir_length / 8;
+	if (memcmp(in_fields->out_value, active->cur_instr, full_bytes) != 0)
+		return false;
+
+	unsigned trailing = active->ir_length % 8;
+	if (trailing) {
+		uint8_t mask = (1 << trailing) - 1;
+		if ((in_fields->out_value[full_bytes] & mask) !=
+				(active->cur_instr[full_bytes] & mask))
+			return false;
+	}
+
+	for (struct jtag_tap *tap = jtag_tap_next_enabled(NULL); tap != NULL;
+			tap = jtag_tap_next_enabled(tap)) {
+		if (tap != active && (!tap->bypass || !tap->cur_instr_valid))
+			return false;
+	}
+
+	return true;
+}
+
 /* If fields->in_value is filled out, then the captured IR value will be checked */
 void jtag_add_ir_scan(struct jtag_tap *active, struct scan_field *in_fields, tap_state_t state)
 {
 	assert(state != TAP_RESET);
 
+	if (jtag_ir_scan_cache && jtag_ir_scan_is_redundant(active, in_fields))
+		return;
+
 	if (jtag_verify && jtag_verify_capture_ir) {
 		/* 8 x 32 bit id's is enough for all invocations */
 
@@ -396,6 +444,12 @@ void jtag_add_plain_ir_scan(int num_bits, const uint8_t *out_bits, uint8_t *in_b
 	assert(out_bits != NULL);
 	assert(state != TAP_RESET);
 
+	/* the raw bits shift through every instruction register on the
+	 * chain; no tap's cached instruction can be trusted afterwards */
+	for (struct jtag_tap *tap = jtag_tap_next_enabled(NULL); tap != NULL;
+			tap = jtag_tap_next_enabled(tap))
+		tap->cur_instr_valid = false;
+
 	jtag_prelude(state);
 
 	int retval = interface_jtag_add_plain_ir_scan(
@@ -464,6 +518,20 @@ void jtag_add_dr_scan(struct jtag_tap *active,
 	jtag_set_error(retval);
 }
 
+void jtag_add_dr_scan_borrow(struct jtag_tap *active,
+	int in_num_fields,
+	const struct scan_field *in_fields,
+	tap_state_t state)
+{
+	assert(state != TAP_RESET);
+
+	jtag_prelude(state);
+
+	int retval;
+	retval = interface_jtag_add_dr_scan_borrow(active, in_num_fields, in_fields, state);
+	jtag_set_error(retval);
+}
+
 void jtag_add_plain_dr_scan(int num_bits, const uint8_t *out_bits, uint8_t *in_bits,
 	tap_state_t state)
 {
@@ -841,10 +909,154 @@ int default_interface_jtag_execute_queue(void)
 	return jtag->execute_queue();
 }
 
+/* Adaptive flush scheduling.  Each flush's round-trip latency is folded
+ * into an exponentially weighted moving average, and asynchronous
+ * submissions are only pushed onto the wire once the queue has grown to
+ * a budget derived from that latency: slow (high-latency) links get
+ * larger batches so the fixed round-trip cost is amortized, low-latency
+ * links flush almost immediately. */
+#define JTAG_FLUSH_BUDGET_MIN		64
+#define JTAG_FLUSH_BUDGET_MAX		65536
+
+static int64_t jtag_flush_latency_avg_us;
+
+int64_t jtag_get_flush_avg_latency(void)
+{
+	return jtag_flush_latency_avg_us;
+}
+
+int jtag_get_flush_budget(void)
+{
+	/* one queued command per microsecond of measured round-trip */
+	int64_t budget = jtag_flush_latency_avg_us;
+
+	if (budget < JTAG_FLUSH_BUDGET_MIN)
+		budget = JTAG_FLUSH_BUDGET_MIN;
+	if (budget > JTAG_FLUSH_BUDGET_MAX)
+		budget = JTAG_FLUSH_BUDGET_MAX;
+
+	return (int)budget;
+}
+
+/* Cumulative adapter transfer statistics; updated by the driver
+ * dispatch layer, displayed and reset by the adapter_stats command. */
+static struct jtag_interface_stats interface_stats;
+
+void jtag_record_transaction_stats(int64_t payload_bytes, int64_t wire_bytes,
+		int64_t latency_us)
+{
+	interface_stats.transactions++;
+	interface_stats.payload_bytes += payload_bytes;
+	interface_stats.wire_bytes += wire_bytes;
+
+	if (latency_us < 0)
+		return;
+
+	interface_stats.latency_us += latency_us;
+
+	unsigned bucket = 0;
+	while ((latency_us >> (bucket + 1)) != 0
+			&& bucket < JTAG_STATS_LATENCY_BUCKETS - 1)
+		bucket++;
+	interface_stats.latency_histogram[bucket]++;
+}
+
+const struct jtag_interface_stats *jtag_get_interface_stats(void)
+{
+	return &interface_stats;
+}
+
+void jtag_clear_interface_stats(void)
+{
+	memset(&interface_stats, 0, sizeof(interface_stats));
+}
+
+static void jtag_flush_latency_update(const struct duration *bench)
+{
+	int64_t elapsed_us = (int64_t)(duration_elapsed(bench) * 1000000.0);
+
+	if (elapsed_us < 0)
+		return;
+
+	if (jtag_flush_latency_avg_us == 0)
+		jtag_flush_latency_avg_us = elapsed_us;
+	else
+		jtag_flush_latency_avg_us +=
+			(elapsed_us - jtag_flush_latency_avg_us) / 8;
+}
+
+/* Completion handlers registered by jtag_execute_queue_async(); they are
+ * delivered, in submission order, by the next flush of the queue. */
+struct jtag_queue_completion {
+	struct jtag_queue_completion *next;
+	jtag_queue_complete_t callback;
+	void *priv;
+};
+
+static struct jtag_queue_completion *jtag_queue_completions;
+static struct jtag_queue_completion **jtag_queue_completions_tail =
+		&jtag_queue_completions;
+
+int jtag_execute_queue_async(jtag_queue_complete_t callback, void *priv)
+{
+	struct jtag_queue_completion *completion;
+
+	if (!callback)
+		return ERROR_OK;
+
+	completion = malloc(sizeof(*completion));
+	if (!completion)
+		return ERROR_FAIL;
+
+	completion->next = NULL;
+	completion->callback = callback;
+	completion->priv = priv;
+
+	*jtag_queue_completions_tail = completion;
+	jtag_queue_completions_tail = &completion->next;
+
+	/* flush once the queue outgrows the learned byte/latency budget */
+	if (jtag_command_queue_get_length() >= jtag_get_flush_budget())
+		jtag_execute_queue_noclear();
+
+	return ERROR_OK;
+}
+
+static void jtag_notify_queue_completions(int retval)
+{
+	struct jtag_queue_completion *completion = jtag_queue_completions;
+
+	/* reset the list first: a completion handler may submit again */
+	jtag_queue_completions = NULL;
+	jtag_queue_completions_tail = &jtag_queue_completions;
+
+	while (completion) {
+		struct jtag_queue_completion *next = completion->next;
+		completion->callback(retval, completion->priv);
+		free(completion);
+		completion = next;
+	}
+}
+
 void jtag_execute_queue_noclear(void)
 {
+	struct duration bench;
+
 	jtag_flush_queue_count++;
+
+	duration_start(&bench);
 	jtag_set_error(interface_jtag_execute_queue());
+	duration_measure(&bench);
+	jtag_flush_latency_update(&bench);
+
+	if (jtag_error != ERROR_OK) {
+		/* chain state is suspect; don't elide IR scans based on it */
+		for (struct jtag_tap *tap = jtag_tap_next_enabled(NULL); tap != NULL;
+				tap = jtag_tap_next_enabled(tap))
+			tap->cur_instr_valid = false;
+	}
+
+	jtag_notify_queue_completions(jtag_error);
 
 	if (jtag_flush_queue_sleep > 0) {
 		/* For debug purposes it can be useful to test performance
@@ -862,8 +1074,15 @@ int jtag_get_flush_queue_count(void)
 
 int jtag_execute_queue(void)
 {
+	int64_t profile_start = profile_enter();
+
 	jtag_execute_queue_noclear();
-	return jtag_error_clear();
+
+	int retval = jtag_error_clear();
+	profile_leave(PROFILE_JTAG_EXECUTE_QUEUE, profile_start);
+	trace_ring_emit(TRACE_SUBSYS_JTAG, TRACE_EV_JTAG_QUEUE_RUN,
+		(uint32_t)retval, jtag_flush_queue_count);
+	return retval;
 }
 
 static int jtag_reset_callback(enum jtag_event event, void *priv)
@@ -875,6 +1094,7 @@ static int jtag_reset_callback(enum jtag_event event, void *priv)
 
 		/* current instruction is either BYPASS or IDCODE */
 		buf_set_ones(tap->cur_instr, tap->ir_length);
+		tap->cur_instr_valid = false;
 		tap->bypass = 1;
 	}
 
@@ -1037,6 +1257,128 @@ static bool jtag_examine_chain_match_tap(const struct jtag_tap *tap)
 	return false;
 }
 
+/* Once a chain has been fully examined and its IR capture validated,
+ * later (re-)inits only need to confirm that nothing changed.  The
+ * cache marks the layout held in the tap structs as trustworthy, so
+ * revalidation can check the IDCODE vector and the IR capture values
+ * in a single flush instead of re-deriving the layout with two. */
+static bool jtag_chain_cache_valid;
+static unsigned jtag_chain_cache_tap_count;
+
+static void jtag_chain_cache_invalidate(void)
+{
+	jtag_chain_cache_valid = false;
+}
+
+/* Fast revalidation of a previously examined chain.  Returns ERROR_OK
+ * only when both the IDCODE vector and the IR capture values match the
+ * cached layout; any difference (or an unexamined chain) invalidates
+ * the cache so the caller falls back to the full interrogation. */
+int jtag_verify_chain(void)
+{
+	struct jtag_tap *tap;
+	unsigned num_idcode = 0;
+	int total_ir_length = 0;
+	uint8_t *idcode_buffer = NULL;
+	uint8_t *ir_test = NULL;
+	unsigned bit_count;
+	int chain_pos;
+	uint64_t val;
+	int retval = ERROR_FAIL;
+
+	for (tap = NULL; (tap = jtag_tap_next_enabled(tap)) != NULL; ) {
+		if (tap->ir_length <= 0)
+			return ERROR_FAIL;
+		num_idcode++;
+		total_ir_length += tap->ir_length;
+	}
+	if (num_idcode == 0)
+		return ERROR_FAIL;
+
+	/* room for the end-of-chain marker and the 2 bit IR sentinel */
+	num_idcode++;
+	total_ir_length += 2;
+
+	idcode_buffer = malloc(num_idcode * 4);
+	ir_test = malloc(DIV_ROUND_UP(total_ir_length, 8));
+	if (idcode_buffer == NULL || ir_test == NULL)
+		goto done;
+
+	for (unsigned i = 0; i < num_idcode; i++)
+		buf_set_u32(idcode_buffer, i * 32, 32, END_OF_CHAIN_FLAG);
+	buf_set_ones(ir_test, total_ir_length);
+
+	/* the same wire sequence the full path uses, in one round trip */
+	jtag_add_plain_dr_scan(num_idcode * 32, idcode_buffer, idcode_buffer, TAP_DRPAUSE);
+	jtag_add_tlr();
+	jtag_add_plain_ir_scan(total_ir_length, ir_test, ir_test, TAP_IDLE);
+	retval = jtag_execute_queue();
+	if (retval != ERROR_OK)
+		goto done;
+
+	retval = ERROR_FAIL;
+	bit_count = 0;
+	chain_pos = 0;
+	for (tap = NULL; (tap = jtag_tap_next_enabled(tap)) != NULL; ) {
+		if (tap->hasidcode) {
+			if (buf_get_u32(idcode_buffer, bit_count, 32) != tap->idcode)
+				goto done;
+			bit_count += 32;
+		} else {
+			if (buf_get_u32(idcode_buffer, bit_count, 1) != 0)
+				goto done;
+			bit_count += 1;
+		}
+
+		val = buf_get_u64(ir_test, chain_pos, tap->ir_length);
+		if ((val & tap->ir_capture_mask) != tap->ir_capture_value)
+			goto done;
+		chain_pos += tap->ir_length;
+	}
+
+	/* end-of-chain marker and IR sentinel, as in the full path */
+	if (!jtag_idcode_is_final(buf_get_u32(idcode_buffer, bit_count, 32)))
+		goto done;
+	if (buf_get_u64(ir_test, chain_pos, 2) != 0x3)
+		goto done;
+
+	retval = ERROR_OK;
+
+done:
+	free(idcode_buffer);
+	free(ir_test);
+	if (retval != ERROR_OK) {
+		/* leave the chain in a known state */
+		jtag_add_tlr();
+		jtag_execute_queue();
+	}
+	return retval;
+}
+
+static int jtag_examine_chain_fast(void)
+{
+	struct jtag_tap *tap;
+	unsigned num_idcode = 0;
+
+	if (!jtag_chain_cache_valid)
+		return ERROR_FAIL;
+
+	for (tap = NULL; (tap = jtag_tap_next_enabled(tap)) != NULL; )
+		num_idcode++;
+	if (num_idcode != jtag_chain_cache_tap_count)
+		return ERROR_FAIL;
+
+	int retval = jtag_verify_chain();
+	if (retval != ERROR_OK) {
+		jtag_chain_cache_invalidate();
+		return retval;
+	}
+
+	LOG_DEBUG("scan chain matches cached layout (%u taps)",
+		jtag_chain_cache_tap_count);
+	return ERROR_OK;
+}
+
 /* Try to examine chain layout according to IEEE 1149.1 §12
  * This is called a "blind interrogation" of the scan chain.
  */
@@ -1298,6 +1640,7 @@ void jtag_tap_init(struct jtag_tap *tap)
 	/* register the reset callback for the TAP */
 	jtag_register_event_callback(&jtag_reset_callback, tap);
 	jtag_tap_add(tap);
+	jtag_chain_cache_invalidate();
 
 	LOG_DEBUG("Created Tap: %s @ abs position %d, "
 			"irlen %d, capture: 0x%x mask: 0x%x", tap->dotted_name,
@@ -1308,6 +1651,7 @@ void jtag_tap_init(struct jtag_tap *tap)
 
 void jtag_tap_free(struct jtag_tap *tap)
 {
+	jtag_chain_cache_invalidate();
 	jtag_unregister_event_callback(&jtag_reset_callback, tap);
 
 	free(tap->expected);
@@ -1424,43 +1768,54 @@ int jtag_init_inner(struct command_context *cmd_ctx)
 	if (retval != ERROR_OK)
 		return retval;
 
-	/* Examine DR values first.  This discovers problems which will
-	 * prevent communication ... hardware issues like TDO stuck, or
-	 * configuring the wrong number of (enabled) TAPs.
+	/* A chain that was fully examined before only needs confirming
+	 * against the cached layout, which takes a single flush; any
+	 * difference falls back to the full interrogation below.
 	 */
-	retval = jtag_examine_chain();
-	switch (retval) {
-		case ERROR_OK:
-			/* complete success */
-			break;
-		default:
-			/* For backward compatibility reasons, try coping with
-			 * configuration errors involving only ID mismatches.
-			 * We might be able to talk to the devices.
-			 *
-			 * Also the device might be powered down during startup.
-			 *
-			 * After OpenOCD starts, we can try to power on the device
-			 * and run a reset.
-			 */
-			LOG_ERROR("Trying to use configured scan chain anyway...");
-			issue_setup = false;
-			break;
-	}
+	if (jtag_examine_chain_fast() != ERROR_OK) {
+		/* Examine DR values first.  This discovers problems which will
+		 * prevent communication ... hardware issues like TDO stuck, or
+		 * configuring the wrong number of (enabled) TAPs.
+		 */
+		retval = jtag_examine_chain();
+		switch (retval) {
+			case ERROR_OK:
+				/* complete success */
+				break;
+			default:
+				/* For backward compatibility reasons, try coping with
+				 * configuration errors involving only ID mismatches.
+				 * We might be able to talk to the devices.
+				 *
+				 * Also the device might be powered down during startup.
+				 *
+				 * After OpenOCD starts, we can try to power on the device
+				 * and run a reset.
+				 */
+				LOG_ERROR("Trying to use configured scan chain anyway...");
+				issue_setup = false;
+				break;
+		}
 
-	/* Now look at IR values.  Problems here will prevent real
-	 * communication.  They mostly mean that the IR length is
-	 * wrong ... or that the IR capture value is wrong.  (The
-	 * latter is uncommon, but easily worked around:  provide
-	 * ircapture/irmask values during TAP setup.)
-	 */
-	retval = jtag_validate_ircapture();
-	if (retval != ERROR_OK) {
-		/* The target might be powered down. The user
-		 * can power it up and reset it after firing
-		 * up OpenOCD.
+		/* Now look at IR values.  Problems here will prevent real
+		 * communication.  They mostly mean that the IR length is
+		 * wrong ... or that the IR capture value is wrong.  (The
+		 * latter is uncommon, but easily worked around:  provide
+		 * ircapture/irmask values during TAP setup.)
 		 */
-		issue_setup = false;
+		retval = jtag_validate_ircapture();
+		if (retval != ERROR_OK) {
+			/* The target might be powered down. The user
+			 * can power it up and reset it after firing
+			 * up OpenOCD.
+			 */
+			issue_setup = false;
+		} else if (issue_setup) {
+			/* layout fully validated; later inits may take
+			 * the fast path */
+			jtag_chain_cache_valid = true;
+			jtag_chain_cache_tap_count = jtag_tap_count_enabled();
+		}
 	}
 
 	if (issue_setup)
@@ -1482,6 +1837,9 @@ int adapter_quit(void)
 	if (ERROR_OK != result)
 		LOG_ERROR("failed: %d", result);
 
+	/* release the pages retained by the command queue arena */
+	cmd_queue_free();
+
 	return ERROR_OK;
 }
 
@@ -1692,6 +2050,16 @@ bool jtag_will_verify_capture_ir()
 	return jtag_verify_capture_ir;
 }
 
+void jtag_set_ir_scan_cache(bool enable)
+{
+	jtag_ir_scan_cache = enable;
+}
+
+bool jtag_will_cache_ir_scans(void)
+{
+	return jtag_ir_scan_cache;
+}
+
 int jtag_power_dropout(int *dropout)
 {
 	if (jtag == NULL) {
@@ -36,6 +36,10 @@ uint32_t bcm2835_peri_base = 0x20000000;
 #define BCM2835_PADS_GPIO_0_27		(bcm2835_peri_base + 0x100000)
 #define BCM2835_PADS_GPIO_0_27_OFFSET	(0x2c / 4)
 
+/* free-running 1 MHz system timer, used to calibrate the delay loop */
+#define BCM2835_SYSTIMER_BASE		(bcm2835_peri_base + 0x3000)
+#define BCM2835_SYSTIMER_CLO_OFFSET	(0x04 / 4)
+
 /* GPIO setup macros */
 #define MODE_GPIO(g) (*(pio_base+((g)/10))>>(((g)%10)*3) & 7)
 #define INP_GPIO(g) do { *(pio_base+((g)/10)) &= ~(7<<(((g)%10)*3)); } while (0)
@@ -50,9 +54,12 @@ uint32_t bcm2835_peri_base = 0x20000000;
 
 static int dev_mem_fd;
 static volatile uint32_t *pio_base;
+static volatile uint32_t *systimer_base = MAP_FAILED;
 
 static int bcm2835gpio_read(void);
 static void bcm2835gpio_write(int tck, int tms, int tdi);
+static void bcm2835gpio_block_transfer(const uint8_t *tms_buf, const uint8_t *tdi_buf,
+		uint8_t *tdo_buf, unsigned num_bits);
 static void bcm2835gpio_reset(int trst, int srst);
 
 static int bcm2835_swdio_read(void);
@@ -64,6 +71,7 @@ static int bcm2835gpio_quit(void);
 static struct bitbang_interface bcm2835gpio_bitbang = {
 	.read = bcm2835gpio_read,
 	.write = bcm2835gpio_write,
+	.block_transfer = bcm2835gpio_block_transfer,
 	.reset = bcm2835gpio_reset,
 	.swdio_read = bcm2835_swdio_read,
 	.swdio_drive = bcm2835_swdio_drive,
@@ -88,9 +96,12 @@ static int swclk_gpio_mode;
 static int swdio_gpio = -1;
 static int swdio_gpio_mode;
 
-/* Transition delay coefficients */
+/* Transition delay coefficients; defaults suit an original RPi1, but
+ * are recalibrated against the system timer at init unless they were
+ * set explicitly with bcm2835gpio_speed_coeffs. */
 static int speed_coeff = 113714;
 static int speed_offset = 28;
+static bool speed_coeff_custom;
 static unsigned int jtag_delay;
 
 static int bcm2835gpio_read(void)
@@ -110,6 +121,40 @@ static void bcm2835gpio_write(int tck, int tms, int tdi)
 		asm volatile ("");
 }
 
+/* Block variant of bcm2835gpio_write(); one tight loop over the packed
+ * buffers saves the two indirect calls per TCK cycle. */
+static void bcm2835gpio_block_transfer(const uint8_t *tms_buf, const uint8_t *tdi_buf,
+		uint8_t *tdo_buf, unsigned num_bits)
+{
+	for (unsigned i = 0; i < num_bits; i++) {
+		int bytec = i / 8;
+		int bcval = 1 << (i % 8);
+		int tms = tms_buf ? !!(tms_buf[bytec] & bcval) : 0;
+		int tdi = tdi_buf ? !!(tdi_buf[bytec] & bcval) : 0;
+
+		uint32_t set = tms<<tms_gpio | tdi<<tdi_gpio;
+		uint32_t clear = !tms<<tms_gpio | !tdi<<tdi_gpio | 1<<tck_gpio;
+
+		GPIO_SET = set;
+		GPIO_CLR = clear;
+
+		for (unsigned int j = 0; j < jtag_delay; j++)
+			asm volatile ("");
+
+		if (tdo_buf) {
+			if (GPIO_LEV & 1<<tdo_gpio)
+				tdo_buf[bytec] |= bcval;
+			else
+				tdo_buf[bytec] &= ~bcval;
+		}
+
+		GPIO_SET = 1<<tck_gpio;
+
+		for (unsigned int j = 0; j < jtag_delay; j++)
+			asm volatile ("");
+	}
+}
+
 static void bcm2835gpio_swd_write(int tck, int tms, int tdi)
 {
 	uint32_t set = tck<<swclk_gpio | tdi<<swdio_gpio;
@@ -179,6 +224,35 @@ static int bcm2835gpio_speed(int speed)
 	return ERROR_OK;
 }
 
+/* Time the transition delay loop against the free-running 1 MHz system
+ * timer and derive speed_coeff from the measured rate.  The DMA engine
+ * would give cycle-exact pacing, but claiming a channel and uncached
+ * memory through the firmware mailbox is out of scope for this driver;
+ * a measured coefficient already removes the guesswork across the
+ * different SoC revisions and clock governors. */
+static void bcm2835gpio_calibrate_delay(void)
+{
+	const unsigned int iterations = 5000000;
+
+	uint32_t start = systimer_base[BCM2835_SYSTIMER_CLO_OFFSET];
+	for (unsigned int i = 0; i < iterations; i++)
+		asm volatile ("");
+	uint32_t elapsed_us = systimer_base[BCM2835_SYSTIMER_CLO_OFFSET] - start;
+
+	if (!elapsed_us) {
+		LOG_WARNING("BCM2835 GPIO: system timer not running, "
+			"keeping default delay coefficients");
+		return;
+	}
+
+	/* iterations per half TCK period at 1 kHz */
+	speed_coeff = (int)((uint64_t)iterations * 500 / elapsed_us);
+
+	LOG_INFO("BCM2835 GPIO: delay loop runs at %u iterations/ms, "
+		"speed_coeff %d", (unsigned int)((uint64_t)iterations * 1000 / elapsed_us),
+		speed_coeff);
+}
+
 static int is_gpio_valid(int gpio)
 {
 	return gpio >= 0 && gpio <= 53;
@@ -295,6 +369,7 @@ COMMAND_HANDLER(bcm2835gpio_handle_speed_coeffs)
 	if (CMD_ARGC == 2) {
 		COMMAND_PARSE_NUMBER(int, CMD_ARGV[0], speed_coeff);
 		COMMAND_PARSE_NUMBER(int, CMD_ARGV[1], speed_offset);
+		speed_coeff_custom = true;
 	}
 	return ERROR_OK;
 }
@@ -473,6 +548,17 @@ static int bcm2835gpio_init(void)
 	/* set 16mA drive strength */
 	pads_base[BCM2835_PADS_GPIO_0_27_OFFSET] = 0x5a000018 + 7;
 
+	if (!speed_coeff_custom) {
+		systimer_base = mmap(NULL, sysconf(_SC_PAGE_SIZE), PROT_READ,
+					MAP_SHARED, dev_mem_fd, BCM2835_SYSTIMER_BASE);
+
+		if (systimer_base == MAP_FAILED)
+			LOG_WARNING("BCM2835 GPIO: cannot map system timer, "
+				"keeping default delay coefficients");
+		else
+			bcm2835gpio_calibrate_delay();
+	}
+
 	tdo_gpio_mode = MODE_GPIO(tdo_gpio);
 	tdi_gpio_mode = MODE_GPIO(tdi_gpio);
 	tck_gpio_mode = MODE_GPIO(tck_gpio);
@@ -69,6 +69,39 @@ struct bitbang_interface *bitbang_interface;
  */
 #define CLOCK_IDLE() 0
 
+/**
+ * Clock a packed buffer of TMS/TDI bits and capture packed TDO,
+ * through the backend's block callback when it provides one, bit by
+ * bit through write()/read() otherwise. TCK is left high after the
+ * last bit; callers park it with a final write() where needed.
+ */
+static void bitbang_clock_block(const uint8_t *tms, const uint8_t *tdi,
+		uint8_t *tdo, unsigned num_bits)
+{
+	if (bitbang_interface->block_transfer) {
+		bitbang_interface->block_transfer(tms, tdi, tdo, num_bits);
+		return;
+	}
+
+	for (unsigned i = 0; i < num_bits; i++) {
+		int bytec = i / 8;
+		int bcval = 1 << (i % 8);
+		int tms_bit = tms ? !!(tms[bytec] & bcval) : 0;
+		int tdi_bit = tdi ? !!(tdi[bytec] & bcval) : 0;
+
+		bitbang_interface->write(0, tms_bit, tdi_bit);
+
+		if (tdo) {
+			if (bitbang_interface->read())
+				tdo[bytec] |= bcval;
+			else
+				tdo[bytec] &= ~bcval;
+		}
+
+		bitbang_interface->write(1, tms_bit, tdi_bit);
+	}
+}
+
 /* The bitbang driver leaves the TCK 0 when in idle */
 static void bitbang_end_state(tap_state_t state)
 {
@@ -108,10 +141,9 @@ static int bitbang_execute_tms(struct jtag_command *cmd)
 	DEBUG_JTAG_IO("TMS: %d bits", num_bits);
 
 	int tms = 0;
-	for (unsigned i = 0; i < num_bits; i++) {
-		tms = ((bits[i/8] >> (i % 8)) & 1);
-		bitbang_interface->write(0, tms, 0);
-		bitbang_interface->write(1, tms, 0);
+	if (num_bits) {
+		bitbang_clock_block(bits, NULL, NULL, num_bits);
+		tms = (bits[(num_bits - 1) / 8] >> ((num_bits - 1) % 8)) & 1;
 	}
 	bitbang_interface->write(CLOCK_IDLE(), tms, 0);
 
@@ -152,8 +184,6 @@ static void bitbang_path_move(struct pathmove_command *cmd)
 
 static void bitbang_runtest(int num_cycles)
 {
-	int i;
-
 	tap_state_t saved_end_state = tap_get_end_state();
 
 	/* only do a state_move when we're not already in IDLE */
@@ -163,10 +193,7 @@ static void bitbang_runtest(int num_cycles)
 	}
 
 	/* execute num_cycles */
-	for (i = 0; i < num_cycles; i++) {
-		bitbang_interface->write(0, 0, 0);
-		bitbang_interface->write(1, 0, 0);
-	}
+	bitbang_clock_block(NULL, NULL, NULL, num_cycles);
 	bitbang_interface->write(CLOCK_IDLE(), 0, 0);
 
 	/* finish in end_state */
@@ -190,7 +217,6 @@ static void bitbang_stableclocks(int num_cycles)
 static void bitbang_scan(bool ir_scan, enum scan_type type, uint8_t *buffer, int scan_size)
 {
 	tap_state_t saved_end_state = tap_get_end_state();
-	int bit_cnt;
 
 	if (!((!ir_scan &&
 			(tap_get_state() == TAP_DRSHIFT)) ||
@@ -204,36 +230,39 @@ static void bitbang_scan(bool ir_scan, enum scan_type type, uint8_t *buffer, int
 		bitbang_end_state(saved_end_state);
 	}
 
-	for (bit_cnt = 0; bit_cnt < scan_size; bit_cnt++) {
-		int val = 0;
-		int tms = (bit_cnt == scan_size-1) ? 1 : 0;
-		int tdi;
-		int bytec = bit_cnt/8;
-		int bcval = 1 << (bit_cnt % 8);
-
-		/* if we're just reading the scan, but don't care about the output
-		 * default to outputting 'low', this also makes valgrind traces more readable,
-		 * as it removes the dependency on an uninitialised value
-		 */
-		tdi = 0;
-		if ((type != SCAN_IN) && (buffer[bytec] & bcval))
-			tdi = 1;
-
-		bitbang_interface->write(0, tms, tdi);
-
-		if (type != SCAN_OUT)
-			val = bitbang_interface->read();
-
-		bitbang_interface->write(1, tms, tdi);
+	if (!scan_size)
+		return;
 
-		if (type != SCAN_OUT) {
-			if (val)
-				buffer[bytec] |= bcval;
-			else
-				buffer[bytec] &= ~bcval;
-		}
+	/* TMS stays low for all but the last bit, so the body of the scan
+	 * can go out as one block. If we're just reading the scan, but
+	 * don't care about the output, default to outputting 'low'; this
+	 * also makes valgrind traces more readable, as it removes the
+	 * dependency on an uninitialised value.
+	 */
+	int last = scan_size - 1;
+	if (last)
+		bitbang_clock_block(NULL,
+			(type != SCAN_IN) ? buffer : NULL,
+			(type != SCAN_OUT) ? buffer : NULL, last);
+
+	/* the last bit is clocked with TMS high to leave the shift state */
+	int bytec = last/8;
+	int bcval = 1 << (last % 8);
+	int tdi = 0;
+	if ((type != SCAN_IN) && (buffer[bytec] & bcval))
+		tdi = 1;
+
+	bitbang_interface->write(0, 1, tdi);
+
+	if (type != SCAN_OUT) {
+		if (bitbang_interface->read())
+			buffer[bytec] |= bcval;
+		else
+			buffer[bytec] &= ~bcval;
 	}
 
+	bitbang_interface->write(1, 1, tdi);
+
 	if (tap_get_state() != tap_get_end_state()) {
 		/* we *KNOW* the above loop transitioned out of
 		 * the shift state, so we skip the first state
@@ -35,6 +35,17 @@ struct bitbang_interface {
 	void (*blink)(int on);
 	int (*swdio_read)(void);
 	void (*swdio_drive)(bool on);
+
+	/** Optional block transfer; clocks out @c num_bits packed TMS/TDI
+	 * bits LSB first and captures packed TDO the same way, sampling
+	 * TDO between the falling and the rising TCK edge of each bit
+	 * just like a read() between two write() calls. A NULL @c tms or
+	 * @c tdi buffer shifts out zeros, a NULL @c tdo discards the
+	 * capture. TCK is left high after the last bit. Backends that
+	 * leave this NULL are driven bit by bit through write()/read().
+	 */
+	void (*block_transfer)(const uint8_t *tms, const uint8_t *tdi,
+			uint8_t *tdo, unsigned num_bits);
 };
 
 const struct swd_driver bitbang_swd;
@@ -80,7 +80,8 @@ enum {
 
 enum {
 	SERIAL_NORMAL = 0,
-	SERIAL_FAST = 1
+	SERIAL_FAST = 1,
+	SERIAL_AUTO = 2,	/* probe FAST at init, fall back to NORMAL */
 };
 
 static const cc_t SHORT_TIMEOUT  = 1; /* Must be at least 1. */
@@ -88,7 +89,8 @@ static const cc_t NORMAL_TIMEOUT = 10;
 
 static int buspirate_fd = -1;
 static int buspirate_pinmode = MODE_JTAG_OD;
-static int buspirate_baudrate = SERIAL_NORMAL;
+static int buspirate_baudrate = SERIAL_AUTO;
+static int buspirate_active_speed = SERIAL_NORMAL;
 static int buspirate_vreg;
 static int buspirate_pullup;
 static char *buspirate_port;
@@ -98,6 +100,8 @@ static enum tap_state last_tap_state = TAP_RESET;
 
 /* TAP interface */
 static void buspirate_tap_init(void);
+static int buspirate_tap_flush(void);
+static int buspirate_tap_drain(void);
 static int buspirate_tap_execute(void);
 static void buspirate_tap_append(int tms, int tdi);
 static void buspirate_tap_append_scan(int length, uint8_t *buffer,
@@ -110,7 +114,7 @@ static void buspirate_reset(int trst, int srst);
 static void buspirate_jtag_reset(int);
 static void buspirate_jtag_enable(int);
 static unsigned char buspirate_jtag_command(int, char *, int);
-static void buspirate_jtag_set_speed(int, char);
+static int buspirate_jtag_set_speed(int, char);
 static void buspirate_jtag_set_mode(int, char);
 static void buspirate_jtag_set_feature(int, char, char);
 static void buspirate_jtag_get_adcs(int);
@@ -299,8 +303,30 @@ static int buspirate_init(void)
 
 	buspirate_jtag_enable(buspirate_fd);
 
-	if (buspirate_baudrate != SERIAL_NORMAL)
-		buspirate_jtag_set_speed(buspirate_fd, SERIAL_FAST);
+	if (buspirate_baudrate == SERIAL_FAST) {
+		if (0 != buspirate_jtag_set_speed(buspirate_fd, SERIAL_FAST)) {
+			LOG_ERROR("Buspirate did not ack the speed change.");
+			return ERROR_JTAG_INIT_FAILED;
+		}
+	} else if (buspirate_baudrate == SERIAL_AUTO) {
+		/* Probe the highest rate the firmware supports. Old firmware
+		   versions ignore CMD_UART_SPEED and stay at 115200 baud, in
+		   which case the handshake times out and we drop back to the
+		   normal rate. Discard anything the probe may have left in the
+		   receive path before carrying on. */
+		if (0 != buspirate_jtag_set_speed(buspirate_fd, SERIAL_FAST)) {
+			LOG_INFO("Buspirate does not support the FAST mode, "
+				"staying at 115200 baud.");
+			if (-1 == buspirate_serial_setspeed(buspirate_fd,
+						SERIAL_NORMAL, SHORT_TIMEOUT)
+					|| !read_and_discard_all_data(buspirate_fd)
+					|| -1 == buspirate_serial_setspeed(buspirate_fd,
+						SERIAL_NORMAL, NORMAL_TIMEOUT)) {
+				LOG_ERROR("Error configuring the serial port.");
+				return ERROR_JTAG_INIT_FAILED;
+			}
+		}
+	}
 
 	LOG_INFO("Buspirate Interface ready!");
 
@@ -320,7 +346,8 @@ static int buspirate_quit(void)
 	LOG_INFO("Shutting down buspirate.");
 	buspirate_jtag_set_mode(buspirate_fd, MODE_HIZ);
 
-	buspirate_jtag_set_speed(buspirate_fd, SERIAL_NORMAL);
+	if (buspirate_active_speed != SERIAL_NORMAL)
+		buspirate_jtag_set_speed(buspirate_fd, SERIAL_NORMAL);
 	buspirate_jtag_reset(buspirate_fd);
 
 	buspirate_serial_close(buspirate_fd);
@@ -423,8 +450,10 @@ COMMAND_HANDLER(buspirate_handle_speed_command)
 		buspirate_baudrate = SERIAL_NORMAL;
 	else if (CMD_ARGV[0][0] == 'f')
 		buspirate_baudrate = SERIAL_FAST;
+	else if (CMD_ARGV[0][0] == 'a')
+		buspirate_baudrate = SERIAL_AUTO;
 	else
-		LOG_ERROR("usage: buspirate_speed <normal|fast>");
+		LOG_ERROR("usage: buspirate_speed <normal|fast|auto>");
 
 	return ERROR_OK;
 
@@ -472,10 +501,10 @@ static const struct command_registration buspirate_command_handlers[] = {
 	},
 	{
 		.name = "buspirate_speed",
-		.usage = "<normal|fast>",
+		.usage = "<normal|fast|auto>",
 		.handler = &buspirate_handle_speed_command,
 		.mode = COMMAND_CONFIG,
-		.help = "speed of the interface",
+		.help = "speed of the interface, 'auto' probes for FAST support",
 	},
 	{
 		.name = "buspirate_mode",
@@ -651,25 +680,83 @@ static struct pending_scan_result
 tap_pending_scans[BUSPIRATE_MAX_PENDING_SCANS];
 static int tap_pending_scans_num;
 
+/* One CMD_TAP_SHIFT exchange may be outstanding on the serial link while
+   the next chain is being assembled: the UART is full duplex, so the host
+   can transmit the following command while the adapter is still clocking
+   out the reply to the previous one. These track the reply that has not
+   been collected yet. */
+static struct pending_scan_result
+tap_inflight_scans[BUSPIRATE_MAX_PENDING_SCANS];
+static int tap_inflight_scans_num;
+static int tap_inflight_bytes; /* TDO bytes outstanding, 0 = none */
+
 static void buspirate_tap_init(void)
 {
 	tap_chain_index = 0;
 	tap_pending_scans_num = 0;
 }
 
-static int buspirate_tap_execute(void)
-{
-	static const int CMD_TAP_SHIFT_HEADER_LEN = 3;
+static const int CMD_TAP_SHIFT_HEADER_LEN = 3;
 
+/* Reads and parses the reply of the CMD_TAP_SHIFT that is still on the wire. */
+static int buspirate_tap_drain(void)
+{
 	char tmp[4096];
 	uint8_t *in_buf;
 	int i;
+	int ret;
+
+	if (tap_inflight_bytes == 0)
+		return ERROR_OK;
+
+	ret = buspirate_serial_read(buspirate_fd, tmp,
+			tap_inflight_bytes + CMD_TAP_SHIFT_HEADER_LEN);
+	if (ret != tap_inflight_bytes + CMD_TAP_SHIFT_HEADER_LEN) {
+		LOG_ERROR("error reading");
+		tap_inflight_scans_num = 0;
+		tap_inflight_bytes = 0;
+		return ERROR_FAIL;
+	}
+	in_buf = (uint8_t *)(&tmp[CMD_TAP_SHIFT_HEADER_LEN]);
+
+	/* parse the scans */
+	for (i = 0; i < tap_inflight_scans_num; i++) {
+		uint8_t *buffer = tap_inflight_scans[i].buffer;
+		int length = tap_inflight_scans[i].length;
+		int first = tap_inflight_scans[i].first;
+		struct scan_command *command = tap_inflight_scans[i].command;
+
+		/* copy bits from buffer */
+		buf_set_buf(in_buf, first, buffer, 0, length);
+
+		/* return buffer to higher level */
+		if (jtag_read_buffer(buffer, command) != ERROR_OK) {
+			tap_inflight_scans_num = 0;
+			tap_inflight_bytes = 0;
+			return ERROR_JTAG_QUEUE_FAILED;
+		}
+
+		free(buffer);
+	}
+	tap_inflight_scans_num = 0;
+	tap_inflight_bytes = 0;
+	return ERROR_OK;
+}
+
+/* Sends the current chain as one CMD_TAP_SHIFT but leaves its reply on the
+   wire. The previous reply, if any, is only collected after the write, so
+   that both the outgoing command and the incoming reply ride the link at
+   the same time. */
+static int buspirate_tap_flush(void)
+{
+	char tmp[4096];
+	int i;
 	int fill_index = 0;
 	int ret;
 	int bytes_to_send;
 
 	if (tap_chain_index <= 0)
-		return ERROR_OK;
+		return buspirate_tap_drain();
 
 	LOG_DEBUG("executing tap num bits = %i scans = %i",
 			tap_chain_index, tap_pending_scans_num);
@@ -702,42 +789,41 @@ static int buspirate_tap_execute(void)
 		return ERROR_JTAG_DEVICE_ERROR;
 	}
 
-	ret = buspirate_serial_read(buspirate_fd, tmp, bytes_to_send + CMD_TAP_SHIFT_HEADER_LEN);
-	if (ret != bytes_to_send + CMD_TAP_SHIFT_HEADER_LEN) {
-		LOG_ERROR("error reading");
-		return ERROR_FAIL;
+	ret = buspirate_tap_drain();
+	if (ret != ERROR_OK) {
+		/* the reply of the exchange just written cannot be trusted either */
+		buspirate_tap_init();
+		return ret;
 	}
-	in_buf = (uint8_t *)(&tmp[CMD_TAP_SHIFT_HEADER_LEN]);
-
-	/* parse the scans */
-	for (i = 0; i < tap_pending_scans_num; i++) {
-		uint8_t *buffer = tap_pending_scans[i].buffer;
-		int length = tap_pending_scans[i].length;
-		int first = tap_pending_scans[i].first;
-		struct scan_command *command = tap_pending_scans[i].command;
 
-		/* copy bits from buffer */
-		buf_set_buf(in_buf, first, buffer, 0, length);
+	for (i = 0; i < tap_pending_scans_num; i++)
+		tap_inflight_scans[i] = tap_pending_scans[i];
+	tap_inflight_scans_num = tap_pending_scans_num;
+	tap_inflight_bytes = bytes_to_send;
 
-		/* return buffer to higher level */
-		if (jtag_read_buffer(buffer, command) != ERROR_OK) {
-			buspirate_tap_init();
-			return ERROR_JTAG_QUEUE_FAILED;
-		}
-
-		free(buffer);
-	}
 	buspirate_tap_init();
 	return ERROR_OK;
 }
 
+static int buspirate_tap_execute(void)
+{
+	int retval = buspirate_tap_flush();
+
+	if (retval != ERROR_OK)
+		return retval;
+
+	return buspirate_tap_drain();
+}
+
 static void buspirate_tap_make_space(int scans, int bits)
 {
 	int have_scans = BUSPIRATE_MAX_PENDING_SCANS - tap_pending_scans_num;
 	int have_bits = BUSPIRATE_BUFFER_SIZE * 8 - tap_chain_index;
 
+	/* Only flush here: the reply is collected after the next exchange has
+	   been written, or at the latest when the queue is drained. */
 	if ((have_scans < scans) || (have_bits < bits))
-		buspirate_tap_execute();
+		buspirate_tap_flush();
 }
 
 static void buspirate_tap_append(int tms, int tdi)
@@ -890,7 +976,10 @@ static void buspirate_jtag_reset(int fd)
 		LOG_ERROR("Unable to restart buspirate!");
 }
 
-static void buspirate_jtag_set_speed(int fd, char speed)
+/* Returns 0 on success, -1 if the handshake failed. The caller decides
+   whether a failure is fatal: with buspirate_speed auto it merely means
+   the firmware does not know CMD_UART_SPEED. */
+static int buspirate_jtag_set_speed(int fd, char speed)
 {
 	int ret;
 	char tmp[2];
@@ -912,15 +1001,17 @@ static void buspirate_jtag_set_speed(int fd, char speed)
 	buspirate_serial_write(fd, ack, 2);
 	ret = buspirate_serial_read(fd, tmp, 2);
 	if (ret != 2) {
-		LOG_ERROR("Buspirate did not ack speed change");
-		exit(-1);
+		LOG_DEBUG("Buspirate did not ack speed change");
+		return -1;
 	}
 	if ((tmp[0] != CMD_UART_SPEED) || (tmp[1] != speed)) {
-		LOG_ERROR("Buspirate did not reply as expected to the speed change command");
-		exit(-1);
+		LOG_DEBUG("Buspirate did not reply as expected to the speed change command");
+		return -1;
 	}
+	buspirate_active_speed = speed;
 	LOG_INFO("Buspirate switched to %s mode",
 		(speed == SERIAL_NORMAL) ? "normal" : "FAST");
+	return 0;
 }
 
 
@@ -148,6 +148,9 @@ struct cmsis_dap {
 	uint16_t packet_size;
 	uint16_t packet_count;
 	uint8_t *packet_buffer;
+	/* responses to pipelined transfer packets land here so that a
+	 * packet being built in packet_buffer is not clobbered */
+	uint8_t *response_buffer;
 	uint8_t caps;
 	uint8_t mode;
 };
@@ -158,8 +161,21 @@ struct pending_transfer_result {
 	void *buffer;
 };
 
-static int pending_transfer_count, pending_queue_len;
-static struct pending_transfer_result *pending_transfers;
+/* Up to this many transfer packets may be on the wire before their
+ * responses are collected, so the probe works on one packet while the
+ * host builds the next. Clamped to the packet count the probe reports. */
+#define MAX_PENDING_REQUESTS 3
+
+struct pending_request_block {
+	struct pending_transfer_result *transfers;
+	int transfer_count;
+};
+
+static struct pending_request_block pending_fifo[MAX_PENDING_REQUESTS];
+static int pending_fifo_put_idx, pending_fifo_get_idx, pending_fifo_block_count;
+/* number of blocks that may be outstanding simultaneously */
+static int pending_fifo_size = 1;
+static int pending_queue_len;
 
 static int queued_retval;
 
@@ -262,6 +278,7 @@ static int cmsis_dap_usb_open(void)
 	dap->dev_handle = dev;
 	dap->caps = 0;
 	dap->mode = 0;
+	dap->packet_count = 1;
 
 	cmsis_dap_handle = dap;
 
@@ -279,9 +296,11 @@ static int cmsis_dap_usb_open(void)
 		packet_size = 512 + 1;
 
 	cmsis_dap_handle->packet_buffer = malloc(packet_size);
+	cmsis_dap_handle->response_buffer = malloc(packet_size);
 	cmsis_dap_handle->packet_size = packet_size;
 
-	if (cmsis_dap_handle->packet_buffer == NULL) {
+	if (cmsis_dap_handle->packet_buffer == NULL ||
+			cmsis_dap_handle->response_buffer == NULL) {
 		LOG_ERROR("unable to allocate memory");
 		return ERROR_FAIL;
 	}
@@ -295,19 +314,29 @@ static void cmsis_dap_usb_close(struct cmsis_dap *dap)
 	hid_exit();
 
 	free(cmsis_dap_handle->packet_buffer);
+	free(cmsis_dap_handle->response_buffer);
 	free(cmsis_dap_handle);
 	cmsis_dap_handle = NULL;
 	free(cmsis_dap_serial);
 	cmsis_dap_serial = NULL;
-	free(pending_transfers);
-	pending_transfers = NULL;
+	for (int i = 0; i < MAX_PENDING_REQUESTS; i++) {
+		free(pending_fifo[i].transfers);
+		pending_fifo[i].transfers = NULL;
+	}
 
 	return;
 }
 
+static void cmsis_dap_swd_read_process(struct cmsis_dap *dap);
+
 /* Send a message and receive the reply */
 static int cmsis_dap_usb_xfer(struct cmsis_dap *dap, int txlen)
 {
+	/* Collect all pipelined transfer responses first, so the reply we
+	 * read below really belongs to this packet */
+	while (pending_fifo_block_count)
+		cmsis_dap_swd_read_process(dap);
+
 	/* Pad the rest of the TX buffer with 0's */
 	memset(dap->packet_buffer + txlen, 0, dap->packet_size - txlen);
 
@@ -517,29 +546,37 @@ static int cmsis_dap_cmd_DAP_Delay(uint16_t delay_us)
 }
 #endif
 
-static int cmsis_dap_swd_run_queue(void)
+/* Build a DAP_Transfer packet from the block currently being filled and
+ * put it on the wire without waiting for the response, so the probe can
+ * work on it while the host keeps queueing. */
+static void cmsis_dap_swd_write_from_queue(struct cmsis_dap *dap)
 {
-	uint8_t *buffer = cmsis_dap_handle->packet_buffer;
+	uint8_t *buffer = dap->packet_buffer;
+	struct pending_request_block *block = &pending_fifo[pending_fifo_put_idx];
 
-	LOG_DEBUG("Executing %d queued transactions", pending_transfer_count);
+	assert(pending_fifo_block_count < pending_fifo_size);
+
+	LOG_DEBUG("Sending %d queued transactions in block %d",
+		  block->transfer_count, pending_fifo_put_idx);
 
 	if (queued_retval != ERROR_OK) {
 		LOG_DEBUG("Skipping due to previous errors: %d", queued_retval);
-		goto skip;
+		block->transfer_count = 0;
+		return;
 	}
 
-	if (!pending_transfer_count)
-		goto skip;
+	if (!block->transfer_count)
+		return;
 
 	size_t idx = 0;
 	buffer[idx++] = 0;	/* report number */
 	buffer[idx++] = CMD_DAP_TFER;
 	buffer[idx++] = 0x00;	/* DAP Index */
-	buffer[idx++] = pending_transfer_count;
+	buffer[idx++] = block->transfer_count;
 
-	for (int i = 0; i < pending_transfer_count; i++) {
-		uint8_t cmd = pending_transfers[i].cmd;
-		uint32_t data = pending_transfers[i].data;
+	for (int i = 0; i < block->transfer_count; i++) {
+		uint8_t cmd = block->transfers[i].cmd;
+		uint32_t data = block->transfers[i].data;
 
 		LOG_DEBUG("%s %s reg %x %"PRIx32,
 				cmd & SWD_CMD_APnDP ? "AP" : "DP",
@@ -574,11 +611,40 @@ static int cmsis_dap_swd_run_queue(void)
 		}
 	}
 
-	queued_retval = cmsis_dap_usb_xfer(cmsis_dap_handle, idx);
+	/* Pad the rest of the TX buffer with 0's */
+	memset(buffer + idx, 0, dap->packet_size - idx);
+
+	int retval = hid_write(dap->dev_handle, buffer, dap->packet_size);
+	if (retval == -1) {
+		LOG_ERROR("error writing data: %ls", hid_error(dap->dev_handle));
+		queued_retval = ERROR_FAIL;
+		block->transfer_count = 0;
+		return;
+	}
+
+	pending_fifo_put_idx = (pending_fifo_put_idx + 1) % pending_fifo_size;
+	pending_fifo_block_count++;
+}
+
+/* Collect and decode the response to the oldest outstanding packet */
+static void cmsis_dap_swd_read_process(struct cmsis_dap *dap)
+{
+	uint8_t *buffer = dap->response_buffer;
+	struct pending_request_block *block = &pending_fifo[pending_fifo_get_idx];
+
+	assert(pending_fifo_block_count > 0);
+
+	int retval = hid_read_timeout(dap->dev_handle, buffer, dap->packet_size, USB_TIMEOUT);
+	if (retval == -1 || retval == 0) {
+		LOG_DEBUG("error reading data: %ls", hid_error(dap->dev_handle));
+		queued_retval = ERROR_FAIL;
+		goto skip;
+	}
+
 	if (queued_retval != ERROR_OK)
 		goto skip;
 
-	idx = 2;
+	size_t idx = 2;
 	uint8_t ack = buffer[idx] & 0x07;
 	if (ack != SWD_ACK_OK || (buffer[idx] & 0x08)) {
 		LOG_DEBUG("SWD ack not OK: %d %s", buffer[idx-1],
@@ -588,12 +654,12 @@ static int cmsis_dap_swd_run_queue(void)
 	}
 	idx++;
 
-	if (pending_transfer_count != buffer[1])
+	if (block->transfer_count != buffer[1])
 		LOG_ERROR("CMSIS-DAP transfer count mismatch: expected %d, got %d",
-			  pending_transfer_count, buffer[1]);
+			  block->transfer_count, buffer[1]);
 
 	for (int i = 0; i < buffer[1]; i++) {
-		if (pending_transfers[i].cmd & SWD_CMD_RnW) {
+		if (block->transfers[i].cmd & SWD_CMD_RnW) {
 			static uint32_t last_read;
 			uint32_t data = le_to_h_u32(&buffer[idx]);
 			uint32_t tmp = data;
@@ -602,19 +668,31 @@ static int cmsis_dap_swd_run_queue(void)
 			LOG_DEBUG("Read result: %"PRIx32, data);
 
 			/* Imitate posted AP reads */
-			if ((pending_transfers[i].cmd & SWD_CMD_APnDP) ||
-			    ((pending_transfers[i].cmd & SWD_CMD_A32) >> 1 == DP_RDBUFF)) {
+			if ((block->transfers[i].cmd & SWD_CMD_APnDP) ||
+			    ((block->transfers[i].cmd & SWD_CMD_A32) >> 1 == DP_RDBUFF)) {
 				tmp = last_read;
 				last_read = data;
 			}
 
-			if (pending_transfers[i].buffer)
-				*(uint32_t *)pending_transfers[i].buffer = tmp;
+			if (block->transfers[i].buffer)
+				*(uint32_t *)block->transfers[i].buffer = tmp;
 		}
 	}
 
 skip:
-	pending_transfer_count = 0;
+	block->transfer_count = 0;
+	pending_fifo_get_idx = (pending_fifo_get_idx + 1) % pending_fifo_size;
+	pending_fifo_block_count--;
+}
+
+static int cmsis_dap_swd_run_queue(void)
+{
+	if (pending_fifo[pending_fifo_put_idx].transfer_count)
+		cmsis_dap_swd_write_from_queue(cmsis_dap_handle);
+
+	while (pending_fifo_block_count)
+		cmsis_dap_swd_read_process(cmsis_dap_handle);
+
 	int retval = queued_retval;
 	queued_retval = ERROR_OK;
 
@@ -623,21 +701,27 @@ skip:
 
 static void cmsis_dap_swd_queue_cmd(uint8_t cmd, uint32_t *dst, uint32_t data)
 {
-	if (pending_transfer_count == pending_queue_len) {
-		/* Not enough room in the queue. Run the queue. */
-		queued_retval = cmsis_dap_swd_run_queue();
+	struct pending_request_block *block = &pending_fifo[pending_fifo_put_idx];
+
+	if (block->transfer_count == pending_queue_len) {
+		/* The current packet is full. Ship it and keep filling the
+		 * next block while the probe is busy with this one. */
+		cmsis_dap_swd_write_from_queue(cmsis_dap_handle);
+		if (pending_fifo_block_count == pending_fifo_size)
+			cmsis_dap_swd_read_process(cmsis_dap_handle);
+		block = &pending_fifo[pending_fifo_put_idx];
 	}
 
 	if (queued_retval != ERROR_OK)
 		return;
 
-	pending_transfers[pending_transfer_count].data = data;
-	pending_transfers[pending_transfer_count].cmd = cmd;
+	block->transfers[block->transfer_count].data = data;
+	block->transfers[block->transfer_count].cmd = cmd;
 	if (cmd & SWD_CMD_RnW) {
 		/* Queue a read transaction */
-		pending_transfers[pending_transfer_count].buffer = dst;
+		block->transfers[block->transfer_count].buffer = dst;
 	}
-	pending_transfer_count++;
+	block->transfer_count++;
 }
 
 static void cmsis_dap_swd_write_reg(uint8_t cmd, uint32_t value, uint32_t ap_delay_clk)
@@ -841,10 +925,13 @@ static int cmsis_dap_init(void)
 		 * write. For bulk read sequences just 4 bytes are
 		 * needed per transfer, so this is suboptimal. */
 		pending_queue_len = (pkt_sz - 4) / 5;
-		pending_transfers = malloc(pending_queue_len * sizeof(*pending_transfers));
-		if (!pending_transfers) {
-			LOG_ERROR("Unable to allocate memory for CMSIS-DAP queue");
-			return ERROR_FAIL;
+		for (int i = 0; i < MAX_PENDING_REQUESTS; i++) {
+			pending_fifo[i].transfers = malloc(pending_queue_len
+					* sizeof(*pending_fifo[i].transfers));
+			if (!pending_fifo[i].transfers) {
+				LOG_ERROR("Unable to allocate memory for CMSIS-DAP queue");
+				return ERROR_FAIL;
+			}
 		}
 
 		if (cmsis_dap_handle->packet_size != pkt_sz + 1) {
@@ -852,7 +939,10 @@ static int cmsis_dap_init(void)
 			cmsis_dap_handle->packet_size = pkt_sz + 1;
 			cmsis_dap_handle->packet_buffer = realloc(cmsis_dap_handle->packet_buffer,
 					cmsis_dap_handle->packet_size);
-			if (cmsis_dap_handle->packet_buffer == NULL) {
+			cmsis_dap_handle->response_buffer = realloc(cmsis_dap_handle->response_buffer,
+					cmsis_dap_handle->packet_size);
+			if (cmsis_dap_handle->packet_buffer == NULL ||
+					cmsis_dap_handle->response_buffer == NULL) {
 				LOG_ERROR("unable to reallocate memory");
 				return ERROR_FAIL;
 			}
@@ -872,6 +962,13 @@ static int cmsis_dap_init(void)
 		LOG_DEBUG("CMSIS-DAP: Packet Count = %" PRId16, pkt_cnt);
 	}
 
+	/* Pipeline transfer packets only as deep as the probe can buffer them */
+	pending_fifo_size = cmsis_dap_handle->packet_count;
+	if (pending_fifo_size > MAX_PENDING_REQUESTS)
+		pending_fifo_size = MAX_PENDING_REQUESTS;
+	if (pending_fifo_size < 1)
+		pending_fifo_size = 1;
+
 	retval = cmsis_dap_get_status();
 	if (retval != ERROR_OK)
 		return ERROR_FAIL;
@@ -37,6 +37,7 @@
 #include <jtag/commands.h>
 #include <jtag/minidriver.h>
 #include <helper/command.h>
+#include <helper/time_support.h>
 
 struct jtag_callback_entry {
 	struct jtag_callback_entry *next;
@@ -116,6 +117,7 @@ int interface_jtag_add_ir_scan(struct jtag_tap *active,
 
 		/* update device information */
 		buf_cpy(field->out_value, tap->cur_instr, tap->ir_length);
+		tap->cur_instr_valid = true;
 
 		field++;
 	}
@@ -126,11 +128,20 @@ int interface_jtag_add_ir_scan(struct jtag_tap *active,
 }
 
 /**
- * see jtag_add_dr_scan()
+ * Borrow a struct scan_field for insertion into the queue.
  *
+ * Unlike cmd_queue_scan_field_clone(), the out_value buffer stays owned
+ * by the caller, who must keep it valid until the queue is flushed.
  */
-int interface_jtag_add_dr_scan(struct jtag_tap *active, int in_num_fields,
-		const struct scan_field *in_fields, tap_state_t state)
+static void cmd_queue_scan_field_borrow(struct scan_field *dst, const struct scan_field *src)
+{
+	dst->num_bits	= src->num_bits;
+	dst->out_value	= src->out_value;
+	dst->in_value	= src->in_value;
+}
+
+static int jtag_add_dr_scan_inner(struct jtag_tap *active, int in_num_fields,
+		const struct scan_field *in_fields, tap_state_t state, bool borrow)
 {
 	/* count devices in bypass */
 
@@ -170,7 +181,10 @@ int interface_jtag_add_dr_scan(struct jtag_tap *active, int in_num_fields,
 #endif /* NDEBUG */
 
 			for (int j = 0; j < in_num_fields; j++) {
-				cmd_queue_scan_field_clone(field, in_fields + j);
+				if (borrow)
+					cmd_queue_scan_field_borrow(field, in_fields + j);
+				else
+					cmd_queue_scan_field_clone(field, in_fields + j);
 
 				field++;
 			}
@@ -193,6 +207,26 @@ int interface_jtag_add_dr_scan(struct jtag_tap *active, int in_num_fields,
 	return ERROR_OK;
 }
 
+/**
+ * see jtag_add_dr_scan()
+ *
+ */
+int interface_jtag_add_dr_scan(struct jtag_tap *active, int in_num_fields,
+		const struct scan_field *in_fields, tap_state_t state)
+{
+	return jtag_add_dr_scan_inner(active, in_num_fields, in_fields, state, false);
+}
+
+/**
+ * see jtag_add_dr_scan_borrow()
+ *
+ */
+int interface_jtag_add_dr_scan_borrow(struct jtag_tap *active, int in_num_fields,
+		const struct scan_field *in_fields, tap_state_t state)
+{
+	return jtag_add_dr_scan_inner(active, in_num_fields, in_fields, state, true);
+}
+
 static int jtag_add_plain_scan(int num_bits, const uint8_t *out_bits,
 		uint8_t *in_bits, tap_state_t state, bool ir_scan)
 {
@@ -373,14 +407,70 @@ void interface_jtag_add_callback4(jtag_callback_t callback,
 	}
 }
 
+/* Estimate the payload and wire traffic of the queued commands, for the
+ * adapter transfer statistics.  Wire bytes are a lower bound: scans add
+ * a flat allowance for state navigation, resets and sleeps clock
+ * nothing. */
+static void jtag_account_queue(int64_t *payload_bytes, int64_t *wire_bytes)
+{
+	int64_t payload = 0;
+	int64_t cycles = 0;
+
+	for (struct jtag_command *cmd = jtag_command_queue; cmd; cmd = cmd->next) {
+		switch (cmd->type) {
+			case JTAG_SCAN:
+				for (int i = 0; i < cmd->cmd.scan->num_fields; i++) {
+					struct scan_field *field = &cmd->cmd.scan->fields[i];
+					if (field->out_value)
+						payload += DIV_ROUND_UP(field->num_bits, 8);
+					if (field->in_value)
+						payload += DIV_ROUND_UP(field->num_bits, 8);
+					cycles += field->num_bits;
+				}
+				cycles += 8;	/* state navigation allowance */
+				break;
+			case JTAG_TLR_RESET:
+				cycles += 5;
+				break;
+			case JTAG_RUNTEST:
+				cycles += cmd->cmd.runtest->num_cycles;
+				break;
+			case JTAG_STABLECLOCKS:
+				cycles += cmd->cmd.stableclocks->num_cycles;
+				break;
+			case JTAG_TMS:
+				cycles += cmd->cmd.tms->num_bits;
+				break;
+			case JTAG_PATHMOVE:
+				cycles += cmd->cmd.pathmove->num_states;
+				break;
+			default:
+				break;
+		}
+	}
+
+	*payload_bytes = payload;
+	*wire_bytes = DIV_ROUND_UP(cycles, 8);
+}
+
 int interface_jtag_execute_queue(void)
 {
 	static int reentry;
+	int64_t payload_bytes, wire_bytes;
+	struct duration bench;
 
 	assert(reentry == 0);
 	reentry++;
 
+	/* account queue contents before execution consumes them */
+	jtag_account_queue(&payload_bytes, &wire_bytes);
+	duration_start(&bench);
+
 	int retval = default_interface_jtag_execute_queue();
+
+	duration_measure(&bench);
+	jtag_record_transaction_stats(payload_bytes, wire_bytes,
+		(int64_t)(duration_elapsed(&bench) * 1000000.0));
 	if (retval == ERROR_OK) {
 		struct jtag_callback_entry *entry;
 		for (entry = jtag_callback_queue_head; entry != NULL; entry = entry->next) {
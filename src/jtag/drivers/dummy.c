@@ -35,6 +35,14 @@ static int clock_count;		/* count clocks in any stable state, only stable states
 
 static uint32_t dummy_data;
 
+/* performance model: counters plus the cost ascribed to each queue flush
+ * and each TCK cycle, so scripted workloads can assert on how much wire
+ * traffic a code path generates without any hardware attached */
+static uint64_t dummy_perf_flushes;
+static uint64_t dummy_perf_clocks;
+static unsigned dummy_latency_us;	/* modeled round-trip cost per flush */
+static unsigned dummy_rate_khz;		/* modeled TCK rate, 0 = not modeled */
+
 static int dummy_read(void)
 {
 	int data = 1 & dummy_data;
@@ -48,6 +56,7 @@ static void dummy_write(int tck, int tms, int tdi)
 	if (tck != dummy_clock) {
 		if (tck) {
 			tap_state_t old_state = dummy_state;
+			dummy_perf_clocks++;
 			dummy_state = tap_state_transition(old_state, tms);
 
 			if (old_state != dummy_state) {
@@ -118,6 +127,12 @@ static int dummy_speed(int speed)
 	return ERROR_OK;
 }
 
+static int dummy_execute_queue(void)
+{
+	dummy_perf_flushes++;
+	return bitbang_execute_queue();
+}
+
 static int dummy_init(void)
 {
 	bitbang_interface = &dummy_bitbang;
@@ -130,13 +145,87 @@ static int dummy_quit(void)
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(handle_dummy_latency_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	if (CMD_ARGC == 1)
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], dummy_latency_us);
+	command_print(CMD_CTX, "dummy latency: %u us per flush", dummy_latency_us);
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_dummy_rate_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	if (CMD_ARGC == 1)
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], dummy_rate_khz);
+	command_print(CMD_CTX, "dummy rate: %u kHz", dummy_rate_khz);
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_dummy_perf_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	if (CMD_ARGC == 1) {
+		if (strcmp(CMD_ARGV[0], "reset") != 0)
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		dummy_perf_flushes = 0;
+		dummy_perf_clocks = 0;
+		return ERROR_OK;
+	}
+
+	uint64_t modeled_us = dummy_perf_flushes * dummy_latency_us;
+	if (dummy_rate_khz)
+		modeled_us += (dummy_perf_clocks * 1000) / dummy_rate_khz;
+
+	/* one line, fixed format, so scripts can parse and assert on it */
+	command_print(CMD_CTX, "dummy_perf: flushes=%" PRIu64 " clocks=%" PRIu64
+		" modeled_us=%" PRIu64,
+		dummy_perf_flushes, dummy_perf_clocks, modeled_us);
+	return ERROR_OK;
+}
+
+static const struct command_registration dummy_subcommand_handlers[] = {
+	{
+		.name = "latency",
+		.handler = handle_dummy_latency_command,
+		.mode = COMMAND_ANY,
+		.help = "set or display the modeled round-trip cost "
+			"charged per queue flush",
+		.usage = "[microseconds]",
+	},
+	{
+		.name = "rate",
+		.handler = handle_dummy_rate_command,
+		.mode = COMMAND_ANY,
+		.help = "set or display the modeled TCK rate "
+			"(0 means clocks cost nothing)",
+		.usage = "[khz]",
+	},
+	{
+		.name = "perf",
+		.handler = handle_dummy_perf_command,
+		.mode = COMMAND_ANY,
+		.help = "display queue flush and TCK counters with the "
+			"wall time the model ascribes to them, or zero them",
+		.usage = "[reset]",
+	},
+	{
+		.chain = hello_command_handlers,
+	},
+	COMMAND_REGISTRATION_DONE,
+};
+
 static const struct command_registration dummy_command_handlers[] = {
 	{
 		.name = "dummy",
 		.mode = COMMAND_ANY,
 		.help = "dummy interface driver commands",
 
-		.chain = hello_command_handlers,
+		.chain = dummy_subcommand_handlers,
 	},
 	COMMAND_REGISTRATION_DONE,
 };
@@ -151,7 +240,7 @@ struct jtag_interface dummy_interface = {
 		.commands = dummy_command_handlers,
 		.transports = jtag_only,
 
-		.execute_queue = &bitbang_execute_queue,
+		.execute_queue = &dummy_execute_queue,
 
 		.speed = &dummy_speed,
 		.khz = &dummy_khz,
@@ -361,45 +361,30 @@ static void ftdi_execute_pathmove(struct jtag_command *cmd)
 		tap_state_name(tap_get_state()),
 		tap_state_name(path[num_states-1]));
 
-	int state_count = 0;
-	unsigned bit_count = 0;
-	uint8_t tms_byte = 0;
+	uint8_t tms_bits[DIV_ROUND_UP(num_states, 8)];
+	unsigned offset = 0;
 
 	DEBUG_JTAG_IO("-");
 
-	/* this loop verifies that the path is legal and logs each state in the path */
-	while (num_states--) {
-
-		/* either TMS=0 or TMS=1 must work ... */
-		if (tap_state_transition(tap_get_state(), false)
-		    == path[state_count])
-			buf_set_u32(&tms_byte, bit_count++, 1, 0x0);
-		else if (tap_state_transition(tap_get_state(), true)
-			 == path[state_count]) {
-			buf_set_u32(&tms_byte, bit_count++, 1, 0x1);
-
-			/* ... or else the caller goofed BADLY */
-		} else {
-			LOG_ERROR("BUG: %s -> %s isn't a valid "
-				"TAP state transition",
-				tap_state_name(tap_get_state()),
-				tap_state_name(path[state_count]));
-			exit(-1);
-		}
-
-		tap_set_state(path[state_count]);
-		state_count++;
+	/* validate the path and pack it into a single TMS sequence */
+	if (tap_build_tms_path(tap_get_state(), path, num_states, tms_bits) < 0)
+		exit(-1);
 
-		if (bit_count == 7 || num_states == 0) {
-			mpsse_clock_tms_cs_out(mpsse_ctx,
-					&tms_byte,
-					0,
-					bit_count,
-					false,
-					ftdi_jtag_mode);
-			bit_count = 0;
-		}
+	/* emit the packed path in maximum-sized MPSSE TMS commands */
+	while (offset < (unsigned)num_states) {
+		unsigned this_len = num_states - offset;
+		if (this_len > 7)
+			this_len = 7;
+		mpsse_clock_tms_cs_out(mpsse_ctx,
+				tms_bits,
+				offset,
+				this_len,
+				false,
+				ftdi_jtag_mode);
+		offset += this_len;
 	}
+
+	tap_set_state(path[num_states - 1]);
 	tap_set_end_state(tap_get_state());
 }
 
@@ -57,9 +57,10 @@ static enum jaylink_target_interface iface = JAYLINK_TIF_JTAG;
 static bool trace_enabled;
 
 #define JLINK_MAX_SPEED			12000
-#define JLINK_TAP_BUFFER_SIZE	2048
+#define JLINK_TAP_BUFFER_SIZE	8192
 
 static unsigned int swd_buffer_size = JLINK_TAP_BUFFER_SIZE;
+static unsigned int jtag_buffer_size = JLINK_TAP_BUFFER_SIZE;
 
 /* 256 byte non-volatile memory */
 struct device_config {
@@ -503,6 +504,44 @@ static bool adjust_swd_buffer_size(void)
 	return true;
 }
 
+/*
+ * Adjust the JTAG transaction buffer size depending on the free device
+ * internal memory, so that as many queued scans and state moves as the
+ * device can take are packed into a single transaction. The device has
+ * to hold the TMS and TDI data and the TDO reply at the same time.
+ */
+static bool adjust_jtag_buffer_size(void)
+{
+	int ret;
+	uint32_t tmp;
+
+	if (!jaylink_has_cap(caps, JAYLINK_DEV_CAP_GET_FREE_MEMORY))
+		return true;
+
+	ret = jaylink_get_free_memory(devh, &tmp);
+
+	if (ret != JAYLINK_OK) {
+		LOG_ERROR("jaylink_get_free_memory() failed: %s.",
+			jaylink_strerror_name(ret));
+		return false;
+	}
+
+	if (tmp < 143) {
+		LOG_ERROR("Not enough free device internal memory: %u bytes.", tmp);
+		return false;
+	}
+
+	tmp = MIN(JLINK_TAP_BUFFER_SIZE, (tmp - 16) / 3);
+
+	if (tmp != jtag_buffer_size) {
+		jtag_buffer_size = tmp;
+		LOG_DEBUG("Adjusted JTAG transaction buffer size to %u bytes.",
+			jtag_buffer_size);
+	}
+
+	return true;
+}
+
 static int jlink_init(void)
 {
 	int ret;
@@ -658,6 +697,13 @@ static int jlink_init(void)
 			jaylink_exit(jayctx);
 			return ERROR_JTAG_INIT_FAILED;
 		}
+	} else {
+		/* Same as above, for the JTAG transaction buffer. */
+		if (!adjust_jtag_buffer_size()) {
+			jaylink_close(devh);
+			jaylink_exit(jayctx);
+			return ERROR_JTAG_INIT_FAILED;
+		}
 	}
 
 	if (jaylink_has_cap(caps, JAYLINK_DEV_CAP_READ_CONFIG)) {
@@ -1700,7 +1746,9 @@ struct pending_scan_result {
 	unsigned buffer_offset;
 };
 
-#define MAX_PENDING_SCAN_RESULTS 256
+/* Sized so that a transaction full of short scans does not force an
+ * early flush before the tap buffer itself is exhausted. */
+#define MAX_PENDING_SCAN_RESULTS 1024
 
 static int pending_scan_results_length;
 static struct pending_scan_result pending_scan_results_buffer[MAX_PENDING_SCAN_RESULTS];
@@ -1718,13 +1766,13 @@ static void jlink_clock_data(const uint8_t *out, unsigned out_offset,
 			     unsigned length)
 {
 	do {
-		unsigned available_length = JLINK_TAP_BUFFER_SIZE - tap_length / 8;
+		unsigned available_length = jtag_buffer_size - tap_length / 8;
 
 		if (!available_length ||
 		    (in && pending_scan_results_length == MAX_PENDING_SCAN_RESULTS)) {
 			if (jlink_flush() != ERROR_OK)
 				return;
-			available_length = JLINK_TAP_BUFFER_SIZE;
+			available_length = jtag_buffer_size;
 		}
 
 		struct pending_scan_result *pending_scan_result =
@@ -1913,7 +1961,7 @@ skip:
 static void jlink_swd_queue_cmd(uint8_t cmd, uint32_t *dst, uint32_t data, uint32_t ap_delay_clk)
 {
 	uint8_t data_parity_trn[DIV_ROUND_UP(32 + 1, 8)];
-	if (tap_length + 46 + 8 + ap_delay_clk >= sizeof(tdi_buffer) * 8 ||
+	if (tap_length + 46 + 8 + ap_delay_clk >= swd_buffer_size * 8 ||
 	    pending_scan_results_length == MAX_PENDING_SCAN_RESULTS) {
 		/* Not enough room in the queue. Run the queue. */
 		queued_retval = jlink_swd_run_queue();
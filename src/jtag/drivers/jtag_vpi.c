@@ -26,6 +26,9 @@
 #ifdef HAVE_ARPA_INET_H
 #include <arpa/inet.h>
 #endif
+#ifdef HAVE_NETINET_TCP_H
+#include <netinet/tcp.h>
+#endif
 
 #define NO_TAP_SHIFT	0
 #define TAP_SHIFT	1
@@ -55,21 +58,124 @@ struct vpi_cmd {
 	int nb_bits;
 };
 
-static int jtag_vpi_send_cmd(struct vpi_cmd *vpi)
+/* Commands are not sent one by one: they are aggregated in this queue and
+ * written out as a single TCP segment at the synchronisation points, with
+ * the scan replies collected in one batch afterwards. Against a simulated
+ * RTL the round trip dwarfs the payload time, so the wall time of a command
+ * queue is set by the number of flushes, not by the number of commands. */
+#define VPI_QUEUE_DEPTH_MAX	64
+#define VPI_QUEUE_DEPTH_DEFAULT	16
+
+static int vpi_queue_depth = VPI_QUEUE_DEPTH_DEFAULT;
+
+static struct vpi_cmd vpi_queue[VPI_QUEUE_DEPTH_MAX];
+static int vpi_queue_count;
+
+/* Only the CMD_SCAN_CHAIN* commands are answered by the server, one reply
+ * per command, in order. Each queued scan registers where its TDO bytes and,
+ * for the last chunk of a scan command, the buffer ownership go. */
+struct vpi_pending_reply {
+	uint8_t *dest;			/* TDO destination, NULL to discard */
+	int nb_bytes;
+	uint8_t *scan_buf;		/* set on the last chunk of a scan: */
+	struct scan_command *command;	/* handed back to jtag_read_buffer() */
+};
+
+static struct vpi_pending_reply vpi_pending_replies[VPI_QUEUE_DEPTH_MAX];
+static int vpi_pending_reply_count;
+
+static int jtag_vpi_write_full(const void *buf, int size)
 {
-	int retval = write_socket(sockfd, vpi, sizeof(struct vpi_cmd));
-	if (retval <= 0)
-		return ERROR_FAIL;
+	const char *ptr = buf;
+
+	while (size > 0) {
+		int retval = write_socket(sockfd, ptr, size);
+		if (retval <= 0)
+			return ERROR_FAIL;
+		ptr += retval;
+		size -= retval;
+	}
 
 	return ERROR_OK;
 }
 
-static int jtag_vpi_receive_cmd(struct vpi_cmd *vpi)
+static int jtag_vpi_read_full(void *buf, int size)
+{
+	char *ptr = buf;
+
+	while (size > 0) {
+		int retval = read_socket(sockfd, ptr, size);
+		if (retval <= 0)
+			return ERROR_FAIL;
+		ptr += retval;
+		size -= retval;
+	}
+
+	return ERROR_OK;
+}
+
+static int jtag_vpi_flush(void)
+{
+	static struct vpi_cmd reply;
+	int retval = ERROR_OK;
+	int i;
+
+	if (vpi_queue_count == 0)
+		return ERROR_OK;
+
+	if (jtag_vpi_write_full(vpi_queue,
+			vpi_queue_count * sizeof(struct vpi_cmd)) != ERROR_OK) {
+		vpi_queue_count = 0;
+		vpi_pending_reply_count = 0;
+		return ERROR_FAIL;
+	}
+
+	for (i = 0; i < vpi_pending_reply_count; i++) {
+		struct vpi_pending_reply *pending = &vpi_pending_replies[i];
+
+		if (jtag_vpi_read_full(&reply, sizeof(reply)) != ERROR_OK) {
+			retval = ERROR_FAIL;
+			break;
+		}
+
+		if (pending->dest)
+			memcpy(pending->dest, reply.buffer_in, pending->nb_bytes);
+
+		if (pending->command) {
+			if (jtag_read_buffer(pending->scan_buf,
+					pending->command) != ERROR_OK)
+				retval = ERROR_JTAG_QUEUE_FAILED;
+			if (pending->scan_buf)
+				free(pending->scan_buf);
+		}
+	}
+
+	vpi_queue_count = 0;
+	vpi_pending_reply_count = 0;
+	return retval;
+}
+
+/* Returns a free queue slot, flushing first when either the command queue
+ * or the reply table is full. */
+static struct vpi_cmd *jtag_vpi_queue_slot(void)
+{
+	if (vpi_queue_count >= vpi_queue_depth
+			|| vpi_pending_reply_count >= vpi_queue_depth) {
+		if (jtag_vpi_flush() != ERROR_OK)
+			return NULL;
+	}
+
+	return &vpi_queue[vpi_queue_count++];
+}
+
+static int jtag_vpi_send_cmd(struct vpi_cmd *vpi)
 {
-	int retval = read_socket(sockfd, vpi, sizeof(struct vpi_cmd));
-	if (retval < (int)sizeof(struct vpi_cmd))
+	struct vpi_cmd *slot = jtag_vpi_queue_slot();
+
+	if (slot == NULL)
 		return ERROR_FAIL;
 
+	memcpy(slot, vpi, sizeof(struct vpi_cmd));
 	return ERROR_OK;
 }
 
@@ -167,29 +273,29 @@ static int jtag_vpi_state_move(tap_state_t state)
 
 static int jtag_vpi_queue_tdi_xfer(uint8_t *bits, int nb_bits, int tap_shift)
 {
-	struct vpi_cmd vpi;
+	struct vpi_cmd *vpi;
+	struct vpi_pending_reply *pending;
 	int nb_bytes = DIV_ROUND_UP(nb_bits, 8);
 
-	vpi.cmd = tap_shift ? CMD_SCAN_CHAIN_FLIP_TMS : CMD_SCAN_CHAIN;
+	vpi = jtag_vpi_queue_slot();
+	if (vpi == NULL)
+		return ERROR_FAIL;
+
+	vpi->cmd = tap_shift ? CMD_SCAN_CHAIN_FLIP_TMS : CMD_SCAN_CHAIN;
 
 	if (bits)
-		memcpy(vpi.buffer_out, bits, nb_bytes);
+		memcpy(vpi->buffer_out, bits, nb_bytes);
 	else
-		memset(vpi.buffer_out, 0xff, nb_bytes);
+		memset(vpi->buffer_out, 0xff, nb_bytes);
 
-	vpi.length = nb_bytes;
-	vpi.nb_bits = nb_bits;
+	vpi->length = nb_bytes;
+	vpi->nb_bits = nb_bits;
 
-	int retval = jtag_vpi_send_cmd(&vpi);
-	if (retval != ERROR_OK)
-		return retval;
-
-	retval = jtag_vpi_receive_cmd(&vpi);
-	if (retval != ERROR_OK)
-		return retval;
-
-	if (bits)
-		memcpy(bits, vpi.buffer_in, nb_bytes);
+	pending = &vpi_pending_replies[vpi_pending_reply_count++];
+	pending->dest = bits;
+	pending->nb_bytes = nb_bytes;
+	pending->scan_buf = NULL;
+	pending->command = NULL;
 
 	return ERROR_OK;
 }
@@ -198,8 +304,14 @@ static int jtag_vpi_queue_tdi_xfer(uint8_t *bits, int nb_bits, int tap_shift)
  * jtag_vpi_queue_tdi - short description
  * @bits: bits to be queued on TDI (or NULL if 0 are to be queued)
  * @nb_bits: number of bits
+ * @scan_buf: buffer to hand back to jtag_read_buffer() once the TDO bits
+ * of the last transfer have been received, or NULL
+ * @command: scan command @scan_buf belongs to, or NULL
+ *
+ * The transfers are only queued; their TDO bits arrive at the next flush.
  */
-static int jtag_vpi_queue_tdi(uint8_t *bits, int nb_bits, int tap_shift)
+static int jtag_vpi_queue_tdi(uint8_t *bits, int nb_bits, int tap_shift,
+	uint8_t *scan_buf, struct scan_command *command)
 {
 	int nb_xfer = DIV_ROUND_UP(nb_bits, XFERT_MAX_SIZE * 8);
 	uint8_t *xmit_buffer = bits;
@@ -210,11 +322,19 @@ static int jtag_vpi_queue_tdi(uint8_t *bits, int nb_bits, int tap_shift)
 	while (nb_xfer) {
 
 		if (nb_xfer ==  1) {
-			retval = jtag_vpi_queue_tdi_xfer(&xmit_buffer[i], xmit_nb_bits, tap_shift);
+			retval = jtag_vpi_queue_tdi_xfer(bits ? &xmit_buffer[i] : NULL,
+					xmit_nb_bits, tap_shift);
 			if (retval != ERROR_OK)
 				return retval;
+			if (command) {
+				struct vpi_pending_reply *pending =
+					&vpi_pending_replies[vpi_pending_reply_count - 1];
+				pending->scan_buf = scan_buf;
+				pending->command = command;
+			}
 		} else {
-			retval = jtag_vpi_queue_tdi_xfer(&xmit_buffer[i], XFERT_MAX_SIZE * 8, NO_TAP_SHIFT);
+			retval = jtag_vpi_queue_tdi_xfer(bits ? &xmit_buffer[i] : NULL,
+					XFERT_MAX_SIZE * 8, NO_TAP_SHIFT);
 			if (retval != ERROR_OK)
 				return retval;
 			xmit_nb_bits -= XFERT_MAX_SIZE * 8;
@@ -267,12 +387,14 @@ static int jtag_vpi_scan(struct scan_command *cmd)
 			return retval;
 	}
 
+	/* The TDO bits are picked up at the next flush: jtag_read_buffer()
+	 * runs from there, and it also frees buf. */
 	if (cmd->end_state == TAP_DRSHIFT) {
-		retval = jtag_vpi_queue_tdi(buf, scan_bits, NO_TAP_SHIFT);
+		retval = jtag_vpi_queue_tdi(buf, scan_bits, NO_TAP_SHIFT, buf, cmd);
 		if (retval != ERROR_OK)
 			return retval;
 	} else {
-		retval = jtag_vpi_queue_tdi(buf, scan_bits, TAP_SHIFT);
+		retval = jtag_vpi_queue_tdi(buf, scan_bits, TAP_SHIFT, buf, cmd);
 		if (retval != ERROR_OK)
 			return retval;
 	}
@@ -292,13 +414,6 @@ static int jtag_vpi_scan(struct scan_command *cmd)
 			tap_set_state(TAP_DRPAUSE);
 	}
 
-	retval = jtag_read_buffer(buf, cmd);
-	if (retval != ERROR_OK)
-		return retval;
-
-	if (buf)
-		free(buf);
-
 	if (cmd->end_state != TAP_DRSHIFT) {
 		retval = jtag_vpi_state_move(cmd->end_state);
 		if (retval != ERROR_OK)
@@ -316,7 +431,7 @@ static int jtag_vpi_runtest(int cycles, tap_state_t state)
 	if (retval != ERROR_OK)
 		return retval;
 
-	retval = jtag_vpi_queue_tdi(NULL, cycles, TAP_SHIFT);
+	retval = jtag_vpi_queue_tdi(NULL, cycles, TAP_SHIFT, NULL, NULL);
 	if (retval != ERROR_OK)
 		return retval;
 
@@ -325,7 +440,7 @@ static int jtag_vpi_runtest(int cycles, tap_state_t state)
 
 static int jtag_vpi_stableclocks(int cycles)
 {
-	return jtag_vpi_queue_tdi(NULL, cycles, TAP_SHIFT);
+	return jtag_vpi_queue_tdi(NULL, cycles, TAP_SHIFT, NULL, NULL);
 }
 
 static int jtag_vpi_execute_queue(void)
@@ -356,6 +471,7 @@ static int jtag_vpi_execute_queue(void)
 			retval = jtag_vpi_tms(cmd->cmd.tms);
 			break;
 		case JTAG_SLEEP:
+			retval = jtag_vpi_flush();
 			jtag_sleep(cmd->cmd.sleep->us);
 			break;
 		case JTAG_SCAN:
@@ -364,11 +480,19 @@ static int jtag_vpi_execute_queue(void)
 		}
 	}
 
+	if (retval == ERROR_OK)
+		retval = jtag_vpi_flush();
+
 	return retval;
 }
 
 static int jtag_vpi_init(void)
 {
+	int flag = 1;
+
+	vpi_queue_count = 0;
+	vpi_pending_reply_count = 0;
+
 	sockfd = socket(AF_INET, SOCK_STREAM, 0);
 	if (sockfd < 0) {
 		LOG_ERROR("Could not create socket");
@@ -396,6 +520,11 @@ static int jtag_vpi_init(void)
 		return ERROR_COMMAND_CLOSE_CONNECTION;
 	}
 
+	/* The queue is flushed in one segment; make sure it leaves right away
+	 * instead of lingering in the Nagle buffer. */
+	if (setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag)) < 0)
+		LOG_WARNING("setsockopt(TCP_NODELAY): %s", strerror(errno));
+
 	LOG_INFO("Connection to %s : %u succeed", server_address, server_port);
 
 	return ERROR_OK;
@@ -434,6 +563,27 @@ COMMAND_HANDLER(jtag_vpi_set_address)
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(jtag_vpi_set_queue_depth)
+{
+	if (CMD_ARGC == 0)
+		LOG_WARNING("You need to set a queue depth");
+	else {
+		int depth;
+
+		COMMAND_PARSE_NUMBER(int, CMD_ARGV[0], depth);
+		if (depth < 1 || depth > VPI_QUEUE_DEPTH_MAX) {
+			command_print(CMD_CTX, "queue depth out of range (1..%d)",
+				VPI_QUEUE_DEPTH_MAX);
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		}
+		vpi_queue_depth = depth;
+	}
+
+	LOG_INFO("Set queue depth to %d", vpi_queue_depth);
+
+	return ERROR_OK;
+}
+
 static const struct command_registration jtag_vpi_command_handlers[] = {
 	{
 		.name = "jtag_vpi_set_port",
@@ -449,6 +599,14 @@ static const struct command_registration jtag_vpi_command_handlers[] = {
 		.help = "set the address of the VPI server",
 		.usage = "description_string",
 	},
+	{
+		.name = "jtag_vpi_set_queue_depth",
+		.handler = &jtag_vpi_set_queue_depth,
+		.mode = COMMAND_CONFIG,
+		.help = "set the number of commands aggregated per TCP segment "
+			"(1 restores one segment per command)",
+		.usage = "depth",
+	},
 	COMMAND_REGISTRATION_DONE
 };
 
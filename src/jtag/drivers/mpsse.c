@@ -66,6 +66,18 @@
 #define SIO_RESET_PURGE_RX 1
 #define SIO_RESET_PURGE_TX 2
 
+/* Context needed by the transfer callbacks */
+struct transfer_result {
+	struct mpsse_ctx *ctx;
+	bool done;
+	unsigned transferred;
+	/* total bytes and base buffer of this transfer; needed because a
+	 * write may still be in flight when the context already builds
+	 * the next batch */
+	unsigned count;
+	uint8_t *buffer;
+};
+
 struct mpsse_ctx {
 	libusb_context *usb_ctx;
 	libusb_device_handle *usb_dev;
@@ -87,8 +99,15 @@ struct mpsse_ctx {
 	unsigned read_chunk_size;
 	struct bit_copy_queue read_queue;
 	int retval;
+	/* double buffering: spare buffer that commands are built in while
+	 * the previous write-only batch is still on the wire */
+	uint8_t *write_buffer_alt;
+	struct libusb_transfer *pending_write;
+	struct transfer_result pending_write_result;
 };
 
+static int mpsse_flush_async(struct mpsse_ctx *ctx);
+
 /* Returns true if the string descriptor indexed by str_index in device matches string */
 static bool string_descriptor_equal(libusb_device_handle *device, uint8_t str_index,
 	const char *string)
@@ -278,7 +297,8 @@ struct mpsse_ctx *mpsse_open(const uint16_t *vid, const uint16_t *pid, const cha
 	ctx->read_chunk = malloc(ctx->read_chunk_size);
 	ctx->read_buffer = malloc(ctx->read_size);
 	ctx->write_buffer = malloc(ctx->write_size);
-	if (!ctx->read_chunk || !ctx->read_buffer || !ctx->write_buffer)
+	ctx->write_buffer_alt = malloc(ctx->write_size);
+	if (!ctx->read_chunk || !ctx->read_buffer || !ctx->write_buffer || !ctx->write_buffer_alt)
 		goto error;
 
 	ctx->interface = channel;
@@ -337,6 +357,15 @@ error:
 
 void mpsse_close(struct mpsse_ctx *ctx)
 {
+	/* don't leave a write dangling on a handle we are about to close */
+	if (ctx->pending_write) {
+		libusb_cancel_transfer(ctx->pending_write);
+		while (!ctx->pending_write_result.done)
+			if (libusb_handle_events(ctx->usb_ctx) != LIBUSB_SUCCESS)
+				break;
+		libusb_free_transfer(ctx->pending_write);
+		ctx->pending_write = NULL;
+	}
 	if (ctx->usb_dev)
 		libusb_close(ctx->usb_dev);
 	if (ctx->usb_ctx)
@@ -344,6 +373,8 @@ void mpsse_close(struct mpsse_ctx *ctx)
 	bit_copy_discard(&ctx->read_queue);
 	if (ctx->write_buffer)
 		free(ctx->write_buffer);
+	if (ctx->write_buffer_alt)
+		free(ctx->write_buffer_alt);
 	if (ctx->read_buffer)
 		free(ctx->read_buffer);
 	if (ctx->read_chunk)
@@ -361,6 +392,17 @@ void mpsse_purge(struct mpsse_ctx *ctx)
 {
 	int err;
 	LOG_DEBUG("-");
+
+	/* drop a write that is still in flight; its batch is void anyway */
+	if (ctx->pending_write) {
+		libusb_cancel_transfer(ctx->pending_write);
+		while (!ctx->pending_write_result.done)
+			if (libusb_handle_events(ctx->usb_ctx) != LIBUSB_SUCCESS)
+				break;
+		libusb_free_transfer(ctx->pending_write);
+		ctx->pending_write = NULL;
+	}
+
 	ctx->write_count = 0;
 	ctx->read_count = 0;
 	ctx->retval = ERROR_OK;
@@ -452,7 +494,7 @@ void mpsse_clock_data(struct mpsse_ctx *ctx, const uint8_t *out, unsigned out_of
 		/* Guarantee buffer space enough for a minimum size transfer */
 		if (buffer_write_space(ctx) + (length < 8) < (out || (!out && !in) ? 4 : 3)
 				|| (in && buffer_read_space(ctx) < 1))
-			ctx->retval = mpsse_flush(ctx);
+			ctx->retval = mpsse_flush_async(ctx);
 
 		if (length < 8) {
 			/* Transfer remaining bits in bit mode */
@@ -526,7 +568,7 @@ void mpsse_clock_tms_cs(struct mpsse_ctx *ctx, const uint8_t *out, unsigned out_
 	while (length > 0) {
 		/* Guarantee buffer space enough for a minimum size transfer */
 		if (buffer_write_space(ctx) < 3 || (in && buffer_read_space(ctx) < 1))
-			ctx->retval = mpsse_flush(ctx);
+			ctx->retval = mpsse_flush_async(ctx);
 
 		/* Byte transfer */
 		unsigned this_bits = length;
@@ -569,7 +611,7 @@ void mpsse_set_data_bits_low_byte(struct mpsse_ctx *ctx, uint8_t data, uint8_t d
 	}
 
 	if (buffer_write_space(ctx) < 3)
-		ctx->retval = mpsse_flush(ctx);
+		ctx->retval = mpsse_flush_async(ctx);
 
 	buffer_write_byte(ctx, 0x80);
 	buffer_write_byte(ctx, data);
@@ -586,7 +628,7 @@ void mpsse_set_data_bits_high_byte(struct mpsse_ctx *ctx, uint8_t data, uint8_t
 	}
 
 	if (buffer_write_space(ctx) < 3)
-		ctx->retval = mpsse_flush(ctx);
+		ctx->retval = mpsse_flush_async(ctx);
 
 	buffer_write_byte(ctx, 0x82);
 	buffer_write_byte(ctx, data);
@@ -603,7 +645,7 @@ void mpsse_read_data_bits_low_byte(struct mpsse_ctx *ctx, uint8_t *data)
 	}
 
 	if (buffer_write_space(ctx) < 1 || buffer_read_space(ctx) < 1)
-		ctx->retval = mpsse_flush(ctx);
+		ctx->retval = mpsse_flush_async(ctx);
 
 	buffer_write_byte(ctx, 0x81);
 	buffer_add_read(ctx, data, 0, 8, 0);
@@ -619,7 +661,7 @@ void mpsse_read_data_bits_high_byte(struct mpsse_ctx *ctx, uint8_t *data)
 	}
 
 	if (buffer_write_space(ctx) < 1 || buffer_read_space(ctx) < 1)
-		ctx->retval = mpsse_flush(ctx);
+		ctx->retval = mpsse_flush_async(ctx);
 
 	buffer_write_byte(ctx, 0x83);
 	buffer_add_read(ctx, data, 0, 8, 0);
@@ -634,7 +676,7 @@ static void single_byte_boolean_helper(struct mpsse_ctx *ctx, bool var, uint8_t
 	}
 
 	if (buffer_write_space(ctx) < 1)
-		ctx->retval = mpsse_flush(ctx);
+		ctx->retval = mpsse_flush_async(ctx);
 
 	buffer_write_byte(ctx, var ? val_if_true : val_if_false);
 }
@@ -655,7 +697,7 @@ void mpsse_set_divisor(struct mpsse_ctx *ctx, uint16_t divisor)
 	}
 
 	if (buffer_write_space(ctx) < 3)
-		ctx->retval = mpsse_flush(ctx);
+		ctx->retval = mpsse_flush_async(ctx);
 
 	buffer_write_byte(ctx, 0x86);
 	buffer_write_byte(ctx, divisor & 0xff);
@@ -715,13 +757,6 @@ int mpsse_set_frequency(struct mpsse_ctx *ctx, int frequency)
 	return frequency;
 }
 
-/* Context needed by the callbacks */
-struct transfer_result {
-	struct mpsse_ctx *ctx;
-	bool done;
-	unsigned transferred;
-};
-
 static LIBUSB_CALL void read_cb(struct libusb_transfer *transfer)
 {
 	struct transfer_result *res = transfer->user_data;
@@ -763,25 +798,66 @@ static LIBUSB_CALL void read_cb(struct libusb_transfer *transfer)
 static LIBUSB_CALL void write_cb(struct libusb_transfer *transfer)
 {
 	struct transfer_result *res = transfer->user_data;
-	struct mpsse_ctx *ctx = res->ctx;
 
 	res->transferred += transfer->actual_length;
 
-	DEBUG_IO("transferred %d of %d", res->transferred, ctx->write_count);
+	DEBUG_IO("transferred %d of %d", res->transferred, res->count);
 
 	DEBUG_PRINT_BUF(transfer->buffer, transfer->actual_length);
 
-	if (res->transferred == ctx->write_count)
+	if (res->transferred == res->count)
 		res->done = true;
 	else {
-		transfer->length = ctx->write_count - res->transferred;
-		transfer->buffer = ctx->write_buffer + res->transferred;
+		transfer->length = res->count - res->transferred;
+		transfer->buffer = res->buffer + res->transferred;
 		if (libusb_submit_transfer(transfer) != LIBUSB_SUCCESS)
 			res->done = true;
 	}
 }
 
-int mpsse_flush(struct mpsse_ctx *ctx)
+/* Wait for a double-buffered write-only batch to leave the wire. */
+static int mpsse_join_pending_write(struct mpsse_ctx *ctx)
+{
+	if (!ctx->pending_write)
+		return ERROR_OK;
+
+	struct transfer_result *res = &ctx->pending_write_result;
+	int retval = LIBUSB_SUCCESS;
+
+	while (!res->done) {
+		retval = libusb_handle_events(ctx->usb_ctx);
+		keep_alive();
+		if (retval != LIBUSB_SUCCESS && retval != LIBUSB_ERROR_INTERRUPTED) {
+			libusb_cancel_transfer(ctx->pending_write);
+			while (!res->done)
+				if (libusb_handle_events(ctx->usb_ctx) != LIBUSB_SUCCESS)
+					break;
+			break;
+		}
+	}
+
+	libusb_free_transfer(ctx->pending_write);
+	ctx->pending_write = NULL;
+
+	if (retval != LIBUSB_SUCCESS && retval != LIBUSB_ERROR_INTERRUPTED) {
+		LOG_ERROR("libusb_handle_events() failed with %s", libusb_error_name(retval));
+		retval = ERROR_FAIL;
+	} else if (res->transferred < res->count) {
+		LOG_ERROR("ftdi device did not accept all data: %d, tried %d",
+			res->transferred,
+			res->count);
+		retval = ERROR_FAIL;
+	} else {
+		retval = ERROR_OK;
+	}
+
+	if (retval != ERROR_OK)
+		mpsse_purge(ctx);
+
+	return retval;
+}
+
+static int mpsse_do_flush(struct mpsse_ctx *ctx, bool async)
 {
 	int retval = ctx->retval;
 
@@ -796,9 +872,53 @@ int mpsse_flush(struct mpsse_ctx *ctx)
 			ctx->read_count);
 	assert(ctx->write_count > 0 || ctx->read_count == 0); /* No read data without write data */
 
+	/* the previous batch must be off the wire before its buffer is
+	 * reused or a response is expected */
+	retval = mpsse_join_pending_write(ctx);
+	if (retval != ERROR_OK) {
+		ctx->write_count = 0;
+		ctx->read_count = 0;
+		bit_copy_discard(&ctx->read_queue);
+		return retval;
+	}
+
 	if (ctx->write_count == 0)
 		return retval;
 
+	if (async && ctx->read_count == 0) {
+		/* Double-buffered write-only flush: leave the transfer in
+		 * flight and build the next batch in the spare buffer. */
+		struct libusb_transfer *write_transfer = libusb_alloc_transfer(0);
+
+		ctx->pending_write_result = (struct transfer_result){
+			.ctx = ctx,
+			.done = false,
+			.count = ctx->write_count,
+			.buffer = ctx->write_buffer,
+		};
+		libusb_fill_bulk_transfer(write_transfer, ctx->usb_dev, ctx->out_ep,
+			ctx->write_buffer, ctx->write_count, write_cb,
+			&ctx->pending_write_result, ctx->usb_write_timeout);
+
+		retval = libusb_submit_transfer(write_transfer);
+		if (retval != LIBUSB_SUCCESS) {
+			LOG_ERROR("libusb_submit_transfer() failed with %s",
+				libusb_error_name(retval));
+			libusb_free_transfer(write_transfer);
+			mpsse_purge(ctx);
+			return ERROR_FAIL;
+		}
+		ctx->pending_write = write_transfer;
+
+		uint8_t *spare = ctx->write_buffer_alt;
+		ctx->write_buffer_alt = ctx->write_buffer;
+		ctx->write_buffer = spare;
+		ctx->write_count = 0;
+		bit_copy_discard(&ctx->read_queue);
+
+		return ERROR_OK;
+	}
+
 	struct libusb_transfer *read_transfer = 0;
 	struct transfer_result read_result = { .ctx = ctx, .done = true };
 	if (ctx->read_count) {
@@ -808,7 +928,12 @@ int mpsse_flush(struct mpsse_ctx *ctx)
 		   immediately after processing the MPSSE commands in the write transaction */
 	}
 
-	struct transfer_result write_result = { .ctx = ctx, .done = false };
+	struct transfer_result write_result = {
+		.ctx = ctx,
+		.done = false,
+		.count = ctx->write_count,
+		.buffer = ctx->write_buffer,
+	};
 	struct libusb_transfer *write_transfer = libusb_alloc_transfer(0);
 	libusb_fill_bulk_transfer(write_transfer, ctx->usb_dev, ctx->out_ep, ctx->write_buffer,
 		ctx->write_count, write_cb, &write_result, ctx->usb_write_timeout);
@@ -869,3 +994,13 @@ int mpsse_flush(struct mpsse_ctx *ctx)
 
 	return retval;
 }
+
+int mpsse_flush(struct mpsse_ctx *ctx)
+{
+	return mpsse_do_flush(ctx, false);
+}
+
+static int mpsse_flush_async(struct mpsse_ctx *ctx)
+{
+	return mpsse_do_flush(ctx, true);
+}
@@ -114,6 +114,11 @@ static uint8_t usb_rx_buf[OPENJTAG_BUFFER_SIZE];
 static struct openjtag_scan_result openjtag_scan_result_buffer[OPENJTAG_MAX_PENDING_RESULTS];
 static int openjtag_scan_result_count;
 
+/* Results already written to the adapter but not yet read back */
+static struct openjtag_scan_result openjtag_inflight_result_buffer[OPENJTAG_MAX_PENDING_RESULTS];
+static int openjtag_inflight_result_count;
+static uint32_t openjtag_inflight_rx_bytes;
+
 /* Openocd usb handler */
 struct openocd {
 	struct usb_dev_handle *usb_handle;
@@ -348,6 +353,8 @@ static int openjtag_init(void)
 usb_tx_buf_offs = 0;
 usb_rx_buf_len = 0;
 openjtag_scan_result_count = 0;
+openjtag_inflight_result_count = 0;
+openjtag_inflight_rx_bytes = 0;
 
 #if BUILD_OPENJTAG_FTD2XX == 1
 	LOG_DEBUG("'openjtag' interface using FTD2XX");
@@ -506,37 +513,31 @@ static int openjtag_quit(void)
 	return ERROR_OK;
 }
 
-static void openjtag_write_tap_buffer(void)
-{
-	uint32_t written;
-
-	openjtag_buf_write(usb_tx_buf, usb_tx_buf_offs, &written);
-	openjtag_buf_read(usb_rx_buf, usb_tx_buf_offs, &usb_rx_buf_len);
-
-	usb_tx_buf_offs = 0;
-}
-
-static int openjtag_execute_tap_queue(void)
+static int openjtag_drain_tap_buffer(void)
 {
-	openjtag_write_tap_buffer();
-
 	int res_count = 0;
 
-	if (openjtag_scan_result_count && usb_rx_buf_len) {
+	if (openjtag_inflight_rx_bytes) {
+		openjtag_buf_read(usb_rx_buf, openjtag_inflight_rx_bytes, &usb_rx_buf_len);
+		openjtag_inflight_rx_bytes = 0;
+	} else
+		usb_rx_buf_len = 0;
+
+	if (openjtag_inflight_result_count && usb_rx_buf_len) {
 
 		int count;
 		int rx_offs = 0;
 		int len;
 
 		/* for every pending result */
-		while (res_count < openjtag_scan_result_count) {
+		while (res_count < openjtag_inflight_result_count) {
 
 			/* get sent bits */
-			len = openjtag_scan_result_buffer[res_count].bits;
+			len = openjtag_inflight_result_buffer[res_count].bits;
 
 			count = 0;
 
-			uint8_t *buffer = openjtag_scan_result_buffer[res_count].buffer;
+			uint8_t *buffer = openjtag_inflight_result_buffer[res_count].buffer;
 
 			while (len) {
 				if (len <= 8) {
@@ -555,29 +556,67 @@ static int openjtag_execute_tap_queue(void)
 
 #ifdef _DEBUG_USB_COMMS_
 			openjtag_debug_buffer(buffer,
-				DIV_ROUND_UP(openjtag_scan_result_buffer[res_count].bits, 8), DEBUG_TYPE_OCD_READ);
+				DIV_ROUND_UP(openjtag_inflight_result_buffer[res_count].bits, 8), DEBUG_TYPE_OCD_READ);
 #endif
-			jtag_read_buffer(buffer, openjtag_scan_result_buffer[res_count].command);
+			jtag_read_buffer(buffer, openjtag_inflight_result_buffer[res_count].command);
 
-			if (openjtag_scan_result_buffer[res_count].buffer)
-				free(openjtag_scan_result_buffer[res_count].buffer);
+			if (openjtag_inflight_result_buffer[res_count].buffer)
+				free(openjtag_inflight_result_buffer[res_count].buffer);
 
 			res_count++;
 		}
 	}
 
-	openjtag_scan_result_count = 0;
+	openjtag_inflight_result_count = 0;
 
 	return ERROR_OK;
 }
 
+static void openjtag_write_tap_buffer(void)
+{
+	uint32_t written;
+	uint32_t rx_expected = 0;
+
+	/* calculate the exact number of reply bytes: only shift commands
+	 * produce one, everything else is write-only.  Reading more used
+	 * to cost a read timeout per flush. */
+	for (int tx_offs = 0; tx_offs < usb_tx_buf_offs; tx_offs++) {
+		if ((usb_tx_buf[tx_offs] & 0x0F) == 6) {
+			rx_expected++;
+			tx_offs++; /* skip the data byte */
+		}
+	}
+
+	if (usb_tx_buf_offs)
+		openjtag_buf_write(usb_tx_buf, usb_tx_buf_offs, &written);
+	usb_tx_buf_offs = 0;
+
+	/* the previous chunk's replies are collected only now, after the
+	 * next chunk has been written, so the adapter keeps shifting
+	 * while we parse */
+	openjtag_drain_tap_buffer();
+
+	memcpy(openjtag_inflight_result_buffer, openjtag_scan_result_buffer,
+			openjtag_scan_result_count * sizeof(struct openjtag_scan_result));
+	openjtag_inflight_result_count = openjtag_scan_result_count;
+	openjtag_inflight_rx_bytes = rx_expected;
+	openjtag_scan_result_count = 0;
+}
+
+static int openjtag_execute_tap_queue(void)
+{
+	openjtag_write_tap_buffer();
+
+	return openjtag_drain_tap_buffer();
+}
+
 static void openjtag_add_byte(char buf)
 {
 
 	if (usb_tx_buf_offs == OPENJTAG_BUFFER_SIZE) {
-		DEBUG_JTAG_IO("Forcing execute_tap_queue");
+		DEBUG_JTAG_IO("Forcing write_tap_buffer");
 		DEBUG_JTAG_IO("TX Buff offs=%d", usb_tx_buf_offs);
-		openjtag_execute_tap_queue();
+		openjtag_write_tap_buffer();
 	}
 
 	usb_tx_buf[usb_tx_buf_offs] = buf;
@@ -590,9 +629,9 @@ static void openjtag_add_scan(uint8_t *buffer, int length, struct scan_command *
 	/* Ensure space to send long chains */
 	/* We add two byte for each eight (or less) bits, one for command, one for data */
 	if (usb_tx_buf_offs + (DIV_ROUND_UP(length, 8) * 2) >= OPENJTAG_BUFFER_SIZE) {
-		DEBUG_JTAG_IO("Forcing execute_tap_queue from scan");
+		DEBUG_JTAG_IO("Forcing write_tap_buffer from scan");
 		DEBUG_JTAG_IO("TX Buff offs=%d len=%d", usb_tx_buf_offs, DIV_ROUND_UP(length, 8) * 2);
-		openjtag_execute_tap_queue();
+		openjtag_write_tap_buffer();
 	}
 
 	openjtag_scan_result_buffer[openjtag_scan_result_count].bits = length;
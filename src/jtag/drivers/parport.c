@@ -173,6 +173,45 @@ static void parport_write(int tck, int tms, int tdi)
 		parport_write_data();
 }
 
+/* Block variant of parport_write(): one tight loop over the packed
+ * buffers, with the TDO status read skipped entirely when the capture
+ * is not wanted.  Each TCK edge still costs one PPWDATA ioctl (or
+ * outb) -- ppdev has no vectored register write -- but the per-bit
+ * queue interpretation and indirect calls are gone. */
+static void parport_block_transfer(const uint8_t *tms_buf, const uint8_t *tdi_buf,
+		uint8_t *tdo_buf, unsigned num_bits)
+{
+	for (unsigned i = 0; i < num_bits; i++) {
+		int bytec = i / 8;
+		int bcval = 1 << (i % 8);
+		int w;
+
+		dataport_value &= ~(cable->TCK_MASK | cable->TMS_MASK | cable->TDI_MASK);
+		if (tms_buf && (tms_buf[bytec] & bcval))
+			dataport_value |= cable->TMS_MASK;
+		if (tdi_buf && (tdi_buf[bytec] & bcval))
+			dataport_value |= cable->TDI_MASK;
+
+		/* falling edge, with the new TMS/TDI */
+		w = wait_states + 1;
+		while (w-- > 0)
+			parport_write_data();
+
+		if (tdo_buf) {
+			if (parport_read())
+				tdo_buf[bytec] |= bcval;
+			else
+				tdo_buf[bytec] &= ~bcval;
+		}
+
+		/* rising edge; TCK is left high after the last bit */
+		dataport_value |= cable->TCK_MASK;
+		w = wait_states + 1;
+		while (w-- > 0)
+			parport_write_data();
+	}
+}
+
 /* (1) assert or (0) deassert reset lines */
 static void parport_reset(int trst, int srst)
 {
@@ -258,6 +297,7 @@ static struct bitbang_interface parport_bitbang = {
 		.write = &parport_write,
 		.reset = &parport_reset,
 		.blink = &parport_led,
+		.block_transfer = &parport_block_transfer,
 	};
 
 static int parport_init(void)
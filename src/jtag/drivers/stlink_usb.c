@@ -54,7 +54,7 @@
 #define STLINK_V2_1_TRACE_EP  (2|ENDPOINT_IN)
 
 #define STLINK_SG_SIZE        (31)
-#define STLINK_DATA_SIZE      (4096)
+#define STLINK_DATA_SIZE      (6144)
 #define STLINK_CMD_SIZE_V2    (16)
 #define STLINK_CMD_SIZE_V1    (10)
 
@@ -66,6 +66,10 @@
  * 8bit read/writes to max 64 bytes. */
 #define STLINK_MAX_RW8		(64)
 
+/* 32bit read/writes can carry up to a full data buffer per command
+ * on firmware from V2 J26 on. */
+#define STLINK_MAX_RW32		(6144)
+
 /* "WAIT" responses will be retried (with exponential backoff) at
  * most this many times before failing to caller.
  */
@@ -110,6 +114,12 @@ struct stlink_usb_handle_s {
 	uint8_t databuf[STLINK_DATA_SIZE];
 	/** */
 	uint32_t max_mem_packet;
+	/** largest 32bit block a single read/write command may carry */
+	uint32_t max_rw_block;
+	/** defer per-block status reads inside a streaming transfer */
+	bool defer_rw_status;
+	/** a status check is owed for one or more deferred blocks */
+	bool rw_status_pending;
 	/** */
 	enum hl_transports transport;
 	/** */
@@ -1137,26 +1147,38 @@ static int stlink_usb_step(void *handle)
 }
 
 /** */
-static int stlink_usb_read_regs(void *handle)
+static int stlink_usb_read_regs(void *handle, uint32_t *regs, unsigned int count)
 {
 	int res;
+	unsigned int i, offset;
 	struct stlink_usb_handle_s *h = handle;
 
 	assert(handle != NULL);
 
-	stlink_usb_init_buffer(handle, h->rx_ep, 84);
+	/* the reply defines r0..r15, xPSR, MSP and PSP only */
+	if (count > 19)
+		count = 19;
+
+	stlink_usb_init_buffer(handle, h->rx_ep, 88);
 
 	h->cmdbuf[h->cmdidx++] = STLINK_DEBUG_COMMAND;
-	if (h->jtag_api == STLINK_JTAG_API_V1)
+	if (h->jtag_api == STLINK_JTAG_API_V1) {
 		h->cmdbuf[h->cmdidx++] = STLINK_DEBUG_APIV1_READALLREGS;
-	else
+		res = stlink_usb_xfer(handle, h->databuf, 84);
+		offset = 0;
+	} else {
+		/* the APIv2 reply carries a 4 byte status in front */
 		h->cmdbuf[h->cmdidx++] = STLINK_DEBUG_APIV2_READALLREGS;
-
-	res = stlink_usb_xfer(handle, h->databuf, 84);
+		res = stlink_usb_xfer(handle, h->databuf, 88);
+		offset = 4;
+	}
 
 	if (res != ERROR_OK)
 		return res;
 
+	for (i = 0; i < count; i++)
+		regs[i] = le_to_h_u32(h->databuf + offset + i * 4);
+
 	return ERROR_OK;
 }
 
@@ -1236,6 +1258,22 @@ static int stlink_usb_get_rw_status(void *handle)
 	return stlink_usb_error_check(h);
 }
 
+/** Check the status of the last memory block, unless the enclosing
+    streaming transfer has elected to defer checking to its end. A fault
+    in an earlier block leaves the DAP sticky error flags set, so it is
+    still visible in the final check. */
+static int stlink_usb_block_rw_status(void *handle)
+{
+	struct stlink_usb_handle_s *h = handle;
+
+	if (h->defer_rw_status) {
+		h->rw_status_pending = true;
+		return ERROR_OK;
+	}
+
+	return stlink_usb_get_rw_status(handle);
+}
+
 /** */
 static int stlink_usb_read_mem8(void *handle, uint32_t addr, uint16_t len,
 			  uint8_t *buffer)
@@ -1272,7 +1310,7 @@ static int stlink_usb_read_mem8(void *handle, uint32_t addr, uint16_t len,
 
 	memcpy(buffer, h->databuf, len);
 
-	return stlink_usb_get_rw_status(handle);
+	return stlink_usb_block_rw_status(handle);
 }
 
 /** */
@@ -1304,7 +1342,7 @@ static int stlink_usb_write_mem8(void *handle, uint32_t addr, uint16_t len,
 	if (res != ERROR_OK)
 		return res;
 
-	return stlink_usb_get_rw_status(handle);
+	return stlink_usb_block_rw_status(handle);
 }
 
 /** */
@@ -1338,7 +1376,7 @@ static int stlink_usb_read_mem32(void *handle, uint32_t addr, uint16_t len,
 
 	memcpy(buffer, h->databuf, len);
 
-	return stlink_usb_get_rw_status(handle);
+	return stlink_usb_block_rw_status(handle);
 }
 
 /** */
@@ -1370,7 +1408,7 @@ static int stlink_usb_write_mem32(void *handle, uint32_t addr, uint16_t len,
 	if (res != ERROR_OK)
 		return res;
 
-	return stlink_usb_get_rw_status(handle);
+	return stlink_usb_block_rw_status(handle);
 }
 
 static uint32_t stlink_max_block_size(uint32_t tar_autoincr_block, uint32_t address)
@@ -1381,21 +1419,35 @@ static uint32_t stlink_max_block_size(uint32_t tar_autoincr_block, uint32_t addr
 	return max_tar_block;
 }
 
-static int stlink_usb_read_mem(void *handle, uint32_t addr, uint32_t size,
+static uint32_t stlink_usb_block_size(struct stlink_usb_handle_s *h, uint32_t address)
+{
+	/* if a flat limit larger than the auto-increment range was
+	 * negotiated, blocks need not stop at the wrap boundary */
+	if (h->max_rw_block > h->max_mem_packet)
+		return h->max_rw_block;
+
+	return stlink_max_block_size(h->max_mem_packet, address);
+}
+
+static int stlink_usb_read_mem_blocks(void *handle, uint32_t addr, uint32_t size,
 		uint32_t count, uint8_t *buffer)
 {
 	int retval = ERROR_OK;
 	uint32_t bytes_remaining;
-	int retries = 0;
 	struct stlink_usb_handle_s *h = handle;
+	bool outer_defer = h->defer_rw_status;
 
 	/* calculate byte count */
 	count *= size;
 
+	/* Batch the blocks and check the r/w status once at the end,
+	 * halving the number of USB commands per transfer */
+	h->defer_rw_status = true;
+
 	while (count) {
 
 		bytes_remaining = (size == 4) ? \
-				stlink_max_block_size(h->max_mem_packet, addr) : STLINK_MAX_RW8;
+				stlink_usb_block_size(h, addr) : STLINK_MAX_RW8;
 
 		if (count < bytes_remaining)
 			bytes_remaining = count;
@@ -1417,12 +1469,8 @@ static int stlink_usb_read_mem(void *handle, uint32_t addr, uint32_t size,
 
 				uint32_t head_bytes = 4 - (addr % 4);
 				retval = stlink_usb_read_mem8(handle, addr, head_bytes, buffer);
-				if (retval == ERROR_WAIT && retries < MAX_WAIT_RETRIES) {
-					usleep((1<<retries++) * 1000);
-					continue;
-				}
 				if (retval != ERROR_OK)
-					return retval;
+					break;
 				buffer += head_bytes;
 				addr += head_bytes;
 				count -= head_bytes;
@@ -1430,42 +1478,69 @@ static int stlink_usb_read_mem(void *handle, uint32_t addr, uint32_t size,
 			}
 
 			if (bytes_remaining % 4)
-				retval = stlink_usb_read_mem(handle, addr, 1, bytes_remaining, buffer);
+				retval = stlink_usb_read_mem_blocks(handle, addr, 1, bytes_remaining, buffer);
 			else
 				retval = stlink_usb_read_mem32(handle, addr, bytes_remaining, buffer);
 		} else
 			retval = stlink_usb_read_mem8(handle, addr, bytes_remaining, buffer);
 
-		if (retval == ERROR_WAIT && retries < MAX_WAIT_RETRIES) {
-			usleep((1<<retries++) * 1000);
-			continue;
-		}
 		if (retval != ERROR_OK)
-			return retval;
+			break;
 
 		buffer += bytes_remaining;
 		addr += bytes_remaining;
 		count -= bytes_remaining;
 	}
 
+	h->defer_rw_status = outer_defer;
+	if (!outer_defer && h->rw_status_pending) {
+		h->rw_status_pending = false;
+		if (retval == ERROR_OK)
+			retval = stlink_usb_get_rw_status(handle);
+		else
+			stlink_usb_get_rw_status(handle);
+	}
+
 	return retval;
 }
 
-static int stlink_usb_write_mem(void *handle, uint32_t addr, uint32_t size,
+static int stlink_usb_read_mem(void *handle, uint32_t addr, uint32_t size,
+		uint32_t count, uint8_t *buffer)
+{
+	int retries = 0;
+	int retval;
+
+	while (1) {
+		retval = stlink_usb_read_mem_blocks(handle, addr, size, count, buffer);
+		if (retval == ERROR_WAIT && retries < MAX_WAIT_RETRIES) {
+			/* the deferred status cannot tell which block stalled,
+			 * so repeat the whole (idempotent) transfer */
+			usleep((1<<retries++) * 1000);
+			continue;
+		}
+		return retval;
+	}
+}
+
+static int stlink_usb_write_mem_blocks(void *handle, uint32_t addr, uint32_t size,
 		uint32_t count, const uint8_t *buffer)
 {
 	int retval = ERROR_OK;
 	uint32_t bytes_remaining;
-	int retries = 0;
 	struct stlink_usb_handle_s *h = handle;
+	bool outer_defer = h->defer_rw_status;
 
 	/* calculate byte count */
 	count *= size;
 
+	/* Batch the blocks and check the r/w status once at the end,
+	 * halving the number of USB commands per transfer */
+	h->defer_rw_status = true;
+
 	while (count) {
 
 		bytes_remaining = (size == 4) ? \
-				stlink_max_block_size(h->max_mem_packet, addr) : STLINK_MAX_RW8;
+				stlink_usb_block_size(h, addr) : STLINK_MAX_RW8;
 
 		if (count < bytes_remaining)
 			bytes_remaining = count;
@@ -1487,12 +1562,8 @@ static int stlink_usb_write_mem(void *handle, uint32_t addr, uint32_t size,
 
 				uint32_t head_bytes = 4 - (addr % 4);
 				retval = stlink_usb_write_mem8(handle, addr, head_bytes, buffer);
-				if (retval == ERROR_WAIT && retries < MAX_WAIT_RETRIES) {
-					usleep((1<<retries++) * 1000);
-					continue;
-				}
 				if (retval != ERROR_OK)
-					return retval;
+					break;
 				buffer += head_bytes;
 				addr += head_bytes;
 				count -= head_bytes;
@@ -1500,27 +1571,51 @@ static int stlink_usb_write_mem(void *handle, uint32_t addr, uint32_t size,
 			}
 
 			if (bytes_remaining % 4)
-				retval = stlink_usb_write_mem(handle, addr, 1, bytes_remaining, buffer);
+				retval = stlink_usb_write_mem_blocks(handle, addr, 1, bytes_remaining, buffer);
 			else
 				retval = stlink_usb_write_mem32(handle, addr, bytes_remaining, buffer);
 
 		} else
 			retval = stlink_usb_write_mem8(handle, addr, bytes_remaining, buffer);
-		if (retval == ERROR_WAIT && retries < MAX_WAIT_RETRIES) {
-			usleep((1<<retries++) * 1000);
-			continue;
-		}
+
 		if (retval != ERROR_OK)
-			return retval;
+			break;
 
 		buffer += bytes_remaining;
 		addr += bytes_remaining;
 		count -= bytes_remaining;
 	}
 
+	h->defer_rw_status = outer_defer;
+	if (!outer_defer && h->rw_status_pending) {
+		h->rw_status_pending = false;
+		if (retval == ERROR_OK)
+			retval = stlink_usb_get_rw_status(handle);
+		else
+			stlink_usb_get_rw_status(handle);
+	}
+
 	return retval;
 }
 
+static int stlink_usb_write_mem(void *handle, uint32_t addr, uint32_t size,
+		uint32_t count, const uint8_t *buffer)
+{
+	int retries = 0;
+	int retval;
+
+	while (1) {
+		retval = stlink_usb_write_mem_blocks(handle, addr, size, count, buffer);
+		if (retval == ERROR_WAIT && retries < MAX_WAIT_RETRIES) {
+			/* the deferred status cannot tell which block stalled,
+			 * so repeat the whole (idempotent) transfer */
+			usleep((1<<retries++) * 1000);
+			continue;
+		}
+		return retval;
+	}
+}
+
 /** */
 static int stlink_usb_override_target(const char *targetname)
 {
@@ -1767,6 +1862,17 @@ static int stlink_usb_open(struct hl_interface_param_s *param, void **fd)
 
 	LOG_DEBUG("Using TAR autoincrement: %" PRIu32, h->max_mem_packet);
 
+	/* From firmware V2 J26 on, a single 32bit command may carry a full
+	 * data buffer. In SWD mode the firmware does single accesses, so
+	 * the TAR auto-increment wrap is no concern there; in jtag mode
+	 * stay within the auto-increment range. */
+	h->max_rw_block = h->max_mem_packet;
+	if (h->version.stlink >= 2 && h->version.jtag >= 26 &&
+			h->transport == HL_TRANSPORT_SWD)
+		h->max_rw_block = STLINK_MAX_RW32;
+
+	LOG_DEBUG("Using 32bit block size: %" PRIu32, h->max_rw_block);
+
 	*fd = h;
 
 	return ERROR_OK;
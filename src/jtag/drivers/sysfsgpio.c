@@ -57,6 +57,8 @@
 #include <jtag/interface.h>
 #include "bitbang.h"
 
+#include <sys/mman.h>
+
 /*
  * Helper func to determine if gpio number valid
  *
@@ -181,6 +183,30 @@ static int last_swdio;
 static bool last_stored;
 static bool swdio_input;
 
+/* Optional /dev/gpiomem fast path.
+ *
+ * Pi-class hosts export the BCM283x GPIO register block through
+ * /dev/gpiomem without needing root or a physical base address.  Pin
+ * setup (export, direction, the reset lines) stays in sysfs so the
+ * rest of the system sees the usual gpiolib state; only the hot value
+ * accesses touch the registers directly.  All value-path pins must sit
+ * in the SoC's first GPIO bank (numbers 0..31, which covers the Pi
+ * header); otherwise, or when the device is absent, the sysfs value
+ * files are used as before. */
+static volatile uint32_t *gpiomem_base;
+static bool gpiomem_enable = true;
+
+#define GPIOMEM_SET (*(gpiomem_base + 7))	/* GPSET0 */
+#define GPIOMEM_CLR (*(gpiomem_base + 10))	/* GPCLR0 */
+#define GPIOMEM_LEV (*(gpiomem_base + 13))	/* GPLEV0 */
+
+/* last values written to tck/tms/tdi, to skip superfluous syscalls;
+ * shared between the per-bit and the block write paths. -1 forces the
+ * first write out. */
+static int last_tck = -1;
+static int last_tms = -1;
+static int last_tdi = -1;
+
 static void sysfsgpio_swdio_drive(bool is_output)
 {
 	char buf[40];
@@ -201,6 +227,9 @@ static int sysfsgpio_swdio_read(void)
 {
 	char buf[1];
 
+	if (gpiomem_base)
+		return !!(GPIOMEM_LEV & (1u << swdio_gpio));
+
 	/* important to seek to signal sysfs of new read */
 	lseek(swdio_fd, 0, SEEK_SET);
 	int ret = read(swdio_fd, &buf, sizeof(buf));
@@ -215,6 +244,23 @@ static int sysfsgpio_swdio_read(void)
 
 static void sysfsgpio_swdio_write(int swclk, int swdio)
 {
+	if (gpiomem_base) {
+		/* data first, clock last, as on the sysfs path */
+		if (swdio)
+			GPIOMEM_SET = 1u << swdio_gpio;
+		else
+			GPIOMEM_CLR = 1u << swdio_gpio;
+		if (swclk)
+			GPIOMEM_SET = 1u << swclk_gpio;
+		else
+			GPIOMEM_CLR = 1u << swclk_gpio;
+
+		last_swdio = swdio;
+		last_swclk = swclk;
+		last_stored = true;
+		return;
+	}
+
 	const char one[] = "1";
 	const char zero[] = "0";
 
@@ -250,6 +296,9 @@ static int sysfsgpio_read(void)
 {
 	char buf[1];
 
+	if (gpiomem_base)
+		return !!(GPIOMEM_LEV & (1u << tdo_gpio));
+
 	/* important to seek to signal sysfs of new read */
 	lseek(tdo_fd, 0, SEEK_SET);
 	int ret = read(tdo_fd, &buf, sizeof(buf));
@@ -275,23 +324,33 @@ static void sysfsgpio_write(int tck, int tms, int tdi)
 		return;
 	}
 
+	if (gpiomem_base) {
+		/* data lines first, clock last, as on the sysfs path */
+		uint32_t set = (tms ? 1u << tms_gpio : 0)
+			| (tdi ? 1u << tdi_gpio : 0);
+		uint32_t clear = (tms ? 0 : 1u << tms_gpio)
+			| (tdi ? 0 : 1u << tdi_gpio);
+
+		if (set)
+			GPIOMEM_SET = set;
+		if (clear)
+			GPIOMEM_CLR = clear;
+		if (tck)
+			GPIOMEM_SET = 1u << tck_gpio;
+		else
+			GPIOMEM_CLR = 1u << tck_gpio;
+
+		last_tdi = tdi;
+		last_tms = tms;
+		last_tck = tck;
+		return;
+	}
+
 	const char one[] = "1";
 	const char zero[] = "0";
 
-	static int last_tck;
-	static int last_tms;
-	static int last_tdi;
-
-	static int first_time;
 	size_t bytes_written;
 
-	if (!first_time) {
-		last_tck = !tck;
-		last_tms = !tms;
-		last_tdi = !tdi;
-		first_time = 1;
-	}
-
 	if (tdi != last_tdi) {
 		bytes_written = write(tdi_fd, tdi ? &one : &zero, 1);
 		if (bytes_written != 1)
@@ -316,6 +375,95 @@ static void sysfsgpio_write(int tck, int tms, int tdi)
 	last_tck = tck;
 }
 
+/*
+ * Block variant of sysfsgpio_write()
+ *
+ * Runs the whole packed buffer in one tight loop. The value caching
+ * means a typical scan pays two syscalls per bit for the TCK edges
+ * plus one whenever TMS or TDI actually changes, instead of up to six.
+ */
+static void sysfsgpio_block_transfer(const uint8_t *tms_buf, const uint8_t *tdi_buf,
+		uint8_t *tdo_buf, unsigned num_bits)
+{
+	const char one[] = "1";
+	const char zero[] = "0";
+
+	size_t bytes_written;
+
+	if (gpiomem_base) {
+		for (unsigned i = 0; i < num_bits; i++) {
+			int bytec = i / 8;
+			int bcval = 1 << (i % 8);
+			int tms = tms_buf ? !!(tms_buf[bytec] & bcval) : 0;
+			int tdi = tdi_buf ? !!(tdi_buf[bytec] & bcval) : 0;
+
+			/* falling edge together with the new TMS/TDI */
+			uint32_t set = (tms ? 1u << tms_gpio : 0)
+				| (tdi ? 1u << tdi_gpio : 0);
+			uint32_t clear = (tms ? 0 : 1u << tms_gpio)
+				| (tdi ? 0 : 1u << tdi_gpio)
+				| 1u << tck_gpio;
+
+			if (set)
+				GPIOMEM_SET = set;
+			GPIOMEM_CLR = clear;
+
+			if (tdo_buf) {
+				if (GPIOMEM_LEV & (1u << tdo_gpio))
+					tdo_buf[bytec] |= bcval;
+				else
+					tdo_buf[bytec] &= ~bcval;
+			}
+
+			GPIOMEM_SET = 1u << tck_gpio;
+
+			last_tms = tms;
+			last_tdi = tdi;
+		}
+		last_tck = 1;
+		return;
+	}
+
+	for (unsigned i = 0; i < num_bits; i++) {
+		int bytec = i / 8;
+		int bcval = 1 << (i % 8);
+		int tms = tms_buf ? !!(tms_buf[bytec] & bcval) : 0;
+		int tdi = tdi_buf ? !!(tdi_buf[bytec] & bcval) : 0;
+
+		if (tdi != last_tdi) {
+			bytes_written = write(tdi_fd, tdi ? &one : &zero, 1);
+			if (bytes_written != 1)
+				LOG_WARNING("writing tdi failed");
+			last_tdi = tdi;
+		}
+
+		if (tms != last_tms) {
+			bytes_written = write(tms_fd, tms ? &one : &zero, 1);
+			if (bytes_written != 1)
+				LOG_WARNING("writing tms failed");
+			last_tms = tms;
+		}
+
+		if (last_tck != 0) {
+			bytes_written = write(tck_fd, zero, 1);
+			if (bytes_written != 1)
+				LOG_WARNING("writing tck failed");
+		}
+
+		if (tdo_buf) {
+			if (sysfsgpio_read())
+				tdo_buf[bytec] |= bcval;
+			else
+				tdo_buf[bytec] &= ~bcval;
+		}
+
+		bytes_written = write(tck_fd, one, 1);
+		if (bytes_written != 1)
+			LOG_WARNING("writing tck failed");
+		last_tck = 1;
+	}
+}
+
 /*
  * Bitbang interface to manipulate reset lines SRST and TRST
  *
@@ -449,6 +597,18 @@ COMMAND_HANDLER(sysfsgpio_handle_swd_gpionum_swdio)
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(sysfsgpio_handle_gpiomem)
+{
+	if (CMD_ARGC == 1)
+		COMMAND_PARSE_ON_OFF(CMD_ARGV[0], gpiomem_enable);
+	else if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	command_print(CMD_CTX, "SysfsGPIO gpiomem fast path: %s",
+		gpiomem_enable ? "enabled" : "disabled");
+	return ERROR_OK;
+}
+
 static const struct command_registration sysfsgpio_command_handlers[] = {
 	{
 		.name = "sysfsgpio_jtag_nums",
@@ -512,6 +672,14 @@ static const struct command_registration sysfsgpio_command_handlers[] = {
 		.mode = COMMAND_CONFIG,
 		.help = "gpio number for swdio.",
 	},
+	{
+		.name = "sysfsgpio_gpiomem",
+		.handler = &sysfsgpio_handle_gpiomem,
+		.mode = COMMAND_CONFIG,
+		.help = "enable or disable the memory mapped /dev/gpiomem "
+			"fast path (default on; used when available).",
+		.usage = "['on'|'off']",
+	},
 	COMMAND_REGISTRATION_DONE
 };
 
@@ -534,6 +702,7 @@ struct jtag_interface sysfsgpio_interface = {
 static struct bitbang_interface sysfsgpio_bitbang = {
 	.read = sysfsgpio_read,
 	.write = sysfsgpio_write,
+	.block_transfer = sysfsgpio_block_transfer,
 	.reset = sysfsgpio_reset,
 	.swdio_read = sysfsgpio_swdio_read,
 	.swdio_drive = sysfsgpio_swdio_drive,
@@ -561,6 +730,39 @@ static void cleanup_all_fds(void)
 	cleanup_fd(srst_fd, srst_gpio);
 }
 
+static void sysfsgpio_gpiomem_init(void)
+{
+	const int value_pins[] = {
+		tck_gpio, tms_gpio, tdi_gpio, tdo_gpio,
+		swclk_gpio, swdio_gpio,
+	};
+
+	for (unsigned i = 0; i < ARRAY_SIZE(value_pins); i++) {
+		if (value_pins[i] > 31) {
+			LOG_DEBUG("gpio %d outside bank 0, staying on sysfs value files",
+				value_pins[i]);
+			return;
+		}
+	}
+
+	int fd = open("/dev/gpiomem", O_RDWR | O_SYNC);
+	if (fd < 0) {
+		LOG_DEBUG("cannot open /dev/gpiomem, staying on sysfs value files");
+		return;
+	}
+
+	void *map = mmap(NULL, sysconf(_SC_PAGE_SIZE),
+			PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		LOG_WARNING("mmap of /dev/gpiomem failed: %s", strerror(errno));
+		return;
+	}
+
+	gpiomem_base = map;
+	LOG_INFO("/dev/gpiomem fast path enabled");
+}
+
 static bool sysfsgpio_jtag_mode_possible(void)
 {
 	if (!is_gpio_valid(tck_gpio))
@@ -661,6 +863,9 @@ static int sysfsgpio_init(void)
 			goto out_error;
 	}
 
+	if (gpiomem_enable)
+		sysfsgpio_gpiomem_init();
+
 	if (sysfsgpio_swd_mode_possible()) {
 		if (swd_mode)
 			bitbang_swd_switch_seq(JTAG_TO_SWD);
@@ -677,6 +882,10 @@ out_error:
 
 static int sysfsgpio_quit(void)
 {
+	if (gpiomem_base) {
+		munmap((void *)gpiomem_base, sysconf(_SC_PAGE_SIZE));
+		gpiomem_base = NULL;
+	}
 	cleanup_all_fds();
 	return ERROR_OK;
 }
@@ -45,6 +45,10 @@
 #define PACKET_START "$"
 #define PACKET_END "#"
 
+/* worst case framing of a binary write: "$X" + 8 digit address + ","
+ * + 8 digit length + ":" payload "#" checksum */
+#define ICDI_WRITE_OVERHEAD 24
+
 struct icdi_usb_handle_s {
 	libusb_context *usb_ctx;
 	libusb_device_handle *usb_dev;
@@ -88,6 +92,29 @@ static int remote_escape_output(const char *buffer, int len, char *out_buf, int
 	return output_index;
 }
 
+/* return how many input bytes fit in out_maxlen once escaped */
+static uint32_t remote_escape_count(const char *buffer, uint32_t len, uint32_t out_maxlen)
+{
+	uint32_t input_index, output_len;
+
+	output_len = 0;
+
+	for (input_index = 0; input_index < len; input_index++) {
+
+		char b = buffer[input_index];
+		uint32_t escaped_len = 1;
+
+		if (b == '$' || b == '#' || b == '}' || b == '*')
+			escaped_len = 2;
+
+		if (output_len + escaped_len > out_maxlen)
+			break;
+		output_len += escaped_len;
+	}
+
+	return input_index;
+}
+
 static int remote_unescape_input(const char *buffer, int len, char *out_buf, int out_maxlen)
 {
 	int input_index, output_index;
@@ -118,11 +145,11 @@ static int remote_unescape_input(const char *buffer, int len, char *out_buf, int
 	return output_index;
 }
 
-static int icdi_send_packet(void *handle, int len)
+static int icdi_transmit_packet(void *handle, int len)
 {
 	unsigned char cksum = 0;
 	struct icdi_usb_handle_s *h = handle;
-	int result, retry = 0;
+	int result;
 	int transferred = 0;
 
 	assert(handle != NULL);
@@ -151,42 +178,44 @@ static int icdi_send_packet(void *handle, int len)
 	}
 #endif
 
-	while (1) {
+	result = libusb_bulk_transfer(h->usb_dev, ICDI_WRITE_ENDPOINT, (unsigned char *)h->write_buffer, len,
+			&transferred, ICDI_WRITE_TIMEOUT);
+	if (result != 0 || transferred != len) {
+		LOG_DEBUG("Error TX Data %d", result);
+		return ERROR_FAIL;
+	}
 
-		result = libusb_bulk_transfer(h->usb_dev, ICDI_WRITE_ENDPOINT, (unsigned char *)h->write_buffer, len,
-				&transferred, ICDI_WRITE_TIMEOUT);
-		if (result != 0 || transferred != len) {
-			LOG_DEBUG("Error TX Data %d", result);
-			return ERROR_FAIL;
-		}
+	return ERROR_OK;
+}
 
-		/* check that the client got the message ok, or shall we resend */
-		result = libusb_bulk_transfer(h->usb_dev, ICDI_READ_ENDPOINT, (unsigned char *)h->read_buffer, h->max_packet,
-					&transferred, ICDI_READ_TIMEOUT);
-		if (result != 0 || transferred < 1) {
-			LOG_DEBUG("Error RX Data %d", result);
-			return ERROR_FAIL;
-		}
+static int icdi_receive_packet(void *handle)
+{
+	struct icdi_usb_handle_s *h = handle;
+	int result, retry = 0;
+	int transferred = 0;
+
+	assert(handle != NULL);
+
+	/* check that the client got the message ok, or shall we resend */
+	result = libusb_bulk_transfer(h->usb_dev, ICDI_READ_ENDPOINT, (unsigned char *)h->read_buffer, h->max_packet,
+				&transferred, ICDI_READ_TIMEOUT);
+	if (result != 0 || transferred < 1) {
+		LOG_DEBUG("Error RX Data %d", result);
+		return ERROR_FAIL;
+	}
 
 #ifdef _DEBUG_USB_COMMS_
-		LOG_DEBUG("received reply: '%c' : count %d", h->read_buffer[0], transferred);
+	LOG_DEBUG("received reply: '%c' : count %d", h->read_buffer[0], transferred);
 #endif
 
-		if (h->read_buffer[0] == '-') {
-			LOG_DEBUG("Resending packet %d", ++retry);
-		} else {
-			if (h->read_buffer[0] != '+')
-				LOG_DEBUG("Unexpected Reply from ICDI: %c", h->read_buffer[0]);
-			break;
-		}
+	/* a nack means the packet has to be resent, the caller decides
+	 * whether it still can */
+	if (h->read_buffer[0] == '-')
+		return ERROR_WAIT;
 
-		if (retry == 3) {
-			LOG_DEBUG("maximum nack retries attempted");
-			return ERROR_FAIL;
-		}
-	}
+	if (h->read_buffer[0] != '+')
+		LOG_DEBUG("Unexpected Reply from ICDI: %c", h->read_buffer[0]);
 
-	retry = 0;
 	h->read_count = transferred;
 
 	while (1) {
@@ -231,6 +260,29 @@ static int icdi_send_packet(void *handle, int len)
 	return ERROR_FAIL;
 }
 
+static int icdi_send_packet(void *handle, int len)
+{
+	int result, retry = 0;
+
+	while (1) {
+
+		result = icdi_transmit_packet(handle, len);
+		if (result != ERROR_OK)
+			return result;
+
+		result = icdi_receive_packet(handle);
+		if (result != ERROR_WAIT)
+			return result;
+
+		if (retry++ == 3) {
+			LOG_DEBUG("maximum nack retries attempted");
+			return ERROR_FAIL;
+		}
+
+		LOG_DEBUG("Resending packet %d", retry);
+	}
+}
+
 static int icdi_send_cmd(void *handle, const char *cmd)
 {
 	struct icdi_usb_handle_s *h = handle;
@@ -471,12 +523,6 @@ static int icdi_usb_step(void *handle)
 	return result;
 }
 
-static int icdi_usb_read_regs(void *handle)
-{
-	/* currently unsupported */
-	return ERROR_OK;
-}
-
 static int icdi_usb_read_reg(void *handle, int num, uint32_t *val)
 {
 	int result;
@@ -558,24 +604,17 @@ static int icdi_usb_read_mem_int(void *handle, uint32_t addr, uint32_t len, uint
 	return ERROR_OK;
 }
 
-static int icdi_usb_write_mem_int(void *handle, uint32_t addr, uint32_t len, const uint8_t *buffer)
+static int icdi_usb_collect_write_reply(void *handle)
 {
 	int result;
-	struct icdi_usb_handle_s *h = handle;
 
-	size_t cmd_len = snprintf(h->write_buffer, h->max_packet, PACKET_START "X%" PRIx32 ",%" PRIx32 ":", addr, len);
-
-	int out_len;
-	cmd_len += remote_escape_output((const char *)buffer, len, h->write_buffer + cmd_len,
-			&out_len, h->max_packet - cmd_len);
-
-	if (out_len < (int)len) {
-		/* for now issue a error as we have no way of allocating a larger buffer */
-		LOG_ERROR("memory buffer too small: requires 0x%x actual 0x%" PRIx32, out_len, len);
+	result = icdi_receive_packet(handle);
+	if (result == ERROR_WAIT) {
+		/* the nacked packet has already been overwritten by its
+		 * successor, so it cannot be resent */
+		LOG_ERROR("ICDI rejected a pipelined packet");
 		return ERROR_FAIL;
 	}
-
-	result = icdi_send_packet(handle, cmd_len);
 	if (result != ERROR_OK)
 		return result;
 
@@ -622,24 +661,51 @@ static int icdi_usb_write_mem(void *handle, uint32_t addr, uint32_t size,
 {
 	int retval = ERROR_OK;
 	struct icdi_usb_handle_s *h = handle;
-	uint32_t bytes_remaining;
+	uint32_t chunk;
+	int pending = 0;
 
 	/* calculate byte count */
 	count *= size;
 
+	/* Each chunk is sized so that its escaped form fills the whole
+	 * negotiated packet, and its reply is only collected after the
+	 * next chunk has been sent, so the firmware commits one chunk
+	 * while the next payload is already in transit. */
 	while (count) {
 
-		bytes_remaining = h->max_rw_packet;
-		if (count < bytes_remaining)
-			bytes_remaining = count;
+		chunk = remote_escape_count((const char *)buffer, count,
+				h->max_packet - ICDI_WRITE_OVERHEAD);
+
+		size_t cmd_len = snprintf(h->write_buffer, h->max_packet,
+				PACKET_START "X%" PRIx32 ",%" PRIx32 ":", addr, chunk);
 
-		retval = icdi_usb_write_mem_int(handle, addr, bytes_remaining, buffer);
+		int out_len;
+		cmd_len += remote_escape_output((const char *)buffer, chunk,
+				h->write_buffer + cmd_len, &out_len, h->max_packet - cmd_len);
+
+		retval = icdi_transmit_packet(handle, cmd_len);
 		if (retval != ERROR_OK)
-			return retval;
+			break;
 
-		buffer += bytes_remaining;
-		addr += bytes_remaining;
-		count -= bytes_remaining;
+		buffer += chunk;
+		addr += chunk;
+		count -= chunk;
+		pending++;
+
+		if (pending < 2)
+			continue;
+
+		retval = icdi_usb_collect_write_reply(handle);
+		pending--;
+		if (retval != ERROR_OK)
+			break;
+	}
+
+	/* drain whatever is still outstanding, keeping the first error */
+	while (pending-- > 0) {
+		int result = icdi_usb_collect_write_reply(handle);
+		if (retval == ERROR_OK)
+			retval = result;
 	}
 
 	return retval;
@@ -749,10 +815,11 @@ static int icdi_usb_open(struct hl_interface_param_s *param, void **fd)
 
 	*fd = h;
 
-	/* set the max target read/write buffer in bytes
-	 * as we are using gdb binary packets to transfer memory we have to
+	/* set the max target read buffer in bytes
+	 * the firmware escapes the reply to a binary read, so we have to
 	 * reserve half the buffer for any possible escape chars plus
-	 * at least 64 bytes for the gdb packet header */
+	 * at least 64 bytes for the gdb packet header.  Writes escape on
+	 * the host side and size each chunk to the escaped output. */
 	h->max_rw_packet = (((h->max_packet - 64) / 4) * 4) / 2;
 
 	return ERROR_OK;
@@ -773,7 +840,9 @@ struct hl_layout_api_s icdi_usb_layout_api = {
 	.run = icdi_usb_run,
 	.halt = icdi_usb_halt,
 	.step = icdi_usb_step,
-	.read_regs = icdi_usb_read_regs,
+	/* the ICDI firmware offers no bulk register read, read_reg is
+	 * looped over instead */
+	.read_regs = NULL,
 	.read_reg = icdi_usb_read_reg,
 	.write_reg = icdi_usb_write_reg,
 	.read_mem = icdi_usb_read_mem,
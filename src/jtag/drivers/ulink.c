@@ -159,6 +159,13 @@ struct ulink {
 	int commands_in_queue;		/**< Number of commands in queue */
 	struct ulink_cmd *queue_start;	/**< Pointer to first command in queue */
 	struct ulink_cmd *queue_end;	/**< Pointer to last command in queue */
+
+	/** OUT transfer of the in-flight command block, NULL when idle */
+	struct libusb_transfer *out_transfer;
+	bool out_transfer_done;			/**< Completion flag for #out_transfer */
+	uint8_t out_buffer[64];			/**< Payload buffer of #out_transfer */
+	struct ulink_cmd *inflight_start;	/**< First command of in-flight block */
+	int inflight_count_in;			/**< IN payload size of in-flight block */
 };
 
 /**************************** Function Prototypes *****************************/
@@ -185,9 +192,12 @@ int ulink_allocate_payload(struct ulink_cmd *ulink_cmd, int size,
 /* OpenULINK command queue helper functions */
 int ulink_get_queue_size(struct ulink *device,
 		enum ulink_payload_direction direction);
+void ulink_free_cmd_list(struct ulink_cmd *head);
 void ulink_clear_queue(struct ulink *device);
 int ulink_append_queue(struct ulink *device, struct ulink_cmd *ulink_cmd);
 int ulink_execute_queued_commands(struct ulink *device, int timeout);
+int ulink_submit_queued_commands(struct ulink *device);
+int ulink_finish_submitted_commands(struct ulink *device, int timeout);
 
 #ifdef _DEBUG_JTAG_IO_
 const char *ulink_cmd_id_string(uint8_t id);
@@ -240,6 +250,7 @@ int ulink_queue_sleep(struct ulink *device, struct jtag_command *cmd);
 int ulink_queue_stableclocks(struct ulink *device, struct jtag_command *cmd);
 
 int ulink_post_process_scan(struct ulink_cmd *ulink_cmd);
+int ulink_post_process_cmd_list(struct ulink_cmd *head);
 int ulink_post_process_queue(struct ulink *device);
 
 /* JTAG driver functions (registered in struct jtag_interface) */
@@ -606,15 +617,13 @@ int ulink_get_queue_size(struct ulink *device,
 }
 
 /**
- * Clear the OpenULINK command queue.
+ * Free a list of OpenULINK commands, including their payloads.
  *
- * @param device pointer to struct ulink identifying ULINK driver instance.
- * @return on success: ERROR_OK
- * @return on failure: ERROR_FAIL
+ * @param head pointer to first command in the list.
  */
-void ulink_clear_queue(struct ulink *device)
+void ulink_free_cmd_list(struct ulink_cmd *head)
 {
-	struct ulink_cmd *current = device->queue_start;
+	struct ulink_cmd *current = head;
 	struct ulink_cmd *next = NULL;
 
 	while (current != NULL) {
@@ -639,6 +648,18 @@ void ulink_clear_queue(struct ulink *device)
 		/* Proceed with next element */
 		current = next;
 	}
+}
+
+/**
+ * Clear the OpenULINK command queue.
+ *
+ * @param device pointer to struct ulink identifying ULINK driver instance.
+ * @return on success: ERROR_OK
+ * @return on failure: ERROR_FAIL
+ */
+void ulink_clear_queue(struct ulink *device)
+{
+	ulink_free_cmd_list(device->queue_start);
 
 	device->commands_in_queue = 0;
 	device->queue_start = NULL;
@@ -667,17 +688,17 @@ int ulink_append_queue(struct ulink *device, struct ulink_cmd *ulink_cmd)
 
 	/* Check if the current command can be appended to the queue */
 	if ((newsize_out > 64) || (newsize_in > 64)) {
-		/* New command does not fit. Execute all commands in queue before starting
-		 * new queue with the current command as first entry. */
-		ret = ulink_execute_queued_commands(device, USB_TIMEOUT);
+		/* New command does not fit. Upload the full queue and let the
+		 * ULINK execute it while the next queue is being assembled; the
+		 * results are collected and post-processed before the next block
+		 * is submitted, or at the end-of-queue flush. */
+		ret = ulink_finish_submitted_commands(device, USB_TIMEOUT);
 		if (ret != ERROR_OK)
 			return ret;
 
-		ret = ulink_post_process_queue(device);
+		ret = ulink_submit_queued_commands(device);
 		if (ret != ERROR_OK)
 			return ret;
-
-		ulink_clear_queue(device);
 	}
 
 	if (device->queue_start == NULL) {
@@ -710,6 +731,11 @@ int ulink_execute_queued_commands(struct ulink *device, int timeout)
 	int ret, i, index_out, index_in, count_out, count_in, transferred;
 	uint8_t buffer[64];
 
+	/* Results must come back in command order */
+	ret = ulink_finish_submitted_commands(device, timeout);
+	if (ret != ERROR_OK)
+		return ret;
+
 #ifdef _DEBUG_JTAG_IO_
 	ulink_print_queue(device);
 #endif
@@ -761,6 +787,155 @@ int ulink_execute_queued_commands(struct ulink *device, int timeout)
 	return ERROR_OK;
 }
 
+/**
+ * Completion callback for asynchronously submitted OUT transfers.
+ *
+ * @param transfer the completed transfer; user_data points to the
+ *  out_transfer_done flag of the corresponding driver instance.
+ */
+static void ulink_out_transfer_cb(struct libusb_transfer *transfer)
+{
+	bool *done = transfer->user_data;
+
+	*done = true;
+}
+
+/**
+ * Sends all queued OpenULINK commands to the ULINK without waiting for
+ * their execution.
+ *
+ * The command queue is detached and kept as the in-flight block so the
+ * ULINK can crunch it while the host assembles the next block. Call
+ * ulink_finish_submitted_commands() to collect the results and
+ * post-process the block.
+ *
+ * @param device pointer to struct ulink identifying ULINK driver instance.
+ * @return on success: ERROR_OK
+ * @return on failure: ERROR_FAIL
+ */
+int ulink_submit_queued_commands(struct ulink *device)
+{
+	struct ulink_cmd *current;
+	int i, index_out, count_in;
+
+	if (device->queue_start == NULL)
+		return ERROR_OK;
+
+#ifdef _DEBUG_JTAG_IO_
+	ulink_print_queue(device);
+#endif
+
+	index_out = 0;
+	count_in = 0;
+
+	for (current = device->queue_start; current; current = current->next) {
+		/* Add command to packet */
+		device->out_buffer[index_out] = current->id;
+		index_out++;
+
+		for (i = 0; i < current->payload_out_size; i++)
+			device->out_buffer[index_out + i] = current->payload_out[i];
+		index_out += current->payload_out_size;
+		count_in += current->payload_in_size;
+	}
+
+	device->out_transfer = libusb_alloc_transfer(0);
+	if (device->out_transfer == NULL)
+		return ERROR_FAIL;
+
+	device->out_transfer_done = false;
+	libusb_fill_bulk_transfer(device->out_transfer, device->usb_device_handle,
+			(2 | LIBUSB_ENDPOINT_OUT), device->out_buffer, index_out,
+			ulink_out_transfer_cb, &device->out_transfer_done, USB_TIMEOUT);
+
+	if (libusb_submit_transfer(device->out_transfer) != 0) {
+		libusb_free_transfer(device->out_transfer);
+		device->out_transfer = NULL;
+		return ERROR_FAIL;
+	}
+
+	/* Detach the queue; it lives on as the in-flight block */
+	device->inflight_start = device->queue_start;
+	device->inflight_count_in = count_in;
+
+	device->commands_in_queue = 0;
+	device->queue_start = NULL;
+	device->queue_end = NULL;
+
+	return ERROR_OK;
+}
+
+/**
+ * Waits for the in-flight command block, reads back its IN payload data
+ * and post-processes it.
+ *
+ * Does nothing if no block has been submitted.
+ *
+ * @param device pointer to struct ulink identifying ULINK driver instance.
+ * @param timeout maximum time to wait for the IN payload data, in ms.
+ * @return on success: ERROR_OK
+ * @return on failure: ERROR_FAIL
+ */
+int ulink_finish_submitted_commands(struct ulink *device, int timeout)
+{
+	struct ulink_cmd *current;
+	int ret, i, index_in, transferred;
+	uint8_t buffer[64];
+
+	if (device->out_transfer == NULL)
+		return ERROR_OK;
+
+	ret = ERROR_OK;
+
+	while (!device->out_transfer_done) {
+		if (libusb_handle_events(device->libusb_ctx) != 0) {
+			libusb_cancel_transfer(device->out_transfer);
+			while (!device->out_transfer_done)
+				if (libusb_handle_events(device->libusb_ctx) != 0)
+					break;
+			ret = ERROR_FAIL;
+			break;
+		}
+	}
+
+	if ((ret == ERROR_OK)
+			&& (device->out_transfer->status != LIBUSB_TRANSFER_COMPLETED))
+		ret = ERROR_FAIL;
+
+	libusb_free_transfer(device->out_transfer);
+	device->out_transfer = NULL;
+
+	/* Collect response if the block contains IN payload data */
+	if ((ret == ERROR_OK) && (device->inflight_count_in > 0)) {
+		if (libusb_bulk_transfer(device->usb_device_handle,
+				(2 | LIBUSB_ENDPOINT_IN), (unsigned char *)buffer, 64,
+				&transferred, timeout) != 0)
+			ret = ERROR_FAIL;
+		else if (transferred != device->inflight_count_in)
+			ret = ERROR_FAIL;
+
+		if (ret == ERROR_OK) {
+			/* Write back IN payload data */
+			index_in = 0;
+			for (current = device->inflight_start; current; current = current->next) {
+				for (i = 0; i < current->payload_in_size; i++) {
+					current->payload_in[i] = buffer[index_in];
+					index_in++;
+				}
+			}
+		}
+	}
+
+	if (ret == ERROR_OK)
+		ret = ulink_post_process_cmd_list(device->inflight_start);
+
+	ulink_free_cmd_list(device->inflight_start);
+	device->inflight_start = NULL;
+	device->inflight_count_in = 0;
+
+	return ret;
+}
+
 #ifdef _DEBUG_JTAG_IO_
 
 /**
@@ -1887,19 +2062,19 @@ int ulink_post_process_scan(struct ulink_cmd *ulink_cmd)
 }
 
 /**
- * Perform post-processing of commands after OpenULINK queue has been executed.
+ * Perform post-processing of a list of commands after they have been executed.
  *
- * @param device pointer to struct ulink identifying ULINK driver instance.
+ * @param head pointer to first command in the list.
  * @return on success: ERROR_OK
  * @return on failure: ERROR_FAIL
  */
-int ulink_post_process_queue(struct ulink *device)
+int ulink_post_process_cmd_list(struct ulink_cmd *head)
 {
 	struct ulink_cmd *current;
 	struct jtag_command *openocd_cmd;
 	int ret;
 
-	current = device->queue_start;
+	current = head;
 
 	while (current != NULL) {
 		openocd_cmd = current->cmd_origin;
@@ -1937,6 +2112,18 @@ int ulink_post_process_queue(struct ulink *device)
 	return ERROR_OK;
 }
 
+/**
+ * Perform post-processing of commands after OpenULINK queue has been executed.
+ *
+ * @param device pointer to struct ulink identifying ULINK driver instance.
+ * @return on success: ERROR_OK
+ * @return on failure: ERROR_FAIL
+ */
+int ulink_post_process_queue(struct ulink *device)
+{
+	return ulink_post_process_cmd_list(device->queue_start);
+}
+
 /**************************** JTAG driver functions ***************************/
 
 /**
@@ -1992,6 +2179,7 @@ static int ulink_execute_queue(void)
 	}
 
 	if (ulink_handle->commands_in_queue > 0) {
+		/* This also collects a still in-flight command block first */
 		ret = ulink_execute_queued_commands(ulink_handle, USB_TIMEOUT);
 		if (ret != ERROR_OK)
 			return ret;
@@ -2001,6 +2189,10 @@ static int ulink_execute_queue(void)
 			return ret;
 
 		ulink_clear_queue(ulink_handle);
+	} else {
+		ret = ulink_finish_submitted_commands(ulink_handle, USB_TIMEOUT);
+		if (ret != ERROR_OK)
+			return ret;
 	}
 
 	return ERROR_OK;
@@ -2261,6 +2453,9 @@ static int ulink_quit(void)
 {
 	int ret;
 
+	/* Collect a possibly still in-flight command block */
+	ulink_finish_submitted_commands(ulink_handle, USB_TIMEOUT);
+
 	ret = ulink_usb_close(&ulink_handle);
 	free(ulink_handle);
 
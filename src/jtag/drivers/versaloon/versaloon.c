@@ -38,7 +38,9 @@ struct versaloon_pending_t versaloon_pending[VERSALOON_MAX_PENDING_NUMBER];
 uint16_t versaloon_pending_idx;
 
 libusb_device_handle *versaloon_usb_device_handle;
+libusb_context *versaloon_usb_ctx;
 static uint32_t versaloon_usb_to = VERSALOON_TIMEOUT;
+static uint8_t *versaloon_reply_buf;
 
 RESULT versaloon_init(void);
 RESULT versaloon_fini(void);
@@ -194,13 +196,28 @@ RESULT versaloon_add_pending(uint8_t type, uint8_t cmd, uint16_t actual_szie,
 	return ERROR_OK;
 }
 
+static void versaloon_transfer_callback(struct libusb_transfer *transfer)
+{
+	int *completed = transfer->user_data;
+
+	*completed = 1;
+}
+
+/* The reply is received into a separate buffer so that the IN transfer can
+ * be queued together with the OUT transfer: the dongle's answer is then
+ * collected in the earliest possible USB frame, instead of only after the
+ * OUT completion has made its way back to user space. The protocol itself
+ * stays strictly request/reply, the firmware has a single command buffer. */
 RESULT versaloon_send_command(uint16_t out_len, uint16_t *inlen)
 {
-	int ret;
-	int transferred;
+	struct libusb_transfer *out_transfer;
+	struct libusb_transfer *in_transfer = NULL;
+	int out_done = 0, in_done = 1;
+	int errors = 0;
+	RESULT result = ERROR_OK;
 
 #if PARAM_CHECK
-	if (NULL == versaloon_buf) {
+	if ((NULL == versaloon_buf) || (NULL == versaloon_reply_buf)) {
 		LOG_BUG(ERRMSG_INVALID_BUFFER, TO_STR(versaloon_buf));
 		return ERRCODE_INVALID_BUFFER;
 	}
@@ -210,28 +227,87 @@ RESULT versaloon_send_command(uint16_t out_len, uint16_t *inlen)
 	}
 #endif
 
-	ret = libusb_bulk_transfer(versaloon_usb_device_handle,
-			versaloon_interface.usb_setting.ep_out,
-			versaloon_buf, out_len, &transferred, versaloon_usb_to);
-	if (0 != ret || transferred != out_len) {
-		LOG_ERROR(ERRMSG_FAILURE_OPERATION, "send usb data");
-		return ERRCODE_FAILURE_OPERATION;
+	out_transfer = libusb_alloc_transfer(0);
+	if (NULL == out_transfer) {
+		LOG_ERROR(ERRMSG_NOT_ENOUGH_MEMORY);
+		return ERRCODE_NOT_ENOUGH_MEMORY;
 	}
+	libusb_fill_bulk_transfer(out_transfer, versaloon_usb_device_handle,
+		versaloon_interface.usb_setting.ep_out, versaloon_buf, out_len,
+		versaloon_transfer_callback, &out_done, versaloon_usb_to);
 
 	if (inlen != NULL) {
-		ret = libusb_bulk_transfer(versaloon_usb_device_handle,
-			versaloon_interface.usb_setting.ep_in,
-			versaloon_buf, versaloon_interface.usb_setting.buf_size,
-			&transferred, versaloon_usb_to);
-		if (0 == ret) {
-			*inlen = (uint16_t)transferred;
-			return ERROR_OK;
-		} else {
+		in_transfer = libusb_alloc_transfer(0);
+		if (NULL == in_transfer) {
+			libusb_free_transfer(out_transfer);
+			LOG_ERROR(ERRMSG_NOT_ENOUGH_MEMORY);
+			return ERRCODE_NOT_ENOUGH_MEMORY;
+		}
+		libusb_fill_bulk_transfer(in_transfer, versaloon_usb_device_handle,
+			versaloon_interface.usb_setting.ep_in, versaloon_reply_buf,
+			versaloon_interface.usb_setting.buf_size,
+			versaloon_transfer_callback, &in_done, versaloon_usb_to);
+		in_done = 0;
+
+		if (0 != libusb_submit_transfer(in_transfer)) {
 			LOG_ERROR(ERRMSG_FAILURE_OPERATION, "receive usb data");
-			return ERROR_FAIL;
+			libusb_free_transfer(in_transfer);
+			libusb_free_transfer(out_transfer);
+			return ERRCODE_FAILURE_OPERATION;
 		}
-	} else
-		return ERROR_OK;
+	}
+
+	if (0 != libusb_submit_transfer(out_transfer)) {
+		LOG_ERROR(ERRMSG_FAILURE_OPERATION, "send usb data");
+		libusb_free_transfer(out_transfer);
+		out_done = 1;
+		result = ERRCODE_FAILURE_OPERATION;
+		if (in_transfer != NULL)
+			libusb_cancel_transfer(in_transfer);
+	}
+
+	while (!out_done || !in_done) {
+		if (0 != libusb_handle_events(versaloon_usb_ctx)) {
+			if (0 == errors++) {
+				if (!out_done)
+					libusb_cancel_transfer(out_transfer);
+				if (!in_done)
+					libusb_cancel_transfer(in_transfer);
+			} else if (errors > 10) {
+				/* cannot even collect the cancellations: the
+				 * transfers must be leaked, their buffers may
+				 * still be in flight */
+				LOG_ERROR(ERRMSG_FAILURE_OPERATION, "handle usb events");
+				return ERROR_FAIL;
+			}
+		}
+	}
+
+	if (result != ERROR_OK) {
+		if (in_transfer != NULL)
+			libusb_free_transfer(in_transfer);
+		return result;
+	}
+
+	if ((LIBUSB_TRANSFER_COMPLETED != out_transfer->status)
+			|| (out_transfer->actual_length != out_len)) {
+		LOG_ERROR(ERRMSG_FAILURE_OPERATION, "send usb data");
+		result = ERRCODE_FAILURE_OPERATION;
+	} else if (in_transfer != NULL) {
+		if (LIBUSB_TRANSFER_COMPLETED != in_transfer->status) {
+			LOG_ERROR(ERRMSG_FAILURE_OPERATION, "receive usb data");
+			result = ERROR_FAIL;
+		} else {
+			*inlen = (uint16_t)in_transfer->actual_length;
+			memcpy(versaloon_buf, versaloon_reply_buf,
+				in_transfer->actual_length);
+		}
+	}
+
+	libusb_free_transfer(out_transfer);
+	if (in_transfer != NULL)
+		libusb_free_transfer(in_transfer);
+	return result;
 }
 
 #define VERSALOON_RETRY_CNT 10
@@ -247,6 +323,11 @@ RESULT versaloon_init(void)
 		LOG_ERROR(ERRMSG_NOT_ENOUGH_MEMORY);
 		return ERRCODE_NOT_ENOUGH_MEMORY;
 	}
+	versaloon_reply_buf = malloc(versaloon_interface.usb_setting.buf_size);
+	if (NULL == versaloon_reply_buf) {
+		LOG_ERROR(ERRMSG_NOT_ENOUGH_MEMORY);
+		return ERRCODE_NOT_ENOUGH_MEMORY;
+	}
 
 	/* connect to versaloon */
 	timeout_tmp = versaloon_usb_to;
@@ -270,9 +351,11 @@ RESULT versaloon_init(void)
 	versaloon_interface.usb_setting.buf_size = versaloon_buf_size;
 	LOG_INFO("%s", versaloon_buf + 2);
 
-	/* free temporary buffer */
+	/* free temporary buffers */
 	free(versaloon_buf);
 	versaloon_buf = NULL;
+	free(versaloon_reply_buf);
+	versaloon_reply_buf = NULL;
 
 	versaloon_buf = malloc(versaloon_interface.usb_setting.buf_size);
 	if (NULL == versaloon_buf) {
@@ -280,6 +363,12 @@ RESULT versaloon_init(void)
 		LOG_ERROR(ERRMSG_NOT_ENOUGH_MEMORY);
 		return ERRCODE_NOT_ENOUGH_MEMORY;
 	}
+	versaloon_reply_buf = malloc(versaloon_interface.usb_setting.buf_size);
+	if (NULL == versaloon_reply_buf) {
+		versaloon_fini();
+		LOG_ERROR(ERRMSG_NOT_ENOUGH_MEMORY);
+		return ERRCODE_NOT_ENOUGH_MEMORY;
+	}
 	versaloon_cmd_buf = malloc(versaloon_interface.usb_setting.buf_size - 3);
 	if (NULL == versaloon_cmd_buf) {
 		versaloon_fini();
@@ -300,11 +389,16 @@ RESULT versaloon_fini(void)
 		versaloon_free_want_pos();
 
 		versaloon_usb_device_handle = NULL;
+		versaloon_usb_ctx = NULL;
 
 		if (versaloon_buf != NULL) {
 			free(versaloon_buf);
 			versaloon_buf = NULL;
 		}
+		if (versaloon_reply_buf != NULL) {
+			free(versaloon_reply_buf);
+			versaloon_reply_buf = NULL;
+		}
 		if (versaloon_cmd_buf != NULL) {
 			free(versaloon_cmd_buf);
 			versaloon_cmd_buf = NULL;
@@ -110,6 +110,7 @@ struct versaloon_interface_t {
 
 extern struct versaloon_interface_t versaloon_interface;
 extern libusb_device_handle *versaloon_usb_device_handle;
+extern libusb_context *versaloon_usb_ctx;
 
 #endif /* __VERSALOON_H_INCLUDED__ */
 
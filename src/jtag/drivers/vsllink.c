@@ -320,6 +320,7 @@ static int vsllink_interface_init(void)
 		versaloon_interface.usb_setting.vid,
 		versaloon_interface.usb_setting.pid);
 	versaloon_usb_device_handle = vsllink_handle->usb_device_handle;
+	versaloon_usb_ctx = vsllink_handle->libusb_ctx;
 
 	if (ERROR_OK != versaloon_interface.init())
 		return ERROR_FAIL;
@@ -351,8 +352,13 @@ static int vsllink_init(void)
 		vsllink_swd_switch_seq(JTAG_TO_SWD);
 
 	} else {
-		/* malloc buffer size for tap */
-		tap_buffer_size = versaloon_interface.usb_setting.buf_size / 2 - 32;
+		/* malloc buffer size for tap.
+		 * One USB_TO_JTAG_RAW exchange carries the TDI and TMS streams
+		 * plus 13 bytes of framing, so this sizing fills the dongle's
+		 * whole command buffer in a single round trip. The previous
+		 * "buf_size / 2 - 32" gave away a quarter of each exchange on
+		 * dongles reporting the minimum 256 byte buffer. */
+		tap_buffer_size = (versaloon_interface.usb_setting.buf_size - 20) / 2;
 		vsllink_free_buffer();
 		tdi_buffer = malloc(tap_buffer_size);
 		tdo_buffer = malloc(tap_buffer_size);
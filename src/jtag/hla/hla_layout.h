@@ -50,8 +50,20 @@ struct hl_layout_api_s {
 	int (*halt) (void *handle);
 	/** */
 	int (*step) (void *handle);
-	/** */
-	int (*read_regs) (void *handle);
+	/**
+	 * Read the core registers r0..r15, xPSR, MSP and PSP in a single
+	 * adapter transaction
+	 *
+	 * @param handle A pointer to the device-specific handle
+	 * @param regs Storage for @p count values, indexed like the
+	 * read_reg register numbers
+	 * @param count Number of registers to read, at most 19
+	 * @returns ERROR_OK on success, or an error code on failure.
+	 *
+	 * Optional; may be NULL when the firmware only supports single
+	 * register reads, callers then fall back to looping on read_reg.
+	 */
+	int (*read_regs) (void *handle, uint32_t *regs, unsigned int count);
 	/** */
 	int (*read_reg) (void *handle, int num, uint32_t *val);
 	/** */
@@ -210,6 +210,33 @@ int tap_get_tms_path_len(tap_state_t from, tap_state_t to)
 	return (*tms_seqs)[tap_move_ndx(from)][tap_move_ndx(to)].bit_count;
 }
 
+int tap_build_tms_path(tap_state_t from, const tap_state_t *path,
+		int num_states, uint8_t *tms_bits)
+{
+	tap_state_t state = from;
+
+	memset(tms_bits, 0, DIV_ROUND_UP(num_states, 8));
+
+	for (int i = 0; i < num_states; i++) {
+		/* either TMS=0 or TMS=1 must lead to the next state ... */
+		if (tap_state_transition(state, false) == path[i]) {
+			/* bit already cleared */
+		} else if (tap_state_transition(state, true) == path[i]) {
+			tms_bits[i / 8] |= 1 << (i % 8);
+		} else {
+			/* ... or else the caller goofed BADLY */
+			LOG_ERROR("BUG: %s -> %s isn't a valid TAP state transition",
+					tap_state_name(state),
+					tap_state_name(path[i]));
+			return ERROR_FAIL;
+		}
+
+		state = path[i];
+	}
+
+	return num_states;
+}
+
 bool tap_is_state_stable(tap_state_t astate)
 {
 	bool is_stable;
@@ -130,6 +130,26 @@ int tap_get_tms_path(tap_state_t from, tap_state_t to);
  */
 int tap_get_tms_path_len(tap_state_t from, tap_state_t to);
 
+/**
+ * Pack the TMS bits for a multi-state path move into a bit buffer, so
+ * a driver can emit the whole path as one TMS command instead of one
+ * transition at a time.
+ *
+ * Each state in \a path must be reachable from its predecessor by a
+ * single TCK cycle; the path is validated exactly like the drivers'
+ * per-transition loops used to do.
+ *
+ * @param from The starting state.
+ * @param path Array of states to pass through.
+ * @param num_states Number of states in \a path.
+ * @param tms_bits Buffer receiving the packed TMS bits, first
+ * transition at bit 0; must hold at least DIV_ROUND_UP(num_states, 8)
+ * bytes.
+ * @return The number of TMS bits packed (== \a num_states), or a
+ * negative value if the path contains an illegal transition.
+ */
+int tap_build_tms_path(tap_state_t from, const tap_state_t *path,
+		int num_states, uint8_t *tms_bits);
 
 /**
  * Function tap_move_ndx
@@ -149,6 +149,9 @@ struct jtag_tap {
 
 	/** current instruction */
 	uint8_t *cur_instr;
+	/** cur_instr is known to match the instruction latched in the TAP;
+	 * cleared by TLR, where the hardware loads IDCODE or BYPASS. */
+	bool cur_instr_valid;
 	/** Bypass register selected */
 	int bypass;
 
@@ -256,6 +259,14 @@ int jtag_config_rclk(unsigned fallback_speed_khz);
 /** Retreives the clock speed of the JTAG interface in KHz. */
 unsigned jtag_get_speed_khz(void);
 
+/**
+ * Verify the scan chain against the configured taps with one DR and
+ * one IR round trip: IDCODEs, IR capture values and the end-of-chain
+ * marker must all match.  Only valid after the chain was examined.
+ * @returns ERROR_OK when the chain reads back correctly.
+ */
+int jtag_verify_chain(void);
+
 enum reset_types {
 	RESET_NONE            = 0x0,
 	RESET_HAS_TRST        = 0x1,
@@ -299,6 +310,17 @@ void jtag_set_verify_capture_ir(bool enable);
 /** @returns True if IR scan verification will be performed. */
 bool jtag_will_verify_capture_ir(void);
 
+/**
+ * Enable or disable elision of IR scans that would reload the
+ * instruction a TAP is already known to hold (with all other TAPs in
+ * BYPASS).  Off by default: rescanning an identical instruction is
+ * architecturally idempotent, but the Update-IR cycle it removes can
+ * matter on quirky hardware.
+ */
+void jtag_set_ir_scan_cache(bool enable);
+/** @returns True if redundant IR scans will be elided. */
+bool jtag_will_cache_ir_scans(void);
+
 /** Initialize debug adapter upon startup.  */
 int adapter_init(struct command_context *cmd_ctx);
 
@@ -368,6 +390,15 @@ void jtag_add_plain_ir_scan(int num_bits, const uint8_t *out_bits, uint8_t *in_b
  */
 void jtag_add_dr_scan(struct jtag_tap *tap, int num_fields,
 		const struct scan_field *fields, tap_state_t endstate);
+/**
+ * A version of jtag_add_dr_scan() that borrows the fields' out_value
+ * buffers instead of copying them into the command queue.  The caller
+ * must keep those buffers valid and unmodified until the queue has been
+ * flushed; in exchange, large scans (e.g. bitstream downloads) avoid a
+ * full extra copy of the data.
+ */
+void jtag_add_dr_scan_borrow(struct jtag_tap *tap, int num_fields,
+		const struct scan_field *fields, tap_state_t endstate);
 /** A version of jtag_add_dr_scan() that uses the check_value/mask fields */
 void jtag_add_dr_scan_check(struct jtag_tap *tap, int num_fields,
 		struct scan_field *fields, tap_state_t endstate);
@@ -571,9 +602,76 @@ int jtag_execute_queue(void);
 /** same as jtag_execute_queue() but does not clear the error flag */
 void jtag_execute_queue_noclear(void);
 
+/**
+ * Signature of a queue completion handler registered through
+ * jtag_execute_queue_async().  @a retval is the result of the flush
+ * that carried the submitted commands; any in_value buffers captured
+ * by those commands are valid when the handler runs (and only then).
+ */
+typedef void (*jtag_queue_complete_t)(int retval, void *priv);
+
+/**
+ * Submit the commands queued so far without waiting for the adapter
+ * round-trip.  The commands ride along with the next flush of the
+ * queue, and @a callback is invoked with that flush's result, so the
+ * caller can keep assembling further commands while earlier work is
+ * coalesced onto the wire.  This builds on the jtag_add_callback4()
+ * post-processing mechanism but, unlike it, also fires on a failed
+ * flush, reporting the error.
+ *
+ * jtag_execute_queue() acts as the join point: when it returns, all
+ * previously submitted completions have run.
+ */
+int jtag_execute_queue_async(jtag_queue_complete_t callback, void *priv);
+
 /** @returns the number of times the scan queue has been flushed */
 int jtag_get_flush_queue_count(void);
 
+/**
+ * @returns the moving average of queue flush round-trip latency, in
+ * microseconds, as measured around the adapter execute_queue calls.
+ */
+int64_t jtag_get_flush_avg_latency(void);
+
+/**
+ * @returns the number of queued commands an asynchronous submission is
+ * allowed to accumulate before the core forces a flush; adapts to the
+ * measured round-trip latency of the adapter.
+ */
+int jtag_get_flush_budget(void);
+
+/** Number of log2 buckets in the adapter latency histogram */
+#define JTAG_STATS_LATENCY_BUCKETS	24
+
+/**
+ * Cumulative transfer statistics for the active adapter, maintained by
+ * the driver dispatch layer around each execute_queue transaction.
+ */
+struct jtag_interface_stats {
+	int64_t transactions;	/**< adapter transactions (queue executions) */
+	int64_t payload_bytes;	/**< scan payload bytes moved (TDI and TDO) */
+	int64_t wire_bytes;	/**< bytes clocked on the wire, overhead included */
+	int64_t latency_us;	/**< cumulative transaction round-trip time */
+	/** bucket N counts transactions that took [2^N, 2^(N+1)) microseconds */
+	int64_t latency_histogram[JTAG_STATS_LATENCY_BUCKETS];
+};
+
+/**
+ * Fold one adapter transaction into the cumulative statistics.
+ *
+ * @param payload_bytes scan payload bytes moved by the transaction.
+ * @param wire_bytes bytes clocked on the wire, overhead included.
+ * @param latency_us round-trip time of the transaction in microseconds.
+ */
+void jtag_record_transaction_stats(int64_t payload_bytes, int64_t wire_bytes,
+		int64_t latency_us);
+
+/** @returns the cumulative adapter transfer statistics */
+const struct jtag_interface_stats *jtag_get_interface_stats(void);
+
+/** Reset the adapter transfer statistics, e.g. between benchmark runs */
+void jtag_clear_interface_stats(void);
+
 /** Report Tcl event to all TAPs */
 void jtag_notify_event(enum jtag_event);
 
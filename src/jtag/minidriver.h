@@ -43,6 +43,18 @@
  * The following core functions are declared in this file for use by
  * the minidriver and do @b not need to be defined by an implementation:
  * - default_interface_jtag_execute_queue()
+ *
+ * A minidriver build executes each interface_jtag_add_* call as it is
+ * made, instead of appending to the command queue for a later flush.
+ * That is only a win when the transport completes an operation in
+ * roughly the time of a function call -- a memory-mapped JTAG engine
+ * like the ZY1000's, or a simulator.  It is a severe loss for any
+ * packetized transport (USB adapters such as ftdi or cmsis_dap): there
+ * the queue exists to amortize a ~125 us-to-1 ms round trip over
+ * thousands of operations, which dwarfs the few nanoseconds the
+ * minidriver saves in dispatch.  So a new minidriver implementation is
+ * worthwhile only for synchronous, low-latency hardware; for USB
+ * adapters, effort is better spent keeping flushes infrequent.
  */
 
 /* this header will be provided by the minidriver implementation, */
@@ -59,6 +71,9 @@ int interface_jtag_add_plain_ir_scan(
 int interface_jtag_add_dr_scan(struct jtag_tap *active,
 		int num_fields, const struct scan_field *fields,
 		tap_state_t endstate);
+int interface_jtag_add_dr_scan_borrow(struct jtag_tap *active,
+		int num_fields, const struct scan_field *fields,
+		tap_state_t endstate);
 int interface_jtag_add_plain_dr_scan(
 		int num_bits, const uint8_t *out_bits, uint8_t *in_bits,
 		tap_state_t endstate);
@@ -221,6 +221,164 @@ static int Jim_Command_drscan(Jim_Interp *interp, int argc, Jim_Obj *const *args
 }
 
 
+static int Jim_Command_drscan_batch(Jim_Interp *interp, int argc, Jim_Obj *const *args)
+{
+	int retval;
+	struct jtag_tap *tap;
+	Jim_Obj *scan_list;
+	int num_scans;
+	struct scan_field **scan_fields;
+	int *scan_num_fields;
+	int i, j;
+
+	/* args[1] = device
+	 * args[2] = list of scans; each scan is itself a list of
+	 *           num_bits/hex string pairs, optionally followed by
+	 *           "-endstate" and a state name
+	 */
+	if (argc != 3) {
+		Jim_WrongNumArgs(interp, 1, args, "wrong arguments");
+		return JIM_ERR;
+	}
+
+	script_debug(interp, "drscan_batch", argc, args);
+
+	tap = jtag_tap_by_jim_obj(interp, args[1]);
+	if (tap == NULL)
+		return JIM_ERR;
+
+	scan_list = args[2];
+	num_scans = Jim_ListLength(interp, scan_list);
+	if (num_scans <= 0) {
+		Jim_SetResultString(interp, "drscan_batch: no scans supplied", -1);
+		return JIM_ERR;
+	}
+
+	scan_fields = calloc(num_scans, sizeof(*scan_fields));
+	scan_num_fields = calloc(num_scans, sizeof(*scan_num_fields));
+	if (scan_fields == NULL || scan_num_fields == NULL) {
+		free(scan_fields);
+		free(scan_num_fields);
+		Jim_SetResultString(interp, "drscan_batch: out of memory", -1);
+		return JIM_ERR;
+	}
+
+	/* queue every scan, then flush the whole batch in one round trip */
+	for (i = 0; i < num_scans; i++) {
+		Jim_Obj *scan;
+		int scan_argc;
+		tap_state_t endstate = TAP_IDLE;
+		struct scan_field *fields;
+		int num_fields;
+
+		Jim_ListIndex(interp, scan_list, i, &scan, JIM_NONE);
+		scan_argc = Jim_ListLength(interp, scan);
+
+		/* a trailing "-endstate statename" pair, as in drscan */
+		if (scan_argc >= 2) {
+			Jim_Obj *opt;
+			const char *cp;
+
+			Jim_ListIndex(interp, scan, scan_argc - 2, &opt, JIM_NONE);
+			if (strcmp(Jim_GetString(opt, NULL), "-endstate") == 0) {
+				Jim_ListIndex(interp, scan, scan_argc - 1, &opt, JIM_NONE);
+				cp = Jim_GetString(opt, NULL);
+				endstate = tap_state_by_name(cp);
+				if (endstate < 0) {
+					Jim_SetResultFormatted(interp, "endstate: %s invalid", cp);
+					goto error;
+				}
+				if (!scan_is_safe(endstate))
+					LOG_WARNING("drscan_batch with unsafe "
+						"endstate \"%s\"", cp);
+				scan_argc -= 2;
+			}
+		}
+
+		if ((scan_argc < 2) || ((scan_argc % 2) != 0)) {
+			Jim_SetResultString(interp, "drscan_batch: "
+				"malformed scan, expect num_bits/value pairs", -1);
+			goto error;
+		}
+
+		num_fields = scan_argc / 2;
+		fields = malloc(sizeof(struct scan_field) * num_fields);
+		if (fields == NULL) {
+			Jim_SetResultString(interp, "drscan_batch: out of memory", -1);
+			goto error;
+		}
+		scan_fields[i] = fields;
+
+		for (j = 0; j < num_fields; j++) {
+			Jim_Obj *obj;
+			long bits;
+			int len;
+			const char *str;
+
+			Jim_ListIndex(interp, scan, 2 * j, &obj, JIM_NONE);
+			if (Jim_GetLong(interp, obj, &bits) != JIM_OK || bits <= 0) {
+				Jim_SetResultString(interp, "drscan_batch: invalid num_bits", -1);
+				goto error;
+			}
+			Jim_ListIndex(interp, scan, 2 * j + 1, &obj, JIM_NONE);
+			str = Jim_GetString(obj, &len);
+
+			fields[j].num_bits = bits;
+			void *t = malloc(DIV_ROUND_UP(bits, 8));
+			fields[j].out_value = t;
+			str_to_buf(str, len, t, bits, 0);
+			fields[j].in_value = t;
+			scan_num_fields[i] = j + 1;
+		}
+
+		jtag_add_dr_scan(tap, num_fields, fields, endstate);
+	}
+
+	retval = jtag_execute_queue();
+	if (retval != ERROR_OK) {
+		Jim_SetResultString(interp, "drscan_batch: jtag execute failed", -1);
+		goto error;
+	}
+
+	Jim_Obj *list = Jim_NewListObj(interp, NULL, 0);
+	for (i = 0; i < num_scans; i++) {
+		Jim_Obj *scan_result = Jim_NewListObj(interp, NULL, 0);
+
+		for (j = 0; j < scan_num_fields[i]; j++) {
+			char *str = buf_to_str(scan_fields[i][j].in_value,
+					scan_fields[i][j].num_bits, 16);
+
+			Jim_ListAppendElement(interp, scan_result,
+				Jim_NewStringObj(interp, str, strlen(str)));
+			free(str);
+			free(scan_fields[i][j].in_value);
+		}
+		free(scan_fields[i]);
+		Jim_ListAppendElement(interp, list, scan_result);
+	}
+
+	Jim_SetResult(interp, list);
+
+	free(scan_fields);
+	free(scan_num_fields);
+
+	return JIM_OK;
+
+error:
+	/* scans already queued hold pointers into our field buffers, so
+	 * drain the queue before anything is freed */
+	jtag_execute_queue();
+	for (i = 0; i < num_scans; i++) {
+		for (j = 0; j < scan_num_fields[i]; j++)
+			free(scan_fields[i][j].in_value);
+		free(scan_fields[i]);
+	}
+	free(scan_fields);
+	free(scan_num_fields);
+
+	return JIM_ERR;
+}
+
 static int Jim_Command_pathmove(Jim_Interp *interp, int argc, Jim_Obj *const *args)
 {
 	tap_state_t states[8];
@@ -288,6 +446,15 @@ static const struct command_registration jtag_command_handlers_to_move[] = {
 			"Other TAPs must be in BYPASS mode.",
 		.usage = "tap_name [num_bits value]* ['-endstate' state_name]",
 	},
+	{
+		.name = "drscan_batch",
+		.mode = COMMAND_EXEC,
+		.jim_handler = Jim_Command_drscan_batch,
+		.help = "Execute a list of Data Register (DR) scans for one "
+			"TAP with a single queue flush; returns a list with "
+			"one result list per scan.",
+		.usage = "tap_name {{num_bits value [num_bits value]* ['-endstate' state_name]}*}",
+	},
 	{
 		.name = "flush_count",
 		.mode = COMMAND_EXEC,
@@ -831,6 +998,59 @@ COMMAND_HANDLER(handle_jtag_init_command)
 	return jtag_init(CMD_CTX);
 }
 
+COMMAND_HANDLER(handle_jtag_bench_command)
+{
+	unsigned num_scans = 1000;
+	unsigned num_bits = 256;
+
+	if (CMD_ARGC > 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	if (CMD_ARGC >= 1)
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], num_scans);
+	if (CMD_ARGC == 2)
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[1], num_bits);
+
+	if (num_scans == 0 || num_bits == 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	uint8_t *out_bits = malloc(DIV_ROUND_UP(num_bits, 8));
+	if (!out_bits)
+		return ERROR_FAIL;
+
+	/* a recognizable pattern beats all-zeroes on adapters that
+	 * compress idle bits */
+	for (unsigned i = 0; i < DIV_ROUND_UP(num_bits, 8); i++)
+		out_bits[i] = 0xa5;
+
+	struct duration build_bench, flush_bench;
+
+	/* queue the synthetic workload */
+	duration_start(&build_bench);
+	for (unsigned i = 0; i < num_scans; i++)
+		jtag_add_plain_dr_scan(num_bits, out_bits, NULL, TAP_IDLE);
+	duration_measure(&build_bench);
+
+	/* ... and push it onto the wire in one flush */
+	duration_start(&flush_bench);
+	int retval = jtag_execute_queue();
+	duration_measure(&flush_bench);
+
+	size_t num_bytes = (size_t)num_scans * DIV_ROUND_UP(num_bits, 8);
+
+	command_print(CMD_CTX, "%u scans x %u bits (%zu bytes payload)",
+		num_scans, num_bits, num_bytes);
+	command_print(CMD_CTX, "queue build: %f s", duration_elapsed(&build_bench));
+	command_print(CMD_CTX, "queue flush: %f s (%f KiB/s)",
+		duration_elapsed(&flush_bench),
+		duration_kbps(&flush_bench, num_bytes));
+	command_print(CMD_CTX, "average flush latency: %" PRId64 " us",
+		jtag_get_flush_avg_latency());
+
+	free(out_bits);
+
+	return retval;
+}
+
 static const struct command_registration jtag_subcommand_handlers[] = {
 	{
 		.name = "init",
@@ -913,6 +1133,17 @@ static const struct command_registration jtag_subcommand_handlers[] = {
 		.jim_handler = jim_jtag_names,
 		.help = "Returns list of all JTAG tap names.",
 	},
+	{
+		.name = "bench",
+		.mode = COMMAND_EXEC,
+		.handler = handle_jtag_bench_command,
+		.help = "Drive a synthetic DR scan workload through the "
+			"current adapter and report queue build time, flush "
+			"time and payload throughput.  Combine with "
+			"jtag_flush_queue_sleep to simulate latency on the "
+			"dummy driver.",
+		.usage = "[num_scans [num_bits]]",
+	},
 	{
 		.chain = jtag_command_handlers_to_move,
 	},
@@ -1036,6 +1267,70 @@ COMMAND_HANDLER(handle_jtag_rclk_command)
 	return retval;
 }
 
+COMMAND_HANDLER(handle_jtag_probe_khz_command)
+{
+	if (CMD_ARGC < 1 || CMD_ARGC > 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	unsigned max_khz, verify_scans = 8;
+	COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], max_khz);
+	if (CMD_ARGC == 2)
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[1], verify_scans);
+	if (max_khz == 0 || verify_scans == 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	unsigned good_khz = jtag_get_speed_khz();
+	if (good_khz == 0) {
+		command_print(CMD_CTX, "adaptive clocking active, nothing to probe");
+		return ERROR_OK;
+	}
+
+	/* the starting rate must itself be sound */
+	if (jtag_verify_chain() != ERROR_OK) {
+		LOG_ERROR("scan chain does not verify at %u kHz; "
+			"fix the base adapter_khz first", good_khz);
+		return ERROR_FAIL;
+	}
+
+	while (good_khz < max_khz) {
+		unsigned try_khz = good_khz + good_khz / 4;
+		if (try_khz == good_khz)
+			try_khz++;
+		if (try_khz > max_khz)
+			try_khz = max_khz;
+
+		int retval = jtag_config_khz(try_khz);
+		if (retval != ERROR_OK)
+			break;
+
+		bool ok = true;
+		for (unsigned i = 0; i < verify_scans; i++) {
+			if (jtag_verify_chain() != ERROR_OK) {
+				ok = false;
+				break;
+			}
+		}
+		if (!ok) {
+			LOG_DEBUG("scan chain verification failed at %u kHz", try_khz);
+			break;
+		}
+
+		good_khz = try_khz;
+	}
+
+	/* settle on the last rate that verified, and prove it once more */
+	int retval = jtag_config_khz(good_khz);
+	if (retval != ERROR_OK)
+		return retval;
+	if (jtag_verify_chain() != ERROR_OK) {
+		LOG_ERROR("scan chain no longer verifies at %u kHz", good_khz);
+		return ERROR_FAIL;
+	}
+
+	command_print(CMD_CTX, "adapter speed: %u kHz (verified)", good_khz);
+	return ERROR_OK;
+}
+
 COMMAND_HANDLER(handle_jtag_reset_command)
 {
 	if (CMD_ARGC != 2)
@@ -1197,6 +1492,23 @@ COMMAND_HANDLER(handle_verify_jtag_command)
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(handle_ir_scan_cache_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC == 1) {
+		bool enable;
+		COMMAND_PARSE_ENABLE(CMD_ARGV[0], enable);
+		jtag_set_ir_scan_cache(enable);
+	}
+
+	const char *status = jtag_will_cache_ir_scans() ? "enabled" : "disabled";
+	command_print(CMD_CTX, "ir scan cache is %s", status);
+
+	return ERROR_OK;
+}
+
 COMMAND_HANDLER(handle_tms_sequence_command)
 {
 	if (CMD_ARGC > 1)
@@ -1233,6 +1545,20 @@ COMMAND_HANDLER(handle_jtag_flush_queue_sleep)
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(handle_jtag_flush_stats)
+{
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	command_print(CMD_CTX, "flushes: %d", jtag_get_flush_queue_count());
+	command_print(CMD_CTX, "average flush latency: %" PRId64 " us",
+		jtag_get_flush_avg_latency());
+	command_print(CMD_CTX, "async flush budget: %d commands",
+		jtag_get_flush_budget());
+
+	return ERROR_OK;
+}
+
 COMMAND_HANDLER(handle_wait_srst_deassert)
 {
 	if (CMD_ARGC != 1)
@@ -1278,6 +1604,15 @@ static const struct command_registration jtag_command_handlers[] = {
 			"to test performance or change in behavior. Default 0ms.",
 		.usage = "[sleep in ms]",
 	},
+	{
+		.name = "jtag_flush_stats",
+		.handler = handle_jtag_flush_stats,
+		.mode = COMMAND_ANY,
+		.help = "Display queue flush count, measured average flush "
+			"round-trip latency and the learned asynchronous "
+			"flush budget.",
+		.usage = "",
+	},
 	{
 		.name = "jtag_rclk",
 		.handler = handle_jtag_rclk_command,
@@ -1287,6 +1622,16 @@ static const struct command_registration jtag_command_handlers[] = {
 			"With or without argument, display current setting.",
 		.usage = "[fallback_speed_khz]",
 	},
+	{
+		.name = "jtag_probe_khz",
+		.handler = handle_jtag_probe_khz_command,
+		.mode = COMMAND_EXEC,
+		.help = "Step the adapter clock up from the current rate "
+			"toward max_khz, keeping the highest rate at which "
+			"the scan chain still verifies.  Emulates adaptive "
+			"clocking on adapters without an RTCK pin.",
+		.usage = "max_khz [verify_scans]",
+	},
 	{
 		.name = "jtag_ntrst_delay",
 		.handler = handle_jtag_ntrst_delay_command,
@@ -1348,6 +1693,15 @@ static const struct command_registration jtag_command_handlers[] = {
 			"verify values captured during IR and DR scans.",
 		.usage = "['enable'|'disable']",
 	},
+	{
+		.name = "ir_scan_cache",
+		.handler = handle_ir_scan_cache_command,
+		.mode = COMMAND_ANY,
+		.help = "Display or assign flag controlling whether IR scans "
+			"that would reload the instruction a TAP already holds "
+			"are elided.",
+		.usage = "['enable'|'disable']",
+	},
 	{
 		.name = "tms_sequence",
 		.handler = handle_tms_sequence_command,
@@ -479,6 +479,15 @@ int interface_jtag_add_dr_scan(struct jtag_tap *active,
 	return ERROR_OK;
 }
 
+int interface_jtag_add_dr_scan_borrow(struct jtag_tap *active,
+	int num_fields,
+	const struct scan_field *fields,
+	tap_state_t state)
+{
+	/* scans execute synchronously, so borrowing needs no special support */
+	return interface_jtag_add_dr_scan(active, num_fields, fields, state);
+}
+
 int interface_jtag_add_plain_dr_scan(int num_bits,
 	const uint8_t *out_bits,
 	uint8_t *in_bits,
@@ -35,6 +35,9 @@
 #include <helper/ioutil.h>
 #include <helper/util.h>
 #include <helper/configuration.h>
+#include <helper/binarytrace.h>
+#include <helper/profiling.h>
+#include <helper/time_support.h>
 #include <flash/nor/core.h>
 #include <flash/nand/core.h>
 #include <pld/pld.h>
@@ -233,7 +236,9 @@ struct command_context *setup_command_handler(Jim_Interp *interp)
 	log_init();
 	LOG_DEBUG("log_init: complete");
 
+	int64_t phase_start = timeval_ms();
 	struct command_context *cmd_ctx = command_init(openocd_startup_tcl, interp);
+	LOG_DEBUG("command_init (startup tcl): %" PRId64 " ms", timeval_ms() - phase_start);
 
 	/* register subsystem commands */
 	typedef int (*command_registrant_t)(struct command_context *cmd_ctx_value);
@@ -242,6 +247,8 @@ struct command_context *setup_command_handler(Jim_Interp *interp)
 		&server_register_commands,
 		&gdb_register_commands,
 		&log_register_commands,
+		&profiling_register_commands,
+		&binarytrace_register_commands,
 		&transport_register_commands,
 		&interface_register_commands,
 		&target_register_commands,
@@ -251,6 +258,7 @@ struct command_context *setup_command_handler(Jim_Interp *interp)
 		&mflash_register_commands,
 		NULL
 	};
+	phase_start = timeval_ms();
 	for (unsigned i = 0; NULL != command_registrants[i]; i++) {
 		int retval = (*command_registrants[i])(cmd_ctx);
 		if (ERROR_OK != retval) {
@@ -258,7 +266,8 @@ struct command_context *setup_command_handler(Jim_Interp *interp)
 			return NULL;
 		}
 	}
-	LOG_DEBUG("command registration: complete");
+	LOG_DEBUG("command registration: complete (%" PRId64 " ms)",
+		timeval_ms() - phase_start);
 
 	LOG_OUTPUT(OPENOCD_VERSION "\n"
 		"Licensed under GNU GPL v2\n");
@@ -282,20 +291,27 @@ static int openocd_thread(int argc, char *argv[], struct command_context *cmd_ct
 	if (server_preinit() != ERROR_OK)
 		return ERROR_FAIL;
 
+	/* phase timing below helps pin down slow cold starts; visible at
+	 * debug level 3 */
+	int64_t phase_start = timeval_ms();
 	ret = parse_config_file(cmd_ctx);
 	if (ret == ERROR_COMMAND_CLOSE_CONNECTION)
 		return ERROR_OK;
 	else if (ret != ERROR_OK)
 		return ERROR_FAIL;
+	LOG_DEBUG("config file parsing: %" PRId64 " ms", timeval_ms() - phase_start);
 
 	ret = server_init(cmd_ctx);
 	if (ERROR_OK != ret)
 		return ERROR_FAIL;
 
 	if (init_at_startup) {
+		phase_start = timeval_ms();
 		ret = command_run_line(cmd_ctx, "init");
 		if (ERROR_OK != ret)
 			return ERROR_FAIL;
+		LOG_DEBUG("init (adapter and target bring-up): %" PRId64 " ms",
+			timeval_ms() - phase_start);
 	}
 
 	ret = server_loop(cmd_ctx);
@@ -25,6 +25,11 @@
 #include "virtex2.h"
 #include "xilinx_bit.h"
 #include "pld.h"
+#include <helper/time_support.h>
+
+/* window size for streaming bitstream loads; bounds both the file buffer
+ * and the copy jtag_add_dr_scan() makes into the command queue */
+#define VIRTEX2_LOAD_CHUNK_SIZE		(64 * 1024)
 
 static int virtex2_set_instr(struct jtag_tap *tap, uint32_t new_instr)
 {
@@ -131,16 +136,27 @@ static int virtex2_load(struct pld_device *pld_device, const char *filename)
 {
 	struct virtex2_pld_device *virtex2_info = pld_device->driver_priv;
 	struct xilinx_bit_file bit_file;
+	FILE *data_file;
+	uint8_t *chunk;
+	uint32_t done, remaining, next_report;
+	struct duration bench;
 	int retval;
-	unsigned int i;
 	struct scan_field field;
 
 	field.in_value = NULL;
 
-	retval = xilinx_read_bit_file(&bit_file, filename);
+	retval = xilinx_bit_file_open(&bit_file, filename, &data_file);
 	if (retval != ERROR_OK)
 		return retval;
 
+	chunk = malloc(VIRTEX2_LOAD_CHUNK_SIZE);
+	if (chunk == NULL) {
+		fclose(data_file);
+		return ERROR_FAIL;
+	}
+
+	duration_start(&bench);
+
 	virtex2_set_instr(virtex2_info->tap, 0xb);	/* JPROG_B */
 	jtag_execute_queue();
 	jtag_add_sleep(1000);
@@ -148,14 +164,55 @@ static int virtex2_load(struct pld_device *pld_device, const char *filename)
 	virtex2_set_instr(virtex2_info->tap, 0x5);	/* CFG_IN */
 	jtag_execute_queue();
 
-	for (i = 0; i < bit_file.length; i++)
-		bit_file.data[i] = flip_u32(bit_file.data[i], 8);
+	/* The configuration data is one continuous DR shift through CFG_IN.
+	 * Rather than queueing it as a single giant scan (which keeps a
+	 * second copy of the whole bitstream in the command queue), stream
+	 * it in bounded windows.  Each window ends in Pause-DR, and the move
+	 * from Pause-DR back into Shift-DR passes only through Exit2-DR, so
+	 * the device never sees Capture-DR or Update-DR between windows and
+	 * the shift is seamless.
+	 */
+	done = 0;
+	remaining = bit_file.length;
+	next_report = bit_file.length / 10;
+	while (remaining > 0) {
+		uint32_t chunk_size = (remaining < VIRTEX2_LOAD_CHUNK_SIZE)
+				? remaining : VIRTEX2_LOAD_CHUNK_SIZE;
+		uint32_t i;
+
+		if (fread(chunk, 1, chunk_size, data_file) != chunk_size) {
+			LOG_ERROR("couldn't read configuration data from file '%s'", filename);
+			retval = ERROR_PLD_FILE_LOAD_FAILED;
+			break;
+		}
+
+		for (i = 0; i < chunk_size; i++)
+			chunk[i] = flip_u32(chunk[i], 8);
+
+		field.num_bits = chunk_size * 8;
+		field.out_value = chunk;
+		jtag_add_dr_scan(virtex2_info->tap, 1, &field, TAP_DRPAUSE);
+
+		retval = jtag_execute_queue();
+		if (retval != ERROR_OK)
+			break;
+
+		done += chunk_size;
+		remaining -= chunk_size;
+
+		if (remaining > 0 && done >= next_report) {
+			LOG_INFO("loaded %" PRIu32 " of %" PRIu32 " bytes (%" PRIu32 "%%)",
+				done, bit_file.length,
+				(uint32_t)(((uint64_t)done * 100) / bit_file.length));
+			next_report += bit_file.length / 10;
+		}
+	}
 
-	field.num_bits = bit_file.length * 8;
-	field.out_value = bit_file.data;
+	free(chunk);
+	fclose(data_file);
 
-	jtag_add_dr_scan(virtex2_info->tap, 1, &field, TAP_DRPAUSE);
-	jtag_execute_queue();
+	if (retval != ERROR_OK)
+		return retval;
 
 	jtag_add_tlr();
 
@@ -170,6 +227,10 @@ static int virtex2_load(struct pld_device *pld_device, const char *filename)
 	virtex2_set_instr(virtex2_info->tap, 0x3f);		/* BYPASS */
 	jtag_execute_queue();
 
+	if (duration_measure(&bench) == ERROR_OK)
+		LOG_INFO("loaded %" PRIu32 " bytes in %fs (%0.3f KiB/s)", done,
+			duration_elapsed(&bench), duration_kbps(&bench, done));
+
 	return ERROR_OK;
 }
 
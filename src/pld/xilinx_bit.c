@@ -70,13 +70,16 @@ static int read_section(FILE *input_file, int length_size, char section,
 	return ERROR_OK;
 }
 
-int xilinx_read_bit_file(struct xilinx_bit_file *bit_file, const char *filename)
+int xilinx_bit_file_open(struct xilinx_bit_file *bit_file, const char *filename,
+		FILE **data_file)
 {
 	FILE *input_file;
 	struct stat input_stat;
+	uint8_t length_buffer[4];
+	char section_char;
 	int read_count;
 
-	if (!filename || !bit_file)
+	if (!filename || !bit_file || !data_file)
 		return ERROR_COMMAND_SYNTAX_ERROR;
 
 	if (stat(filename, &input_stat) == -1) {
@@ -103,27 +106,74 @@ int xilinx_read_bit_file(struct xilinx_bit_file *bit_file, const char *filename)
 	read_count = fread(bit_file->unknown_header, 1, 13, input_file);
 	if (read_count != 13) {
 		LOG_ERROR("couldn't read unknown_header from file '%s'", filename);
+		fclose(input_file);
 		return ERROR_PLD_FILE_LOAD_FAILED;
 	}
 
-	if (read_section(input_file, 2, 'a', NULL, &bit_file->source_file) != ERROR_OK)
+	if (read_section(input_file, 2, 'a', NULL, &bit_file->source_file) != ERROR_OK) {
+		fclose(input_file);
 		return ERROR_PLD_FILE_LOAD_FAILED;
+	}
+
+	if (read_section(input_file, 2, 'b', NULL, &bit_file->part_name) != ERROR_OK) {
+		fclose(input_file);
+		return ERROR_PLD_FILE_LOAD_FAILED;
+	}
 
-	if (read_section(input_file, 2, 'b', NULL, &bit_file->part_name) != ERROR_OK)
+	if (read_section(input_file, 2, 'c', NULL, &bit_file->date) != ERROR_OK) {
+		fclose(input_file);
 		return ERROR_PLD_FILE_LOAD_FAILED;
+	}
 
-	if (read_section(input_file, 2, 'c', NULL, &bit_file->date) != ERROR_OK)
+	if (read_section(input_file, 2, 'd', NULL, &bit_file->time) != ERROR_OK) {
+		fclose(input_file);
 		return ERROR_PLD_FILE_LOAD_FAILED;
+	}
 
-	if (read_section(input_file, 2, 'd', NULL, &bit_file->time) != ERROR_OK)
+	/* the 'e' section holds the configuration data; read only its length
+	 * and leave the stream positioned at the first data byte */
+	read_count = fread(&section_char, 1, 1, input_file);
+	if ((read_count != 1) || (section_char != 'e')) {
+		fclose(input_file);
 		return ERROR_PLD_FILE_LOAD_FAILED;
+	}
 
-	if (read_section(input_file, 4, 'e', &bit_file->length, &bit_file->data) != ERROR_OK)
+	read_count = fread(length_buffer, 1, 4, input_file);
+	if (read_count != 4) {
+		fclose(input_file);
 		return ERROR_PLD_FILE_LOAD_FAILED;
+	}
+
+	bit_file->length = be_to_h_u32(length_buffer);
+	bit_file->data = NULL;
 
 	LOG_DEBUG("bit_file: %s %s %s,%s %" PRIi32 "", bit_file->source_file, bit_file->part_name,
 		bit_file->date, bit_file->time, bit_file->length);
 
+	*data_file = input_file;
+
+	return ERROR_OK;
+}
+
+int xilinx_read_bit_file(struct xilinx_bit_file *bit_file, const char *filename)
+{
+	FILE *input_file;
+	int read_count;
+	int retval;
+
+	retval = xilinx_bit_file_open(bit_file, filename, &input_file);
+	if (retval != ERROR_OK)
+		return retval;
+
+	bit_file->data = malloc(bit_file->length);
+
+	read_count = fread(bit_file->data, 1, bit_file->length, input_file);
+	if (read_count != (int)bit_file->length) {
+		LOG_ERROR("couldn't read configuration data from file '%s'", filename);
+		fclose(input_file);
+		return ERROR_PLD_FILE_LOAD_FAILED;
+	}
+
 	fclose(input_file);
 
 	return ERROR_OK;
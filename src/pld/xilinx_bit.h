@@ -21,6 +21,8 @@
 #ifndef XILINX_BIT_H
 #define XILINX_BIT_H
 
+#include <stdio.h>
+
 struct xilinx_bit_file {
 	uint8_t unknown_header[13];
 	uint8_t *source_file;
@@ -33,4 +35,11 @@ struct xilinx_bit_file {
 
 int xilinx_read_bit_file(struct xilinx_bit_file *bit_file, const char *filename);
 
+/* Parse the header sections of a .bit file and the length of the
+ * configuration data, but don't read the data itself; bit_file->data is
+ * left NULL and *data_file is positioned at the first data byte.  The
+ * caller streams the data from *data_file and fclose()s it when done. */
+int xilinx_bit_file_open(struct xilinx_bit_file *bit_file, const char *filename,
+		FILE **data_file);
+
 #endif	/* XILINX_BIT_H */
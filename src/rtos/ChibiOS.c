@@ -278,6 +278,16 @@ static int ChibiOS_update_stacking(struct rtos *rtos)
 	return -1;
 }
 
+static int ChibiOS_cached_read_u32(struct rtos *rtos,
+		struct rtos_mem_cache *mem_cache, uint32_t address, uint32_t *value)
+{
+	uint8_t buf[4];
+	int retval = rtos_mem_cache_read(mem_cache, address, 4, buf);
+	if (retval == ERROR_OK)
+		*value = target_buffer_get_u32(rtos->target, buf);
+	return retval;
+}
+
 static int ChibiOS_update_threads(struct rtos *rtos)
 {
 	int retval;
@@ -317,13 +327,21 @@ static int ChibiOS_update_threads(struct rtos *rtos)
 	uint32_t previous;
 	uint32_t older;
 
+	/* Both passes below traverse the same registry; routing the reads
+	 * through a block cache means the integrity pass pulls each thread
+	 * structure once and the detail pass is served locally, so the
+	 * registry crosses the wire only once per update. */
+	struct rtos_mem_cache mem_cache;
+	rtos_mem_cache_init(&mem_cache, rtos->target);
+
 	current = rlist;
 	previous = rlist;
 	while (1) {
-		retval = target_read_u32(rtos->target,
-								 current + signature->cf_off_newer, &current);
+		retval = ChibiOS_cached_read_u32(rtos, &mem_cache,
+				current + signature->cf_off_newer, &current);
 		if (retval != ERROR_OK) {
 			LOG_ERROR("Could not read next ChibiOS thread");
+			rtos_mem_cache_free(&mem_cache);
 			return retval;
 		}
 		/* Could be NULL if the kernel is not initialized yet or if the
@@ -335,8 +353,8 @@ static int ChibiOS_update_threads(struct rtos *rtos)
 			break;
 		}
 		/* Fetch previous thread in the list as a integrity check. */
-		retval = target_read_u32(rtos->target,
-								 current + signature->cf_off_older, &older);
+		retval = ChibiOS_cached_read_u32(rtos, &mem_cache,
+				current + signature->cf_off_older, &older);
 		if ((retval != ERROR_OK) || (older == 0) || (older != previous)) {
 			LOG_ERROR("ChibiOS registry integrity check failed, "
 						"double linked list violation");
@@ -373,6 +391,7 @@ static int ChibiOS_update_threads(struct rtos *rtos)
 
 		rtos->current_thread = 1;
 		rtos->thread_count = 1;
+		rtos_mem_cache_free(&mem_cache);
 		return ERROR_OK;
 	}
 
@@ -381,6 +400,7 @@ static int ChibiOS_update_threads(struct rtos *rtos)
 			sizeof(struct thread_detail) * tasks_found);
 	if (!rtos->thread_details) {
 		LOG_ERROR("Could not allocate space for thread details");
+		rtos_mem_cache_free(&mem_cache);
 		return -1;
 	}
 
@@ -391,10 +411,11 @@ static int ChibiOS_update_threads(struct rtos *rtos)
 		uint32_t name_ptr = 0;
 		char tmp_str[CHIBIOS_THREAD_NAME_STR_SIZE];
 
-		retval = target_read_u32(rtos->target,
-								 current + signature->cf_off_newer, &current);
+		retval = ChibiOS_cached_read_u32(rtos, &mem_cache,
+				current + signature->cf_off_newer, &current);
 		if (retval != ERROR_OK) {
 			LOG_ERROR("Could not read next ChibiOS thread");
+			rtos_mem_cache_free(&mem_cache);
 			return -6;
 		}
 
@@ -406,19 +427,21 @@ static int ChibiOS_update_threads(struct rtos *rtos)
 		curr_thrd_details->threadid = current;
 
 		/* read the name pointer */
-		retval = target_read_u32(rtos->target,
-								 current + signature->cf_off_name, &name_ptr);
+		retval = ChibiOS_cached_read_u32(rtos, &mem_cache,
+				current + signature->cf_off_name, &name_ptr);
 		if (retval != ERROR_OK) {
 			LOG_ERROR("Could not read ChibiOS thread name pointer from target");
+			rtos_mem_cache_free(&mem_cache);
 			return retval;
 		}
 
 		/* Read the thread name */
-		retval = target_read_buffer(rtos->target, name_ptr,
+		retval = rtos_mem_cache_read(&mem_cache, name_ptr,
 									CHIBIOS_THREAD_NAME_STR_SIZE,
 									(uint8_t *)&tmp_str);
 		if (retval != ERROR_OK) {
 			LOG_ERROR("Error reading thread name from ChibiOS target");
+			rtos_mem_cache_free(&mem_cache);
 			return retval;
 		}
 		tmp_str[CHIBIOS_THREAD_NAME_STR_SIZE - 1] = '\x00';
@@ -434,10 +457,11 @@ static int ChibiOS_update_threads(struct rtos *rtos)
 		uint8_t threadState;
 		const char *state_desc;
 
-		retval = target_read_u8(rtos->target,
-								current + signature->cf_off_state, &threadState);
+		retval = rtos_mem_cache_read(&mem_cache,
+				current + signature->cf_off_state, 1, &threadState);
 		if (retval != ERROR_OK) {
 			LOG_ERROR("Error reading thread state from ChibiOS target");
+			rtos_mem_cache_free(&mem_cache);
 			return retval;
 		}
 
@@ -459,9 +483,10 @@ static int ChibiOS_update_threads(struct rtos *rtos)
 
 	uint32_t current_thrd;
 	/* NOTE: By design, cf_off_name equals readylist_current_offset */
-	retval = target_read_u32(rtos->target,
-							 rlist + signature->cf_off_name,
-							 &current_thrd);
+	retval = ChibiOS_cached_read_u32(rtos, &mem_cache,
+			rlist + signature->cf_off_name,
+			&current_thrd);
+	rtos_mem_cache_free(&mem_cache);
 	if (retval != ERROR_OK) {
 		LOG_ERROR("Could not read current Thread from ChibiOS target");
 		return retval;
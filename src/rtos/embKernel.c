@@ -135,11 +135,11 @@ static int embKernel_create(struct target *target)
 	return 0;
 }
 
-static int embKernel_get_tasks_details(struct rtos *rtos, int64_t iterable, const struct embKernel_params *param,
-		struct thread_detail *details, const char* state_str)
+static int embKernel_get_tasks_details(struct rtos *rtos, struct rtos_mem_cache *mem_cache, int64_t iterable,
+		const struct embKernel_params *param, struct thread_detail *details, const char* state_str)
 {
 	int64_t task = 0;
-	int retval = target_read_buffer(rtos->target, iterable + param->iterable_task_owner_offset, param->pointer_width,
+	int retval = rtos_mem_cache_read(mem_cache, iterable + param->iterable_task_owner_offset, param->pointer_width,
 			(uint8_t *) &task);
 	if (retval != ERROR_OK)
 		return retval;
@@ -148,14 +148,14 @@ static int embKernel_get_tasks_details(struct rtos *rtos, int64_t iterable, cons
 	details->display_str = NULL;
 
 	int64_t name_ptr = 0;
-	retval = target_read_buffer(rtos->target, task + param->thread_name_offset, param->pointer_width,
+	retval = rtos_mem_cache_read(mem_cache, task + param->thread_name_offset, param->pointer_width,
 			(uint8_t *) &name_ptr);
 	if (retval != ERROR_OK)
 		return retval;
 
 	details->thread_name_str = malloc(EMBKERNEL_MAX_THREAD_NAME_STR_SIZE);
 	if (name_ptr) {
-		retval = target_read_buffer(rtos->target, name_ptr, EMBKERNEL_MAX_THREAD_NAME_STR_SIZE,
+		retval = rtos_mem_cache_read(mem_cache, name_ptr, EMBKERNEL_MAX_THREAD_NAME_STR_SIZE,
 				(uint8_t *) details->thread_name_str);
 		if (retval != ERROR_OK)
 			return retval;
@@ -165,7 +165,7 @@ static int embKernel_get_tasks_details(struct rtos *rtos, int64_t iterable, cons
 	}
 
 	int64_t priority = 0;
-	retval = target_read_buffer(rtos->target, task + param->thread_priority_offset, param->thread_priority_width,
+	retval = rtos_mem_cache_read(mem_cache, task + param->thread_priority_offset, param->thread_priority_width,
 			(uint8_t *) &priority);
 	if (retval != ERROR_OK)
 		return retval;
@@ -239,64 +239,78 @@ static int embKernel_update_threads(struct rtos *rtos)
 		return ERROR_FAIL;
 	}
 
+	/* The iterables and task structures are small heap neighbours; a
+	 * block cache collapses the 4-5 reads per task into the occasional
+	 * block fetch.  Valid for this halted pass only. */
+	struct rtos_mem_cache mem_cache;
+	rtos_mem_cache_init(&mem_cache, rtos->target);
+
 	int threadIdx = 0;
 	/* Look for ready tasks */
 	for (int pri = 0; pri < max_used_priority; pri++) {
 		/* Get first item in queue */
 		int64_t iterable = 0;
-		retval = target_read_buffer(rtos->target,
+		retval = rtos_mem_cache_read(&mem_cache,
 				rtos->symbols[SYMBOL_ID_sListReady].address + (pri * param->rtos_list_size), param->pointer_width,
 				(uint8_t *) &iterable);
 		if (retval != ERROR_OK)
-			return retval;
+			goto done;
 		for (; iterable && threadIdx < thread_list_size; threadIdx++) {
 			/* Get info from this iterable item */
-			retval = embKernel_get_tasks_details(rtos, iterable, param, &rtos->thread_details[threadIdx], "Ready");
+			retval = embKernel_get_tasks_details(rtos, &mem_cache, iterable, param,
+					&rtos->thread_details[threadIdx], "Ready");
 			if (retval != ERROR_OK)
-				return retval;
+				goto done;
 			/* Get next iterable item */
-			retval = target_read_buffer(rtos->target, iterable + param->iterable_next_offset, param->pointer_width,
+			retval = rtos_mem_cache_read(&mem_cache, iterable + param->iterable_next_offset, param->pointer_width,
 					(uint8_t *) &iterable);
 			if (retval != ERROR_OK)
-				return retval;
+				goto done;
 		}
 	}
 	/* Look for sleeping tasks */
 	int64_t iterable = 0;
-	retval = target_read_buffer(rtos->target, rtos->symbols[SYMBOL_ID_sListSleep].address, param->pointer_width,
+	retval = rtos_mem_cache_read(&mem_cache, rtos->symbols[SYMBOL_ID_sListSleep].address, param->pointer_width,
 			(uint8_t *) &iterable);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 	for (; iterable && threadIdx < thread_list_size; threadIdx++) {
 		/*Get info from this iterable item */
-		retval = embKernel_get_tasks_details(rtos, iterable, param, &rtos->thread_details[threadIdx], "Sleeping");
+		retval = embKernel_get_tasks_details(rtos, &mem_cache, iterable, param,
+				&rtos->thread_details[threadIdx], "Sleeping");
 		if (retval != ERROR_OK)
-			return retval;
+			goto done;
 		/*Get next iterable item */
-		retval = target_read_buffer(rtos->target, iterable + param->iterable_next_offset, param->pointer_width,
+		retval = rtos_mem_cache_read(&mem_cache, iterable + param->iterable_next_offset, param->pointer_width,
 				(uint8_t *) &iterable);
 		if (retval != ERROR_OK)
-			return retval;
+			goto done;
 	}
 
 	/* Look for suspended tasks  */
 	iterable = 0;
-	retval = target_read_buffer(rtos->target, rtos->symbols[SYMBOL_ID_sListSuspended].address, param->pointer_width,
+	retval = rtos_mem_cache_read(&mem_cache, rtos->symbols[SYMBOL_ID_sListSuspended].address, param->pointer_width,
 			(uint8_t *) &iterable);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 	for (; iterable && threadIdx < thread_list_size; threadIdx++) {
 		/* Get info from this iterable item */
-		retval = embKernel_get_tasks_details(rtos, iterable, param, &rtos->thread_details[threadIdx], "Suspended");
+		retval = embKernel_get_tasks_details(rtos, &mem_cache, iterable, param,
+				&rtos->thread_details[threadIdx], "Suspended");
 		if (retval != ERROR_OK)
-			return retval;
+			goto done;
 		/*Get next iterable item */
-		retval = target_read_buffer(rtos->target, iterable + param->iterable_next_offset, param->pointer_width,
+		retval = rtos_mem_cache_read(&mem_cache, iterable + param->iterable_next_offset, param->pointer_width,
 				(uint8_t *) &iterable);
 		if (retval != ERROR_OK)
-			return retval;
+			goto done;
 	}
 
+done:
+	rtos_mem_cache_free(&mem_cache);
+	if (retval != ERROR_OK)
+		return retval;
+
 	rtos->thread_count = 0;
 	rtos->thread_count = threadIdx;
 	LOG_OUTPUT("Found %u tasks\n", (unsigned int)threadIdx);
@@ -372,78 +372,67 @@ int fill_task_pid(struct target *target, struct threads *t)
 }
 #endif
 
-int fill_task(struct target *target, struct threads *t)
-{
-	int retval;
-	uint32_t pid_addr = t->base_addr + PID;
-	uint32_t mem_addr = t->base_addr + MEM;
-	uint32_t on_cpu = t->base_addr + ONCPU;
-	uint8_t *buffer = calloc(1, 4);
-	retval = fill_buffer(target, t->base_addr, buffer);
-
-	if (retval == ERROR_OK) {
-		uint32_t val = get_buffer(target, buffer);
-		t->state = val;
-	} else
-		LOG_ERROR("fill_task: unable to read memory");
-
-	retval = fill_buffer(target, pid_addr, buffer);
+/* Every task_struct field we read (state, ONCPU, NEXT, MEM, PID, COMM)
+ * lives in this leading window; one ranged read per task replaces the
+ * six single-word round trips of the old walk. */
+#define TASK_WINDOW_SIZE (COMM + 16)
 
-	if (retval == ERROR_OK) {
-		uint32_t val = get_buffer(target, buffer);
-		t->pid = val;
-	} else
-		LOG_ERROR("fill task: unable to read memory");
+static int fill_task_window(struct target *target, uint32_t base_addr,
+	uint8_t *window)
+{
+	return linux_read_memory(target, base_addr, 4,
+			TASK_WINDOW_SIZE / 4, window);
+}
 
-	retval = fill_buffer(target, on_cpu, buffer);
+static int fill_task_from_window(struct target *target, struct threads *t,
+	const uint8_t *window)
+{
+	int retval = ERROR_OK;
+	t->state = get_buffer(target, window);
+	t->pid = get_buffer(target, window + PID);
+	t->oncpu = get_buffer(target, window + ONCPU);
+	uint32_t val = get_buffer(target, window + MEM);
+
+	if (val != 0) {
+		/* mm_struct is elsewhere on the heap; this is the one
+		 * field the window cannot cover */
+		uint32_t asid_addr = val + MM_CTX;
+		uint8_t buffer[4];
+		retval = fill_buffer(target, asid_addr, buffer);
 
-	if (retval == ERROR_OK) {
-		uint32_t val = get_buffer(target, buffer);
-		t->oncpu = val;
+		if (retval == ERROR_OK)
+			t->asid = get_buffer(target, buffer);
+		else
+			LOG_ERROR("fill task: unable to read memory -- ASID");
 	} else
-		LOG_ERROR("fill task: unable to read memory");
-
-	retval = fill_buffer(target, mem_addr, buffer);
-
-	if (retval == ERROR_OK) {
-		uint32_t val = get_buffer(target, buffer);
+		t->asid = 0;
 
-		if (val != 0) {
-			uint32_t asid_addr = val + MM_CTX;
-			retval = fill_buffer(target, asid_addr, buffer);
+	return retval;
+}
 
-			if (retval == ERROR_OK) {
-				val = get_buffer(target, buffer);
-				t->asid = val;
-			} else
-				LOG_ERROR
-					("fill task: unable to read memory -- ASID");
-		} else
-			t->asid = 0;
-	} else
-		LOG_ERROR("fill task: unable to read memory");
+int fill_task(struct target *target, struct threads *t)
+{
+	uint8_t window[TASK_WINDOW_SIZE];
+	int retval = fill_task_window(target, t->base_addr, window);
 
-	free(buffer);
+	if (retval != ERROR_OK) {
+		LOG_ERROR("fill_task: unable to read memory");
+		return retval;
+	}
 
-	return retval;
+	return fill_task_from_window(target, t, window);
 }
 
-int get_name(struct target *target, struct threads *t)
+static int get_name_from_buffer(struct target *target, struct threads *t,
+	const uint8_t *window)
 {
-	int retval;
 	uint32_t full_name[4];
-	uint32_t comm = t->base_addr + COMM;
 	int i;
 
 	for (i = 0; i < 17; i++)
 		t->name[i] = 0;
 
-	retval = linux_read_memory(target, comm, 4, 4, (uint8_t *) full_name);
-
-	if (retval != ERROR_OK) {
-		LOG_ERROR("get_name: unable to read memory\n");
-		return ERROR_FAIL;
-	}
+	memcpy(full_name, window, sizeof(full_name));
 
 	uint32_t raw_name = target_buffer_get_u32(target,
 			(const uint8_t *)
@@ -474,6 +463,22 @@ int get_name(struct target *target, struct threads *t)
 
 }
 
+int get_name(struct target *target, struct threads *t)
+{
+	int retval;
+	uint32_t full_name[4];
+	uint32_t comm = t->base_addr + COMM;
+
+	retval = linux_read_memory(target, comm, 4, 4, (uint8_t *) full_name);
+
+	if (retval != ERROR_OK) {
+		LOG_ERROR("get_name: unable to read memory\n");
+		return ERROR_FAIL;
+	}
+
+	return get_name_from_buffer(target, t, (const uint8_t *)full_name);
+}
+
 int get_current(struct target *target, int create)
 {
 	struct target_list *head;
@@ -788,8 +793,15 @@ int linux_get_tasks(struct target *target, int context)
 	while (((t->base_addr != linux_os->init_task_addr) &&
 		(t->base_addr != 0)) || (loop == 0)) {
 		loop++;
-		fill_task(target, t);
-		retval = get_name(target, t);
+		/* one ranged read per task_struct, parsed locally */
+		uint8_t window[TASK_WINDOW_SIZE];
+		retval = fill_task_window(target, t->base_addr, window);
+
+		if (retval == ERROR_OK) {
+			fill_task_from_window(target, t, window);
+			retval = get_name_from_buffer(target, t, window + COMM);
+		} else
+			LOG_ERROR("linux_get_tasks: unable to read memory");
 
 		if (loop > MAX_THREADS) {
 			free(t);
@@ -829,7 +841,8 @@ int linux_get_tasks(struct target *target, int context)
 			free(t);
 		}
 
-		uint32_t base_addr = next_task(target, t);
+		/* the next pointer is already in the window; no extra read */
+		uint32_t base_addr = get_buffer(target, window + NEXT) - NEXT;
 		t = calloc(1, sizeof(struct threads));
 		t->base_addr = base_addr;
 	}
@@ -1090,9 +1103,17 @@ static int linux_task_update(struct target *target, int context)
 		}
 
 		if (found == 0) {
-			uint32_t base_addr;
-			fill_task(target, t);
-			get_name(target, t);
+			uint32_t base_addr = 0;
+			uint8_t window[TASK_WINDOW_SIZE];
+
+			if (fill_task_window(target, t->base_addr, window) ==
+					ERROR_OK) {
+				fill_task_from_window(target, t, window);
+				get_name_from_buffer(target, t, window + COMM);
+				base_addr = get_buffer(target, window + NEXT) - NEXT;
+			} else
+				LOG_ERROR("linux_task_update: unable to read memory");
+
 			retval = insert_into_threadlist(target, t);
 			t->thread_info_addr = 0xdeadbeef;
 
@@ -1101,7 +1122,6 @@ static int linux_task_update(struct target *target, int context)
 					cpu_context_read(target, t->base_addr,
 						&t->thread_info_addr);
 
-			base_addr = next_task(target, t);
 			t = calloc(1, sizeof(struct threads));
 			t->base_addr = base_addr;
 			linux_os->thread_count++;
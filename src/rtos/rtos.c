@@ -49,6 +49,7 @@ static struct rtos_type *rtos_types[] = {
 };
 
 int rtos_thread_packet(struct connection *connection, const char *packet, int packet_size);
+static void rtos_flush_reg_list_cache(struct rtos *rtos);
 
 int rtos_smp_init(struct target *target)
 {
@@ -84,6 +85,7 @@ static void os_free(struct target *target)
 	if (target->rtos->symbols)
 		free(target->rtos->symbols);
 
+	rtos_free_threadlist(target->rtos);
 	free(target->rtos);
 	target->rtos = NULL;
 }
@@ -218,6 +220,38 @@ int rtos_qsymbol(struct connection *connection, char const *packet, int packet_s
 	int len = unhexify(cur_sym, strchr(packet + 8, ':') + 1, strlen(strchr(packet + 8, ':') + 1));
 	cur_sym[len] = 0;
 
+	/* A reconnect re-offers symbol lookup, but the table resolved by
+	 * the previous connection is still on the struct rtos.  Instead of
+	 * paying one round trip per symbol again, ask gdb only for the
+	 * first symbol: if its address is unchanged, the loaded program is
+	 * the same and the whole cached table stands.  A relinked image
+	 * moves the anchor symbol, which falls back to the full handshake.
+	 */
+	if (strcmp(packet, "qSymbol::") == 0 &&
+			os->symbols && os->symbols_cached &&
+			os->symbols[0].symbol_name) {
+		os->symbol_cache_checking = true;
+		reply_len = snprintf(reply, sizeof(reply), "qSymbol:");
+		reply_len += hexify(reply + reply_len, os->symbols[0].symbol_name,
+				0, sizeof(reply) - reply_len);
+		goto done;
+	}
+
+	if (os->symbol_cache_checking) {
+		os->symbol_cache_checking = false;
+		if (sscanf(packet, "qSymbol:%" SCNx64 ":", &addr) &&
+				os->symbols[0].address == (symbol_address_t)addr) {
+			/* Program identity unchanged; reuse the cached table and
+			 * skip the rest of the handshake.  The "OK" reply is
+			 * already prepared. */
+			rtos_detected = 1;
+			goto done;
+		}
+		/* Image changed (or the anchor symbol is gone): drop the cache
+		 * and fall through, re-walking the table from this reply. */
+		os->symbols_cached = false;
+	}
+
 	if ((strcmp(packet, "qSymbol::") != 0) &&               /* GDB is not offering symbol lookup for the first time */
 	    (!sscanf(packet, "qSymbol:%" SCNx64 ":", &addr)) && /* GDB did not find an address for a symbol */
 	    is_symbol_mandatory(os, cur_sym)) {					/* the symbol is mandatory for this RTOS */
@@ -244,12 +278,14 @@ int rtos_qsymbol(struct connection *connection, char const *packet, int packet_s
 
 		if (!target->rtos_auto_detect) {
 			rtos_detected = 1;
+			os->symbols_cached = true;
 			goto done;
 		}
 
 		if (os->type->detect_rtos(target)) {
 			LOG_INFO("Auto-detected RTOS: %s", os->type->name);
 			rtos_detected = 1;
+			os->symbols_cached = true;
 			goto done;
 		} else {
 			LOG_WARNING("No RTOS could be auto-detected!");
@@ -297,6 +333,18 @@ int rtos_thread_packet(struct connection *connection, char const *packet, int pa
 
 			struct thread_detail *detail = &target->rtos->thread_details[found];
 
+			/* gdb asks again for every refresh of its thread view;
+			 * serve the reply built last time when we have one */
+			if (target->rtos->extra_info_replies == NULL)
+				target->rtos->extra_info_replies =
+					calloc(target->rtos->thread_count, sizeof(char *));
+			if ((target->rtos->extra_info_replies != NULL) &&
+					(target->rtos->extra_info_replies[found] != NULL)) {
+				char *reply = target->rtos->extra_info_replies[found];
+				gdb_put_packet(connection, reply, strlen(reply));
+				return ERROR_OK;
+			}
+
 			int str_size = 0;
 			if (detail->display_str != NULL)
 				str_size += strlen(detail->display_str);
@@ -329,7 +377,10 @@ int rtos_thread_packet(struct connection *connection, char const *packet, int pa
 			int pkt_len = hexify(hex_str, tmp_str, 0, strlen(tmp_str) * 2 + 1);
 
 			gdb_put_packet(connection, hex_str, pkt_len);
-			free(hex_str);
+			if (target->rtos->extra_info_replies != NULL)
+				target->rtos->extra_info_replies[found] = hex_str;
+			else
+				free(hex_str);
 			free(tmp_str);
 			return ERROR_OK;
 
@@ -349,15 +400,19 @@ int rtos_thread_packet(struct connection *connection, char const *packet, int pa
 			if (target->rtos->thread_count == 0) {
 				gdb_put_packet(connection, "l", 1);
 			} else {
-				/*thread id are 16 char +1 for ',' */
-				char *out_str = malloc(17 * target->rtos->thread_count + 1);
-				char *tmp_str = out_str;
-				for (i = 0; i < target->rtos->thread_count; i++) {
-					tmp_str += sprintf(tmp_str, "%c%016" PRIx64, i == 0 ? 'm' : ',',
-										target->rtos->thread_details[i].threadid);
+				/* build the id list once per thread-list update */
+				if (target->rtos->thread_info_reply == NULL) {
+					/*thread id are 16 char +1 for ',' */
+					char *out_str = malloc(17 * target->rtos->thread_count + 1);
+					char *tmp_str = out_str;
+					for (i = 0; i < target->rtos->thread_count; i++) {
+						tmp_str += sprintf(tmp_str, "%c%016" PRIx64, i == 0 ? 'm' : ',',
+											target->rtos->thread_details[i].threadid);
+					}
+					target->rtos->thread_info_reply = out_str;
 				}
-				gdb_put_packet(connection, out_str, strlen(out_str));
-				free(out_str);
+				gdb_put_packet(connection, target->rtos->thread_info_reply,
+					strlen(target->rtos->thread_info_reply));
 			}
 		} else
 			gdb_put_packet(connection, "l", 1);
@@ -418,6 +473,22 @@ int rtos_thread_packet(struct connection *connection, char const *packet, int pa
 	return GDB_THREAD_PACKET_NOT_CONSUMED;
 }
 
+struct rtos_reg_list_cache_entry {
+	struct rtos_reg_list_cache_entry *next;
+	threadid_t threadid;
+	char *hex_reg_list;
+};
+
+static void rtos_flush_reg_list_cache(struct rtos *rtos)
+{
+	while (rtos->reg_list_cache != NULL) {
+		struct rtos_reg_list_cache_entry *entry = rtos->reg_list_cache;
+		rtos->reg_list_cache = entry->next;
+		free(entry->hex_reg_list);
+		free(entry);
+	}
+}
+
 int rtos_get_gdb_reg_list(struct connection *connection)
 {
 	struct target *target = get_target_from_connection(connection);
@@ -427,6 +498,17 @@ int rtos_get_gdb_reg_list(struct connection *connection)
 			((current_threadid != target->rtos->current_thread) ||
 			(target->smp))) {	/* in smp several current thread are possible */
 		char *hex_reg_list;
+		struct rtos_reg_list_cache_entry *entry;
+
+		/* The stacked registers can't change while the target stays
+		 * halted, and gdb front ends re-read every thread on each
+		 * refresh of their thread view; serve repeats from the cache. */
+		for (entry = target->rtos->reg_list_cache; entry != NULL; entry = entry->next)
+			if (entry->threadid == current_threadid) {
+				gdb_put_packet(connection, entry->hex_reg_list,
+					strlen(entry->hex_reg_list));
+				return ERROR_OK;
+			}
 
 		LOG_DEBUG("RTOS: getting register list for thread 0x%" PRIx64
 				  ", target->rtos->current_thread=0x%" PRIx64 "\r\n",
@@ -439,7 +521,16 @@ int rtos_get_gdb_reg_list(struct connection *connection)
 
 		if (hex_reg_list != NULL) {
 			gdb_put_packet(connection, hex_reg_list, strlen(hex_reg_list));
-			free(hex_reg_list);
+
+			/* keep the blob for the remainder of this halt */
+			entry = malloc(sizeof(struct rtos_reg_list_cache_entry));
+			if (entry != NULL) {
+				entry->threadid = current_threadid;
+				entry->hex_reg_list = hex_reg_list;
+				entry->next = target->rtos->reg_list_cache;
+				target->rtos->reg_list_cache = entry;
+			} else
+				free(hex_reg_list);
 			return ERROR_OK;
 		}
 	}
@@ -529,6 +620,7 @@ int rtos_try_next(struct target *target)
 		free(os->symbols);
 		os->symbols = NULL;
 	}
+	os->symbols_cached = false;
 
 	return 1;
 }
@@ -540,8 +632,94 @@ int rtos_update_threads(struct target *target)
 	return ERROR_OK;
 }
 
+/* Must be a power of two.  Large enough that a typical TCB plus its
+ * name string fits in one or two blocks, small enough that a sparse
+ * thread list does not drag in much dead memory. */
+#define RTOS_MEM_CACHE_BLOCK_SIZE 256
+
+struct rtos_mem_block {
+	struct rtos_mem_block *next;
+	uint64_t base;
+	uint8_t data[RTOS_MEM_CACHE_BLOCK_SIZE];
+};
+
+void rtos_mem_cache_init(struct rtos_mem_cache *cache, struct target *target)
+{
+	cache->target = target;
+	cache->blocks = NULL;
+}
+
+static struct rtos_mem_block *rtos_mem_cache_get_block(
+		struct rtos_mem_cache *cache, uint64_t base)
+{
+	struct rtos_mem_block *block;
+	int retval;
+
+	for (block = cache->blocks; block != NULL; block = block->next)
+		if (block->base == base)
+			return block;
+
+	block = malloc(sizeof(struct rtos_mem_block));
+	if (block == NULL)
+		return NULL;
+	retval = target_read_buffer(cache->target, base,
+			RTOS_MEM_CACHE_BLOCK_SIZE, block->data);
+	if (retval != ERROR_OK) {
+		free(block);
+		return NULL;
+	}
+	block->base = base;
+	block->next = cache->blocks;
+	cache->blocks = block;
+	return block;
+}
+
+int rtos_mem_cache_read(struct rtos_mem_cache *cache,
+		symbol_address_t address, uint32_t size, uint8_t *buffer)
+{
+	while (size > 0) {
+		uint64_t base = address & ~(uint64_t)(RTOS_MEM_CACHE_BLOCK_SIZE - 1);
+		uint32_t offset = address - base;
+		uint32_t chunk = RTOS_MEM_CACHE_BLOCK_SIZE - offset;
+		struct rtos_mem_block *block;
+
+		if (chunk > size)
+			chunk = size;
+
+		block = rtos_mem_cache_get_block(cache, base);
+		if (block != NULL)
+			memcpy(buffer, block->data + offset, chunk);
+		else {
+			/* The enclosing block may straddle a hole in the
+			 * memory map even though the requested bytes are
+			 * readable; retry just those uncached. */
+			int retval = target_read_buffer(cache->target,
+					address, chunk, buffer);
+			if (retval != ERROR_OK)
+				return retval;
+		}
+		address += chunk;
+		buffer += chunk;
+		size -= chunk;
+	}
+	return ERROR_OK;
+}
+
+void rtos_mem_cache_free(struct rtos_mem_cache *cache)
+{
+	while (cache->blocks != NULL) {
+		struct rtos_mem_block *block = cache->blocks;
+		cache->blocks = block->next;
+		free(block);
+	}
+}
+
 void rtos_free_threadlist(struct rtos *rtos)
 {
+	/* the thread list is rebuilt on every halt, so any stacked-register
+	 * blobs read during the previous halt are stale now */
+	rtos_flush_reg_list_cache(rtos);
+
 	if (rtos->thread_details) {
 		int j;
 
@@ -550,9 +728,15 @@ void rtos_free_threadlist(struct rtos *rtos)
 			free(current_thread->display_str);
 			free(current_thread->thread_name_str);
 			free(current_thread->extra_info_str);
+			if (rtos->extra_info_replies)
+				free(rtos->extra_info_replies[j]);
 		}
 		free(rtos->thread_details);
 		rtos->thread_details = NULL;
 		rtos->thread_count = 0;
+		free(rtos->extra_info_replies);
+		rtos->extra_info_replies = NULL;
+		free(rtos->thread_info_reply);
+		rtos->thread_info_reply = NULL;
 	}
 }
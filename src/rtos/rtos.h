@@ -50,12 +50,28 @@ struct rtos {
 	const struct rtos_type *type;
 
 	symbol_table_elem_t *symbols;
+	/* The resolved symbol table survives gdb reconnects.  When
+	 * symbols_cached is set, rtos_qsymbol() revalidates the table with
+	 * a single anchor-symbol lookup instead of re-running the qSymbol
+	 * handshake for every symbol; symbol_cache_checking marks that the
+	 * anchor reply is outstanding. */
+	bool symbols_cached;
+	bool symbol_cache_checking;
 	struct target *target;
 	/*  add a context variable instead of global variable */
 	int64_t current_threadid;
 	threadid_t current_thread;
 	struct thread_detail *thread_details;
 	int thread_count;
+	/* Stacked-register blobs already read for individual threads, keyed
+	 * by thread id.  Only valid while the target stays halted; flushed
+	 * whenever the thread list is rebuilt. */
+	struct rtos_reg_list_cache_entry *reg_list_cache;
+	/* Serialized replies built from thread_details, so repeated
+	 * qfThreadInfo/qThreadExtraInfo requests don't re-run the sprintf
+	 * and hexify passes; freed with the thread list they describe. */
+	char *thread_info_reply;
+	char **extra_info_replies;
 	int (*gdb_thread_packet)(struct connection *connection, char const *packet, int packet_size);
 	void *rtos_specific_params;
 };
@@ -97,6 +113,31 @@ struct rtos_register_stacking {
 
 #define GDB_THREAD_PACKET_NOT_CONSUMED (-40)
 
+/**
+ * Read-combining cache for thread-list walks.
+ *
+ * Walking an RTOS thread list chases pointers through the kernel heap,
+ * costing one target round trip per node, name string and TCB field.
+ * Since those structures cluster in a few heap regions, fetching whole
+ * aligned blocks and serving subsequent reads from them collapses the
+ * walk into a handful of block transfers.
+ *
+ * The cache is only coherent while the target stays halted; create one
+ * on the stack at the top of an update_threads() pass and free it
+ * before returning.
+ */
+struct rtos_mem_block;
+
+struct rtos_mem_cache {
+	struct target *target;
+	struct rtos_mem_block *blocks;
+};
+
+void rtos_mem_cache_init(struct rtos_mem_cache *cache, struct target *target);
+int rtos_mem_cache_read(struct rtos_mem_cache *cache,
+		symbol_address_t address, uint32_t size, uint8_t *buffer);
+void rtos_mem_cache_free(struct rtos_mem_cache *cache);
+
 int rtos_create(Jim_GetOptInfo *goi, struct target *target);
 int rtos_generic_stack_read(struct target *target,
 		const struct rtos_register_stacking *stacking,
@@ -48,6 +48,7 @@
 #include "gdb_server.h"
 #include <target/image.h>
 #include <jtag/jtag.h>
+#include <helper/profiling.h>
 #include "rtos/rtos.h"
 #include "target/smp.h"
 
@@ -60,9 +61,14 @@
  * found in most modern embedded processors.
  */
 
-struct target_desc_format {
-	char *tdesc;
-	uint32_t tdesc_length;
+/* one staged vFlashWrite payload; packets are accumulated on a chunk
+ * list and only stitched into contiguous runs at vFlashDone, so large
+ * downloads don't repeatedly realloc-and-copy the staged image */
+struct gdb_vflash_chunk {
+	struct gdb_vflash_chunk *next;
+	uint32_t addr;
+	uint32_t length;
+	uint8_t *data;
 };
 
 /* private connection data for GDB */
@@ -72,7 +78,9 @@ struct gdb_connection {
 	int buf_cnt;
 	int ctrl_c;
 	enum target_state frontend_state;
-	struct image *vflash_image;
+	/* staged vFlashWrite packets, oldest first */
+	struct gdb_vflash_chunk *vflash_chunks;
+	struct gdb_vflash_chunk *vflash_chunks_tail;
 	int closed;
 	int busy;
 	int noack_mode;
@@ -90,8 +98,16 @@ struct gdb_connection {
 	 * normally we reply with a S reply via gdb_last_signal_packet.
 	 * as a side note this behaviour only effects gdb > 6.8 */
 	bool attached;
-	/* temporarily used for target description support */
-	struct target_desc_format target_desc;
+	/* streaming vFlashWrite state: contiguous data not yet programmed */
+	uint8_t *vflash_buffer;
+	uint32_t vflash_addr;
+	uint32_t vflash_len;
+	uint32_t vflash_alloc;
+	/* scratch buffer for memory read replies, grown on demand and kept
+	 * for the lifetime of the connection so memory-heavy sessions don't
+	 * malloc/free per request */
+	char *mem_reply;
+	uint32_t mem_reply_size;
 };
 
 #if 0
@@ -127,6 +143,18 @@ static int gdb_flash_program = 1;
  */
 static int gdb_report_data_abort;
 
+/* if set, outgoing packets are run-length encoded as allowed by the remote
+ * protocol; this mostly helps 'g' replies full of zero registers over slow
+ * links. Disabled by default.
+ */
+static int gdb_use_rle;
+
+/* if set, vFlashWrite data is programmed as soon as complete erase blocks
+ * arrive instead of being buffered until vFlashDone, overlapping flash
+ * programming with packet reception. Disabled by default.
+ */
+static int gdb_flash_stream;
+
 /* set if we are sending target descriptions to gdb
  * via qXfer:features:read packet */
 /* enabled by default */
@@ -339,17 +367,78 @@ static int gdb_write(struct connection *connection, void *data, int len)
 	if (gdb_con->closed)
 		return ERROR_SERVER_REMOTE_CLOSED;
 
-	if (connection_write(connection, data, len) == len)
+	if (connection_write_buffered(connection, data, len) == len)
 		return ERROR_OK;
 	gdb_con->closed = 1;
 	return ERROR_SERVER_REMOTE_CLOSED;
 }
 
+static int gdb_writev(struct connection *connection,
+		const struct connection_iovec *iov, int iovcnt, int total)
+{
+	struct gdb_connection *gdb_con = connection->priv;
+	if (gdb_con->closed)
+		return ERROR_SERVER_REMOTE_CLOSED;
+
+	if (connection_writev(connection, iov, iovcnt) == total)
+		return ERROR_OK;
+	gdb_con->closed = 1;
+	return ERROR_SERVER_REMOTE_CLOSED;
+}
+
+/* Run-length encode @c buffer into @c out (at least @c len bytes), as
+ * described in the remote protocol: a run of identical characters becomes
+ * the character, '*', and a count byte of (repeats - 1) + 29.  Counts that
+ * would encode to the framing characters '#' or '$' are shortened.  Escape
+ * pairs ('}' plus one character) are copied verbatim and never merged into
+ * a run, since gdb expands runs of *decoded* characters.
+ *
+ * Returns the encoded length, never larger than @c len.
+ */
+static int gdb_rle_encode(const char *buffer, int len, char *out)
+{
+	int i = 0;
+	int out_len = 0;
+
+	while (i < len) {
+		char c = buffer[i];
+		int run = 1;
+
+		if (c == '}' && i + 1 < len) {
+			out[out_len++] = buffer[i];
+			out[out_len++] = buffer[i + 1];
+			i += 2;
+			continue;
+		}
+
+		while (i + run < len && buffer[i + run] == c && run < 98)
+			run++;
+
+		/* counts 6 and 7 encode to '#' and '$' */
+		if (run == 7 || run == 8)
+			run = 6;
+
+		if (run >= 4) {
+			out[out_len++] = c;
+			out[out_len++] = '*';
+			out[out_len++] = (char)(run - 1 + 29);
+		} else {
+			int j;
+			for (j = 0; j < run; j++)
+				out[out_len++] = c;
+		}
+		i += run;
+	}
+
+	return out_len;
+}
+
 static int gdb_put_packet_inner(struct connection *connection,
 		char *buffer, int len)
 {
 	int i;
-	unsigned char my_checksum = 0;
+	unsigned char my_checksum;
+	unsigned int sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
 #ifdef _DEBUG_GDB_IO_
 	char *debug_buffer;
 #endif
@@ -357,8 +446,17 @@ static int gdb_put_packet_inner(struct connection *connection,
 	int retval;
 	struct gdb_connection *gdb_con = connection->priv;
 
-	for (i = 0; i < len; i++)
-		my_checksum += buffer[i];
+	/* modulo-256 byte sum; four accumulators so long 'm' replies don't
+	 * serialize every addition on the previous one */
+	for (i = 0; i + 4 <= len; i += 4) {
+		sum0 += (unsigned char)buffer[i];
+		sum1 += (unsigned char)buffer[i + 1];
+		sum2 += (unsigned char)buffer[i + 2];
+		sum3 += (unsigned char)buffer[i + 3];
+	}
+	for (; i < len; i++)
+		sum0 += (unsigned char)buffer[i];
+	my_checksum = (unsigned char)(sum0 + sum1 + sum2 + sum3);
 
 #ifdef _DEBUG_GDB_IO_
 	/*
@@ -404,16 +502,17 @@ static int gdb_put_packet_inner(struct connection *connection,
 			if (retval != ERROR_OK)
 				return retval;
 		} else {
-			/* larger packets are transmitted directly from caller supplied buffer
-			 * by several calls to gdb_write() to avoid dynamic allocation */
+			/* larger packets are transmitted directly from the caller
+			 * supplied buffer, gathered with the header and trailer into
+			 * a single operation to avoid both dynamic allocation and
+			 * sending three separate TCP segments */
 			snprintf(local_buffer + 1, sizeof(local_buffer) - 1, "#%02x", my_checksum);
-			retval = gdb_write(connection, local_buffer, 1);
-			if (retval != ERROR_OK)
-				return retval;
-			retval = gdb_write(connection, buffer, len);
-			if (retval != ERROR_OK)
-				return retval;
-			retval = gdb_write(connection, local_buffer + 1, 3);
+			struct connection_iovec iov[3] = {
+				{ local_buffer, 1 },
+				{ buffer, len },
+				{ local_buffer + 1, 3 },
+			};
+			retval = gdb_writev(connection, iov, 3, len + 4);
 			if (retval != ERROR_OK)
 				return retval;
 		}
@@ -471,10 +570,30 @@ static int gdb_put_packet_inner(struct connection *connection,
 int gdb_put_packet(struct connection *connection, char *buffer, int len)
 {
 	struct gdb_connection *gdb_con = connection->priv;
+	char *rle_buffer = NULL;
+
+	if (gdb_use_rle && len > 3) {
+		rle_buffer = malloc(len);
+		if (rle_buffer != NULL) {
+			int rle_len = gdb_rle_encode(buffer, len, rle_buffer);
+			if (rle_len < len) {
+				buffer = rle_buffer;
+				len = rle_len;
+			}
+		}
+	}
+
 	gdb_con->busy = 1;
 	int retval = gdb_put_packet_inner(connection, buffer, len);
 	gdb_con->busy = 0;
 
+	/* a complete packet is a flush point: in noack mode nothing else
+	 * would push it out, and stop replies may be sent from polling,
+	 * outside input handling */
+	connection_flush(connection);
+
+	free(rle_buffer);
+
 	/* we sent some data, reset timer for keep alive messages */
 	kept_alive();
 
@@ -505,13 +624,38 @@ static inline int fetch_packet(struct connection *connection,
 		 * gdb_get_char() update various bits and bobs correctly.
 		 */
 		if ((buf_cnt > 2) && ((buf_cnt + count) < *len)) {
-			/* The compiler will struggle a bit with constant propagation and
-			 * aliasing, so we help it by showing that these values do not
-			 * change inside the loop
+			/* Delimit the packet in place: the slice up to '#' (or the
+			 * whole run) needs no per-byte state machine unless it
+			 * contains an escape character, and can then be appended
+			 * with a single copy.  In noack mode the checksum is never
+			 * checked, so the summing loop is skipped as well. */
+			int run = buf_cnt - 2;
+			char *end = memchr(buf_p, '#', run);
+			int slice = end ? (int)(end - buf_p) : run;
+
+			if (memchr(buf_p, '}', slice) == NULL) {
+				memcpy(buffer + count, buf_p, slice);
+				if (!noack) {
+					for (int i = 0; i < slice; i++)
+						my_checksum += buf_p[i] & 0xff;
+				}
+				count += slice;
+				if (end)
+					slice++;	/* consume the '#' as well */
+				buf_p += slice;
+				buf_cnt -= slice;
+				if (end)
+					break;
+				continue;
+			}
+
+			/* escape characters present: fall back to the byte loop.
+			 * The compiler will struggle a bit with constant propagation
+			 * and aliasing, so we help it by showing that these values
+			 * do not change inside the loop.
 			 */
 			int i;
 			char *buf = buf_p;
-			int run = buf_cnt - 2;
 			i = 0;
 			int done = 0;
 			while (i < run) {
@@ -927,18 +1071,25 @@ static int gdb_new_connection(struct connection *connection)
 	gdb_connection->buf_cnt = 0;
 	gdb_connection->ctrl_c = 0;
 	gdb_connection->frontend_state = TARGET_HALTED;
-	gdb_connection->vflash_image = NULL;
+	gdb_connection->vflash_chunks = NULL;
+	gdb_connection->vflash_chunks_tail = NULL;
 	gdb_connection->closed = 0;
 	gdb_connection->busy = 0;
 	gdb_connection->noack_mode = 0;
 	gdb_connection->sync = false;
 	gdb_connection->mem_write_error = false;
 	gdb_connection->attached = true;
-	gdb_connection->target_desc.tdesc = NULL;
-	gdb_connection->target_desc.tdesc_length = 0;
-
-	/* send ACK to GDB for debug request */
+	gdb_connection->mem_reply = NULL;
+	gdb_connection->mem_reply_size = 0;
+	gdb_connection->vflash_buffer = NULL;
+	gdb_connection->vflash_addr = 0;
+	gdb_connection->vflash_len = 0;
+	gdb_connection->vflash_alloc = 0;
+
+	/* send ACK to GDB for debug request; we are not in input handling
+	 * here, so it has to be flushed explicitly */
 	gdb_write(connection, "+", 1);
+	connection_flush(connection);
 
 	/* output goes through gdb connection */
 	command_set_output_handler(connection->cmd_ctx, gdb_output, connection);
@@ -1003,6 +1154,20 @@ static int gdb_new_connection(struct connection *connection)
 	return ERROR_OK;
 }
 
+static void gdb_vflash_chunks_free(struct gdb_connection *gdb_connection)
+{
+	struct gdb_vflash_chunk *chunk = gdb_connection->vflash_chunks;
+
+	while (chunk) {
+		struct gdb_vflash_chunk *next = chunk->next;
+		free(chunk->data);
+		free(chunk);
+		chunk = next;
+	}
+	gdb_connection->vflash_chunks = NULL;
+	gdb_connection->vflash_chunks_tail = NULL;
+}
+
 static int gdb_connection_closed(struct connection *connection)
 {
 	struct gdb_service *gdb_service = connection->service->priv;
@@ -1019,11 +1184,20 @@ static int gdb_connection_closed(struct connection *connection)
 		target_state_name(gdb_service->target),
 		gdb_actual_connections);
 
-	/* see if an image built with vFlash commands is left */
-	if (gdb_connection->vflash_image) {
-		image_close(gdb_connection->vflash_image);
-		free(gdb_connection->vflash_image);
-		gdb_connection->vflash_image = NULL;
+	/* see if staged vFlash data is left */
+	gdb_vflash_chunks_free(gdb_connection);
+
+	if (gdb_connection->mem_reply) {
+		free(gdb_connection->mem_reply);
+		gdb_connection->mem_reply = NULL;
+		gdb_connection->mem_reply_size = 0;
+	}
+
+	if (gdb_connection->vflash_buffer) {
+		free(gdb_connection->vflash_buffer);
+		gdb_connection->vflash_buffer = NULL;
+		gdb_connection->vflash_len = 0;
+		gdb_connection->vflash_alloc = 0;
 	}
 
 	/* if this connection registered a debug-message receiver delete it */
@@ -1343,6 +1517,25 @@ static int gdb_error(struct connection *connection, int retval)
 	return ERROR_OK;
 }
 
+/* Return a scratch buffer of at least @c size bytes for encoding memory
+ * replies, growing the per-connection buffer on demand.  The buffer stays
+ * allocated until the connection closes, so the common case of gdb reading
+ * memory in a tight loop doesn't malloc/free on every packet. */
+static char *gdb_mem_reply_buffer(struct connection *connection, uint32_t size)
+{
+	struct gdb_connection *gdb_connection = connection->priv;
+
+	if (gdb_connection->mem_reply_size < size) {
+		char *reply = realloc(gdb_connection->mem_reply, size);
+		if (reply == NULL)
+			return NULL;
+		gdb_connection->mem_reply = reply;
+		gdb_connection->mem_reply_size = size;
+	}
+
+	return gdb_connection->mem_reply;
+}
+
 /* We don't have to worry about the default 2 second timeout for GDB packets,
  * because GDB breaks up large memory reads into smaller reads.
  *
@@ -1404,13 +1597,93 @@ static int gdb_read_memory_packet(struct connection *connection,
 	}
 
 	if (retval == ERROR_OK) {
-		hex_buffer = malloc(len * 2 + 1);
+		hex_buffer = gdb_mem_reply_buffer(connection, len * 2 + 1);
+		if (hex_buffer == NULL) {
+			free(buffer);
+			return ERROR_GDB_BUFFER_TOO_SMALL;
+		}
 
 		int pkt_len = hexify(hex_buffer, (char *)buffer, len, len * 2 + 1);
 
 		gdb_put_packet(connection, hex_buffer, pkt_len);
+	} else
+		retval = gdb_error(connection, retval);
+
+	free(buffer);
+
+	return retval;
+}
+
+/* Handle the 'x' packet: like 'm', but the reply is "b" followed by raw
+ * binary data, halving the wire traffic compared to hex encoding.  The
+ * characters '#', '$', '}' and '*' are escaped as '}' followed by the
+ * character xor 0x20, same as in the 'X' write packet. */
+static int gdb_read_memory_binary_packet(struct connection *connection,
+		char const *packet, int packet_size)
+{
+	struct target *target = get_target_from_connection(connection);
+	char *separator;
+	uint32_t addr = 0;
+	uint32_t len = 0;
+
+	uint8_t *buffer;
+	char *bin_buffer;
 
-		free(hex_buffer);
+	int retval = ERROR_OK;
+
+	/* skip command character */
+	packet++;
+
+	addr = strtoul(packet, &separator, 16);
+
+	if (*separator != ',') {
+		LOG_ERROR("incomplete read memory packet received, dropping connection");
+		return ERROR_SERVER_REMOTE_CLOSED;
+	}
+
+	len = strtoul(separator + 1, NULL, 16);
+
+	if (!len) {
+		/* a zero-length request probes for 'x' support; the reply is
+		 * a bare "b" */
+		gdb_put_packet(connection, "b", 1);
+		return ERROR_OK;
+	}
+
+	buffer = malloc(len);
+
+	LOG_DEBUG("addr: 0x%8.8" PRIx32 ", len: 0x%8.8" PRIx32 "", addr, len);
+
+	retval = target_read_buffer(target, addr, len, buffer);
+
+	if ((retval != ERROR_OK) && !gdb_report_data_abort) {
+		/* lie and send back all zero's, see gdb_read_memory_packet() */
+		memset(buffer, 0, len);
+		retval = ERROR_OK;
+	}
+
+	if (retval == ERROR_OK) {
+		/* worst case: "b" plus every byte escaped */
+		bin_buffer = gdb_mem_reply_buffer(connection, len * 2 + 1);
+		if (bin_buffer == NULL) {
+			free(buffer);
+			return ERROR_GDB_BUFFER_TOO_SMALL;
+		}
+
+		int pkt_len = 0;
+		uint32_t i;
+
+		bin_buffer[pkt_len++] = 'b';
+		for (i = 0; i < len; i++) {
+			uint8_t t = buffer[i];
+			if (t == '#' || t == '$' || t == '}' || t == '*') {
+				bin_buffer[pkt_len++] = '}';
+				bin_buffer[pkt_len++] = t ^ 0x20;
+			} else
+				bin_buffer[pkt_len++] = t;
+		}
+
+		gdb_put_packet(connection, bin_buffer, pkt_len);
 	} else
 		retval = gdb_error(connection, retval);
 
@@ -1721,36 +1994,24 @@ static int compare_bank(const void *a, const void *b)
 		return -1;
 }
 
-static int gdb_memory_map(struct connection *connection,
-		char const *packet, int packet_size)
+/* Build the memory map XML for @c target.  We get away with only
+ * specifying flash here. Regions that are not specified are treated as if
+ * we provided no memory map(if not we could detect the holes and mark them
+ * as RAM).
+ */
+static int gdb_generate_memory_map(struct target *target, char **map_out,
+		uint32_t *map_len_out)
 {
-	/* We get away with only specifying flash here. Regions that are not
-	 * specified are treated as if we provided no memory map(if not we
-	 * could detect the holes and mark them as RAM).
-	 * Normally we only execute this code once, but no big deal if we
-	 * have to regenerate it a couple of times.
-	 */
-
-	struct target *target = get_target_from_connection(connection);
 	struct flash_bank *p;
 	char *xml = NULL;
 	int size = 0;
 	int pos = 0;
 	int retval = ERROR_OK;
 	struct flash_bank **banks;
-	int offset;
-	int length;
-	char *separator;
 	uint32_t ram_start = 0;
 	int i;
 	int target_flash_banks = 0;
 
-	/* skip command character */
-	packet += 23;
-
-	offset = strtoul(packet, &separator, 16);
-	length = strtoul(separator + 1, &separator, 16);
-
 	xml_printf(&retval, &xml, &pos, &size, "<memory-map>\n");
 
 	/* Sort banks in ascending order.  We need to report non-flash
@@ -1769,7 +2030,7 @@ static int gdb_memory_map(struct connection *connection,
 		retval = get_flash_bank_by_num(i, &p);
 		if (retval != ERROR_OK) {
 			free(banks);
-			gdb_error(connection, retval);
+			free(xml);
 			return retval;
 		}
 		banks[target_flash_banks++] = p;
@@ -1850,20 +2111,61 @@ static int gdb_memory_map(struct connection *connection,
 	xml_printf(&retval, &xml, &pos, &size, "</memory-map>\n");
 
 	if (retval != ERROR_OK) {
-		gdb_error(connection, retval);
+		free(xml);
 		return retval;
 	}
 
-	if (offset + length > pos)
-		length = pos - offset;
+	*map_out = xml;
+	*map_len_out = pos;
+	return ERROR_OK;
+}
+
+static int gdb_memory_map(struct connection *connection,
+		char const *packet, int packet_size)
+{
+	struct target *target = get_target_from_connection(connection);
+	int retval;
+	uint32_t offset;
+	uint32_t length;
+	char *separator;
+
+	/* skip command character */
+	packet += 23;
+
+	offset = strtoul(packet, &separator, 16);
+	length = strtoul(separator + 1, &separator, 16);
+
+	/* The map is cached on the target, so repeated requests (and the
+	 * chunked windows of one request) don't re-trigger bank probing and
+	 * regeneration; the flash layer invalidates the cache when a bank
+	 * is added or explicitly reprobed. */
+	if (target->memory_map == NULL) {
+		retval = gdb_generate_memory_map(target, &target->memory_map,
+				&target->memory_map_length);
+		if (retval != ERROR_OK) {
+			gdb_error(connection, retval);
+			return retval;
+		}
+	}
+
+	char transfer_type;
+
+	if (offset > target->memory_map_length)
+		offset = target->memory_map_length;
+
+	if (length < (target->memory_map_length - offset))
+		transfer_type = 'm';
+	else {
+		transfer_type = 'l';
+		length = target->memory_map_length - offset;
+	}
 
 	char *t = malloc(length + 1);
-	t[0] = 'l';
-	memcpy(t + 1, xml + offset, length);
+	t[0] = transfer_type;
+	memcpy(t + 1, target->memory_map + offset, length);
 	gdb_put_packet(connection, t, length + 1);
 
 	free(t);
-	free(xml);
 	return ERROR_OK;
 }
 
@@ -2171,30 +2473,25 @@ error:
 	return retval;
 }
 
-static int gdb_get_target_description_chunk(struct target *target, struct target_desc_format *target_desc,
+static int gdb_get_target_description_chunk(struct target *target,
 		char **chunk, int32_t offset, uint32_t length)
 {
-	if (target_desc == NULL) {
-		LOG_ERROR("Unable to Generate Target Description");
-		return ERROR_FAIL;
-	}
-
-	char *tdesc = target_desc->tdesc;
-	uint32_t tdesc_length = target_desc->tdesc_length;
-
-	if (tdesc == NULL) {
-		int retval = gdb_generate_target_description(target, &tdesc);
+	/* The description is cached on the target and survives both chunked
+	 * serving and reconnects; target_examine_one() invalidates it when
+	 * the register set can have changed. */
+	if (target->tdesc == NULL) {
+		int retval = gdb_generate_target_description(target, &target->tdesc);
 		if (retval != ERROR_OK) {
 			LOG_ERROR("Unable to Generate Target Description");
 			return ERROR_FAIL;
 		}
 
-		tdesc_length = strlen(tdesc);
+		target->tdesc_length = strlen(target->tdesc);
 	}
 
 	char transfer_type;
 
-	if (length < (tdesc_length - offset))
+	if (length < (target->tdesc_length - offset))
 		transfer_type = 'm';
 	else
 		transfer_type = 'l';
@@ -2207,21 +2504,14 @@ static int gdb_get_target_description_chunk(struct target *target, struct target
 
 	(*chunk)[0] = transfer_type;
 	if (transfer_type == 'm') {
-		strncpy((*chunk) + 1, tdesc + offset, length);
+		strncpy((*chunk) + 1, target->tdesc + offset, length);
 		(*chunk)[1 + length] = '\0';
 	} else {
-		strncpy((*chunk) + 1, tdesc + offset, tdesc_length - offset);
-		(*chunk)[1 + (tdesc_length - offset)] = '\0';
-
-		/* After gdb-server sends out last chunk, invalidate tdesc. */
-		free(tdesc);
-		tdesc = NULL;
-		tdesc_length = 0;
+		strncpy((*chunk) + 1, target->tdesc + offset,
+			target->tdesc_length - offset);
+		(*chunk)[1 + (target->tdesc_length - offset)] = '\0';
 	}
 
-	target_desc->tdesc = tdesc;
-	target_desc->tdesc_length = tdesc_length;
-
 	return ERROR_OK;
 }
 
@@ -2357,7 +2647,7 @@ static int gdb_query_packet(struct connection *connection,
 			&buffer,
 			&pos,
 			&size,
-			"PacketSize=%x;qXfer:memory-map:read%c;qXfer:features:read%c;QStartNoAckMode+",
+			"PacketSize=%x;qXfer:memory-map:read%c;qXfer:features:read%c;QStartNoAckMode+;binary-upload+",
 			(GDB_BUFFER_SIZE - 1),
 			((gdb_use_memory_map == 1) && (flash_get_bank_count() > 0)) ? '+' : '-',
 			(gdb_target_desc_supported == 1) ? '+' : '-');
@@ -2394,7 +2684,7 @@ static int gdb_query_packet(struct connection *connection,
 		 * there are *more* chunks to transfer. 'l' for it is the *last*
 		 * chunk of target description.
 		 */
-		retval = gdb_get_target_description_chunk(target, &gdb_connection->target_desc,
+		retval = gdb_get_target_description_chunk(target,
 				&xml, offset, length);
 		if (retval != ERROR_OK) {
 			gdb_error(connection, retval);
@@ -2415,6 +2705,76 @@ static int gdb_query_packet(struct connection *connection,
 	return ERROR_OK;
 }
 
+/* Program the run of streamed vFlashWrite data buffered on @c connection.
+ * Unless @c done is set, only the prefix ending on the last completed erase
+ * block boundary is written; the tail stays buffered until more data arrives
+ * or vFlashDone completes the run. */
+static int gdb_vflash_stream_flush(struct connection *connection, bool done)
+{
+	struct gdb_connection *gdb_connection = connection->priv;
+	struct gdb_service *gdb_service = connection->service->priv;
+	struct target *target = gdb_service->target;
+	uint32_t flush_len = gdb_connection->vflash_len;
+	uint32_t written;
+	struct image image;
+	int retval;
+
+	if (flush_len == 0)
+		return ERROR_OK;
+
+	if (!done) {
+		struct flash_bank *bank;
+		uint32_t end = gdb_connection->vflash_addr + gdb_connection->vflash_len;
+		int i;
+
+		retval = get_flash_bank_by_addr(target, gdb_connection->vflash_addr,
+				true, &bank);
+		if (retval != ERROR_OK)
+			return retval;
+
+		/* largest erase block end inside the buffered run */
+		flush_len = 0;
+		for (i = 0; i < bank->num_sectors; i++) {
+			uint32_t sector_end = bank->base + bank->sectors[i].offset
+				+ bank->sectors[i].size;
+			if (sector_end > gdb_connection->vflash_addr && sector_end <= end)
+				flush_len = sector_end - gdb_connection->vflash_addr;
+		}
+
+		if (flush_len == 0)
+			return ERROR_OK;
+	}
+
+	/* wrap the chunk in a scratch image so flash_write() handles bank
+	 * boundaries and driver alignment padding */
+	image_open(&image, "", "build");
+	retval = image_add_section(&image, gdb_connection->vflash_addr, flush_len,
+			0x0, gdb_connection->vflash_buffer);
+	if (retval != ERROR_OK) {
+		image_close(&image);
+		return retval;
+	}
+
+	target_call_event_callbacks(target, TARGET_EVENT_GDB_FLASH_WRITE_START);
+	retval = flash_write(target, &image, &written, 0);
+	target_call_event_callbacks(target, TARGET_EVENT_GDB_FLASH_WRITE_END);
+	image_close(&image);
+	if (retval != ERROR_OK)
+		return retval;
+
+	LOG_DEBUG("streamed %u bytes to flash at 0x%8.8" PRIx32,
+		(unsigned)written, gdb_connection->vflash_addr);
+
+	gdb_connection->vflash_addr += flush_len;
+	gdb_connection->vflash_len -= flush_len;
+	if (gdb_connection->vflash_len > 0)
+		memmove(gdb_connection->vflash_buffer,
+			gdb_connection->vflash_buffer + flush_len,
+			gdb_connection->vflash_len);
+
+	return ERROR_OK;
+}
+
 static int gdb_v_packet(struct connection *connection,
 		char const *packet, int packet_size)
 {
@@ -2502,17 +2862,71 @@ static int gdb_v_packet(struct connection *connection,
 		}
 		length = packet_size - (parse - packet);
 
-		/* create a new image if there isn't already one */
-		if (gdb_connection->vflash_image == NULL) {
-			gdb_connection->vflash_image = malloc(sizeof(struct image));
-			image_open(gdb_connection->vflash_image, "", "build");
+		if (gdb_flash_stream) {
+			/* a non-contiguous write ends the current run; drain it
+			 * completely before starting the new one */
+			if (gdb_connection->vflash_len > 0
+					&& addr != gdb_connection->vflash_addr + gdb_connection->vflash_len) {
+				retval = gdb_vflash_stream_flush(connection, true);
+				if (retval != ERROR_OK) {
+					LOG_ERROR("flash write returned %i", retval);
+					gdb_send_error(connection, EIO);
+					return ERROR_OK;
+				}
+			}
+
+			if (gdb_connection->vflash_len == 0)
+				gdb_connection->vflash_addr = addr;
+
+			if (gdb_connection->vflash_len + length > gdb_connection->vflash_alloc) {
+				uint32_t new_alloc = gdb_connection->vflash_alloc ?
+					gdb_connection->vflash_alloc : 16384;
+				while (new_alloc < gdb_connection->vflash_len + length)
+					new_alloc *= 2;
+				uint8_t *new_buffer = realloc(gdb_connection->vflash_buffer, new_alloc);
+				if (new_buffer == NULL)
+					return ERROR_GDB_BUFFER_TOO_SMALL;
+				gdb_connection->vflash_buffer = new_buffer;
+				gdb_connection->vflash_alloc = new_alloc;
+			}
+			memcpy(gdb_connection->vflash_buffer + gdb_connection->vflash_len,
+				parse, length);
+			gdb_connection->vflash_len += length;
+
+			/* program any completed erase blocks while gdb is still
+			 * pushing the remaining packets into the socket */
+			retval = gdb_vflash_stream_flush(connection, false);
+			if (retval != ERROR_OK) {
+				LOG_ERROR("flash write returned %i", retval);
+				gdb_send_error(connection, EIO);
+				return ERROR_OK;
+			}
+
+			gdb_put_packet(connection, "OK", 2);
+
+			return ERROR_OK;
 		}
 
-		/* create new section with content from packet buffer */
-		retval = image_add_section(gdb_connection->vflash_image,
-				addr, length, 0x0, (uint8_t const *)parse);
-		if (retval != ERROR_OK)
-			return retval;
+		/* stage the payload on the chunk list; contiguous runs are
+		 * only stitched together at vFlashDone */
+		struct gdb_vflash_chunk *chunk = malloc(sizeof(struct gdb_vflash_chunk));
+		if (chunk == NULL)
+			return ERROR_GDB_BUFFER_TOO_SMALL;
+		chunk->data = malloc(length);
+		if (chunk->data == NULL) {
+			free(chunk);
+			return ERROR_GDB_BUFFER_TOO_SMALL;
+		}
+		chunk->next = NULL;
+		chunk->addr = addr;
+		chunk->length = length;
+		memcpy(chunk->data, parse, length);
+
+		if (gdb_connection->vflash_chunks_tail)
+			gdb_connection->vflash_chunks_tail->next = chunk;
+		else
+			gdb_connection->vflash_chunks = chunk;
+		gdb_connection->vflash_chunks_tail = chunk;
 
 		gdb_put_packet(connection, "OK", 2);
 
@@ -2521,13 +2935,73 @@ static int gdb_v_packet(struct connection *connection,
 
 	if (strncmp(packet, "vFlashDone", 10) == 0) {
 		uint32_t written;
+		struct image image;
+		struct gdb_vflash_chunk *chunk = gdb_connection->vflash_chunks;
+
+		if (chunk == NULL) {
+			/* streaming mode: program whatever tail is left over */
+			result = gdb_vflash_stream_flush(connection, true);
+			if (result != ERROR_OK) {
+				if (result == ERROR_FLASH_DST_OUT_OF_BANK)
+					gdb_put_packet(connection, "E.memtype", 9);
+				else {
+					LOG_ERROR("flash write returned %i", result);
+					gdb_send_error(connection, EIO);
+				}
+			} else
+				gdb_put_packet(connection, "OK", 2);
+
+			return ERROR_OK;
+		}
+
+		/* stitch the staged chunks into one section per contiguous
+		 * run; each byte is copied once here instead of on every
+		 * vFlashWrite packet */
+		image_open(&image, "", "build");
+		result = ERROR_OK;
+		while (chunk != NULL && result == ERROR_OK) {
+			struct gdb_vflash_chunk *run_end = chunk;
+			struct gdb_vflash_chunk *c;
+			uint32_t run_len = chunk->length;
+			uint32_t offset;
+			uint8_t *run_buf;
+
+			/* size the contiguous run starting here */
+			while (run_end->next != NULL
+					&& run_end->next->addr == run_end->addr + run_end->length) {
+				run_end = run_end->next;
+				run_len += run_end->length;
+			}
+
+			run_buf = malloc(run_len);
+			if (run_buf == NULL) {
+				result = ERROR_GDB_BUFFER_TOO_SMALL;
+				break;
+			}
+
+			offset = 0;
+			for (c = chunk; ; c = c->next) {
+				memcpy(run_buf + offset, c->data, c->length);
+				offset += c->length;
+				if (c == run_end)
+					break;
+			}
+
+			result = image_add_section(&image, chunk->addr, run_len,
+					0x0, run_buf);
+			free(run_buf);
+
+			chunk = run_end->next;
+		}
 
 		/* process the flashing buffer. No need to erase as GDB
 		 * always issues a vFlashErase first. */
-		target_call_event_callbacks(gdb_service->target,
-				TARGET_EVENT_GDB_FLASH_WRITE_START);
-		result = flash_write(gdb_service->target, gdb_connection->vflash_image, &written, 0);
-		target_call_event_callbacks(gdb_service->target, TARGET_EVENT_GDB_FLASH_WRITE_END);
+		if (result == ERROR_OK) {
+			target_call_event_callbacks(gdb_service->target,
+					TARGET_EVENT_GDB_FLASH_WRITE_START);
+			result = flash_write(gdb_service->target, &image, &written, 0);
+			target_call_event_callbacks(gdb_service->target, TARGET_EVENT_GDB_FLASH_WRITE_END);
+		}
 		if (result != ERROR_OK) {
 			if (result == ERROR_FLASH_DST_OUT_OF_BANK)
 				gdb_put_packet(connection, "E.memtype", 9);
@@ -2538,9 +3012,8 @@ static int gdb_v_packet(struct connection *connection,
 			gdb_put_packet(connection, "OK", 2);
 		}
 
-		image_close(gdb_connection->vflash_image);
-		free(gdb_connection->vflash_image);
-		gdb_connection->vflash_image = NULL;
+		image_close(&image);
+		gdb_vflash_chunks_free(gdb_connection);
 
 		return ERROR_OK;
 	}
@@ -2650,7 +3123,14 @@ static int gdb_input_inner(struct connection *connection)
 	 *
 	 * If the error is recoverable, this fn is called again to
 	 * drain the rest of the buffer.
+	 *
+	 * The drain is bounded to a burst of packets rather than the whole
+	 * buffer: with one connection per core, an unbounded drain lets a
+	 * busy core starve the others' step/status responses.  input_pending
+	 * tracks the buffer precisely, so the server loop calls us straight
+	 * back once every other ready connection has had a turn.
 	 */
+	int burst = 16;
 	do {
 		packet_size = GDB_BUFFER_SIZE-1;
 		retval = gdb_get_packet(connection, gdb_packet_buffer, &packet_size);
@@ -2674,6 +3154,12 @@ static int gdb_input_inner(struct connection *connection)
 		}
 
 		if (packet_size > 0) {
+			int64_t profile_start = profile_enter();
+
+			/* gdb talking to us is a strong hint that a state change
+			 * is of interest soon; drop any polling backoff */
+			target_poll_tighten(target);
+
 			retval = ERROR_OK;
 			switch (packet[0]) {
 				case 'T':	/* Is thread alive? */
@@ -2704,6 +3190,9 @@ static int gdb_input_inner(struct connection *connection)
 				case 'm':
 					retval = gdb_read_memory_packet(connection, packet, packet_size);
 					break;
+				case 'x':
+					retval = gdb_read_memory_binary_packet(connection, packet, packet_size);
+					break;
 				case 'M':
 					retval = gdb_write_memory_packet(connection, packet, packet_size);
 					break;
@@ -2852,6 +3341,8 @@ static int gdb_input_inner(struct connection *connection)
 					break;
 			}
 
+			profile_leave(PROFILE_GDB_PACKET, profile_start);
+
 			/* if a packet handler returned an error, exit input loop */
 			if (retval != ERROR_OK)
 				return retval;
@@ -2869,7 +3360,7 @@ static int gdb_input_inner(struct connection *connection)
 			}
 		}
 
-	} while (gdb_con->buf_cnt > 0);
+	} while (gdb_con->buf_cnt > 0 && --burst > 0);
 
 	return ERROR_OK;
 }
@@ -3016,6 +3507,24 @@ COMMAND_HANDLER(handle_gdb_report_data_abort_command)
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(handle_gdb_rle_command)
+{
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	COMMAND_PARSE_ENABLE(CMD_ARGV[0], gdb_use_rle);
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_gdb_flash_stream_command)
+{
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	COMMAND_PARSE_ENABLE(CMD_ARGV[0], gdb_flash_stream);
+	return ERROR_OK;
+}
+
 /* gdb_breakpoint_override */
 COMMAND_HANDLER(handle_gdb_breakpoint_override_command)
 {
@@ -3137,6 +3646,21 @@ static const struct command_registration gdb_command_handlers[] = {
 		.help = "enable or disable reporting data aborts",
 		.usage = "('enable'|'disable')"
 	},
+	{
+		.name = "gdb_rle",
+		.handler = handle_gdb_rle_command,
+		.mode = COMMAND_CONFIG,
+		.help = "enable or disable run-length encoding of reply packets",
+		.usage = "('enable'|'disable')"
+	},
+	{
+		.name = "gdb_flash_stream",
+		.handler = handle_gdb_flash_stream_command,
+		.mode = COMMAND_CONFIG,
+		.help = "enable or disable streaming of vFlashWrite data "
+			"into the flash as complete erase blocks arrive",
+		.usage = "('enable'|'disable')"
+	},
 	{
 		.name = "gdb_breakpoint_override",
 		.handler = handle_gdb_breakpoint_override_command,
@@ -40,6 +40,7 @@
 
 #ifndef _WIN32
 #include <netinet/tcp.h>
+#include <sys/uio.h>
 #endif
 
 static struct service *services;
@@ -54,6 +55,11 @@ static int last_signal;
 /* set the polling period to 100ms */
 static int polling_period = 100;
 
+/* self-pipe watched by server_loop(); writing to it cuts a sleeping
+ * select() short, so completions can wake the loop instead of waiting
+ * for the next timeout tick */
+static int wakeup_pipe[2] = { -1, -1 };
+
 static int add_connection(struct service *service, struct command_context *cmd_ctx)
 {
 	socklen_t address_size;
@@ -68,6 +74,9 @@ static int add_connection(struct service *service, struct command_context *cmd_c
 	c->cmd_ctx = copy_command_context(cmd_ctx);
 	c->service = service;
 	c->input_pending = 0;
+	c->out_buffer = NULL;
+	c->out_buffer_size = 0;
+	c->out_buffer_len = 0;
 	c->priv = NULL;
 	c->next = NULL;
 
@@ -88,6 +97,25 @@ static int add_connection(struct service *service, struct command_context *cmd_c
 			(char *)&flag,			/* the cast is historical cruft */
 			sizeof(int));			/* length of option value */
 
+		/* per-service socket profile; as with TCP_NODELAY, a failure
+		 * here only costs performance, so errors are ignored */
+		if (strcmp(service->name, "tcl") == 0) {
+			/* the tcl binary channel moves megabyte payloads; give
+			 * the kernel enough buffer to keep the pipe full over
+			 * high-latency links */
+			int window_size = 1024 * 1024;
+			setsockopt(c->fd, SOL_SOCKET, SO_SNDBUF,
+				(char *)&window_size, sizeof(window_size));
+			setsockopt(c->fd, SOL_SOCKET, SO_RCVBUF,
+				(char *)&window_size, sizeof(window_size));
+		} else if (strcmp(service->name, "telnet") == 0) {
+			/* telnet sessions in remote labs sit idle for hours;
+			 * probe the peer so half-open connections get reaped
+			 * instead of wedging the single connection slot */
+			setsockopt(c->fd, SOL_SOCKET, SO_KEEPALIVE,
+				(char *)&flag, sizeof(int));
+		}
+
 		LOG_INFO("accepting '%s' connection on tcp/%s", service->name, service->port);
 		retval = service->new_connection(c);
 		if (retval != ERROR_OK) {
@@ -159,7 +187,9 @@ static int remove_connection(struct service *service, struct connection *connect
 	/* find connection */
 	while ((c = *p)) {
 		if (c->fd == connection->fd) {
+			connection_flush(c);
 			service->connection_closed(c);
+			free(c->out_buffer);
 			if (service->type == CONNECTION_TCP)
 				close_socket(c->fd);
 			else if (service->type == CONNECTION_PIPE) {
@@ -338,6 +368,17 @@ static int remove_services(void)
 	return ERROR_OK;
 }
 
+void server_wakeup(void)
+{
+	if (wakeup_pipe[1] == -1)
+		return;
+
+	/* a full pipe means a wakeup is already pending; nothing to do */
+	char dummy = 0;
+	if (write(wakeup_pipe[1], &dummy, 1) < 0 && errno != EAGAIN)
+		LOG_DEBUG("server wakeup write failed: %s", strerror(errno));
+}
+
 int server_loop(struct command_context *command_context)
 {
 	struct service *service;
@@ -354,6 +395,19 @@ int server_loop(struct command_context *command_context)
 #ifndef _WIN32
 	if (signal(SIGPIPE, SIG_IGN) == SIG_ERR)
 		LOG_ERROR("couldn't set SIGPIPE to SIG_IGN");
+
+	/* select() on Win32 only understands sockets, so the wakeup pipe
+	 * is POSIX-only; there server_wakeup() stays a no-op and latency
+	 * is bounded by the timeout tick as before */
+	if (wakeup_pipe[0] == -1) {
+		if (pipe(wakeup_pipe) == 0) {
+			socket_nonblock(wakeup_pipe[0]);
+			socket_nonblock(wakeup_pipe[1]);
+		} else {
+			wakeup_pipe[0] = -1;
+			wakeup_pipe[1] = -1;
+		}
+	}
 #endif
 
 	while (!shutdown_openocd) {
@@ -361,6 +415,12 @@ int server_loop(struct command_context *command_context)
 		fd_max = 0;
 		FD_ZERO(&read_fds);
 
+		if (wakeup_pipe[0] != -1) {
+			FD_SET(wakeup_pipe[0], &read_fds);
+			if (wakeup_pipe[0] > fd_max)
+				fd_max = wakeup_pipe[0];
+		}
+
 		/* add service and connection fds to read_fds */
 		for (service = services; service; service = service->next) {
 			if (service->fd != -1) {
@@ -391,8 +451,16 @@ int server_loop(struct command_context *command_context)
 			tv.tv_usec = 0;
 			retval = socket_select(fd_max + 1, &read_fds, NULL, NULL, &tv);
 		} else {
-			/* Every 100ms, can be changed with "poll_period" command */
-			tv.tv_usec = polling_period * 1000;
+			/* Sleep until the next timer callback is due, at most
+			 * polling_period ms (changeable with "poll_period"), so
+			 * that poll intervals shorter than the default period
+			 * take effect. */
+			int64_t timeout_ms = target_timer_next_event();
+			if (timeout_ms > polling_period)
+				timeout_ms = polling_period;
+			if (timeout_ms < 1)
+				timeout_ms = 1;
+			tv.tv_usec = timeout_ms * 1000;
 			/* Only while we're sleeping we'll let others run */
 			openocd_sleep_prelude();
 			kept_alive();
@@ -422,10 +490,24 @@ int server_loop(struct command_context *command_context)
 #endif
 		}
 
+		if (wakeup_pipe[0] != -1 && retval > 0
+				&& FD_ISSET(wakeup_pipe[0], &read_fds)) {
+			/* drain every pending wakeup; whatever was signalled is
+			 * picked up by the timer callbacks below */
+			char buf[16];
+			while (read(wakeup_pipe[0], buf, sizeof(buf)) > 0)
+				;
+		}
+
+		/* Service timer callbacks (which include target polling) on
+		 * every iteration, not only when select() times out; they are
+		 * gated on their own due times, so this is cheap, and busy
+		 * connections no longer starve polling. */
+		target_call_timer_callbacks();
+
 		if (retval == 0) {
 			/* We only execute these callbacks when there was nothing to do or we timed
 			 *out */
-			target_call_timer_callbacks();
 			process_jim_events(command_context);
 
 			FD_ZERO(&read_fds);	/* eCos leaves read_fds unchanged in this case!  */
@@ -467,7 +549,19 @@ int server_loop(struct command_context *command_context)
 				}
 			}
 
-			/* handle activity on connections */
+			/* handle activity on connections
+			 *
+			 * This is the concurrency boundary for every client
+			 * (GDB, telnet, tcl): one input handler runs at a time,
+			 * to completion, on this thread.  Fairness between
+			 * clients comes from servicing each ready connection
+			 * once per select() pass; isolation comes from never
+			 * running two commands concurrently.  A long command
+			 * (e.g. a flash write) therefore blocks all other
+			 * clients until it finishes -- input handlers must not
+			 * recurse into this loop to "help out", since command
+			 * context, the Jim interpreter and the adapter queue
+			 * all assume exclusive access. */
 			if (service->connections) {
 				struct connection *c;
 
@@ -488,6 +582,9 @@ int server_loop(struct command_context *command_context)
 							c = next;
 							continue;
 						}
+						/* input handling done, push out whatever
+						 * the handler left buffered */
+						connection_flush(c);
 					}
 					c = c->next;
 				}
@@ -597,8 +694,122 @@ int connection_write(struct connection *connection, const void *data, int len)
 		return write(connection->fd_out, data, len);
 }
 
+#define CONNECTION_OUT_BUFFER_SIZE 4096
+
+int connection_flush(struct connection *connection)
+{
+	int written;
+
+	if (connection->out_buffer_len == 0)
+		return ERROR_OK;
+
+	written = connection_write(connection, connection->out_buffer,
+			connection->out_buffer_len);
+	if (written != connection->out_buffer_len) {
+		connection->out_buffer_len = 0;
+		return ERROR_SERVER_REMOTE_CLOSED;
+	}
+	connection->out_buffer_len = 0;
+
+	return ERROR_OK;
+}
+
+int connection_write_buffered(struct connection *connection,
+		const void *data, int len)
+{
+	if (len <= 0)
+		return len;
+
+	/* writes that can never fit are passed straight through */
+	if (len >= CONNECTION_OUT_BUFFER_SIZE) {
+		if (connection_flush(connection) != ERROR_OK)
+			return -1;
+		return connection_write(connection, data, len);
+	}
+
+	if (connection->out_buffer == NULL) {
+		connection->out_buffer = malloc(CONNECTION_OUT_BUFFER_SIZE);
+		if (connection->out_buffer == NULL)
+			return connection_write(connection, data, len);
+		connection->out_buffer_size = CONNECTION_OUT_BUFFER_SIZE;
+	}
+
+	if (connection->out_buffer_len + len > connection->out_buffer_size
+			&& connection_flush(connection) != ERROR_OK)
+		return -1;
+
+	memcpy(connection->out_buffer + connection->out_buffer_len, data, len);
+	connection->out_buffer_len += len;
+
+	return len;
+}
+
+/* Write several buffers as one operation where the platform allows it, so
+ * the pieces of a reply share a TCP segment instead of going out one
+ * write() each. Returns the total number of bytes written, or a negative
+ * value on error. */
+int connection_writev(struct connection *connection,
+		const struct connection_iovec *iov, int iovcnt)
+{
+	int i;
+	int total = 0;
+
+	for (i = 0; i < iovcnt; i++)
+		total += iov[i].len;
+
+	if (total == 0)
+		return 0;
+
+	/* anything already buffered has to go out first */
+	if (connection->out_buffer_len > 0
+			&& connection_flush(connection) != ERROR_OK)
+		return -1;
+
+#ifndef _WIN32
+	if (iovcnt <= 8) {
+		struct iovec sys_iov[8];
+		int written = 0;
+
+		for (i = 0; i < iovcnt; i++) {
+			sys_iov[i].iov_base = (void *)iov[i].data;
+			sys_iov[i].iov_len = iov[i].len;
+		}
+
+		i = 0;
+		while (written < total) {
+			int n = writev(connection->fd_out, &sys_iov[i], iovcnt - i);
+			if (n < 0)
+				return n;
+			written += n;
+
+			/* skip elements the kernel consumed completely and adjust
+			 * a partially consumed one */
+			while (i < iovcnt && (size_t)n >= sys_iov[i].iov_len) {
+				n -= sys_iov[i].iov_len;
+				i++;
+			}
+			if (i < iovcnt && n > 0) {
+				sys_iov[i].iov_base = (char *)sys_iov[i].iov_base + n;
+				sys_iov[i].iov_len -= n;
+			}
+		}
+		return written;
+	}
+#endif
+
+	/* fall back to one write per buffer */
+	for (i = 0; i < iovcnt; i++) {
+		if (connection_write(connection, iov[i].data, iov[i].len) != iov[i].len)
+			return -1;
+	}
+	return total;
+}
+
 int connection_read(struct connection *connection, void *data, int len)
 {
+	/* the peer may be waiting for buffered output before it sends more */
+	connection_flush(connection);
+
 	if (connection->service->type == CONNECTION_TCP)
 		return read_socket(connection->fd, data, len);
 	else
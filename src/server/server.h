@@ -48,6 +48,11 @@ struct connection {
 	struct command_context *cmd_ctx;
 	struct service *service;
 	int input_pending;
+	/* output buffered by connection_write_buffered(), flushed on packet
+	 * boundaries and before any read */
+	char *out_buffer;
+	int out_buffer_size;
+	int out_buffer_len;
 	void *priv;
 	struct connection *next;
 };
@@ -84,11 +89,41 @@ void exit_on_signal(int);
 
 int server_loop(struct command_context *command_context);
 
+/**
+ * Wake a sleeping server_loop() select() immediately.  Callable from
+ * anywhere that learns of new work asynchronously (a driver completion
+ * callback, a timer rearm); bounds event latency by the event itself
+ * instead of the polling tick.  Safe to call before the loop starts and
+ * on platforms without the wakeup pipe, where it is a no-op.
+ */
+void server_wakeup(void);
+
 int server_register_commands(struct command_context *context);
 
 int connection_write(struct connection *connection, const void *data, int len);
 int connection_read(struct connection *connection, void *data, int len);
 
+/** scatter-gather element for connection_writev() */
+struct connection_iovec {
+	const void *data;
+	int len;
+};
+
+int connection_writev(struct connection *connection,
+		const struct connection_iovec *iov, int iovcnt);
+
+/**
+ * Like connection_write(), but collects small writes in a per-connection
+ * buffer so that e.g. per-character telnet echo doesn't cost one syscall
+ * per byte.  Buffered data is sent by connection_flush(), which the server
+ * loop calls after each input handler invocation and connection_read()
+ * calls before blocking; callers producing output outside input handling
+ * (log callbacks) must flush explicitly.
+ */
+int connection_write_buffered(struct connection *connection,
+		const void *data, int len);
+int connection_flush(struct connection *connection);
+
 /**
  * Used by server_loop(), defined in server_stubs.c
  */
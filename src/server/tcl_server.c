@@ -25,10 +25,12 @@
 #include "tcl_server.h"
 #include <target/target.h>
 #include <helper/binarybuffer.h>
+#include <helper/progress.h>
 
 #define TCL_SERVER_VERSION		"TCL Server 0.1"
 #define TCL_LINE_INITIAL		(4*1024)
 #define TCL_LINE_MAX			(4*1024*1024)
+#define TCL_BULK_MAX			(16*1024*1024)
 
 struct tcl_connection {
 	int tc_linedrop;
@@ -39,6 +41,18 @@ struct tcl_connection {
 	enum target_state tc_laststate;
 	bool tc_notify;
 	bool tc_trace;
+	/* which target events this connection subscribed to; all bits set
+	 * means everything, so plain "tcl_notifications on" behaves as it
+	 * always has */
+	uint64_t tc_event_mask;
+	/* in-flight binary payload of a tcl_write_memory command; while
+	 * tc_bulk_buf is non-NULL, incoming bytes are raw data rather than
+	 * command text */
+	uint8_t *tc_bulk_buf;
+	uint32_t tc_bulk_len;
+	uint32_t tc_bulk_offset;
+	uint32_t tc_bulk_addr;
+	struct target *tc_bulk_target;
 };
 
 static char *tcl_port;
@@ -58,19 +72,26 @@ static int tcl_target_callback_event_handler(struct target *target,
 
 	tclc = connection->priv;
 
-	if (tclc->tc_notify) {
-		snprintf(buf, sizeof(buf), "type target_event event %s\r\n\x1a", target_event_name(event));
+	/* the target name comes last so that clients parsing the historic
+	 * fixed prefix keep working */
+	if (tclc->tc_notify && (tclc->tc_event_mask & (1ULL << event))) {
+		snprintf(buf, sizeof(buf), "type target_event event %s target %s\r\n\x1a",
+				target_event_name(event), target_name(target));
 		tcl_output(connection, buf, strlen(buf));
 	}
 
 	if (tclc->tc_laststate != target->state) {
 		tclc->tc_laststate = target->state;
 		if (tclc->tc_notify) {
-			snprintf(buf, sizeof(buf), "type target_state state %s\r\n\x1a", target_state_name(target));
+			snprintf(buf, sizeof(buf), "type target_state state %s target %s\r\n\x1a",
+					target_state_name(target), target_name(target));
 			tcl_output(connection, buf, strlen(buf));
 		}
 	}
 
+	/* notifications happen outside input handling, push them out now */
+	connection_flush(connection);
+
 	return ERROR_OK;
 }
 
@@ -84,8 +105,10 @@ static int tcl_target_callback_reset_handler(struct target *target,
 	tclc = connection->priv;
 
 	if (tclc->tc_notify) {
-		snprintf(buf, sizeof(buf), "type target_reset mode %s\r\n\x1a", target_reset_mode_name(reset_mode));
+		snprintf(buf, sizeof(buf), "type target_reset mode %s target %s\r\n\x1a",
+				target_reset_mode_name(reset_mode), target_name(target));
 		tcl_output(connection, buf, strlen(buf));
+		connection_flush(connection);
 	}
 
 	return ERROR_OK;
@@ -110,6 +133,7 @@ static int tcl_target_callback_trace_handler(struct target *target,
 		hexify(hex, (const char *)data, len, hex_len);
 		snprintf(buf, max_len, "%s%s%s", header, hex, trailer);
 		tcl_output(connection, buf, strlen(buf));
+		connection_flush(connection);
 		free(hex);
 		free(buf);
 	}
@@ -117,6 +141,24 @@ static int tcl_target_callback_trace_handler(struct target *target,
 	return ERROR_OK;
 }
 
+static void tcl_progress_handler(const char *op, uint64_t done,
+		uint64_t total, void *priv)
+{
+	struct connection *connection = priv;
+	struct tcl_connection *tclc;
+	char buf[256];
+
+	tclc = connection->priv;
+
+	if (tclc->tc_notify) {
+		snprintf(buf, sizeof(buf),
+				"type progress op %s done %" PRIu64 " total %" PRIu64 "\r\n\x1a",
+				op, done, total);
+		tcl_output(connection, buf, strlen(buf));
+		connection_flush(connection);
+	}
+}
+
 /* write data out to a socket.
  *
  * this is a blocking write, so the return value must equal the length, if
@@ -131,7 +173,7 @@ int tcl_output(struct connection *connection, const void *data, ssize_t len)
 	if (tclc->tc_outerror)
 		return ERROR_SERVER_REMOTE_CLOSED;
 
-	wlen = connection_write(connection, data, len);
+	wlen = connection_write_buffered(connection, data, len);
 
 	if (wlen == len)
 		return ERROR_OK;
@@ -141,6 +183,31 @@ int tcl_output(struct connection *connection, const void *data, ssize_t len)
 	return ERROR_SERVER_REMOTE_CLOSED;
 }
 
+/* a tcl_write_memory payload is complete; commit it to the target and
+ * send the deferred reply for the command that announced it.
+ */
+static int tcl_bulk_write_complete(struct connection *connection)
+{
+	struct tcl_connection *tclc = connection->priv;
+	int retval;
+
+	retval = target_write_buffer(tclc->tc_bulk_target, tclc->tc_bulk_addr,
+			tclc->tc_bulk_len, tclc->tc_bulk_buf);
+
+	free(tclc->tc_bulk_buf);
+	tclc->tc_bulk_buf = NULL;
+
+	if (retval != ERROR_OK) {
+#define ESTR "memory write failed\n"
+		retval = tcl_output(connection, ESTR, sizeof(ESTR) - 1);
+		if (retval != ERROR_OK)
+			return retval;
+#undef ESTR
+	}
+
+	return tcl_output(connection, "\x1a", 1);
+}
+
 /* connections */
 static int tcl_new_connection(struct connection *connection)
 {
@@ -159,6 +226,9 @@ static int tcl_new_connection(struct connection *connection)
 
 	connection->priv = tclc;
 
+	/* subscribed to everything until told otherwise */
+	tclc->tc_event_mask = ~0ULL;
+
 	struct target *target = get_target_by_num(connection->cmd_ctx->current_target);
 	if (target != NULL)
 		tclc->tc_laststate = target->state;
@@ -169,6 +239,7 @@ static int tcl_new_connection(struct connection *connection)
 	target_register_event_callback(tcl_target_callback_event_handler, connection);
 	target_register_reset_callback(tcl_target_callback_reset_handler, connection);
 	target_register_trace_callback(tcl_target_callback_trace_handler, connection);
+	progress_add_callback(tcl_progress_handler, connection);
 
 	return ERROR_OK;
 }
@@ -199,6 +270,23 @@ static int tcl_input(struct connection *connection)
 
 	/* push as much data into the line as possible */
 	for (i = 0; i < rlen; i++) {
+		/* a bulk write is in progress; raw payload bytes take
+		 * precedence over command text */
+		if (tclc->tc_bulk_buf != NULL) {
+			size_t chunk = tclc->tc_bulk_len - tclc->tc_bulk_offset;
+			if (chunk > (size_t)(rlen - i))
+				chunk = rlen - i;
+			memcpy(tclc->tc_bulk_buf + tclc->tc_bulk_offset, in + i, chunk);
+			tclc->tc_bulk_offset += chunk;
+			i += chunk - 1;
+			if (tclc->tc_bulk_offset == tclc->tc_bulk_len) {
+				retval = tcl_bulk_write_complete(connection);
+				if (retval != ERROR_OK)
+					return retval;
+			}
+			continue;
+		}
+
 		/* buffer the data */
 		tclc->tc_line[tclc->tc_lineoffset] = in[i];
 		if (tclc->tc_lineoffset < tclc->tc_line_size) {
@@ -244,6 +332,13 @@ static int tcl_input(struct connection *connection)
 		} else {
 			tclc->tc_line[tclc->tc_lineoffset-1] = '\0';
 			command_run_line(connection->cmd_ctx, tclc->tc_line);
+			if (tclc->tc_bulk_buf != NULL) {
+				/* tcl_write_memory armed a bulk transfer; the
+				 * reply is deferred until its payload arrives */
+				tclc->tc_lineoffset = 0;
+				tclc->tc_linedrop = 0;
+				continue;
+			}
 			result = Jim_GetString(Jim_GetResult(interp), &reslen);
 			retval = tcl_output(connection, result, reslen);
 			if (retval != ERROR_OK)
@@ -266,6 +361,7 @@ static int tcl_closed(struct connection *connection)
 
 	/* cleanup connection context */
 	if (tclc) {
+		free(tclc->tc_bulk_buf);
 		free(tclc->tc_line);
 		free(tclc);
 		connection->priv = NULL;
@@ -274,6 +370,7 @@ static int tcl_closed(struct connection *connection)
 	target_unregister_event_callback(tcl_target_callback_event_handler, connection);
 	target_unregister_reset_callback(tcl_target_callback_reset_handler, connection);
 	target_unregister_trace_callback(tcl_target_callback_trace_handler, connection);
+	progress_remove_callback(tcl_progress_handler, connection);
 
 	return ERROR_OK;
 }
@@ -312,6 +409,90 @@ COMMAND_HANDLER(handle_tcl_notifications_command)
 	}
 }
 
+/* update an event subscription mask from a list of event names; used by
+ * both tcl_subscribe and tcl_unsubscribe
+ */
+static COMMAND_HELPER(tcl_update_event_mask, uint64_t *mask, bool subscribe)
+{
+	for (unsigned i = 0; i < CMD_ARGC; i++) {
+		if (strcmp(CMD_ARGV[i], "all") == 0) {
+			*mask = subscribe ? ~0ULL : 0;
+			continue;
+		}
+
+		enum target_event event;
+		if (target_event_by_name(CMD_ARGV[i], &event) != ERROR_OK) {
+			LOG_ERROR("unknown target event: %s", CMD_ARGV[i]);
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		}
+		if (subscribe)
+			*mask |= 1ULL << event;
+		else
+			*mask &= ~(1ULL << event);
+	}
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_tcl_subscribe_command)
+{
+	struct connection *connection = NULL;
+	struct tcl_connection *tclc = NULL;
+
+	if (CMD_CTX->output_handler_priv != NULL)
+		connection = CMD_CTX->output_handler_priv;
+
+	if (connection == NULL || strcmp(connection->service->name, "tcl")) {
+		LOG_ERROR("%s: can only be called from the tcl server", CMD_NAME);
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+
+	tclc = connection->priv;
+
+	if (CMD_ARGC == 0) {
+		if (tclc->tc_event_mask == ~0ULL) {
+			command_print(CMD_CTX, "all");
+			return ERROR_OK;
+		}
+		for (int e = 0; e < TARGET_EVENT_NUM; e++) {
+			if (tclc->tc_event_mask & (1ULL << e))
+				command_print(CMD_CTX, "%s", target_event_name(e));
+		}
+		return ERROR_OK;
+	}
+
+	int retval = CALL_COMMAND_HANDLER(tcl_update_event_mask,
+			&tclc->tc_event_mask, true);
+	if (retval != ERROR_OK)
+		return retval;
+
+	/* a subscription without notifications enabled would push nothing */
+	tclc->tc_notify = true;
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_tcl_unsubscribe_command)
+{
+	struct connection *connection = NULL;
+	struct tcl_connection *tclc = NULL;
+
+	if (CMD_ARGC == 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_CTX->output_handler_priv != NULL)
+		connection = CMD_CTX->output_handler_priv;
+
+	if (connection == NULL || strcmp(connection->service->name, "tcl")) {
+		LOG_ERROR("%s: can only be called from the tcl server", CMD_NAME);
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+
+	tclc = connection->priv;
+
+	return CALL_COMMAND_HANDLER(tcl_update_event_mask,
+			&tclc->tc_event_mask, false);
+}
+
 COMMAND_HANDLER(handle_tcl_trace_command)
 {
 	struct connection *connection = NULL;
@@ -329,6 +510,93 @@ COMMAND_HANDLER(handle_tcl_trace_command)
 	}
 }
 
+COMMAND_HANDLER(handle_tcl_read_memory_command)
+{
+	struct connection *connection = NULL;
+	uint32_t address;
+	uint32_t count;
+	uint8_t *buffer;
+	char header[32];
+	int retval;
+
+	if (CMD_ARGC != 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_CTX->output_handler_priv != NULL)
+		connection = CMD_CTX->output_handler_priv;
+
+	if (connection == NULL || strcmp(connection->service->name, "tcl")) {
+		LOG_ERROR("%s: can only be called from the tcl server", CMD_NAME);
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], address);
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], count);
+
+	if (count == 0 || count > TCL_BULK_MAX)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	buffer = malloc(count);
+	if (buffer == NULL)
+		return ERROR_FAIL;
+
+	retval = target_read_buffer(get_current_target(CMD_CTX), address, count, buffer);
+	if (retval != ERROR_OK) {
+		free(buffer);
+		return retval;
+	}
+
+	/* length-prefixed binary frame: "bulk <len>\n" announces exactly
+	 * <len> raw bytes; the usual ctrl-z terminated (empty) result
+	 * still follows, so line-oriented clients stay in sync */
+	snprintf(header, sizeof(header), "bulk %" PRIu32 "\n", count);
+	retval = tcl_output(connection, header, strlen(header));
+	if (retval == ERROR_OK)
+		retval = tcl_output(connection, buffer, count);
+
+	free(buffer);
+	return retval;
+}
+
+COMMAND_HANDLER(handle_tcl_write_memory_command)
+{
+	struct connection *connection = NULL;
+	struct tcl_connection *tclc;
+	uint32_t address;
+	uint32_t count;
+
+	if (CMD_ARGC != 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_CTX->output_handler_priv != NULL)
+		connection = CMD_CTX->output_handler_priv;
+
+	if (connection == NULL || strcmp(connection->service->name, "tcl")) {
+		LOG_ERROR("%s: can only be called from the tcl server", CMD_NAME);
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], address);
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], count);
+
+	if (count == 0 || count > TCL_BULK_MAX)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	tclc = connection->priv;
+	tclc->tc_bulk_buf = malloc(count);
+	if (tclc->tc_bulk_buf == NULL)
+		return ERROR_FAIL;
+
+	/* the <count> raw bytes following this command's terminator are the
+	 * payload; the reply is sent once they have all arrived */
+	tclc->tc_bulk_len = count;
+	tclc->tc_bulk_offset = 0;
+	tclc->tc_bulk_addr = address;
+	tclc->tc_bulk_target = get_current_target(CMD_CTX);
+
+	return ERROR_OK;
+}
+
 static const struct command_registration tcl_command_handlers[] = {
 	{
 		.name = "tcl_port",
@@ -346,6 +614,24 @@ static const struct command_registration tcl_command_handlers[] = {
 		.help = "Target Notification output",
 		.usage = "[on|off]",
 	},
+	{
+		.name = "tcl_subscribe",
+		.handler = handle_tcl_subscribe_command,
+		.mode = COMMAND_EXEC,
+		.help = "Subscribe this connection to the named target events "
+			"(as in 'target configure -event') and enable "
+			"notifications; 'all' restores every event.  Without "
+			"arguments, list the current subscription.",
+		.usage = "[event|all ...]",
+	},
+	{
+		.name = "tcl_unsubscribe",
+		.handler = handle_tcl_unsubscribe_command,
+		.mode = COMMAND_EXEC,
+		.help = "Drop the named target events (or 'all' of them) from "
+			"this connection's subscription.",
+		.usage = "event|all [...]",
+	},
 	{
 		.name = "tcl_trace",
 		.handler = handle_tcl_trace_command,
@@ -353,6 +639,22 @@ static const struct command_registration tcl_command_handlers[] = {
 		.help = "Target trace output",
 		.usage = "[on|off]",
 	},
+	{
+		.name = "tcl_read_memory",
+		.handler = handle_tcl_read_memory_command,
+		.mode = COMMAND_EXEC,
+		.help = "Read target memory and send it over the tcl "
+			"connection as a length-prefixed binary frame.",
+		.usage = "address count",
+	},
+	{
+		.name = "tcl_write_memory",
+		.handler = handle_tcl_write_memory_command,
+		.mode = COMMAND_EXEC,
+		.help = "Write the count raw bytes that follow this command "
+			"on the tcl connection to target memory.",
+		.usage = "address count",
+	},
 	COMMAND_REGISTRATION_DONE
 };
 
@@ -54,7 +54,9 @@ static int telnet_write(struct connection *connection, const void *data,
 	if (t_con->closed)
 		return ERROR_SERVER_REMOTE_CLOSED;
 
-	if (connection_write(connection, data, len) == len)
+	/* buffered: per-character echo and line redraws coalesce into one
+	 * write, flushed when input handling finishes */
+	if (connection_write_buffered(connection, data, len) == len)
 		return ERROR_OK;
 	t_con->closed = 1;
 	return ERROR_SERVER_REMOTE_CLOSED;
@@ -108,6 +110,7 @@ static void telnet_log_callback(void *priv, const char *file, unsigned line,
 	/* if there is no prompt, simply output the message */
 	if (t_con->line_cursor < 0) {
 		telnet_outputline(connection, string);
+		connection_flush(connection);
 		return;
 	}
 
@@ -127,6 +130,10 @@ static void telnet_log_callback(void *priv, const char *file, unsigned line,
 	telnet_write(connection, t_con->line, t_con->line_size);
 	for (i = t_con->line_size; i > t_con->line_cursor; i--)
 		telnet_write(connection, "\b", 1);
+
+	/* log output may arrive from timer callbacks, outside input
+	 * handling; make sure it reaches the user now */
+	connection_flush(connection);
 }
 
 static void telnet_load_history(struct telnet_connection *t_con)
@@ -237,6 +244,10 @@ static int telnet_new_connection(struct connection *connection)
 	telnet_write(connection, "\r", 1);
 	telnet_prompt(connection);
 
+	/* we are not in input handling here, so the greeting has to be
+	 * flushed explicitly */
+	connection_flush(connection);
+
 	/* initialize history */
 	for (i = 0; i < TELNET_LINE_HISTORY_SIZE; i++)
 		telnet_connection->history[i] = NULL;
@@ -331,9 +342,21 @@ static int telnet_input(struct connection *connection)
 							 * "\a" does not work, at least on windows */
 							telnet_write(connection, "\x07", 1);
 						} else if (t_con->line_cursor == t_con->line_size) {
-							telnet_write(connection, buf_p, 1);
-							t_con->line[t_con->line_size++] = *buf_p;
-							t_con->line_cursor++;
+							/* appending at the end of the line; consume the
+							 * whole run of printable characters from this
+							 * read at once, so pasted or machine-generated
+							 * input is buffered and echoed per batch instead
+							 * of per character */
+							int run = 1;
+							while ((run < bytes_read) && isprint(buf_p[run]) &&
+									(t_con->line_size + run < TELNET_LINE_MAX_SIZE-1))
+								run++;
+							telnet_write(connection, buf_p, run);
+							memcpy(t_con->line + t_con->line_size, buf_p, run);
+							t_con->line_size += run;
+							t_con->line_cursor += run;
+							buf_p += run - 1;
+							bytes_read -= run - 1;
 						} else {
 							int i;
 							memmove(t_con->line + t_con->line_cursor + 1,
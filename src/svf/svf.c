@@ -228,7 +228,11 @@ static int svf_getline(char **lineptr, size_t *n, FILE *stream);
 
 #define SVF_MAX_BUFFER_SIZE_TO_COMMIT   (1024 * 1024)
 static uint8_t *svf_tdi_buffer, *svf_tdo_buffer, *svf_mask_buffer;
-static int svf_buffer_index, svf_buffer_size ;
+static size_t svf_buffer_index, svf_buffer_size;
+/* scan bytes accumulated before the queue is flushed to the adapter;
+ * "-buffersize" raises it so high-latency links see fewer, larger
+ * batches and spend less time idle between flushes */
+static int svf_commit_size = SVF_MAX_BUFFER_SIZE_TO_COMMIT;
 static int svf_quiet;
 static int svf_nil;
 static int svf_ignore_error;
@@ -243,6 +247,55 @@ static long svf_total_lines;
 static int svf_percentage;
 static int svf_last_printed_percentage = -1;
 
+/* Live rate/ETA reporting, sampled while "progress" is active.  The
+ * shifted-byte counter and the adapter's cumulative transfer time let
+ * an operator tell a slow adapter (high rate, high utilization) from a
+ * hung board (rate collapses to zero) within one report interval. */
+#define SVF_STAT_INTERVAL_MS_DEFAULT	5000
+static long long svf_stat_interval_ms;
+static long long svf_start_time_ms;
+static long long svf_last_stat_ms;
+static long long svf_scan_bytes;
+static int64_t svf_start_latency_us;
+
+static void svf_emit_stats(long long now)
+{
+	long long elapsed_ms = now - svf_start_time_ms;
+	long long busy_ms =
+		(jtag_get_interface_stats()->latency_us - svf_start_latency_us) / 1000;
+	long long kbps = 0;
+	long long eta_s = -1;
+	int util = 0;
+
+	if (elapsed_ms > 0) {
+		kbps = (svf_scan_bytes * 8) / elapsed_ms;
+		util = (int)((busy_ms * 100) / elapsed_ms);
+		if (util > 100)
+			util = 100;
+	}
+	if (svf_total_lines > 0 && svf_line_number > 0)
+		eta_s = (elapsed_ms * (svf_total_lines - svf_line_number))
+				/ ((long long)svf_line_number * 1000);
+
+	LOG_USER("svf: line %d/%ld, %lld kbit/s, adapter %d%% busy, ETA %llds",
+		svf_line_number, svf_total_lines, kbps, util, eta_s);
+}
+
+/* Pre-parsed command cache ("svf ... cache").  Flows that replay the
+ * same file many times pay the full line assembly and comment stripping
+ * cost on every run; the cache stores each assembled command as a
+ * length-prefixed record next to the source file, keyed by a hash of
+ * the source text, so later runs skip that stage entirely. */
+#define SVF_CACHE_MAGIC		0x53564643	/* "SVFC" */
+#define SVF_CACHE_VERSION	1
+#define SVF_CACHE_HDR_SIZE	20
+
+static int svf_cache_enabled;
+static char *svf_cache_path;
+static FILE *svf_cache_rd;
+static FILE *svf_cache_wr;
+static long svf_cache_commands;
+
 /*
  * macro is used to print the svf hex buffer at desired debug level
  * DEBUG, INFO, ERROR, USER
@@ -281,6 +334,18 @@ static int svf_realloc_buffers(size_t len)
 	if (svf_execute_tap() != ERROR_OK)
 		return ERROR_FAIL;
 
+	/* Never shrink, and grow in powers of two: the buffers settle at
+	 * the high-water mark of the file instead of being reallocated
+	 * whenever scan sizes fluctuate. */
+	if (len <= svf_buffer_size)
+		return ERROR_OK;
+	if (svf_buffer_size > 0) {
+		size_t alloc_len = svf_buffer_size;
+		while (alloc_len < len)
+			alloc_len *= 2;
+		len = alloc_len;
+	}
+
 	ptr = realloc(svf_tdi_buffer, len);
 	if (!ptr)
 		return ERROR_FAIL;
@@ -357,10 +422,119 @@ int svf_add_statemove(tap_state_t state_to)
 	return ERROR_FAIL;
 }
 
+static uint32_t svf_cache_hash_file(FILE *fd)
+{
+	/* FNV-1a over the source text */
+	uint32_t hash = 0x811c9dc5;
+	uint8_t buf[4096];
+	size_t nread;
+
+	while ((nread = fread(buf, 1, sizeof(buf), fd)) > 0)
+		for (size_t i = 0; i < nread; i++) {
+			hash ^= buf[i];
+			hash *= 0x01000193;
+		}
+	rewind(fd);
+
+	return hash;
+}
+
+static int svf_cache_open(const char *path, uint32_t hash)
+{
+	uint8_t header[SVF_CACHE_HDR_SIZE];
+	FILE *fd = fopen(path, "rb");
+
+	if (fd == NULL)
+		return ERROR_FAIL;
+
+	if (fread(header, 1, sizeof(header), fd) != sizeof(header)
+			|| le_to_h_u32(header) != SVF_CACHE_MAGIC
+			|| le_to_h_u32(header + 4) != SVF_CACHE_VERSION
+			|| le_to_h_u32(header + 8) != hash) {
+		/* stale or foreign file; it will be rewritten */
+		fclose(fd);
+		return ERROR_FAIL;
+	}
+
+	svf_cache_commands = le_to_h_u32(header + 12);
+	svf_total_lines = le_to_h_u32(header + 16);
+	svf_cache_rd = fd;
+
+	return ERROR_OK;
+}
+
+static int svf_cache_create(const char *path, uint32_t hash)
+{
+	uint8_t header[SVF_CACHE_HDR_SIZE];
+	FILE *fd = fopen(path, "wb");
+
+	if (fd == NULL) {
+		LOG_DEBUG("cannot create svf cache \"%s\"", path);
+		return ERROR_FAIL;
+	}
+
+	/* command and line counts are patched in once the run succeeds */
+	h_u32_to_le(header, SVF_CACHE_MAGIC);
+	h_u32_to_le(header + 4, SVF_CACHE_VERSION);
+	h_u32_to_le(header + 8, hash);
+	h_u32_to_le(header + 12, 0);
+	h_u32_to_le(header + 16, 0);
+	if (fwrite(header, 1, sizeof(header), fd) != sizeof(header)) {
+		fclose(fd);
+		remove(path);
+		return ERROR_FAIL;
+	}
+
+	svf_cache_wr = fd;
+
+	return ERROR_OK;
+}
+
+static int svf_cache_append(int line_number, const char *cmd)
+{
+	uint8_t record[8];
+	size_t len = strlen(cmd);
+
+	h_u32_to_le(record, line_number);
+	h_u32_to_le(record + 4, len);
+	if (fwrite(record, 1, sizeof(record), svf_cache_wr) != sizeof(record)
+			|| fwrite(cmd, 1, len, svf_cache_wr) != len)
+		return ERROR_FAIL;
+
+	return ERROR_OK;
+}
+
+static int svf_read_command_from_cache(void)
+{
+	uint8_t record[8];
+	size_t len;
+
+	if (fread(record, 1, sizeof(record), svf_cache_rd) != sizeof(record))
+		return ERROR_FAIL;
+
+	svf_line_number = le_to_h_u32(record);
+	len = le_to_h_u32(record + 4);
+
+	if (len + 1 > svf_command_buffer_size) {
+		svf_command_buffer = realloc(svf_command_buffer, len + 1);
+		svf_command_buffer_size = len + 1;
+		if (svf_command_buffer == NULL) {
+			LOG_ERROR("not enough memory");
+			return ERROR_FAIL;
+		}
+	}
+
+	if (fread(svf_command_buffer, 1, len, svf_cache_rd) != len)
+		return ERROR_FAIL;
+	svf_command_buffer[len] = '\0';
+
+	return ERROR_OK;
+}
+
 COMMAND_HANDLER(handle_svf_command)
 {
 #define SVF_MIN_NUM_OF_OPTIONS 1
-#define SVF_MAX_NUM_OF_OPTIONS 5
+#define SVF_MAX_NUM_OF_OPTIONS 10
 	int command_num = 0;
 	int ret = ERROR_OK;
 	long long time_measure_ms;
@@ -371,6 +545,7 @@ COMMAND_HANDLER(handle_svf_command)
 	 * that should be affected
 	*/
 	struct jtag_tap *tap = NULL;
+	const char *svf_file_name = NULL;
 
 	if ((CMD_ARGC < SVF_MIN_NUM_OF_OPTIONS) || (CMD_ARGC > SVF_MAX_NUM_OF_OPTIONS))
 		return ERROR_COMMAND_SYNTAX_ERROR;
@@ -380,6 +555,9 @@ COMMAND_HANDLER(handle_svf_command)
 	svf_nil = 0;
 	svf_progress_enabled = 0;
 	svf_ignore_error = 0;
+	svf_cache_enabled = 0;
+	svf_commit_size = SVF_MAX_BUFFER_SIZE_TO_COMMIT;
+	svf_stat_interval_ms = SVF_STAT_INTERVAL_MS_DEFAULT;
 	for (unsigned int i = 0; i < CMD_ARGC; i++) {
 		if (strcmp(CMD_ARGV[i], "-tap") == 0) {
 			tap = jtag_tap_by_string(CMD_ARGV[i+1]);
@@ -399,15 +577,35 @@ COMMAND_HANDLER(handle_svf_command)
 		else if ((strcmp(CMD_ARGV[i],
 				  "ignore_error") == 0) || (strcmp(CMD_ARGV[i], "-ignore_error") == 0))
 			svf_ignore_error = 1;
-		else {
+		else if ((strcmp(CMD_ARGV[i], "cache") == 0) || (strcmp(CMD_ARGV[i], "-cache") == 0))
+			svf_cache_enabled = 1;
+		else if (strcmp(CMD_ARGV[i], "-buffersize") == 0) {
+			if (i + 1 >= CMD_ARGC)
+				return ERROR_COMMAND_SYNTAX_ERROR;
+			COMMAND_PARSE_NUMBER(int, CMD_ARGV[i + 1], svf_commit_size);
+			if (svf_commit_size < SVF_MAX_BUFFER_SIZE_TO_COMMIT)
+				svf_commit_size = SVF_MAX_BUFFER_SIZE_TO_COMMIT;
+			i++;
+		} else if (strcmp(CMD_ARGV[i], "-statinterval") == 0) {
+			int interval_s;
+
+			if (i + 1 >= CMD_ARGC)
+				return ERROR_COMMAND_SYNTAX_ERROR;
+			COMMAND_PARSE_NUMBER(int, CMD_ARGV[i + 1], interval_s);
+			/* 0 disables the periodic reports */
+			svf_stat_interval_ms = (long long)interval_s * 1000;
+			i++;
+		} else {
 			svf_fd = fopen(CMD_ARGV[i], "r");
 			if (svf_fd == NULL) {
 				int err = errno;
 				command_print(CMD_CTX, "open(\"%s\"): %s", CMD_ARGV[i], strerror(err));
 				/* no need to free anything now */
 				return ERROR_COMMAND_SYNTAX_ERROR;
-			} else
+			} else {
+				svf_file_name = CMD_ARGV[i];
 				LOG_USER("svf processing file: \"%s\"", CMD_ARGV[i]);
+			}
 		}
 	}
 
@@ -416,6 +614,10 @@ COMMAND_HANDLER(handle_svf_command)
 
 	/* get time */
 	time_measure_ms = timeval_ms();
+	svf_start_time_ms = time_measure_ms;
+	svf_last_stat_ms = time_measure_ms;
+	svf_scan_bytes = 0;
+	svf_start_latency_us = jtag_get_interface_stats()->latency_us;
 
 	/* init */
 	svf_line_number = 0;
@@ -434,7 +636,7 @@ COMMAND_HANDLER(handle_svf_command)
 	/* in case current command cannot be committed, and next command is a bit scan command */
 	/* here is 32K bits for this big scan command, it should be enough */
 	/* buffer will be reallocated if buffer size is not enough */
-	if (svf_realloc_buffers(2 * SVF_MAX_BUFFER_SIZE_TO_COMMIT) != ERROR_OK) {
+	if (svf_realloc_buffers(2 * svf_commit_size) != ERROR_OK) {
 		ret = ERROR_FAIL;
 		goto free_all;
 	}
@@ -490,15 +692,34 @@ COMMAND_HANDLER(handle_svf_command)
 		}
 	}
 
-	if (svf_progress_enabled) {
-		/* Count total lines in file. */
-		while (!feof(svf_fd)) {
-			svf_getline(&svf_command_buffer, &svf_command_buffer_size, svf_fd);
-			svf_total_lines++;
+	if (svf_cache_enabled && svf_file_name) {
+		uint32_t hash = svf_cache_hash_file(svf_fd);
+
+		svf_cache_path = malloc(strlen(svf_file_name) + 5);
+		if (svf_cache_path) {
+			sprintf(svf_cache_path, "%s.svc", svf_file_name);
+			if (ERROR_OK == svf_cache_open(svf_cache_path, hash))
+				LOG_USER("svf replaying pre-parsed cache: \"%s\"", svf_cache_path);
+			else
+				svf_cache_create(svf_cache_path, hash);
+		}
+	}
+
+	if (!svf_cache_rd && (svf_progress_enabled || svf_cache_wr)) {
+		/* count total lines in file, block-wise */
+		char count_buf[4096];
+		size_t count_read;
+
+		while ((count_read = fread(count_buf, 1, sizeof(count_buf), svf_fd)) > 0) {
+			for (size_t j = 0; j < count_read; j++)
+				if (count_buf[j] == '\n')
+					svf_total_lines++;
 		}
 		rewind(svf_fd);
 	}
-	while (ERROR_OK == svf_read_command_from_file(svf_fd)) {
+	while (ERROR_OK == (svf_cache_rd
+			? svf_read_command_from_cache()
+			: svf_read_command_from_file(svf_fd))) {
 		/* Log Output */
 		if (svf_quiet) {
 			if (svf_progress_enabled) {
@@ -511,9 +732,19 @@ COMMAND_HANDLER(handle_svf_command)
 		} else {
 			if (svf_progress_enabled) {
 				svf_percentage = ((svf_line_number * 20) / svf_total_lines) * 5;
-				LOG_USER_N("%3d%%  %s", svf_percentage, svf_read_line);
+				LOG_USER_N("%3d%%  %s", svf_percentage,
+					svf_cache_rd ? svf_command_buffer : svf_read_line);
 			} else
-				LOG_USER_N("%s", svf_read_line);
+				LOG_USER_N("%s", svf_cache_rd ? svf_command_buffer : svf_read_line);
+			if (svf_cache_rd)
+				LOG_USER_N("\n");
+		}
+		if (svf_cache_wr
+				&& ERROR_OK != svf_cache_append(svf_line_number, svf_command_buffer)) {
+			LOG_DEBUG("svf cache write failed, disabling");
+			fclose(svf_cache_wr);
+			svf_cache_wr = NULL;
+			remove(svf_cache_path);
 		}
 		/* Run Command */
 		if (ERROR_OK != svf_run_command(CMD_CTX, svf_command_buffer)) {
@@ -522,6 +753,40 @@ COMMAND_HANDLER(handle_svf_command)
 			break;
 		}
 		command_num++;
+
+		if (svf_progress_enabled && svf_stat_interval_ms > 0) {
+			long long now = timeval_ms();
+
+			if (now - svf_last_stat_ms >= svf_stat_interval_ms) {
+				svf_emit_stats(now);
+				svf_last_stat_ms = now;
+			}
+		}
+	}
+
+	/* commands silently lost to a damaged cache would be a correctness
+	 * bug, not just a performance one */
+	if (svf_cache_rd && ERROR_OK == ret && command_num != svf_cache_commands) {
+		LOG_ERROR("svf cache \"%s\" is truncated, delete it and rerun", svf_cache_path);
+		ret = ERROR_FAIL;
+	}
+
+	if (svf_cache_wr) {
+		uint8_t counts[8];
+
+		h_u32_to_le(counts, command_num);
+		h_u32_to_le(counts + 4, svf_total_lines);
+		if (ERROR_OK != ret
+				|| fseek(svf_cache_wr, 12, SEEK_SET) != 0
+				|| fwrite(counts, 1, sizeof(counts), svf_cache_wr) != sizeof(counts)) {
+			fclose(svf_cache_wr);
+			svf_cache_wr = NULL;
+			remove(svf_cache_path);
+		} else {
+			fclose(svf_cache_wr);
+			svf_cache_wr = NULL;
+			LOG_DEBUG("svf cache written: \"%s\"", svf_cache_path);
+		}
 	}
 
 	if ((!svf_nil) && (ERROR_OK != jtag_execute_queue()))
@@ -529,6 +794,22 @@ COMMAND_HANDLER(handle_svf_command)
 	else if (ERROR_OK != svf_check_tdo())
 		ret = ERROR_FAIL;
 
+	/* machine-readable summary, one line, key=value */
+	if (svf_progress_enabled) {
+		long long total_ms = timeval_ms() - svf_start_time_ms;
+		long long busy_ms =
+			(jtag_get_interface_stats()->latency_us - svf_start_latency_us) / 1000;
+		long long kbps = total_ms > 0 ? (svf_scan_bytes * 8) / total_ms : 0;
+		int util = total_ms > 0 ? (int)((busy_ms * 100) / total_ms) : 0;
+
+		if (util > 100)
+			util = 100;
+		LOG_USER("svf_stats: result=%s commands=%d scan_bytes=%lld time_ms=%lld "
+			"throughput_kbps=%lld adapter_util_percent=%d",
+			(ERROR_OK == ret) ? "ok" : "error", command_num,
+			svf_scan_bytes, total_ms, kbps, util);
+	}
+
 	/* print time */
 	time_measure_ms = timeval_ms() - time_measure_ms;
 	time_measure_s = time_measure_ms / 1000;
@@ -547,6 +828,21 @@ free_all:
 	fclose(svf_fd);
 	svf_fd = 0;
 
+	if (svf_cache_rd) {
+		fclose(svf_cache_rd);
+		svf_cache_rd = NULL;
+	}
+	if (svf_cache_wr) {
+		/* error path: an incomplete cache must not survive */
+		fclose(svf_cache_wr);
+		svf_cache_wr = NULL;
+		if (svf_cache_path)
+			remove(svf_cache_path);
+	}
+	free(svf_cache_path);
+	svf_cache_path = NULL;
+	svf_cache_commands = 0;
+
 	/* free buffers */
 	if (svf_command_buffer) {
 		free(svf_command_buffer);
@@ -595,8 +891,8 @@ free_all:
 
 static int svf_getline(char **lineptr, size_t *n, FILE *stream)
 {
-#define MIN_CHUNK 16	/* Buffer is increased by this size each time as required */
-	size_t i = 0;
+#define MIN_CHUNK 256	/* the line buffer starts at this size and doubles */
+	size_t used = 0;
 
 	if (*lineptr == NULL) {
 		*n = MIN_CHUNK;
@@ -605,21 +901,31 @@ static int svf_getline(char **lineptr, size_t *n, FILE *stream)
 			return -1;
 	}
 
-	(*lineptr)[0] = fgetc(stream);
-	while ((*lineptr)[i] != '\n') {
-		(*lineptr)[++i] = fgetc(stream);
-		if (feof(stream)) {
+	/* Read through the stdio buffer a line fragment at a time instead
+	 * of a character at a time; the per-character call overhead used to
+	 * dominate the parse stage on large files. */
+	for (;;) {
+		if (fgets(*lineptr + used, *n - used, stream) == NULL) {
+			/* EOF; a trailing line without newline is dropped,
+			 * as the character based reader did */
 			(*lineptr)[0] = 0;
 			return -1;
 		}
-		if ((i + 2) > *n) {
-			*n += MIN_CHUNK;
-			*lineptr = realloc(*lineptr, *n);
+
+		used += strlen(*lineptr + used);
+		if (used > 0 && (*lineptr)[used - 1] == '\n')
+			break;
+
+		/* line continues beyond the buffer; double it */
+		if (*n - used < 2) {
+			char *reallocated = realloc(*lineptr, *n * 2);
+			if (reallocated == NULL)
+				return -1;
+			*lineptr = reallocated;
+			*n *= 2;
 		}
 	}
 
-	(*lineptr)[++i] = 0;
-
 	return sizeof(*lineptr);
 }
 
@@ -682,8 +988,15 @@ static int svf_read_command_from_file(FILE *fd)
 				 *  - terminating NUL ('\0')
 				 */
 				if (cmd_pos + 3 > svf_command_buffer_size) {
-					svf_command_buffer = realloc(svf_command_buffer, cmd_pos + 3);
-					svf_command_buffer_size = cmd_pos + 3;
+					/* grow geometrically, a byte-exact realloc
+					 * per appended character is too expensive */
+					size_t new_size = 2 * svf_command_buffer_size;
+					if (new_size < cmd_pos + 3)
+						new_size = cmd_pos + 3;
+					if (new_size < SVFP_CMD_INC_CNT)
+						new_size = SVFP_CMD_INC_CNT;
+					svf_command_buffer = realloc(svf_command_buffer, new_size);
+					svf_command_buffer_size = new_size;
 					if (svf_command_buffer == NULL) {
 						LOG_ERROR("not enough memory");
 						return ERROR_FAIL;
@@ -763,11 +1076,24 @@ static int svf_find_string_in_array(char *str, char **strs, int num_of_element)
 	return 0xFF;
 }
 
+/* Round an array size up so scans with fluctuating lengths reuse one
+ * allocation at its high-water mark.  Both the old and the new length go
+ * through the same rounding, so the result is never larger than what a
+ * previous call actually allocated. */
+static int svf_array_alloc_length(int bit_len)
+{
+	int alloc_len = 256;
+
+	while (alloc_len < ((bit_len + 7) >> 3))
+		alloc_len *= 2;
+	return alloc_len;
+}
+
 static int svf_adjust_array_length(uint8_t **arr, int orig_bit_len, int new_bit_len)
 {
-	int new_byte_len = (new_bit_len + 7) >> 3;
+	int new_byte_len = svf_array_alloc_length(new_bit_len);
 
-	if ((NULL == *arr) || (((orig_bit_len + 7) >> 3) < ((new_bit_len + 7) >> 3))) {
+	if ((NULL == *arr) || (svf_array_alloc_length(orig_bit_len) < new_byte_len)) {
 		if (*arr != NULL) {
 			free(*arr);
 			*arr = NULL;
@@ -805,32 +1131,58 @@ static int svf_copy_hexstring_to_binary(char *str, uint8_t **bin, int orig_bit_l
 		return ERROR_FAIL;
 	}
 
+	/* Table of nibble values: -1 marks an invalid character, -2 marks
+	 * whitespace.  The SVF specification (rev E) is deficient in terms
+	 * of basic lexical issues like where whitespace is allowed.  Long
+	 * bitstrings may require line ends for correctness, since there is
+	 * a hard limit on line length. */
+	static int8_t hex_value[256];
+	static bool hex_value_init;
+
+	if (!hex_value_init) {
+		memset(hex_value, -1, sizeof(hex_value));
+		for (i = '0'; i <= '9'; i++)
+			hex_value[i] = i - '0';
+		for (i = 'A'; i <= 'F'; i++)
+			hex_value[i] = i - 'A' + 10;
+		hex_value[' '] = -2;
+		hex_value['\t'] = -2;
+		hex_value['\r'] = -2;
+		hex_value['\n'] = -2;
+		hex_value['\v'] = -2;
+		hex_value['\f'] = -2;
+		hex_value_init = true;
+	}
+
 	/* fill from LSB (end of str) to MSB (beginning of str) */
 	for (i = 0; i < str_hbyte_len; i++) {
+		/* bulk path: two adjacent plain hex digits form a byte */
+		if ((i % 2) == 0 && i + 1 < str_hbyte_len && str_len >= 2) {
+			int8_t lo = hex_value[(uint8_t)str[str_len - 1]];
+			int8_t hi = hex_value[(uint8_t)str[str_len - 2]];
+
+			if ((lo >= 0) && (hi >= 0)) {
+				(*bin)[i / 2] = (hi << 4) | lo;
+				ch = hi;
+				str_len -= 2;
+				i++;
+				continue;
+			}
+		}
+
+		/* single nibble, skipping whitespace */
 		ch = 0;
 		while (str_len > 0) {
-			ch = str[--str_len];
-
-			/* Skip whitespace.  The SVF specification (rev E) is
-			 * deficient in terms of basic lexical issues like
-			 * where whitespace is allowed.  Long bitstrings may
-			 * require line ends for correctness, since there is
-			 * a hard limit on line length.
-			 */
-			if (!isspace(ch)) {
-				if ((ch >= '0') && (ch <= '9')) {
-					ch = ch - '0';
-					break;
-				} else if ((ch >= 'A') && (ch <= 'F')) {
-					ch = ch - 'A' + 10;
-					break;
-				} else {
-					LOG_ERROR("invalid hex string");
-					return ERROR_FAIL;
-				}
-			}
+			int8_t nibble = hex_value[(uint8_t)str[--str_len]];
 
-			ch = 0;
+			if (nibble == -2)
+				continue;
+			if (nibble < 0) {
+				LOG_ERROR("invalid hex string");
+				return ERROR_FAIL;
+			}
+			ch = nibble;
+			break;
 		}
 
 		/* write bin */
@@ -908,6 +1260,7 @@ static int svf_execute_tap(void)
 	else if (ERROR_OK != svf_check_tdo())
 		return ERROR_FAIL;
 
+	svf_scan_bytes += svf_buffer_index;
 	svf_buffer_index = 0;
 
 	return ERROR_OK;
@@ -1124,7 +1477,7 @@ XXR_common:
 				/* check buffer size first, reallocate if necessary */
 				i = svf_para.hdr_para.len + svf_para.sdr_para.len +
 						svf_para.tdr_para.len;
-				if ((svf_buffer_size - svf_buffer_index) < ((i + 7) >> 3)) {
+				if ((svf_buffer_size - svf_buffer_index) < (size_t)((i + 7) >> 3)) {
 					/* reallocate buffer */
 					if (svf_realloc_buffers(svf_buffer_index + ((i + 7) >> 3)) != ERROR_OK) {
 						LOG_ERROR("not enough memory");
@@ -1215,7 +1568,7 @@ XXR_common:
 				/* check buffer size first, reallocate if necessary */
 				i = svf_para.hir_para.len + svf_para.sir_para.len +
 						svf_para.tir_para.len;
-				if ((svf_buffer_size - svf_buffer_index) < ((i + 7) >> 3)) {
+				if ((svf_buffer_size - svf_buffer_index) < (size_t)((i + 7) >> 3)) {
 					if (svf_realloc_buffers(svf_buffer_index + ((i + 7) >> 3)) != ERROR_OK) {
 						LOG_ERROR("not enough memory");
 						return ERROR_FAIL;
@@ -1553,7 +1906,7 @@ XXR_common:
 	} else {
 		/* for fast executing, execute tap if necessary */
 		/* half of the buffer is for the next command */
-		if (((svf_buffer_index >= SVF_MAX_BUFFER_SIZE_TO_COMMIT) ||
+		if (((svf_buffer_index >= (size_t)svf_commit_size) ||
 				(svf_check_tdo_para_index >= SVF_CHECK_TDO_PARA_SIZE / 2)) && \
 				(((command != STATE) && (command != RUNTEST)) || \
 						((command == STATE) && (num_of_argu == 2))))
@@ -1569,7 +1922,8 @@ static const struct command_registration svf_command_handlers[] = {
 		.handler = handle_svf_command,
 		.mode = COMMAND_EXEC,
 		.help = "Runs a SVF file.",
-		.usage = "svf [-tap device.tap] <file> [quiet] [nil] [progress] [ignore_error]",
+		.usage = "svf [-tap device.tap] <file> [quiet] [nil] [progress] [ignore_error] [cache] "
+			"[-buffersize <bytes>] [-statinterval <seconds>]",
 	},
 	COMMAND_REGISTRATION_DONE
 };
@@ -0,0 +1,693 @@
+/***************************************************************************
+ *   Copyright (C) 2015 by Oleksij Rempel                                  *
+ *   linux@rempel-privat.de                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ ***************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "jtag/interface.h"
+#include "arm.h"
+#include "armv7a.h"
+#include "armv7a_cache.h"
+#include <helper/time_support.h>
+#include "arm_opcodes.h"
+#include "algorithm.h"
+
+/* Ranges at least this large are maintained by a small routine running on
+ * the target instead of one DPM round trip per cache line; the download
+ * and algorithm setup cost a few dozen target accesses, a line operation
+ * costs at least one. */
+#define ARMV7A_CACHE_ALGO_MIN_SIZE	4096
+
+static int armv7a_l1_d_cache_sanity_check(struct target *target)
+{
+	struct armv7a_common *armv7a = target_to_armv7a(target);
+
+	if (target->state != TARGET_HALTED) {
+		LOG_ERROR("%s: target not halted", __func__);
+		return ERROR_TARGET_NOT_HALTED;
+	}
+
+	/*  check that cache data is on at target halt */
+	if (!armv7a->armv7a_mmu.armv7a_cache.d_u_cache_enabled) {
+		LOG_DEBUG("data cache is not enabled");
+		return ERROR_TARGET_INVALID;
+	}
+
+	return ERROR_OK;
+}
+
+static int armv7a_l1_i_cache_sanity_check(struct target *target)
+{
+	struct armv7a_common *armv7a = target_to_armv7a(target);
+
+	if (target->state != TARGET_HALTED) {
+		LOG_ERROR("%s: target not halted", __func__);
+		return ERROR_TARGET_NOT_HALTED;
+	}
+
+	/*  check that cache data is on at target halt */
+	if (!armv7a->armv7a_mmu.armv7a_cache.i_cache_enabled) {
+		LOG_DEBUG("instruction cache is not enabled");
+		return ERROR_TARGET_INVALID;
+	}
+
+	return ERROR_OK;
+}
+
+static int armv7a_l1_d_cache_flush_level(struct arm_dpm *dpm, struct armv7a_cachesize *size, int cl)
+{
+	int retval = ERROR_OK;
+	int32_t c_way, c_index = size->index;
+
+	LOG_DEBUG("cl %" PRId32, cl);
+	do {
+		c_way = size->way;
+		do {
+			uint32_t value = (c_index << size->index_shift)
+				| (c_way << size->way_shift) | (cl << 1);
+			/*
+			 * DCCISW - Clean and invalidate data cache
+			 * line by Set/Way.
+			 */
+			retval = dpm->instr_write_data_r0(dpm,
+					ARMV4_5_MCR(15, 0, 0, 7, 14, 2),
+					value);
+			if (retval != ERROR_OK)
+				goto done;
+			c_way -= 1;
+		} while (c_way >= 0);
+		c_index -= 1;
+	} while (c_index >= 0);
+
+ done:
+	return retval;
+}
+
+static int armv7a_l1_d_cache_clean_inval_all(struct target *target)
+{
+	struct armv7a_common *armv7a = target_to_armv7a(target);
+	struct armv7a_cache_common *cache = &(armv7a->armv7a_mmu.armv7a_cache);
+	struct arm_dpm *dpm = armv7a->arm.dpm;
+	int cl;
+	int retval;
+
+	retval = armv7a_l1_d_cache_sanity_check(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	retval = dpm->prepare(dpm);
+	if (retval != ERROR_OK)
+		goto done;
+
+	for (cl = 0; cl < cache->loc; cl++) {
+		/* skip i-only caches */
+		if (cache->arch[cl].ctype < CACHE_LEVEL_HAS_D_CACHE)
+			continue;
+
+		armv7a_l1_d_cache_flush_level(dpm, &cache->arch[cl].d_u_size, cl);
+	}
+
+	retval = dpm->finish(dpm);
+	return retval;
+
+done:
+	LOG_ERROR("clean invalidate failed");
+	dpm->finish(dpm);
+
+	return retval;
+}
+
+int armv7a_cache_auto_flush_all_data(struct target *target)
+{
+	int retval = ERROR_FAIL;
+	struct armv7a_common *armv7a = target_to_armv7a(target);
+
+	if (!armv7a->armv7a_mmu.armv7a_cache.auto_cache_enabled)
+		return ERROR_OK;
+
+	if (target->smp) {
+		struct target_list *head;
+		struct target *curr;
+		head = target->head;
+		while (head != (struct target_list *)NULL) {
+			curr = head->target;
+			if (curr->state == TARGET_HALTED)
+				retval = armv7a_l1_d_cache_clean_inval_all(curr);
+
+			head = head->next;
+		}
+	} else
+		retval = armv7a_l1_d_cache_clean_inval_all(target);
+
+	/* do outer cache flushing after inner caches have been flushed */
+	retval = arm7a_l2x_flush_all_data(target);
+
+	return retval;
+}
+
+
+/* Run one cache maintenance operation per line over [va_line, va_end)
+ * on the target itself.  \p op is the MCR opcode for the by-MVA
+ * maintenance operation, executed with the line address in r0.
+ */
+static int armv7a_l1_d_cache_range_algo(struct target *target, uint32_t op,
+	uint32_t va_line, uint32_t va_end, uint32_t linelen)
+{
+	uint32_t code[] = {
+		op,		/* loop: mcr (by MVA, r0) */
+		0xe0800002,	/* add r0, r0, r2 */
+		0xe1500001,	/* cmp r0, r1 */
+		0x3afffffb,	/* blo loop */
+		0xf57ff04f,	/* dsb sy */
+		ARMV5_BKPT(0),
+	};
+	uint8_t code_buf[sizeof(code)];
+	struct working_area *algo;
+	struct reg_param reg_params[3];
+	struct arm_algorithm arm_algo;
+	int retval;
+
+	arm_algo.common_magic = ARM_COMMON_MAGIC;
+	arm_algo.core_mode = ARM_MODE_SVC;
+	arm_algo.core_state = ARM_STATE_ARM;
+
+	retval = target_alloc_working_area(target, sizeof(code), &algo);
+	if (retval != ERROR_OK)
+		return retval;
+
+	target_buffer_set_u32_array(target, code_buf, ARRAY_SIZE(code), code);
+	retval = target_write_buffer(target, algo->address,
+			sizeof(code_buf), code_buf);
+	if (retval != ERROR_OK)
+		goto cleanup;
+
+	init_reg_param(&reg_params[0], "r0", 32, PARAM_OUT);
+	init_reg_param(&reg_params[1], "r1", 32, PARAM_OUT);
+	init_reg_param(&reg_params[2], "r2", 32, PARAM_OUT);
+	buf_set_u32(reg_params[0].value, 0, 32, va_line);
+	buf_set_u32(reg_params[1].value, 0, 32, va_end);
+	buf_set_u32(reg_params[2].value, 0, 32, linelen);
+
+	retval = target_run_algorithm(target, 0, NULL,
+			ARRAY_SIZE(reg_params), reg_params,
+			algo->address,
+			algo->address + sizeof(code) - 4,
+			10000, &arm_algo);
+
+	destroy_reg_param(&reg_params[0]);
+	destroy_reg_param(&reg_params[1]);
+	destroy_reg_param(&reg_params[2]);
+
+cleanup:
+	target_free_working_area(target, algo);
+	return retval;
+}
+
+int armv7a_l1_d_cache_inval_virt(struct target *target, uint32_t virt,
+					uint32_t size)
+{
+	struct armv7a_common *armv7a = target_to_armv7a(target);
+	struct arm_dpm *dpm = armv7a->arm.dpm;
+	struct armv7a_cache_common *armv7a_cache = &armv7a->armv7a_mmu.armv7a_cache;
+	uint32_t linelen = armv7a_cache->dminline;
+	uint32_t va_line, va_end;
+	int retval;
+
+	retval = armv7a_l1_d_cache_sanity_check(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	retval = dpm->prepare(dpm);
+	if (retval != ERROR_OK)
+		goto done;
+
+	va_line = virt & (-linelen);
+	va_end = virt + size;
+
+	/* handle unaligned start */
+	if (virt != va_line) {
+		/* DCCIMVAC */
+		retval = dpm->instr_write_data_r0(dpm,
+				ARMV4_5_MCR(15, 0, 0, 7, 14, 1), va_line);
+		if (retval != ERROR_OK)
+			goto done;
+		va_line += linelen;
+	}
+
+	/* handle unaligned end */
+	if ((va_end & (linelen-1)) != 0) {
+		va_end &= (-linelen);
+		/* DCCIMVAC */
+		retval = dpm->instr_write_data_r0(dpm,
+				ARMV4_5_MCR(15, 0, 0, 7, 14, 1), va_end);
+		if (retval != ERROR_OK)
+			goto done;
+	}
+
+	while (va_line < va_end) {
+		/* DCIMVAC - Invalidate data cache line by VA to PoC. */
+		retval = dpm->instr_write_data_r0(dpm,
+				ARMV4_5_MCR(15, 0, 0, 7, 6, 1), va_line);
+		if (retval != ERROR_OK)
+			goto done;
+		va_line += linelen;
+	}
+
+	dpm->finish(dpm);
+	return retval;
+
+done:
+	LOG_ERROR("d-cache invalidate failed");
+	dpm->finish(dpm);
+
+	return retval;
+}
+
+int armv7a_l1_d_cache_clean_virt(struct target *target, uint32_t virt,
+					unsigned int size)
+{
+	struct armv7a_common *armv7a = target_to_armv7a(target);
+	struct arm_dpm *dpm = armv7a->arm.dpm;
+	struct armv7a_cache_common *armv7a_cache = &armv7a->armv7a_mmu.armv7a_cache;
+	uint32_t linelen = armv7a_cache->dminline;
+	uint32_t va_line, va_end;
+	int retval;
+
+	retval = armv7a_l1_d_cache_sanity_check(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	va_line = virt & (-linelen);
+	va_end = virt + size;
+
+	/* try to run the loop on the target for larger ranges */
+	if (size >= ARMV7A_CACHE_ALGO_MIN_SIZE) {
+		/* DCCMVAC - Data Cache Clean by MVA to PoC */
+		retval = armv7a_l1_d_cache_range_algo(target,
+				ARMV4_5_MCR(15, 0, 0, 7, 10, 1),
+				va_line, va_end, linelen);
+		if (retval == ERROR_OK)
+			return retval;
+		LOG_DEBUG("on-target d-cache clean failed, using line-by-line");
+	}
+
+	retval = dpm->prepare(dpm);
+	if (retval != ERROR_OK)
+		goto done;
+
+	while (va_line < va_end) {
+		/* DCCMVAC - Data Cache Clean by MVA to PoC */
+		retval = dpm->instr_write_data_r0(dpm,
+				ARMV4_5_MCR(15, 0, 0, 7, 10, 1), va_line);
+		if (retval != ERROR_OK)
+			goto done;
+		va_line += linelen;
+	}
+
+	dpm->finish(dpm);
+	return retval;
+
+done:
+	LOG_ERROR("d-cache invalidate failed");
+	dpm->finish(dpm);
+
+	return retval;
+}
+
+int armv7a_l1_d_cache_flush_virt(struct target *target, uint32_t virt,
+					unsigned int size)
+{
+	struct armv7a_common *armv7a = target_to_armv7a(target);
+	struct arm_dpm *dpm = armv7a->arm.dpm;
+	struct armv7a_cache_common *armv7a_cache = &armv7a->armv7a_mmu.armv7a_cache;
+	uint32_t linelen = armv7a_cache->dminline;
+	uint32_t va_line, va_end;
+	int retval;
+
+	retval = armv7a_l1_d_cache_sanity_check(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	va_line = virt & (-linelen);
+	va_end = virt + size;
+
+	/* try to run the loop on the target for larger ranges */
+	if (size >= ARMV7A_CACHE_ALGO_MIN_SIZE) {
+		/* DCCIMVAC */
+		retval = armv7a_l1_d_cache_range_algo(target,
+				ARMV4_5_MCR(15, 0, 0, 7, 14, 1),
+				va_line, va_end, linelen);
+		if (retval == ERROR_OK)
+			return retval;
+		LOG_DEBUG("on-target d-cache flush failed, using line-by-line");
+	}
+
+	retval = dpm->prepare(dpm);
+	if (retval != ERROR_OK)
+		goto done;
+
+	while (va_line < va_end) {
+		/* DCCIMVAC */
+		retval = dpm->instr_write_data_r0(dpm,
+				ARMV4_5_MCR(15, 0, 0, 7, 14, 1), va_line);
+		if (retval != ERROR_OK)
+			goto done;
+		va_line += linelen;
+	}
+
+	dpm->finish(dpm);
+	return retval;
+
+done:
+	LOG_ERROR("d-cache invalidate failed");
+	dpm->finish(dpm);
+
+	return retval;
+}
+
+int armv7a_l1_i_cache_inval_all(struct target *target)
+{
+	struct armv7a_common *armv7a = target_to_armv7a(target);
+	struct arm_dpm *dpm = armv7a->arm.dpm;
+	int retval;
+
+	retval = armv7a_l1_i_cache_sanity_check(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	retval = dpm->prepare(dpm);
+	if (retval != ERROR_OK)
+		goto done;
+
+	if (target->smp) {
+		/* ICIALLUIS */
+		retval = dpm->instr_write_data_r0(dpm,
+				ARMV4_5_MCR(15, 0, 0, 7, 1, 0), 0);
+	} else {
+		/* ICIALLU */
+		retval = dpm->instr_write_data_r0(dpm,
+				ARMV4_5_MCR(15, 0, 0, 7, 5, 0), 0);
+	}
+
+	if (retval != ERROR_OK)
+		goto done;
+
+	dpm->finish(dpm);
+	return retval;
+
+done:
+	LOG_ERROR("i-cache invalidate failed");
+	dpm->finish(dpm);
+
+	return retval;
+}
+
+int armv7a_l1_i_cache_inval_virt(struct target *target, uint32_t virt,
+					uint32_t size)
+{
+	struct armv7a_common *armv7a = target_to_armv7a(target);
+	struct arm_dpm *dpm = armv7a->arm.dpm;
+	struct armv7a_cache_common *armv7a_cache =
+				&armv7a->armv7a_mmu.armv7a_cache;
+	uint32_t linelen = armv7a_cache->iminline;
+	uint32_t va_line, va_end;
+	int retval;
+
+	retval = armv7a_l1_i_cache_sanity_check(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	retval = dpm->prepare(dpm);
+	if (retval != ERROR_OK)
+		goto done;
+
+	va_line = virt & (-linelen);
+	va_end = virt + size;
+
+	while (va_line < va_end) {
+		/* ICIMVAU - Invalidate instruction cache by VA to PoU. */
+		retval = dpm->instr_write_data_r0(dpm,
+				ARMV4_5_MCR(15, 0, 0, 7, 5, 1), va_line);
+		if (retval != ERROR_OK)
+			goto done;
+		/* BPIMVA */
+		retval = dpm->instr_write_data_r0(dpm,
+				ARMV4_5_MCR(15, 0, 0, 7, 5, 7), va_line);
+		if (retval != ERROR_OK)
+			goto done;
+		va_line += linelen;
+	}
+	return retval;
+
+done:
+	LOG_ERROR("i-cache invalidate failed");
+	dpm->finish(dpm);
+
+	return retval;
+}
+
+int armv7a_cache_flush_virt(struct target *target, uint32_t virt,
+				uint32_t size)
+{
+	armv7a_l1_d_cache_flush_virt(target, virt, size);
+	armv7a_l2x_cache_flush_virt(target, virt, size);
+
+	return ERROR_OK;
+}
+
+/*
+ * We assume that target core was chosen correctly. It means if same data
+ * was handled by two cores, other core will loose the changes. Since it
+ * is impossible to know (FIXME) which core has correct data, keep in mind
+ * that some kind of data lost or korruption is possible.
+ * Possible scenario:
+ *  - core1 loaded and changed data on 0x12345678
+ *  - we halted target and modified same data on core0
+ *  - data on core1 will be lost.
+ */
+int armv7a_cache_auto_flush_on_write(struct target *target, uint32_t virt,
+					uint32_t size)
+{
+	struct armv7a_common *armv7a = target_to_armv7a(target);
+
+	if (!armv7a->armv7a_mmu.armv7a_cache.auto_cache_enabled)
+		return ERROR_OK;
+
+	return armv7a_cache_flush_virt(target, virt, size);
+}
+
+COMMAND_HANDLER(arm7a_l1_cache_info_cmd)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	struct armv7a_common *armv7a = target_to_armv7a(target);
+
+	return armv7a_handle_cache_info_command(CMD_CTX,
+			&armv7a->armv7a_mmu.armv7a_cache);
+}
+
+COMMAND_HANDLER(armv7a_l1_d_cache_clean_inval_all_cmd)
+{
+	struct target *target = get_current_target(CMD_CTX);
+
+	armv7a_l1_d_cache_clean_inval_all(target);
+
+	return 0;
+}
+
+COMMAND_HANDLER(arm7a_l1_d_cache_inval_virt_cmd)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	uint32_t virt, size;
+
+	if (CMD_ARGC == 0 || CMD_ARGC > 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC == 2)
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], size);
+	else
+		size = 1;
+
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], virt);
+
+	return armv7a_l1_d_cache_inval_virt(target, virt, size);
+}
+
+COMMAND_HANDLER(arm7a_l1_d_cache_clean_virt_cmd)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	uint32_t virt, size;
+
+	if (CMD_ARGC == 0 || CMD_ARGC > 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC == 2)
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], size);
+	else
+		size = 1;
+
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], virt);
+
+	return armv7a_l1_d_cache_clean_virt(target, virt, size);
+}
+
+COMMAND_HANDLER(armv7a_i_cache_clean_inval_all_cmd)
+{
+	struct target *target = get_current_target(CMD_CTX);
+
+	armv7a_l1_i_cache_inval_all(target);
+
+	return 0;
+}
+
+COMMAND_HANDLER(arm7a_l1_i_cache_inval_virt_cmd)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	uint32_t virt, size;
+
+	if (CMD_ARGC == 0 || CMD_ARGC > 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC == 2)
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], size);
+	else
+		size = 1;
+
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], virt);
+
+	return armv7a_l1_i_cache_inval_virt(target, virt, size);
+}
+
+COMMAND_HANDLER(arm7a_cache_disable_auto_cmd)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	struct armv7a_common *armv7a = target_to_armv7a(target);
+
+	if (CMD_ARGC == 0) {
+		command_print(CMD_CTX, "auto cache is %s",
+			armv7a->armv7a_mmu.armv7a_cache.auto_cache_enabled ? "enabled" : "disabled");
+		return ERROR_OK;
+	}
+
+	if (CMD_ARGC == 1) {
+		uint32_t set;
+
+		COMMAND_PARSE_ENABLE(CMD_ARGV[0], set);
+		armv7a->armv7a_mmu.armv7a_cache.auto_cache_enabled = !!set;
+		return ERROR_OK;
+	}
+
+	return ERROR_COMMAND_SYNTAX_ERROR;
+}
+
+static const struct command_registration arm7a_l1_d_cache_commands[] = {
+	{
+		.name = "flush_all",
+		.handler = armv7a_l1_d_cache_clean_inval_all_cmd,
+		.mode = COMMAND_ANY,
+		.help = "flush (clean and invalidate) complete l1 d-cache",
+		.usage = "",
+	},
+	{
+		.name = "inval",
+		.handler = arm7a_l1_d_cache_inval_virt_cmd,
+		.mode = COMMAND_ANY,
+		.help = "invalidate l1 d-cache by virtual address offset and range size",
+		.usage = "<virt_addr> [size]",
+	},
+	{
+		.name = "clean",
+		.handler = arm7a_l1_d_cache_clean_virt_cmd,
+		.mode = COMMAND_ANY,
+		.help = "clean l1 d-cache by virtual address address offset and range size",
+		.usage = "<virt_addr> [size]",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+static const struct command_registration arm7a_l1_i_cache_commands[] = {
+	{
+		.name = "inval_all",
+		.handler = armv7a_i_cache_clean_inval_all_cmd,
+		.mode = COMMAND_ANY,
+		.help = "invalidate complete l1 i-cache",
+		.usage = "",
+	},
+	{
+		.name = "inval",
+		.handler = arm7a_l1_i_cache_inval_virt_cmd,
+		.mode = COMMAND_ANY,
+		.help = "invalidate l1 i-cache by virtual address offset and range size",
+		.usage = "<virt_addr> [size]",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+const struct command_registration arm7a_l1_di_cache_group_handlers[] = {
+	{
+		.name = "info",
+		.handler = arm7a_l1_cache_info_cmd,
+		.mode = COMMAND_ANY,
+		.help = "print cache realted information",
+		.usage = "",
+	},
+	{
+		.name = "d",
+		.mode = COMMAND_ANY,
+		.help = "l1 d-cache command group",
+		.usage = "",
+		.chain = arm7a_l1_d_cache_commands,
+	},
+	{
+		.name = "i",
+		.mode = COMMAND_ANY,
+		.help = "l1 i-cache command group",
+		.usage = "",
+		.chain = arm7a_l1_i_cache_commands,
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+const struct command_registration arm7a_cache_group_handlers[] = {
+	{
+		.name = "auto",
+		.handler = arm7a_cache_disable_auto_cmd,
+		.mode = COMMAND_ANY,
+		.help = "disable or enable automatic cache handling.",
+		.usage = "(1|0)",
+	},
+	{
+		.name = "l1",
+		.mode = COMMAND_ANY,
+		.help = "l1 cache command group",
+		.usage = "",
+		.chain = arm7a_l1_di_cache_group_handlers,
+	},
+	{
+		.chain = arm7a_l2x_cache_command_handler,
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+const struct command_registration arm7a_cache_command_handlers[] = {
+	{
+		.name = "cache",
+		.mode = COMMAND_ANY,
+		.help = "cache command group",
+		.usage = "",
+		.chain = arm7a_cache_group_handlers,
+	},
+	COMMAND_REGISTRATION_DONE
+};
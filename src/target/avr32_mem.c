@@ -0,0 +1,369 @@
+/***************************************************************************
+ *   Copyright (C) 2010 by Oleksandr Tymoshenko <gonzo@bluezbox.com>       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.           *
+ ***************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "target.h"
+#include "jtag/jtag.h"
+#include "avr32_jtag.h"
+#include "avr32_mem.h"
+
+int avr32_jtag_read_memory32(struct avr32_jtag *jtag_info,
+	uint32_t addr, int count, uint32_t *buffer)
+{
+	int i, retval;
+
+	retval = avr32_jtag_mwa_read_block(jtag_info, SLAVE_HSB_UNCACHED,
+			addr, count, buffer);
+
+	if (retval != ERROR_OK)
+		return retval;
+
+	/* XXX: Assume AVR32 is BE */
+	for (i = 0; i < count; i++)
+		buffer[i] = be_to_h_u32((uint8_t *)&buffer[i]);
+
+	return ERROR_OK;
+}
+
+int avr32_jtag_read_memory16(struct avr32_jtag *jtag_info,
+	uint32_t addr, int count, uint16_t *buffer)
+{
+	int i, n, nwords, retval;
+	uint32_t data;
+	uint32_t *word_buf;
+
+	i = 0;
+
+	/* any unaligned half-words? */
+	if (addr & 3) {
+		retval = avr32_jtag_mwa_read(jtag_info, SLAVE_HSB_UNCACHED,
+				addr + i*2, &data);
+
+		if (retval != ERROR_OK)
+			return retval;
+
+		/* XXX: Assume AVR32 is BE */
+		data = be_to_h_u32((uint8_t *)&data);
+		buffer[i] = (data >> 16) & 0xffff;
+		i++;
+	}
+
+	/* read all complete words */
+	nwords = ((count & ~1) - i) / 2;
+	if (nwords > 0) {
+		word_buf = malloc(nwords * sizeof(uint32_t));
+		if (word_buf == NULL)
+			return ERROR_FAIL;
+
+		retval = avr32_jtag_mwa_read_block(jtag_info, SLAVE_HSB_UNCACHED,
+				addr + i*2, nwords, word_buf);
+
+		if (retval != ERROR_OK) {
+			free(word_buf);
+			return retval;
+		}
+
+		for (n = 0; n < nwords; n++, i += 2) {
+			/* XXX: Assume AVR32 is BE */
+			data = be_to_h_u32((uint8_t *)&word_buf[n]);
+			buffer[i] = data & 0xffff;
+			buffer[i+1] = (data >> 16) & 0xffff;
+		}
+
+		free(word_buf);
+	}
+
+	/* last halfword */
+	if (i < count) {
+		retval = avr32_jtag_mwa_read(jtag_info, SLAVE_HSB_UNCACHED,
+				addr + i*2, &data);
+
+		if (retval != ERROR_OK)
+			return retval;
+
+		/* XXX: Assume AVR32 is BE */
+		data = be_to_h_u32((uint8_t *)&data);
+		buffer[i] = data & 0xffff;
+	}
+
+	return ERROR_OK;
+}
+
+int avr32_jtag_read_memory8(struct avr32_jtag *jtag_info,
+	uint32_t addr, int count, uint8_t *buffer)
+{
+	int i, j, n, nwords, retval;
+	uint8_t data[4];
+	uint32_t *word_buf;
+
+	i = 0;
+
+	/* Do we have non-aligned bytes? */
+	if (addr & 3) {
+		retval = avr32_jtag_mwa_read(jtag_info, SLAVE_HSB_UNCACHED,
+				addr + i, (uint32_t *)(void *)data);
+
+		if (retval != ERROR_OK)
+			return retval;
+
+		for (j = addr & 3; (j < 4) && (i < count); j++, i++)
+			buffer[i] = data[3-j];
+	}
+
+	/* read all complete words */
+	nwords = ((count & ~3) - i) / 4;
+	if (nwords > 0) {
+		word_buf = malloc(nwords * sizeof(uint32_t));
+		if (word_buf == NULL)
+			return ERROR_FAIL;
+
+		retval = avr32_jtag_mwa_read_block(jtag_info, SLAVE_HSB_UNCACHED,
+				addr + i, nwords, word_buf);
+
+		if (retval != ERROR_OK) {
+			free(word_buf);
+			return retval;
+		}
+
+		for (n = 0; n < nwords; n++, i += 4) {
+			memcpy(data, &word_buf[n], 4);
+			for (j = 0; j < 4; j++)
+				buffer[i+j] = data[3-j];
+		}
+
+		free(word_buf);
+	}
+
+	/* remaining bytes */
+	if (i < count) {
+		retval = avr32_jtag_mwa_read(jtag_info, SLAVE_HSB_UNCACHED,
+				addr + i, (uint32_t *)(void *)data);
+
+		if (retval != ERROR_OK)
+			return retval;
+
+		for (j = 0; i + j < count; j++)
+			buffer[i+j] = data[3-j];
+	}
+
+	return ERROR_OK;
+}
+
+int avr32_jtag_write_memory32(struct avr32_jtag *jtag_info,
+	uint32_t addr, int count, const uint32_t *buffer)
+{
+	int i, retval;
+	uint32_t *word_buf;
+
+	word_buf = malloc(count * sizeof(uint32_t));
+	if (word_buf == NULL)
+		return ERROR_FAIL;
+
+	/* XXX: Assume AVR32 is BE */
+	for (i = 0; i < count; i++)
+		h_u32_to_be((uint8_t *)&word_buf[i], buffer[i]);
+
+	retval = avr32_jtag_mwa_write_block(jtag_info, SLAVE_HSB_UNCACHED,
+			addr, count, word_buf);
+
+	free(word_buf);
+
+	return retval;
+}
+
+int avr32_jtag_write_memory16(struct avr32_jtag *jtag_info,
+	uint32_t addr, int count, const uint16_t *buffer)
+{
+	int i, n, nwords, retval;
+	uint32_t data;
+	uint32_t data_out;
+	uint32_t *word_buf;
+
+	i = 0;
+
+	/*
+	 * Do we have any non-aligned half-words?
+	 */
+	if (addr & 3) {
+		/*
+		 * mwa_read will read whole world, no nead to fiddle
+		 * with address. It will be truncated in set_addr
+		 */
+		retval = avr32_jtag_mwa_read(jtag_info, SLAVE_HSB_UNCACHED,
+				addr, &data);
+
+		if (retval != ERROR_OK)
+			return retval;
+
+		data = be_to_h_u32((uint8_t *)&data);
+		data = (buffer[i] << 16) | (data & 0xffff);
+		h_u32_to_be((uint8_t *)&data_out, data);
+
+		retval = avr32_jtag_mwa_write(jtag_info, SLAVE_HSB_UNCACHED,
+				addr, data_out);
+
+		if (retval != ERROR_OK)
+			return retval;
+
+		i++;
+	}
+
+	/* write all complete words */
+	nwords = ((count & ~1) - i) / 2;
+	if (nwords > 0) {
+		word_buf = malloc(nwords * sizeof(uint32_t));
+		if (word_buf == NULL)
+			return ERROR_FAIL;
+
+		for (n = 0; n < nwords; n++) {
+			/* XXX: Assume AVR32 is BE */
+			data = (buffer[i + n*2 + 1] << 16) | buffer[i + n*2];
+			h_u32_to_be((uint8_t *)&word_buf[n], data);
+		}
+
+		retval = avr32_jtag_mwa_write_block(jtag_info, SLAVE_HSB_UNCACHED,
+				addr + i*2, nwords, word_buf);
+
+		free(word_buf);
+
+		if (retval != ERROR_OK)
+			return retval;
+
+		i += nwords * 2;
+	}
+
+	/* last halfword */
+	if (i < count) {
+		retval = avr32_jtag_mwa_read(jtag_info, SLAVE_HSB_UNCACHED,
+				addr + i*2, &data);
+
+		if (retval != ERROR_OK)
+			return retval;
+
+		data = be_to_h_u32((uint8_t *)&data);
+		data &= ~0xffff;
+		data |= buffer[i];
+		h_u32_to_be((uint8_t *)&data_out, data);
+
+		retval = avr32_jtag_mwa_write(jtag_info, SLAVE_HSB_UNCACHED,
+				addr + i*2, data_out);
+
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	return ERROR_OK;
+}
+
+int avr32_jtag_write_memory8(struct avr32_jtag *jtag_info,
+	uint32_t addr, int count, const uint8_t *buffer)
+{
+	int i, j, n, nwords, retval;
+	uint32_t data;
+	uint32_t data_out;
+	uint32_t *word_buf;
+
+	i = 0;
+
+	/*
+	 * Do we have any non-aligned bytes?
+	 */
+	if (addr & 3) {
+		/*
+		 * mwa_read will read whole world, no nead to fiddle
+		 * with address. It will be truncated in set_addr
+		 */
+		retval = avr32_jtag_mwa_read(jtag_info, SLAVE_HSB_UNCACHED,
+				addr, &data);
+
+		if (retval != ERROR_OK)
+			return retval;
+
+		data = be_to_h_u32((uint8_t *)&data);
+		for (j = addr & 3; (j < 4) && (i < count); j++, i++) {
+			data &= ~(0xff << j*8);
+			data |= (buffer[i] << j*8);
+		}
+
+		h_u32_to_be((uint8_t *)&data_out, data);
+		retval = avr32_jtag_mwa_write(jtag_info, SLAVE_HSB_UNCACHED,
+				addr, data_out);
+
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+
+	/* write all complete words */
+	nwords = ((count & ~3) - i) / 4;
+	if (nwords > 0) {
+		word_buf = malloc(nwords * sizeof(uint32_t));
+		if (word_buf == NULL)
+			return ERROR_FAIL;
+
+		for (n = 0; n < nwords; n++) {
+			data = 0;
+
+			for (j = 0; j < 4; j++)
+				data |= (buffer[n*4 + i + j] << j*8);
+
+			h_u32_to_be((uint8_t *)&word_buf[n], data);
+		}
+
+		retval = avr32_jtag_mwa_write_block(jtag_info, SLAVE_HSB_UNCACHED,
+				addr + i, nwords, word_buf);
+
+		free(word_buf);
+
+		if (retval != ERROR_OK)
+			return retval;
+
+		i += nwords * 4;
+	}
+
+	/*
+	 * Write trailing bytes
+	 */
+	if (i < count) {
+		retval = avr32_jtag_mwa_read(jtag_info, SLAVE_HSB_UNCACHED,
+				addr + i, &data);
+
+		if (retval != ERROR_OK)
+			return retval;
+
+		data = be_to_h_u32((uint8_t *)&data);
+		for (j = 0; i < count; j++, i++) {
+			data &= ~(0xff << j*8);
+			data |= (buffer[j+i] << j*8);
+		}
+
+		h_u32_to_be((uint8_t *)&data_out, data);
+
+		retval = avr32_jtag_mwa_write(jtag_info, SLAVE_HSB_UNCACHED,
+				addr+i, data_out);
+
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	return ERROR_OK;
+}
@@ -0,0 +1,7433 @@
+/***************************************************************************
+ *   Copyright (C) 2005 by Dominic Rath                                    *
+ *   Dominic.Rath@gmx.de                                                   *
+ *                                                                         *
+ *   Copyright (C) 2007-2010 Øyvind Harboe                                 *
+ *   oyvind.harboe@zylin.com                                               *
+ *                                                                         *
+ *   Copyright (C) 2008, Duane Ellis                                       *
+ *   openocd@duaneeellis.com                                               *
+ *                                                                         *
+ *   Copyright (C) 2008 by Spencer Oliver                                  *
+ *   spen@spen-soft.co.uk                                                  *
+ *                                                                         *
+ *   Copyright (C) 2008 by Rick Altherr                                    *
+ *   kc8apf@kc8apf.net>                                                    *
+ *                                                                         *
+ *   Copyright (C) 2011 by Broadcom Corporation                            *
+ *   Evan Hunter - ehunter@broadcom.com                                    *
+ *                                                                         *
+ *   Copyright (C) ST-Ericsson SA 2011                                     *
+ *   michel.jaouen@stericsson.com : smp minimum support                    *
+ *                                                                         *
+ *   Copyright (C) 2011 Andreas Fritiofson                                 *
+ *   andreas.fritiofson@gmail.com                                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.           *
+ ***************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <helper/time_support.h>
+#include <helper/binarytrace.h>
+#include <helper/profiling.h>
+#include <helper/progress.h>
+#include <jtag/jtag.h>
+#include <flash/nor/core.h>
+
+#include "target.h"
+#include "target_type.h"
+#include "target_request.h"
+#include "breakpoints.h"
+#include "register.h"
+#include "trace.h"
+#include "image.h"
+#include "rtos/rtos.h"
+#include "transport/transport.h"
+
+/* default halt wait timeout (ms) */
+#define DEFAULT_HALT_TIMEOUT 5000
+
+static int target_read_buffer_default(struct target *target, uint32_t address,
+		uint32_t count, uint8_t *buffer);
+static int target_write_buffer_default(struct target *target, uint32_t address,
+		uint32_t count, const uint8_t *buffer);
+static int target_array2mem(Jim_Interp *interp, struct target *target,
+		int argc, Jim_Obj * const *argv);
+static int target_mem2array(Jim_Interp *interp, struct target *target,
+		int argc, Jim_Obj * const *argv);
+static int target_list2mem(Jim_Interp *interp, struct target *target,
+		int argc, Jim_Obj * const *argv);
+static int target_mem2list(Jim_Interp *interp, struct target *target,
+		int argc, Jim_Obj * const *argv);
+static int target_register_user_commands(struct command_context *cmd_ctx);
+static int target_get_gdb_fileio_info_default(struct target *target,
+		struct gdb_fileio_info *fileio_info);
+static int target_gdb_fileio_end_default(struct target *target, int retcode,
+		int fileio_errno, bool ctrl_c);
+static int target_profiling_default(struct target *target, uint32_t *samples,
+		uint32_t max_num_samples, uint32_t *num_samples, uint32_t seconds);
+static void target_algorithm_cache_invalidate(struct target *target,
+		uint32_t address, uint32_t size);
+
+/* targets */
+extern struct target_type arm7tdmi_target;
+extern struct target_type arm720t_target;
+extern struct target_type arm9tdmi_target;
+extern struct target_type arm920t_target;
+extern struct target_type arm966e_target;
+extern struct target_type arm946e_target;
+extern struct target_type arm926ejs_target;
+extern struct target_type fa526_target;
+extern struct target_type feroceon_target;
+extern struct target_type dragonite_target;
+extern struct target_type xscale_target;
+extern struct target_type cortexm_target;
+extern struct target_type cortexa_target;
+extern struct target_type cortexr4_target;
+extern struct target_type arm11_target;
+extern struct target_type mips_m4k_target;
+extern struct target_type avr_target;
+extern struct target_type dsp563xx_target;
+extern struct target_type dsp5680xx_target;
+extern struct target_type testee_target;
+extern struct target_type avr32_ap7k_target;
+extern struct target_type hla_target;
+extern struct target_type nds32_v2_target;
+extern struct target_type nds32_v3_target;
+extern struct target_type nds32_v3m_target;
+extern struct target_type or1k_target;
+extern struct target_type quark_x10xx_target;
+extern struct target_type quark_d20xx_target;
+
+static struct target_type *target_types[] = {
+	&arm7tdmi_target,
+	&arm9tdmi_target,
+	&arm920t_target,
+	&arm720t_target,
+	&arm966e_target,
+	&arm946e_target,
+	&arm926ejs_target,
+	&fa526_target,
+	&feroceon_target,
+	&dragonite_target,
+	&xscale_target,
+	&cortexm_target,
+	&cortexa_target,
+	&cortexr4_target,
+	&arm11_target,
+	&mips_m4k_target,
+	&avr_target,
+	&dsp563xx_target,
+	&dsp5680xx_target,
+	&testee_target,
+	&avr32_ap7k_target,
+	&hla_target,
+	&nds32_v2_target,
+	&nds32_v3_target,
+	&nds32_v3m_target,
+	&or1k_target,
+	&quark_x10xx_target,
+	&quark_d20xx_target,
+	NULL,
+};
+
+struct target *all_targets;
+static struct target_event_callback *target_event_callbacks;
+static struct target_timer_callback *target_timer_callbacks;
+LIST_HEAD(target_reset_callback_list);
+LIST_HEAD(target_trace_callback_list);
+static const int polling_interval = 100;
+/* bounds for the adaptive per-target poll interval: polling runs this fast
+ * right after a resume (to catch the halt quickly), and backs off this far
+ * while a target sits halted with nothing happening */
+static const int polling_interval_min = 25;
+static const int polling_interval_max = 800;
+
+static const Jim_Nvp nvp_assert[] = {
+	{ .name = "assert", NVP_ASSERT },
+	{ .name = "deassert", NVP_DEASSERT },
+	{ .name = "T", NVP_ASSERT },
+	{ .name = "F", NVP_DEASSERT },
+	{ .name = "t", NVP_ASSERT },
+	{ .name = "f", NVP_DEASSERT },
+	{ .name = NULL, .value = -1 }
+};
+
+static const Jim_Nvp nvp_error_target[] = {
+	{ .value = ERROR_TARGET_INVALID, .name = "err-invalid" },
+	{ .value = ERROR_TARGET_INIT_FAILED, .name = "err-init-failed" },
+	{ .value = ERROR_TARGET_TIMEOUT, .name = "err-timeout" },
+	{ .value = ERROR_TARGET_NOT_HALTED, .name = "err-not-halted" },
+	{ .value = ERROR_TARGET_FAILURE, .name = "err-failure" },
+	{ .value = ERROR_TARGET_UNALIGNED_ACCESS   , .name = "err-unaligned-access" },
+	{ .value = ERROR_TARGET_DATA_ABORT , .name = "err-data-abort" },
+	{ .value = ERROR_TARGET_RESOURCE_NOT_AVAILABLE , .name = "err-resource-not-available" },
+	{ .value = ERROR_TARGET_TRANSLATION_FAULT  , .name = "err-translation-fault" },
+	{ .value = ERROR_TARGET_NOT_RUNNING, .name = "err-not-running" },
+	{ .value = ERROR_TARGET_NOT_EXAMINED, .name = "err-not-examined" },
+	{ .value = -1, .name = NULL }
+};
+
+static const char *target_strerror_safe(int err)
+{
+	const Jim_Nvp *n;
+
+	n = Jim_Nvp_value2name_simple(nvp_error_target, err);
+	if (n->name == NULL)
+		return "unknown";
+	else
+		return n->name;
+}
+
+static const Jim_Nvp nvp_target_event[] = {
+
+	{ .value = TARGET_EVENT_GDB_HALT, .name = "gdb-halt" },
+	{ .value = TARGET_EVENT_HALTED, .name = "halted" },
+	{ .value = TARGET_EVENT_RESUMED, .name = "resumed" },
+	{ .value = TARGET_EVENT_RESUME_START, .name = "resume-start" },
+	{ .value = TARGET_EVENT_RESUME_END, .name = "resume-end" },
+
+	{ .name = "gdb-start", .value = TARGET_EVENT_GDB_START },
+	{ .name = "gdb-end", .value = TARGET_EVENT_GDB_END },
+
+	{ .value = TARGET_EVENT_RESET_START,         .name = "reset-start" },
+	{ .value = TARGET_EVENT_RESET_ASSERT_PRE,    .name = "reset-assert-pre" },
+	{ .value = TARGET_EVENT_RESET_ASSERT,        .name = "reset-assert" },
+	{ .value = TARGET_EVENT_RESET_ASSERT_POST,   .name = "reset-assert-post" },
+	{ .value = TARGET_EVENT_RESET_DEASSERT_PRE,  .name = "reset-deassert-pre" },
+	{ .value = TARGET_EVENT_RESET_DEASSERT_POST, .name = "reset-deassert-post" },
+	{ .value = TARGET_EVENT_RESET_HALT_PRE,      .name = "reset-halt-pre" },
+	{ .value = TARGET_EVENT_RESET_HALT_POST,     .name = "reset-halt-post" },
+	{ .value = TARGET_EVENT_RESET_WAIT_PRE,      .name = "reset-wait-pre" },
+	{ .value = TARGET_EVENT_RESET_WAIT_POST,     .name = "reset-wait-post" },
+	{ .value = TARGET_EVENT_RESET_INIT,          .name = "reset-init" },
+	{ .value = TARGET_EVENT_RESET_END,           .name = "reset-end" },
+
+	{ .value = TARGET_EVENT_EXAMINE_START, .name = "examine-start" },
+	{ .value = TARGET_EVENT_EXAMINE_END, .name = "examine-end" },
+
+	{ .value = TARGET_EVENT_DEBUG_HALTED, .name = "debug-halted" },
+	{ .value = TARGET_EVENT_DEBUG_RESUMED, .name = "debug-resumed" },
+
+	{ .value = TARGET_EVENT_GDB_ATTACH, .name = "gdb-attach" },
+	{ .value = TARGET_EVENT_GDB_DETACH, .name = "gdb-detach" },
+
+	{ .value = TARGET_EVENT_GDB_FLASH_WRITE_START, .name = "gdb-flash-write-start" },
+	{ .value = TARGET_EVENT_GDB_FLASH_WRITE_END  , .name = "gdb-flash-write-end"   },
+
+	{ .value = TARGET_EVENT_GDB_FLASH_ERASE_START, .name = "gdb-flash-erase-start" },
+	{ .value = TARGET_EVENT_GDB_FLASH_ERASE_END  , .name = "gdb-flash-erase-end" },
+
+	{ .value = TARGET_EVENT_TRACE_CONFIG, .name = "trace-config" },
+
+	{ .name = NULL, .value = -1 }
+};
+
+static const Jim_Nvp nvp_target_state[] = {
+	{ .name = "unknown", .value = TARGET_UNKNOWN },
+	{ .name = "running", .value = TARGET_RUNNING },
+	{ .name = "halted",  .value = TARGET_HALTED },
+	{ .name = "reset",   .value = TARGET_RESET },
+	{ .name = "debug-running", .value = TARGET_DEBUG_RUNNING },
+	{ .name = NULL, .value = -1 },
+};
+
+static const Jim_Nvp nvp_target_debug_reason[] = {
+	{ .name = "debug-request"            , .value = DBG_REASON_DBGRQ },
+	{ .name = "breakpoint"               , .value = DBG_REASON_BREAKPOINT },
+	{ .name = "watchpoint"               , .value = DBG_REASON_WATCHPOINT },
+	{ .name = "watchpoint-and-breakpoint", .value = DBG_REASON_WPTANDBKPT },
+	{ .name = "single-step"              , .value = DBG_REASON_SINGLESTEP },
+	{ .name = "target-not-halted"        , .value = DBG_REASON_NOTHALTED  },
+	{ .name = "program-exit"             , .value = DBG_REASON_EXIT },
+	{ .name = "undefined"                , .value = DBG_REASON_UNDEFINED },
+	{ .name = NULL, .value = -1 },
+};
+
+static const Jim_Nvp nvp_target_endian[] = {
+	{ .name = "big",    .value = TARGET_BIG_ENDIAN },
+	{ .name = "little", .value = TARGET_LITTLE_ENDIAN },
+	{ .name = "be",     .value = TARGET_BIG_ENDIAN },
+	{ .name = "le",     .value = TARGET_LITTLE_ENDIAN },
+	{ .name = NULL,     .value = -1 },
+};
+
+static const Jim_Nvp nvp_reset_modes[] = {
+	{ .name = "unknown", .value = RESET_UNKNOWN },
+	{ .name = "run"    , .value = RESET_RUN },
+	{ .name = "halt"   , .value = RESET_HALT },
+	{ .name = "init"   , .value = RESET_INIT },
+	{ .name = NULL     , .value = -1 },
+};
+
+const char *debug_reason_name(struct target *t)
+{
+	const char *cp;
+
+	cp = Jim_Nvp_value2name_simple(nvp_target_debug_reason,
+			t->debug_reason)->name;
+	if (!cp) {
+		LOG_ERROR("Invalid debug reason: %d", (int)(t->debug_reason));
+		cp = "(*BUG*unknown*BUG*)";
+	}
+	return cp;
+}
+
+const char *target_state_name(struct target *t)
+{
+	const char *cp;
+	cp = Jim_Nvp_value2name_simple(nvp_target_state, t->state)->name;
+	if (!cp) {
+		LOG_ERROR("Invalid target state: %d", (int)(t->state));
+		cp = "(*BUG*unknown*BUG*)";
+	}
+	return cp;
+}
+
+const char *target_event_name(enum target_event event)
+{
+	const char *cp;
+	cp = Jim_Nvp_value2name_simple(nvp_target_event, event)->name;
+	if (!cp) {
+		LOG_ERROR("Invalid target event: %d", (int)(event));
+		cp = "(*BUG*unknown*BUG*)";
+	}
+	return cp;
+}
+
+int target_event_by_name(const char *name, enum target_event *event)
+{
+	const Jim_Nvp *n;
+	n = Jim_Nvp_name2value_simple(nvp_target_event, name);
+	if (!n->name)
+		return ERROR_FAIL;
+	*event = n->value;
+	return ERROR_OK;
+}
+
+const char *target_reset_mode_name(enum target_reset_mode reset_mode)
+{
+	const char *cp;
+	cp = Jim_Nvp_value2name_simple(nvp_reset_modes, reset_mode)->name;
+	if (!cp) {
+		LOG_ERROR("Invalid target reset mode: %d", (int)(reset_mode));
+		cp = "(*BUG*unknown*BUG*)";
+	}
+	return cp;
+}
+
+/* determine the number of the new target */
+static int new_target_number(void)
+{
+	struct target *t;
+	int x;
+
+	/* number is 0 based */
+	x = -1;
+	t = all_targets;
+	while (t) {
+		if (x < t->target_number)
+			x = t->target_number;
+		t = t->next;
+	}
+	return x + 1;
+}
+
+/* read a uint64_t from a buffer in target memory endianness */
+uint64_t target_buffer_get_u64(struct target *target, const uint8_t *buffer)
+{
+	if (target->endianness == TARGET_LITTLE_ENDIAN)
+		return le_to_h_u64(buffer);
+	else
+		return be_to_h_u64(buffer);
+}
+
+/* read a uint32_t from a buffer in target memory endianness */
+uint32_t target_buffer_get_u32(struct target *target, const uint8_t *buffer)
+{
+	if (target->endianness == TARGET_LITTLE_ENDIAN)
+		return le_to_h_u32(buffer);
+	else
+		return be_to_h_u32(buffer);
+}
+
+/* read a uint24_t from a buffer in target memory endianness */
+uint32_t target_buffer_get_u24(struct target *target, const uint8_t *buffer)
+{
+	if (target->endianness == TARGET_LITTLE_ENDIAN)
+		return le_to_h_u24(buffer);
+	else
+		return be_to_h_u24(buffer);
+}
+
+/* read a uint16_t from a buffer in target memory endianness */
+uint16_t target_buffer_get_u16(struct target *target, const uint8_t *buffer)
+{
+	if (target->endianness == TARGET_LITTLE_ENDIAN)
+		return le_to_h_u16(buffer);
+	else
+		return be_to_h_u16(buffer);
+}
+
+/* read a uint8_t from a buffer in target memory endianness */
+static uint8_t target_buffer_get_u8(struct target *target, const uint8_t *buffer)
+{
+	return *buffer & 0x0ff;
+}
+
+/* write a uint64_t to a buffer in target memory endianness */
+void target_buffer_set_u64(struct target *target, uint8_t *buffer, uint64_t value)
+{
+	if (target->endianness == TARGET_LITTLE_ENDIAN)
+		h_u64_to_le(buffer, value);
+	else
+		h_u64_to_be(buffer, value);
+}
+
+/* write a uint32_t to a buffer in target memory endianness */
+void target_buffer_set_u32(struct target *target, uint8_t *buffer, uint32_t value)
+{
+	if (target->endianness == TARGET_LITTLE_ENDIAN)
+		h_u32_to_le(buffer, value);
+	else
+		h_u32_to_be(buffer, value);
+}
+
+/* write a uint24_t to a buffer in target memory endianness */
+void target_buffer_set_u24(struct target *target, uint8_t *buffer, uint32_t value)
+{
+	if (target->endianness == TARGET_LITTLE_ENDIAN)
+		h_u24_to_le(buffer, value);
+	else
+		h_u24_to_be(buffer, value);
+}
+
+/* write a uint16_t to a buffer in target memory endianness */
+void target_buffer_set_u16(struct target *target, uint8_t *buffer, uint16_t value)
+{
+	if (target->endianness == TARGET_LITTLE_ENDIAN)
+		h_u16_to_le(buffer, value);
+	else
+		h_u16_to_be(buffer, value);
+}
+
+/* write a uint8_t to a buffer in target memory endianness */
+static void target_buffer_set_u8(struct target *target, uint8_t *buffer, uint8_t value)
+{
+	*buffer = value;
+}
+
+/* write a uint64_t array to a buffer in target memory endianness */
+void target_buffer_get_u64_array(struct target *target, const uint8_t *buffer, uint32_t count, uint64_t *dstbuf)
+{
+	uint32_t i;
+	for (i = 0; i < count; i++)
+		dstbuf[i] = target_buffer_get_u64(target, &buffer[i * 8]);
+}
+
+/* write a uint32_t array to a buffer in target memory endianness */
+void target_buffer_get_u32_array(struct target *target, const uint8_t *buffer, uint32_t count, uint32_t *dstbuf)
+{
+	uint32_t i;
+	for (i = 0; i < count; i++)
+		dstbuf[i] = target_buffer_get_u32(target, &buffer[i * 4]);
+}
+
+/* write a uint16_t array to a buffer in target memory endianness */
+void target_buffer_get_u16_array(struct target *target, const uint8_t *buffer, uint32_t count, uint16_t *dstbuf)
+{
+	uint32_t i;
+	for (i = 0; i < count; i++)
+		dstbuf[i] = target_buffer_get_u16(target, &buffer[i * 2]);
+}
+
+/* write a uint64_t array to a buffer in target memory endianness */
+void target_buffer_set_u64_array(struct target *target, uint8_t *buffer, uint32_t count, const uint64_t *srcbuf)
+{
+	uint32_t i;
+	for (i = 0; i < count; i++)
+		target_buffer_set_u64(target, &buffer[i * 8], srcbuf[i]);
+}
+
+/* write a uint32_t array to a buffer in target memory endianness */
+void target_buffer_set_u32_array(struct target *target, uint8_t *buffer, uint32_t count, const uint32_t *srcbuf)
+{
+	uint32_t i;
+	for (i = 0; i < count; i++)
+		target_buffer_set_u32(target, &buffer[i * 4], srcbuf[i]);
+}
+
+/* write a uint16_t array to a buffer in target memory endianness */
+void target_buffer_set_u16_array(struct target *target, uint8_t *buffer, uint32_t count, const uint16_t *srcbuf)
+{
+	uint32_t i;
+	for (i = 0; i < count; i++)
+		target_buffer_set_u16(target, &buffer[i * 2], srcbuf[i]);
+}
+
+/* return a pointer to a configured target; id is name or number */
+struct target *get_target(const char *id)
+{
+	struct target *target;
+
+	/* try as tcltarget name */
+	for (target = all_targets; target; target = target->next) {
+		if (target_name(target) == NULL)
+			continue;
+		if (strcmp(id, target_name(target)) == 0)
+			return target;
+	}
+
+	/* It's OK to remove this fallback sometime after August 2010 or so */
+
+	/* no match, try as number */
+	unsigned num;
+	if (parse_uint(id, &num) != ERROR_OK)
+		return NULL;
+
+	for (target = all_targets; target; target = target->next) {
+		if (target->target_number == (int)num) {
+			LOG_WARNING("use '%s' as target identifier, not '%u'",
+					target_name(target), num);
+			return target;
+		}
+	}
+
+	return NULL;
+}
+
+/* returns a pointer to the n-th configured target */
+struct target *get_target_by_num(int num)
+{
+	struct target *target = all_targets;
+
+	while (target) {
+		if (target->target_number == num)
+			return target;
+		target = target->next;
+	}
+
+	return NULL;
+}
+
+struct target *get_current_target(struct command_context *cmd_ctx)
+{
+	struct target *target = get_target_by_num(cmd_ctx->current_target);
+
+	if (target == NULL) {
+		LOG_ERROR("BUG: current_target out of bounds");
+		exit(-1);
+	}
+
+	return target;
+}
+
+int target_poll(struct target *target)
+{
+	int retval;
+
+	/* We can't poll until after examine */
+	if (!target_was_examined(target)) {
+		/* Fail silently lest we pollute the log */
+		return ERROR_FAIL;
+	}
+
+	retval = target->type->poll(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	if (target->halt_issued) {
+		if (target->state == TARGET_HALTED)
+			target->halt_issued = false;
+		else {
+			long long t = timeval_ms() - target->halt_issued_time;
+			if (t > DEFAULT_HALT_TIMEOUT) {
+				target->halt_issued = false;
+				LOG_INFO("Halt timed out, wake up GDB.");
+				target_call_event_callbacks(target, TARGET_EVENT_GDB_HALT);
+			}
+		}
+	}
+
+	return ERROR_OK;
+}
+
+void target_poll_tighten(struct target *target)
+{
+	/* debugger activity usually precedes a state change; poll at the
+	 * fast rate again until the backoff builds back up */
+	target->poll_interval = polling_interval_min;
+	target->next_poll_time = 0;
+}
+
+int target_halt(struct target *target)
+{
+	int retval;
+	/* We can't poll until after examine */
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+
+	retval = target->type->halt(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	target->halt_issued = true;
+	target->halt_issued_time = timeval_ms();
+
+	return ERROR_OK;
+}
+
+/**
+ * Make the target (re)start executing using its saved execution
+ * context (possibly with some modifications).
+ *
+ * @param target Which target should start executing.
+ * @param current True to use the target's saved program counter instead
+ *	of the address parameter
+ * @param address Optionally used as the program counter.
+ * @param handle_breakpoints True iff breakpoints at the resumption PC
+ *	should be skipped.  (For example, maybe execution was stopped by
+ *	such a breakpoint, in which case it would be counterprodutive to
+ *	let it re-trigger.
+ * @param debug_execution False if all working areas allocated by OpenOCD
+ *	should be released and/or restored to their original contents.
+ *	(This would for example be true to run some downloaded "helper"
+ *	algorithm code, which resides in one such working buffer and uses
+ *	another for data storage.)
+ *
+ * @todo Resolve the ambiguity about what the "debug_execution" flag
+ * signifies.  For example, Target implementations don't agree on how
+ * it relates to invalidation of the register cache, or to whether
+ * breakpoints and watchpoints should be enabled.  (It would seem wrong
+ * to enable breakpoints when running downloaded "helper" algorithms
+ * (debug_execution true), since the breakpoints would be set to match
+ * target firmware being debugged, not the helper algorithm.... and
+ * enabling them could cause such helpers to malfunction (for example,
+ * by overwriting data with a breakpoint instruction.  On the other
+ * hand the infrastructure for running such helpers might use this
+ * procedure but rely on hardware breakpoint to detect termination.)
+ */
+int target_resume(struct target *target, int current, uint32_t address, int handle_breakpoints, int debug_execution)
+{
+	int retval;
+
+	/* We can't poll until after examine */
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+
+	target_call_event_callbacks(target, TARGET_EVENT_RESUME_START);
+
+	/* Running target code may modify the working area at will. */
+	target->algorithm_cache_valid = false;
+
+	/* note that resume *must* be asynchronous. The CPU can halt before
+	 * we poll. The CPU can even halt at the current PC as a result of
+	 * a software breakpoint being inserted by (a bug?) the application.
+	 */
+	retval = target->type->resume(target, current, address, handle_breakpoints, debug_execution);
+	if (retval != ERROR_OK)
+		return retval;
+
+	/* poll quickly now; breakpoints are often hit right away */
+	target_poll_tighten(target);
+
+	target_call_event_callbacks(target, TARGET_EVENT_RESUME_END);
+
+	return retval;
+}
+
+static int target_process_reset(struct command_context *cmd_ctx, enum target_reset_mode reset_mode)
+{
+	char buf[100];
+	int retval;
+	Jim_Nvp *n;
+	n = Jim_Nvp_value2name_simple(nvp_reset_modes, reset_mode);
+	if (n->name == NULL) {
+		LOG_ERROR("invalid reset mode");
+		return ERROR_FAIL;
+	}
+
+	struct target *target;
+	for (target = all_targets; target; target = target->next)
+		target_call_reset_callbacks(target, reset_mode);
+
+	/* disable polling during reset to make reset event scripts
+	 * more predictable, i.e. dr/irscan & pathmove in events will
+	 * not have JTAG operations injected into the middle of a sequence.
+	 */
+	bool save_poll = jtag_poll_get_enabled();
+
+	jtag_poll_set_enabled(false);
+
+	sprintf(buf, "ocd_process_reset %s", n->name);
+	retval = Jim_Eval(cmd_ctx->interp, buf);
+
+	jtag_poll_set_enabled(save_poll);
+
+	if (retval != JIM_OK) {
+		Jim_MakeErrorMessage(cmd_ctx->interp);
+		command_print(NULL, "%s\n", Jim_GetString(Jim_GetResult(cmd_ctx->interp), NULL));
+		return ERROR_FAIL;
+	}
+
+	/* We want any events to be processed before the prompt */
+	retval = target_call_timer_callbacks_now();
+
+	for (target = all_targets; target; target = target->next) {
+		target->type->check_reset(target);
+		target->running_alg = false;
+	}
+
+	return retval;
+}
+
+static int identity_virt2phys(struct target *target,
+		uint32_t virtual, uint32_t *physical)
+{
+	*physical = virtual;
+	return ERROR_OK;
+}
+
+static int no_mmu(struct target *target, int *enabled)
+{
+	*enabled = 0;
+	return ERROR_OK;
+}
+
+static int default_examine(struct target *target)
+{
+	target_set_examined(target);
+	return ERROR_OK;
+}
+
+/* no check by default */
+static int default_check_reset(struct target *target)
+{
+	return ERROR_OK;
+}
+
+int target_examine_one(struct target *target)
+{
+	target_call_event_callbacks(target, TARGET_EVENT_EXAMINE_START);
+
+	int retval = target->type->examine(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	/* examination (re)builds the register caches, so a previously
+	 * generated gdb target description may be stale */
+	free(target->tdesc);
+	target->tdesc = NULL;
+	target->tdesc_length = 0;
+
+	target_call_event_callbacks(target, TARGET_EVENT_EXAMINE_END);
+
+	return ERROR_OK;
+}
+
+static int jtag_enable_callback(enum jtag_event event, void *priv)
+{
+	struct target *target = priv;
+
+	if (event != JTAG_TAP_EVENT_ENABLE || !target->tap->enabled)
+		return ERROR_OK;
+
+	jtag_unregister_event_callback(jtag_enable_callback, target);
+
+	return target_examine_one(target);
+}
+
+/* Targets that correctly implement init + examine, i.e.
+ * no communication with target during init:
+ *
+ * XScale
+ */
+int target_examine(void)
+{
+	int retval = ERROR_OK;
+	struct target *target;
+
+	for (target = all_targets; target; target = target->next) {
+		/* defer examination, but don't skip it */
+		if (!target->tap->enabled) {
+			jtag_register_event_callback(jtag_enable_callback,
+					target);
+			continue;
+		}
+
+		retval = target_examine_one(target);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+	return retval;
+}
+
+const char *target_type_name(struct target *target)
+{
+	return target->type->name;
+}
+
+static int target_soft_reset_halt(struct target *target)
+{
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+	if (!target->type->soft_reset_halt) {
+		LOG_ERROR("Target %s does not support soft_reset_halt",
+				target_name(target));
+		return ERROR_FAIL;
+	}
+	return target->type->soft_reset_halt(target);
+}
+
+/**
+ * Downloads a target-specific native code algorithm to the target,
+ * and executes it.  * Note that some targets may need to set up, enable,
+ * and tear down a breakpoint (hard or * soft) to detect algorithm
+ * termination, while others may support  lower overhead schemes where
+ * soft breakpoints embedded in the algorithm automatically terminate the
+ * algorithm.
+ *
+ * @param target used to run the algorithm
+ * @param arch_info target-specific description of the algorithm.
+ */
+int target_run_algorithm(struct target *target,
+		int num_mem_params, struct mem_param *mem_params,
+		int num_reg_params, struct reg_param *reg_param,
+		uint32_t entry_point, uint32_t exit_point,
+		int timeout_ms, void *arch_info)
+{
+	int retval = ERROR_FAIL;
+
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		goto done;
+	}
+	if (!target->type->run_algorithm) {
+		LOG_ERROR("Target type '%s' does not support %s",
+				target_type_name(target), __func__);
+		goto done;
+	}
+
+	target->running_alg = true;
+	retval = target->type->run_algorithm(target,
+			num_mem_params, mem_params,
+			num_reg_params, reg_param,
+			entry_point, exit_point, timeout_ms, arch_info);
+	target->running_alg = false;
+
+done:
+	return retval;
+}
+
+/**
+ * Downloads a target-specific native code algorithm to the target,
+ * executes and leaves it running.
+ *
+ * @param target used to run the algorithm
+ * @param arch_info target-specific description of the algorithm.
+ */
+int target_start_algorithm(struct target *target,
+		int num_mem_params, struct mem_param *mem_params,
+		int num_reg_params, struct reg_param *reg_params,
+		uint32_t entry_point, uint32_t exit_point,
+		void *arch_info)
+{
+	int retval = ERROR_FAIL;
+
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		goto done;
+	}
+	if (!target->type->start_algorithm) {
+		LOG_ERROR("Target type '%s' does not support %s",
+				target_type_name(target), __func__);
+		goto done;
+	}
+	if (target->running_alg) {
+		LOG_ERROR("Target is already running an algorithm");
+		goto done;
+	}
+
+	target->running_alg = true;
+	retval = target->type->start_algorithm(target,
+			num_mem_params, mem_params,
+			num_reg_params, reg_params,
+			entry_point, exit_point, arch_info);
+
+done:
+	return retval;
+}
+
+/**
+ * Waits for an algorithm started with target_start_algorithm() to complete.
+ *
+ * @param target used to run the algorithm
+ * @param arch_info target-specific description of the algorithm.
+ */
+int target_wait_algorithm(struct target *target,
+		int num_mem_params, struct mem_param *mem_params,
+		int num_reg_params, struct reg_param *reg_params,
+		uint32_t exit_point, int timeout_ms,
+		void *arch_info)
+{
+	int retval = ERROR_FAIL;
+
+	if (!target->type->wait_algorithm) {
+		LOG_ERROR("Target type '%s' does not support %s",
+				target_type_name(target), __func__);
+		goto done;
+	}
+	if (!target->running_alg) {
+		LOG_ERROR("Target is not running an algorithm");
+		goto done;
+	}
+
+	retval = target->type->wait_algorithm(target,
+			num_mem_params, mem_params,
+			num_reg_params, reg_params,
+			exit_point, timeout_ms, arch_info);
+	if (retval != ERROR_TARGET_TIMEOUT)
+		target->running_alg = false;
+
+done:
+	return retval;
+}
+
+/**
+ * Executes a target-specific native code algorithm in the target.
+ * It differs from target_run_algorithm in that the algorithm is asynchronous.
+ * Because of this it requires an compliant algorithm:
+ * see contrib/loaders/flash/stm32f1x.S for example.
+ *
+ * @param target used to run the algorithm
+ */
+
+int target_run_flash_async_algorithm(struct target *target,
+		const uint8_t *buffer, uint32_t count, int block_size,
+		int num_mem_params, struct mem_param *mem_params,
+		int num_reg_params, struct reg_param *reg_params,
+		uint32_t buffer_start, uint32_t buffer_size,
+		uint32_t entry_point, uint32_t exit_point, void *arch_info)
+{
+	int retval;
+	int timeout = 0;
+
+	const uint8_t *buffer_orig = buffer;
+
+	/* Set up working area. First word is write pointer, second word is read pointer,
+	 * rest is fifo data area. */
+	uint32_t wp_addr = buffer_start;
+	uint32_t rp_addr = buffer_start + 4;
+	uint32_t fifo_start_addr = buffer_start + 8;
+	uint32_t fifo_end_addr = buffer_start + buffer_size;
+
+	uint32_t wp = fifo_start_addr;
+	uint32_t rp = fifo_start_addr;
+
+	/* validate block_size is 2^n */
+	assert(!block_size || !(block_size & (block_size - 1)));
+
+	retval = target_write_u32(target, wp_addr, wp);
+	if (retval != ERROR_OK)
+		return retval;
+	retval = target_write_u32(target, rp_addr, rp);
+	if (retval != ERROR_OK)
+		return retval;
+
+	/* Start up algorithm on target and let it idle while writing the first chunk */
+	retval = target_start_algorithm(target, num_mem_params, mem_params,
+			num_reg_params, reg_params,
+			entry_point,
+			exit_point,
+			arch_info);
+
+	if (retval != ERROR_OK) {
+		LOG_ERROR("error starting target flash write algorithm");
+		return retval;
+	}
+
+	while (count > 0) {
+
+		retval = target_read_u32(target, rp_addr, &rp);
+		if (retval != ERROR_OK) {
+			LOG_ERROR("failed to get read pointer");
+			break;
+		}
+
+		LOG_DEBUG("offs 0x%zx count 0x%" PRIx32 " wp 0x%" PRIx32 " rp 0x%" PRIx32,
+			(size_t) (buffer - buffer_orig), count, wp, rp);
+
+		if (rp == 0) {
+			LOG_ERROR("flash write algorithm aborted by target");
+			retval = ERROR_FLASH_OPERATION_FAILED;
+			break;
+		}
+
+		if (((rp - fifo_start_addr) & (block_size - 1)) || rp < fifo_start_addr || rp >= fifo_end_addr) {
+			LOG_ERROR("corrupted fifo read pointer 0x%" PRIx32, rp);
+			break;
+		}
+
+		/* Count the number of bytes available in the fifo without
+		 * crossing the wrap around. Make sure to not fill it completely,
+		 * because that would make wp == rp and that's the empty condition. */
+		uint32_t thisrun_bytes;
+		if (rp > wp)
+			thisrun_bytes = rp - wp - block_size;
+		else if (rp > fifo_start_addr)
+			thisrun_bytes = fifo_end_addr - wp;
+		else
+			thisrun_bytes = fifo_end_addr - wp - block_size;
+
+		if (thisrun_bytes == 0) {
+			/* Throttle polling a bit if transfer is (much) faster than flash
+			 * programming. The exact delay shouldn't matter as long as it's
+			 * less than buffer size / flash speed. This is very unlikely to
+			 * run when using high latency connections such as USB. */
+			alive_sleep(10);
+
+			/* to stop an infinite loop on some targets check and increment a timeout
+			 * this issue was observed on a stellaris using the new ICDI interface */
+			if (timeout++ >= 500) {
+				LOG_ERROR("timeout waiting for algorithm, a target reset is recommended");
+				return ERROR_FLASH_OPERATION_FAILED;
+			}
+			continue;
+		}
+
+		/* reset our timeout */
+		timeout = 0;
+
+		/* Limit to the amount of data we actually want to write */
+		if (thisrun_bytes > count * block_size)
+			thisrun_bytes = count * block_size;
+
+		/* Write data to fifo */
+		retval = target_write_buffer(target, wp, thisrun_bytes, buffer);
+		if (retval != ERROR_OK)
+			break;
+
+		/* Update counters and wrap write pointer */
+		buffer += thisrun_bytes;
+		count -= thisrun_bytes / block_size;
+		wp += thisrun_bytes;
+		if (wp >= fifo_end_addr)
+			wp = fifo_start_addr;
+
+		/* Store updated write pointer to target */
+		retval = target_write_u32(target, wp_addr, wp);
+		if (retval != ERROR_OK)
+			break;
+	}
+
+	if (retval != ERROR_OK) {
+		/* abort flash write algorithm on target */
+		target_write_u32(target, wp_addr, 0);
+	}
+
+	int retval2 = target_wait_algorithm(target, num_mem_params, mem_params,
+			num_reg_params, reg_params,
+			exit_point,
+			10000,
+			arch_info);
+
+	if (retval2 != ERROR_OK) {
+		LOG_ERROR("error waiting for target flash write algorithm");
+		retval = retval2;
+	}
+
+	return retval;
+}
+
+/**
+ * Executes an asynchronous target-specific read algorithm, the mirror
+ * image of target_run_flash_async_algorithm(): the algorithm produces
+ * data into the circular buffer by advancing the write pointer while
+ * the host drains it and advances the read pointer. The same buffer
+ * layout is used, so compliant kernels only swap the roles of the two
+ * pointers.
+ *
+ * @param target used to run the algorithm
+ */
+int target_run_read_async_algorithm(struct target *target,
+		uint8_t *buffer, uint32_t count, int block_size,
+		int num_mem_params, struct mem_param *mem_params,
+		int num_reg_params, struct reg_param *reg_params,
+		uint32_t buffer_start, uint32_t buffer_size,
+		uint32_t entry_point, uint32_t exit_point, void *arch_info)
+{
+	int retval;
+	int timeout = 0;
+
+	const uint8_t *buffer_orig = buffer;
+
+	/* Set up working area. First word is write pointer, second word is read pointer,
+	 * rest is fifo data area. */
+	uint32_t wp_addr = buffer_start;
+	uint32_t rp_addr = buffer_start + 4;
+	uint32_t fifo_start_addr = buffer_start + 8;
+	uint32_t fifo_end_addr = buffer_start + buffer_size;
+
+	uint32_t wp = fifo_start_addr;
+	uint32_t rp = fifo_start_addr;
+
+	/* validate block_size is 2^n */
+	assert(!block_size || !(block_size & (block_size - 1)));
+
+	retval = target_write_u32(target, wp_addr, wp);
+	if (retval != ERROR_OK)
+		return retval;
+	retval = target_write_u32(target, rp_addr, rp);
+	if (retval != ERROR_OK)
+		return retval;
+
+	/* Start up algorithm on target and let it fill the buffer while the
+	 * host catches up */
+	retval = target_start_algorithm(target, num_mem_params, mem_params,
+			num_reg_params, reg_params,
+			entry_point,
+			exit_point,
+			arch_info);
+
+	if (retval != ERROR_OK) {
+		LOG_ERROR("error starting target read algorithm");
+		return retval;
+	}
+
+	while (count > 0) {
+
+		retval = target_read_u32(target, wp_addr, &wp);
+		if (retval != ERROR_OK) {
+			LOG_ERROR("failed to get write pointer");
+			break;
+		}
+
+		LOG_DEBUG("offs 0x%zx count 0x%" PRIx32 " wp 0x%" PRIx32 " rp 0x%" PRIx32,
+			(size_t) (buffer - buffer_orig), count, wp, rp);
+
+		if (wp == 0) {
+			LOG_ERROR("read algorithm aborted by target");
+			retval = ERROR_FAIL;
+			break;
+		}
+
+		if (((wp - fifo_start_addr) & (block_size - 1)) || wp < fifo_start_addr || wp >= fifo_end_addr) {
+			LOG_ERROR("corrupted fifo write pointer 0x%" PRIx32, wp);
+			break;
+		}
+
+		/* Count the number of bytes available in the fifo without
+		 * crossing the wrap around. */
+		uint32_t thisrun_bytes;
+		if (wp >= rp)
+			thisrun_bytes = wp - rp;
+		else
+			thisrun_bytes = fifo_end_addr - rp;
+
+		if (thisrun_bytes == 0) {
+			/* Throttle polling a bit if the host drains faster than the
+			 * target produces. The exact delay shouldn't matter as long
+			 * as it's less than buffer size / production speed. */
+			alive_sleep(10);
+
+			/* to stop an infinite loop on some targets check and increment a timeout */
+			if (timeout++ >= 500) {
+				LOG_ERROR("timeout waiting for algorithm, a target reset is recommended");
+				return ERROR_FAIL;
+			}
+			continue;
+		}
+
+		/* reset our timeout */
+		timeout = 0;
+
+		/* Limit to the amount of data we actually want to read */
+		if (thisrun_bytes > count * block_size)
+			thisrun_bytes = count * block_size;
+
+		/* Read data from fifo */
+		retval = target_read_buffer(target, rp, thisrun_bytes, buffer);
+		if (retval != ERROR_OK)
+			break;
+
+		/* Update counters and wrap read pointer */
+		buffer += thisrun_bytes;
+		count -= thisrun_bytes / block_size;
+		rp += thisrun_bytes;
+		if (rp >= fifo_end_addr)
+			rp = fifo_start_addr;
+
+		/* Store updated read pointer to target */
+		retval = target_write_u32(target, rp_addr, rp);
+		if (retval != ERROR_OK)
+			break;
+	}
+
+	if (retval != ERROR_OK) {
+		/* abort read algorithm on target */
+		target_write_u32(target, rp_addr, 0);
+	}
+
+	int retval2 = target_wait_algorithm(target, num_mem_params, mem_params,
+			num_reg_params, reg_params,
+			exit_point,
+			10000,
+			arch_info);
+
+	if (retval2 != ERROR_OK) {
+		LOG_ERROR("error waiting for target read algorithm");
+		retval = retval2;
+	}
+
+	return retval;
+}
+
+int target_read_memory(struct target *target,
+		uint32_t address, uint32_t size, uint32_t count, uint8_t *buffer)
+{
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+	if (!target->type->read_memory) {
+		LOG_ERROR("Target %s doesn't support read_memory", target_name(target));
+		return ERROR_FAIL;
+	}
+	return target->type->read_memory(target, address, size, count, buffer);
+}
+
+int target_read_phys_memory(struct target *target,
+		uint32_t address, uint32_t size, uint32_t count, uint8_t *buffer)
+{
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+	if (!target->type->read_phys_memory) {
+		LOG_ERROR("Target %s doesn't support read_phys_memory", target_name(target));
+		return ERROR_FAIL;
+	}
+	return target->type->read_phys_memory(target, address, size, count, buffer);
+}
+
+int target_write_memory(struct target *target,
+		uint32_t address, uint32_t size, uint32_t count, const uint8_t *buffer)
+{
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+	if (!target->type->write_memory) {
+		LOG_ERROR("Target %s doesn't support write_memory", target_name(target));
+		return ERROR_FAIL;
+	}
+	target_algorithm_cache_invalidate(target, address, size * count);
+	return target->type->write_memory(target, address, size, count, buffer);
+}
+
+int target_write_phys_memory(struct target *target,
+		uint32_t address, uint32_t size, uint32_t count, const uint8_t *buffer)
+{
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+	if (!target->type->write_phys_memory) {
+		LOG_ERROR("Target %s doesn't support write_phys_memory", target_name(target));
+		return ERROR_FAIL;
+	}
+	target_algorithm_cache_invalidate(target, address, size * count);
+	return target->type->write_phys_memory(target, address, size, count, buffer);
+}
+
+int target_add_breakpoint(struct target *target,
+		struct breakpoint *breakpoint)
+{
+	if ((target->state != TARGET_HALTED) && (breakpoint->type != BKPT_HARD)) {
+		LOG_WARNING("target %s is not halted", target_name(target));
+		return ERROR_TARGET_NOT_HALTED;
+	}
+	return target->type->add_breakpoint(target, breakpoint);
+}
+
+int target_add_context_breakpoint(struct target *target,
+		struct breakpoint *breakpoint)
+{
+	if (target->state != TARGET_HALTED) {
+		LOG_WARNING("target %s is not halted", target_name(target));
+		return ERROR_TARGET_NOT_HALTED;
+	}
+	return target->type->add_context_breakpoint(target, breakpoint);
+}
+
+int target_add_hybrid_breakpoint(struct target *target,
+		struct breakpoint *breakpoint)
+{
+	if (target->state != TARGET_HALTED) {
+		LOG_WARNING("target %s is not halted", target_name(target));
+		return ERROR_TARGET_NOT_HALTED;
+	}
+	return target->type->add_hybrid_breakpoint(target, breakpoint);
+}
+
+int target_remove_breakpoint(struct target *target,
+		struct breakpoint *breakpoint)
+{
+	return target->type->remove_breakpoint(target, breakpoint);
+}
+
+int target_add_watchpoint(struct target *target,
+		struct watchpoint *watchpoint)
+{
+	if (target->state != TARGET_HALTED) {
+		LOG_WARNING("target %s is not halted", target_name(target));
+		return ERROR_TARGET_NOT_HALTED;
+	}
+	return target->type->add_watchpoint(target, watchpoint);
+}
+int target_remove_watchpoint(struct target *target,
+		struct watchpoint *watchpoint)
+{
+	return target->type->remove_watchpoint(target, watchpoint);
+}
+int target_hit_watchpoint(struct target *target,
+		struct watchpoint **hit_watchpoint)
+{
+	if (target->state != TARGET_HALTED) {
+		LOG_WARNING("target %s is not halted", target->cmd_name);
+		return ERROR_TARGET_NOT_HALTED;
+	}
+
+	if (target->type->hit_watchpoint == NULL) {
+		/* For backward compatible, if hit_watchpoint is not implemented,
+		 * return ERROR_FAIL such that gdb_server will not take the nonsense
+		 * information. */
+		return ERROR_FAIL;
+	}
+
+	return target->type->hit_watchpoint(target, hit_watchpoint);
+}
+
+int target_get_gdb_reg_list(struct target *target,
+		struct reg **reg_list[], int *reg_list_size,
+		enum target_register_class reg_class)
+{
+	return target->type->get_gdb_reg_list(target, reg_list, reg_list_size, reg_class);
+}
+int target_step(struct target *target,
+		int current, uint32_t address, int handle_breakpoints)
+{
+	return target->type->step(target, current, address, handle_breakpoints);
+}
+
+int target_get_gdb_fileio_info(struct target *target, struct gdb_fileio_info *fileio_info)
+{
+	if (target->state != TARGET_HALTED) {
+		LOG_WARNING("target %s is not halted", target->cmd_name);
+		return ERROR_TARGET_NOT_HALTED;
+	}
+	return target->type->get_gdb_fileio_info(target, fileio_info);
+}
+
+int target_gdb_fileio_end(struct target *target, int retcode, int fileio_errno, bool ctrl_c)
+{
+	if (target->state != TARGET_HALTED) {
+		LOG_WARNING("target %s is not halted", target->cmd_name);
+		return ERROR_TARGET_NOT_HALTED;
+	}
+	return target->type->gdb_fileio_end(target, retcode, fileio_errno, ctrl_c);
+}
+
+int target_profiling(struct target *target, uint32_t *samples,
+			uint32_t max_num_samples, uint32_t *num_samples, uint32_t seconds)
+{
+	if (target->state != TARGET_HALTED) {
+		LOG_WARNING("target %s is not halted", target->cmd_name);
+		return ERROR_TARGET_NOT_HALTED;
+	}
+	return target->type->profiling(target, samples, max_num_samples,
+			num_samples, seconds);
+}
+
+/**
+ * Reset the @c examined flag for the given target.
+ * Pure paranoia -- targets are zeroed on allocation.
+ */
+static void target_reset_examined(struct target *target)
+{
+	target->examined = false;
+}
+
+static int handle_target(void *priv);
+
+static int target_init_one(struct command_context *cmd_ctx,
+		struct target *target)
+{
+	target_reset_examined(target);
+
+	struct target_type *type = target->type;
+	if (type->examine == NULL)
+		type->examine = default_examine;
+
+	if (type->check_reset == NULL)
+		type->check_reset = default_check_reset;
+
+	assert(type->init_target != NULL);
+
+	int retval = type->init_target(cmd_ctx, target);
+	if (ERROR_OK != retval) {
+		LOG_ERROR("target '%s' init failed", target_name(target));
+		return retval;
+	}
+
+	/* Sanity-check MMU support ... stub in what we must, to help
+	 * implement it in stages, but warn if we need to do so.
+	 */
+	if (type->mmu) {
+		if (type->virt2phys == NULL) {
+			LOG_ERROR("type '%s' is missing virt2phys", type->name);
+			type->virt2phys = identity_virt2phys;
+		}
+	} else {
+		/* Make sure no-MMU targets all behave the same:  make no
+		 * distinction between physical and virtual addresses, and
+		 * ensure that virt2phys() is always an identity mapping.
+		 */
+		if (type->write_phys_memory || type->read_phys_memory || type->virt2phys)
+			LOG_WARNING("type '%s' has bad MMU hooks", type->name);
+
+		type->mmu = no_mmu;
+		type->write_phys_memory = type->write_memory;
+		type->read_phys_memory = type->read_memory;
+		type->virt2phys = identity_virt2phys;
+	}
+
+	if (target->type->read_buffer == NULL)
+		target->type->read_buffer = target_read_buffer_default;
+
+	if (target->type->write_buffer == NULL)
+		target->type->write_buffer = target_write_buffer_default;
+
+	if (target->type->get_gdb_fileio_info == NULL)
+		target->type->get_gdb_fileio_info = target_get_gdb_fileio_info_default;
+
+	if (target->type->gdb_fileio_end == NULL)
+		target->type->gdb_fileio_end = target_gdb_fileio_end_default;
+
+	if (target->type->profiling == NULL)
+		target->type->profiling = target_profiling_default;
+
+	return ERROR_OK;
+}
+
+static int target_init(struct command_context *cmd_ctx)
+{
+	struct target *target;
+	int retval;
+
+	for (target = all_targets; target; target = target->next) {
+		retval = target_init_one(cmd_ctx, target);
+		if (ERROR_OK != retval)
+			return retval;
+	}
+
+	if (!all_targets)
+		return ERROR_OK;
+
+	retval = target_register_user_commands(cmd_ctx);
+	if (ERROR_OK != retval)
+		return retval;
+
+	retval = target_register_timer_callback(&handle_target,
+			polling_interval, 1, cmd_ctx->interp);
+	if (ERROR_OK != retval)
+		return retval;
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_target_init_command)
+{
+	int retval;
+
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	static bool target_initialized;
+	if (target_initialized) {
+		LOG_INFO("'target init' has already been called");
+		return ERROR_OK;
+	}
+	target_initialized = true;
+
+	retval = command_run_line(CMD_CTX, "init_targets");
+	if (ERROR_OK != retval)
+		return retval;
+
+	retval = command_run_line(CMD_CTX, "init_target_events");
+	if (ERROR_OK != retval)
+		return retval;
+
+	retval = command_run_line(CMD_CTX, "init_board");
+	if (ERROR_OK != retval)
+		return retval;
+
+	LOG_DEBUG("Initializing targets...");
+	return target_init(CMD_CTX);
+}
+
+int target_register_event_callback(int (*callback)(struct target *target,
+		enum target_event event, void *priv), void *priv)
+{
+	struct target_event_callback **callbacks_p = &target_event_callbacks;
+
+	if (callback == NULL)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (*callbacks_p) {
+		while ((*callbacks_p)->next)
+			callbacks_p = &((*callbacks_p)->next);
+		callbacks_p = &((*callbacks_p)->next);
+	}
+
+	(*callbacks_p) = malloc(sizeof(struct target_event_callback));
+	(*callbacks_p)->callback = callback;
+	(*callbacks_p)->priv = priv;
+	(*callbacks_p)->next = NULL;
+
+	return ERROR_OK;
+}
+
+int target_register_reset_callback(int (*callback)(struct target *target,
+		enum target_reset_mode reset_mode, void *priv), void *priv)
+{
+	struct target_reset_callback *entry;
+
+	if (callback == NULL)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	entry = malloc(sizeof(struct target_reset_callback));
+	if (entry == NULL) {
+		LOG_ERROR("error allocating buffer for reset callback entry");
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+
+	entry->callback = callback;
+	entry->priv = priv;
+	list_add(&entry->list, &target_reset_callback_list);
+
+
+	return ERROR_OK;
+}
+
+int target_register_trace_callback(int (*callback)(struct target *target,
+		size_t len, uint8_t *data, void *priv), void *priv)
+{
+	struct target_trace_callback *entry;
+
+	if (callback == NULL)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	entry = malloc(sizeof(struct target_trace_callback));
+	if (entry == NULL) {
+		LOG_ERROR("error allocating buffer for trace callback entry");
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+
+	entry->callback = callback;
+	entry->priv = priv;
+	list_add(&entry->list, &target_trace_callback_list);
+
+
+	return ERROR_OK;
+}
+
+/* Earliest deadline over all live timer callbacks, in ms since the
+ * epoch, maintained so idle server-loop passes can skip walking the
+ * callback list entirely.  0 means "stale, recompute on next walk". */
+static int64_t target_timer_earliest_ms;
+
+static int64_t target_timeval_ms(const struct timeval *tv)
+{
+	return (int64_t)tv->tv_sec * 1000 + tv->tv_usec / 1000;
+}
+
+int target_register_timer_callback(int (*callback)(void *priv), int time_ms, int periodic, void *priv)
+{
+	struct target_timer_callback **callbacks_p = &target_timer_callbacks;
+	struct timeval now;
+
+	if (callback == NULL)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (*callbacks_p) {
+		while ((*callbacks_p)->next)
+			callbacks_p = &((*callbacks_p)->next);
+		callbacks_p = &((*callbacks_p)->next);
+	}
+
+	(*callbacks_p) = malloc(sizeof(struct target_timer_callback));
+	(*callbacks_p)->callback = callback;
+	(*callbacks_p)->periodic = periodic;
+	(*callbacks_p)->time_ms = time_ms;
+	(*callbacks_p)->removed = false;
+
+	gettimeofday(&now, NULL);
+	(*callbacks_p)->when.tv_usec = now.tv_usec + (time_ms % 1000) * 1000;
+	time_ms -= (time_ms % 1000);
+	(*callbacks_p)->when.tv_sec = now.tv_sec + (time_ms / 1000);
+	if ((*callbacks_p)->when.tv_usec > 1000000) {
+		(*callbacks_p)->when.tv_usec = (*callbacks_p)->when.tv_usec - 1000000;
+		(*callbacks_p)->when.tv_sec += 1;
+	}
+
+	(*callbacks_p)->priv = priv;
+	(*callbacks_p)->next = NULL;
+
+	int64_t when_ms = target_timeval_ms(&(*callbacks_p)->when);
+	if (target_timer_earliest_ms == 0 || when_ms < target_timer_earliest_ms)
+		target_timer_earliest_ms = when_ms;
+
+	return ERROR_OK;
+}
+
+int target_unregister_event_callback(int (*callback)(struct target *target,
+		enum target_event event, void *priv), void *priv)
+{
+	struct target_event_callback **p = &target_event_callbacks;
+	struct target_event_callback *c = target_event_callbacks;
+
+	if (callback == NULL)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	while (c) {
+		struct target_event_callback *next = c->next;
+		if ((c->callback == callback) && (c->priv == priv)) {
+			*p = next;
+			free(c);
+			return ERROR_OK;
+		} else
+			p = &(c->next);
+		c = next;
+	}
+
+	return ERROR_OK;
+}
+
+int target_unregister_reset_callback(int (*callback)(struct target *target,
+		enum target_reset_mode reset_mode, void *priv), void *priv)
+{
+	struct target_reset_callback *entry;
+
+	if (callback == NULL)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	list_for_each_entry(entry, &target_reset_callback_list, list) {
+		if (entry->callback == callback && entry->priv == priv) {
+			list_del(&entry->list);
+			free(entry);
+			break;
+		}
+	}
+
+	return ERROR_OK;
+}
+
+int target_unregister_trace_callback(int (*callback)(struct target *target,
+		size_t len, uint8_t *data, void *priv), void *priv)
+{
+	struct target_trace_callback *entry;
+
+	if (callback == NULL)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	list_for_each_entry(entry, &target_trace_callback_list, list) {
+		if (entry->callback == callback && entry->priv == priv) {
+			list_del(&entry->list);
+			free(entry);
+			break;
+		}
+	}
+
+	return ERROR_OK;
+}
+
+int target_unregister_timer_callback(int (*callback)(void *priv), void *priv)
+{
+	if (callback == NULL)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	for (struct target_timer_callback *c = target_timer_callbacks;
+	     c; c = c->next) {
+		if ((c->callback == callback) && (c->priv == priv)) {
+			c->removed = true;
+			return ERROR_OK;
+		}
+	}
+
+	return ERROR_FAIL;
+}
+
+int target_call_event_callbacks(struct target *target, enum target_event event)
+{
+	struct target_event_callback *callback = target_event_callbacks;
+	struct target_event_callback *next_callback;
+
+	if (event == TARGET_EVENT_HALTED) {
+		/* execute early halted first */
+		target_call_event_callbacks(target, TARGET_EVENT_GDB_HALT);
+	}
+
+	LOG_DEBUG("target event %i (%s)", event,
+			Jim_Nvp_value2name_simple(nvp_target_event, event)->name);
+
+	trace_ring_emit(TRACE_SUBSYS_TARGET, TRACE_EV_TARGET_EVENT,
+		event, target->target_number);
+
+	target_handle_event(target, event);
+
+	while (callback) {
+		next_callback = callback->next;
+		callback->callback(target, event, callback->priv);
+		callback = next_callback;
+	}
+
+	return ERROR_OK;
+}
+
+int target_call_reset_callbacks(struct target *target, enum target_reset_mode reset_mode)
+{
+	struct target_reset_callback *callback;
+
+	LOG_DEBUG("target reset %i (%s)", reset_mode,
+			Jim_Nvp_value2name_simple(nvp_reset_modes, reset_mode)->name);
+
+	list_for_each_entry(callback, &target_reset_callback_list, list)
+		callback->callback(target, reset_mode, callback->priv);
+
+	return ERROR_OK;
+}
+
+int target_call_trace_callbacks(struct target *target, size_t len, uint8_t *data)
+{
+	struct target_trace_callback *callback;
+
+	list_for_each_entry(callback, &target_trace_callback_list, list)
+		callback->callback(target, len, data, callback->priv);
+
+	return ERROR_OK;
+}
+
+static int target_timer_callback_periodic_restart(
+		struct target_timer_callback *cb, struct timeval *now)
+{
+	int time_ms = cb->time_ms;
+	cb->when.tv_usec = now->tv_usec + (time_ms % 1000) * 1000;
+	time_ms -= (time_ms % 1000);
+	cb->when.tv_sec = now->tv_sec + time_ms / 1000;
+	if (cb->when.tv_usec > 1000000) {
+		cb->when.tv_usec = cb->when.tv_usec - 1000000;
+		cb->when.tv_sec += 1;
+	}
+	return ERROR_OK;
+}
+
+static int target_call_timer_callback(struct target_timer_callback *cb,
+		struct timeval *now)
+{
+	cb->callback(cb->priv);
+
+	if (cb->periodic)
+		return target_timer_callback_periodic_restart(cb, now);
+
+	return target_unregister_timer_callback(cb->callback, cb->priv);
+}
+
+static int target_call_timer_callbacks_check_time(int checktime)
+{
+	static bool callback_processing;
+
+	/* Do not allow nesting */
+	if (callback_processing)
+		return ERROR_OK;
+
+	callback_processing = true;
+
+	keep_alive();
+
+	struct timeval now;
+	gettimeofday(&now, NULL);
+
+	/* The common case is that nothing is due yet; the cached earliest
+	 * deadline lets us say so without walking the list. */
+	if (checktime && target_timer_earliest_ms != 0
+			&& target_timeval_ms(&now) < target_timer_earliest_ms) {
+		callback_processing = false;
+		return ERROR_OK;
+	}
+
+	int64_t earliest_ms = 0;
+
+	/* Store an address of the place containing a pointer to the
+	 * next item; initially, that's a standalone "root of the
+	 * list" variable. */
+	struct target_timer_callback **callback = &target_timer_callbacks;
+	while (*callback) {
+		if ((*callback)->removed) {
+			struct target_timer_callback *p = *callback;
+			*callback = (*callback)->next;
+			free(p);
+			continue;
+		}
+
+		bool call_it = (*callback)->callback &&
+			((!checktime && (*callback)->periodic) ||
+			 now.tv_sec > (*callback)->when.tv_sec ||
+			 (now.tv_sec == (*callback)->when.tv_sec &&
+			  now.tv_usec >= (*callback)->when.tv_usec));
+
+		if (call_it)
+			target_call_timer_callback(*callback, &now);
+
+		/* one-shot callbacks just called are marked removed by now;
+		 * periodic ones carry their restarted deadline */
+		if (!(*callback)->removed) {
+			int64_t when_ms = target_timeval_ms(&(*callback)->when);
+			if (earliest_ms == 0 || when_ms < earliest_ms)
+				earliest_ms = when_ms;
+		}
+
+		callback = &(*callback)->next;
+	}
+
+	target_timer_earliest_ms = earliest_ms;
+
+	callback_processing = false;
+	return ERROR_OK;
+}
+
+int target_call_timer_callbacks(void)
+{
+	return target_call_timer_callbacks_check_time(1);
+}
+
+/* invoke periodic callbacks immediately */
+int target_call_timer_callbacks_now(void)
+{
+	return target_call_timer_callbacks_check_time(0);
+}
+
+int64_t target_timer_next_event(void)
+{
+	struct target_timer_callback *callback;
+	struct timeval now;
+	int64_t now_ms, next_ms = polling_interval;
+
+	gettimeofday(&now, NULL);
+	now_ms = target_timeval_ms(&now);
+
+	if (target_timer_earliest_ms != 0) {
+		/* the cached deadline is never later than any live callback */
+		if (target_timer_earliest_ms - now_ms < next_ms)
+			next_ms = target_timer_earliest_ms - now_ms;
+		return next_ms > 0 ? next_ms : 0;
+	}
+
+	for (callback = target_timer_callbacks; callback; callback = callback->next) {
+		int64_t when_ms;
+
+		if (callback->removed || !callback->callback)
+			continue;
+
+		when_ms = target_timeval_ms(&callback->when);
+		if (when_ms - now_ms < next_ms)
+			next_ms = when_ms - now_ms;
+	}
+
+	return next_ms > 0 ? next_ms : 0;
+}
+
+/* Prints the working area layout for debug purposes */
+static void print_wa_layout(struct target *target)
+{
+	struct working_area *c = target->working_areas;
+
+	while (c) {
+		LOG_DEBUG("%c%c 0x%08"PRIx32"-0x%08"PRIx32" (%"PRIu32" bytes)",
+			c->backup ? 'b' : ' ', c->free ? ' ' : '*',
+			c->address, c->address + c->size - 1, c->size);
+		c = c->next;
+	}
+}
+
+/* Reduce area to size bytes, create a new free area from the remaining bytes, if any. */
+static void target_split_working_area(struct working_area *area, uint32_t size)
+{
+	assert(area->free); /* Shouldn't split an allocated area */
+	assert(size <= area->size); /* Caller should guarantee this */
+
+	/* Split only if not already the right size */
+	if (size < area->size) {
+		struct working_area *new_wa = malloc(sizeof(*new_wa));
+
+		if (new_wa == NULL)
+			return;
+
+		new_wa->next = area->next;
+		new_wa->size = area->size - size;
+		new_wa->address = area->address + size;
+		new_wa->backup = NULL;
+		new_wa->user = NULL;
+		new_wa->free = true;
+
+		area->next = new_wa;
+		area->size = size;
+
+		/* If backup memory was allocated to this area, it has the wrong size
+		 * now so free it and it will be reallocated if/when needed */
+		if (area->backup) {
+			free(area->backup);
+			area->backup = NULL;
+		}
+	}
+}
+
+/* Merge all adjacent free areas into one */
+static void target_merge_working_areas(struct target *target)
+{
+	struct working_area *c = target->working_areas;
+
+	while (c && c->next) {
+		assert(c->next->address == c->address + c->size); /* This is an invariant */
+
+		/* Find two adjacent free areas */
+		if (c->free && c->next->free) {
+			/* Merge the last into the first */
+			c->size += c->next->size;
+
+			/* Remove the last */
+			struct working_area *to_be_freed = c->next;
+			c->next = c->next->next;
+			if (to_be_freed->backup)
+				free(to_be_freed->backup);
+			free(to_be_freed);
+
+			/* If backup memory was allocated to the remaining area, it's has
+			 * the wrong size now */
+			if (c->backup) {
+				free(c->backup);
+				c->backup = NULL;
+			}
+		} else {
+			c = c->next;
+		}
+	}
+}
+
+int target_alloc_working_area_try(struct target *target, uint32_t size, struct working_area **area)
+{
+	/* Reevaluate working area address based on MMU state*/
+	if (target->working_areas == NULL) {
+		int retval;
+		int enabled;
+
+		retval = target->type->mmu(target, &enabled);
+		if (retval != ERROR_OK)
+			return retval;
+
+		if (!enabled) {
+			if (target->working_area_phys_spec) {
+				LOG_DEBUG("MMU disabled, using physical "
+					"address for working memory 0x%08"PRIx32,
+					target->working_area_phys);
+				target->working_area = target->working_area_phys;
+			} else {
+				LOG_ERROR("No working memory available. "
+					"Specify -work-area-phys to target.");
+				return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+			}
+		} else {
+			if (target->working_area_virt_spec) {
+				LOG_DEBUG("MMU enabled, using virtual "
+					"address for working memory 0x%08"PRIx32,
+					target->working_area_virt);
+				target->working_area = target->working_area_virt;
+			} else {
+				LOG_ERROR("No working memory available. "
+					"Specify -work-area-virt to target.");
+				return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+			}
+		}
+
+		/* Set up initial working area on first call */
+		struct working_area *new_wa = malloc(sizeof(*new_wa));
+		if (new_wa) {
+			new_wa->next = NULL;
+			new_wa->size = target->working_area_size & ~3UL; /* 4-byte align */
+			new_wa->address = target->working_area;
+			new_wa->backup = NULL;
+			new_wa->user = NULL;
+			new_wa->free = true;
+		}
+
+		target->working_areas = new_wa;
+	}
+
+	/* only allocate multiples of 4 byte */
+	if (size % 4)
+		size = (size + 3) & (~3UL);
+
+	struct working_area *c = target->working_areas;
+
+	/* Find the first large enough working area */
+	while (c) {
+		if (c->free && c->size >= size)
+			break;
+		c = c->next;
+	}
+
+	if (c == NULL)
+		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+
+	/* Split the working area into the requested size */
+	target_split_working_area(c, size);
+
+	LOG_DEBUG("allocated new working area of %"PRIu32" bytes at address 0x%08"PRIx32, size, c->address);
+
+	if (target->backup_working_area) {
+		if (c->backup == NULL) {
+			c->backup = malloc(c->size);
+			if (c->backup == NULL)
+				return ERROR_FAIL;
+		}
+
+		int retval = target_read_memory(target, c->address, 4, c->size / 4, c->backup);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	/* mark as used, and return the new (reused) area */
+	c->free = false;
+	*area = c;
+
+	/* The new owner may put anything in the area. */
+	target_algorithm_cache_invalidate(target, c->address, c->size);
+
+	/* user pointer */
+	c->user = area;
+
+	print_wa_layout(target);
+
+	return ERROR_OK;
+}
+
+int target_alloc_working_area(struct target *target, uint32_t size, struct working_area **area)
+{
+	int retval;
+
+	retval = target_alloc_working_area_try(target, size, area);
+	if (retval == ERROR_TARGET_RESOURCE_NOT_AVAILABLE)
+		LOG_WARNING("not enough working area available(requested %"PRIu32")", size);
+	return retval;
+
+}
+
+/* Drop the algorithm image cache record if the given range touches it */
+static void target_algorithm_cache_invalidate(struct target *target,
+		uint32_t address, uint32_t size)
+{
+	if (target->algorithm_cache_valid
+			&& address < target->algorithm_cache_address + target->algorithm_cache_size
+			&& address + size > target->algorithm_cache_address)
+		target->algorithm_cache_valid = false;
+}
+
+int target_load_algorithm_image(struct target *target, const uint8_t *code,
+		uint32_t code_size, struct working_area **area)
+{
+	/* Capture the cache record before allocating; the allocation below
+	 * invalidates it for its own range, which is exactly the range we
+	 * are about to check. */
+	bool cache_valid = target->algorithm_cache_valid;
+	uint32_t cache_address = target->algorithm_cache_address;
+	uint32_t cache_size = target->algorithm_cache_size;
+	uint32_t cache_crc = target->algorithm_cache_crc;
+	uint32_t crc;
+	int retval;
+
+	retval = target_alloc_working_area(target, code_size, area);
+	if (retval != ERROR_OK)
+		return retval;
+
+	image_calculate_checksum((uint8_t *)code, code_size, &crc);
+
+	if (cache_valid && cache_address == (*area)->address
+			&& cache_size == code_size && cache_crc == crc) {
+		LOG_DEBUG("algorithm image still resident at 0x%08"PRIx32", skipping download",
+				(*area)->address);
+		target->algorithm_cache_valid = true;
+		return ERROR_OK;
+	}
+
+	retval = target_write_buffer(target, (*area)->address, code_size, code);
+	if (retval != ERROR_OK) {
+		target_free_working_area(target, *area);
+		return retval;
+	}
+
+	target->algorithm_cache_address = (*area)->address;
+	target->algorithm_cache_size = code_size;
+	target->algorithm_cache_crc = crc;
+	target->algorithm_cache_valid = true;
+
+	return ERROR_OK;
+}
+
+static int target_restore_working_area(struct target *target, struct working_area *area)
+{
+	int retval = ERROR_OK;
+
+	if (target->backup_working_area && area->backup != NULL) {
+		retval = target_write_memory(target, area->address, 4, area->size / 4, area->backup);
+		if (retval != ERROR_OK)
+			LOG_ERROR("failed to restore %"PRIu32" bytes of working area at address 0x%08"PRIx32,
+					area->size, area->address);
+	}
+
+	return retval;
+}
+
+/* Restore the area's backup memory, if any, and return the area to the allocation pool */
+static int target_free_working_area_restore(struct target *target, struct working_area *area, int restore)
+{
+	int retval = ERROR_OK;
+
+	if (area->free)
+		return retval;
+
+	if (restore) {
+		retval = target_restore_working_area(target, area);
+		/* REVISIT: Perhaps the area should be freed even if restoring fails. */
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	area->free = true;
+
+	LOG_DEBUG("freed %"PRIu32" bytes of working area at address 0x%08"PRIx32,
+			area->size, area->address);
+
+	/* mark user pointer invalid */
+	/* TODO: Is this really safe? It points to some previous caller's memory.
+	 * How could we know that the area pointer is still in that place and not
+	 * some other vital data? What's the purpose of this, anyway? */
+	*area->user = NULL;
+	area->user = NULL;
+
+	target_merge_working_areas(target);
+
+	print_wa_layout(target);
+
+	return retval;
+}
+
+int target_free_working_area(struct target *target, struct working_area *area)
+{
+	return target_free_working_area_restore(target, area, 1);
+}
+
+void target_quit(void)
+{
+	struct target_event_callback *pe = target_event_callbacks;
+	while (pe) {
+		struct target_event_callback *t = pe->next;
+		free(pe);
+		pe = t;
+	}
+	target_event_callbacks = NULL;
+
+	struct target_timer_callback *pt = target_timer_callbacks;
+	while (pt) {
+		struct target_timer_callback *t = pt->next;
+		free(pt);
+		pt = t;
+	}
+	target_timer_callbacks = NULL;
+
+	for (struct target *target = all_targets;
+	     target; target = target->next) {
+		if (target->type->deinit_target)
+			target->type->deinit_target(target);
+	}
+}
+
+/* free resources and restore memory, if restoring memory fails,
+ * free up resources anyway
+ */
+static void target_free_all_working_areas_restore(struct target *target, int restore)
+{
+	struct working_area *c = target->working_areas;
+
+	LOG_DEBUG("freeing all working areas");
+
+	/* Loop through all areas, restoring the allocated ones and marking them as free */
+	while (c) {
+		if (!c->free) {
+			if (restore)
+				target_restore_working_area(target, c);
+			c->free = true;
+			*c->user = NULL; /* Same as above */
+			c->user = NULL;
+		}
+		c = c->next;
+	}
+
+	/* Run a merge pass to combine all areas into one */
+	target_merge_working_areas(target);
+
+	print_wa_layout(target);
+}
+
+void target_free_all_working_areas(struct target *target)
+{
+	target_free_all_working_areas_restore(target, 1);
+}
+
+/* Find the largest number of bytes that can be allocated */
+uint32_t target_get_working_area_avail(struct target *target)
+{
+	struct working_area *c = target->working_areas;
+	uint32_t max_size = 0;
+
+	if (c == NULL)
+		return target->working_area_size;
+
+	while (c) {
+		if (c->free && max_size < c->size)
+			max_size = c->size;
+
+		c = c->next;
+	}
+
+	return max_size;
+}
+
+int target_arch_state(struct target *target)
+{
+	int retval;
+	if (target == NULL) {
+		LOG_USER("No target has been configured");
+		return ERROR_OK;
+	}
+
+	LOG_USER("%s: target state: %s", target_name(target),
+		 target_state_name(target));
+
+	if (target->state != TARGET_HALTED)
+		return ERROR_OK;
+
+	retval = target->type->arch_state(target);
+	return retval;
+}
+
+static int target_get_gdb_fileio_info_default(struct target *target,
+		struct gdb_fileio_info *fileio_info)
+{
+	/* If target does not support semi-hosting function, target
+	   has no need to provide .get_gdb_fileio_info callback.
+	   It just return ERROR_FAIL and gdb_server will return "Txx"
+	   as target halted every time.  */
+	return ERROR_FAIL;
+}
+
+static int target_gdb_fileio_end_default(struct target *target,
+		int retcode, int fileio_errno, bool ctrl_c)
+{
+	return ERROR_OK;
+}
+
+static int target_profiling_default(struct target *target, uint32_t *samples,
+		uint32_t max_num_samples, uint32_t *num_samples, uint32_t seconds)
+{
+	struct timeval timeout, now;
+
+	gettimeofday(&timeout, NULL);
+	timeval_add_time(&timeout, seconds, 0);
+
+	LOG_INFO("Starting profiling. Halting and resuming the"
+			" target as often as we can...");
+
+	uint32_t sample_count = 0;
+	/* hopefully it is safe to cache! We want to stop/restart as quickly as possible. */
+	struct reg *reg = register_get_by_name(target->reg_cache, "pc", 1);
+
+	int retval = ERROR_OK;
+	for (;;) {
+		target_poll(target);
+		if (target->state == TARGET_HALTED) {
+			uint32_t t = buf_get_u32(reg->value, 0, 32);
+			samples[sample_count++] = t;
+			/* current pc, addr = 0, do not handle breakpoints, not debugging */
+			retval = target_resume(target, 1, 0, 0, 0);
+			target_poll(target);
+			alive_sleep(10); /* sleep 10ms, i.e. <100 samples/second. */
+		} else if (target->state == TARGET_RUNNING) {
+			/* We want to quickly sample the PC. */
+			retval = target_halt(target);
+		} else {
+			LOG_INFO("Target not halted or running");
+			retval = ERROR_OK;
+			break;
+		}
+
+		if (retval != ERROR_OK)
+			break;
+
+		gettimeofday(&now, NULL);
+		if ((sample_count >= max_num_samples) ||
+			((now.tv_sec >= timeout.tv_sec) && (now.tv_usec >= timeout.tv_usec))) {
+			LOG_INFO("Profiling completed. %" PRIu32 " samples.", sample_count);
+			break;
+		}
+	}
+
+	*num_samples = sample_count;
+	return retval;
+}
+
+/* Single aligned words are guaranteed to use 16 or 32 bit access
+ * mode respectively, otherwise data is handled as quickly as
+ * possible
+ */
+int target_write_buffer(struct target *target, uint32_t address, uint32_t size, const uint8_t *buffer)
+{
+	LOG_DEBUG("writing buffer of %i byte at 0x%8.8x",
+			(int)size, (unsigned)address);
+
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+
+	if (size == 0)
+		return ERROR_OK;
+
+	if ((address + size - 1) < address) {
+		/* GDB can request this when e.g. PC is 0xfffffffc*/
+		LOG_ERROR("address + size wrapped(0x%08x, 0x%08x)",
+				  (unsigned)address,
+				  (unsigned)size);
+		return ERROR_FAIL;
+	}
+
+	/* Custom write_buffer handlers may not route through
+	 * target_write_memory(), so invalidate here as well. */
+	target_algorithm_cache_invalidate(target, address, size);
+
+	return target->type->write_buffer(target, address, size, buffer);
+}
+
+/* Size of the chunks the default buffer handlers feed to the memory
+ * callbacks.  Derived from the adapter's measured payload rate so one
+ * chunk keeps the link busy for roughly 100 ms: long enough to amortize
+ * the per-call overhead and keep pipelined drivers fed, short enough
+ * that keep_alive() runs and errors abort a multi-megabyte transfer
+ * early.  Falls back to a fixed size until measurements exist. */
+static uint32_t target_buffer_chunk_size(void)
+{
+	const struct jtag_interface_stats *stats = jtag_get_interface_stats();
+	int64_t chunk = 64 * 1024;
+
+	if (stats->latency_us > 0 && stats->payload_bytes > 0)
+		chunk = stats->payload_bytes * 100000 / stats->latency_us;
+
+	if (chunk < 4 * 1024)
+		chunk = 4 * 1024;
+	if (chunk > 1024 * 1024)
+		chunk = 1024 * 1024;
+
+	/* keep whatever alignment the caller established */
+	return (uint32_t)chunk & ~(uint32_t)3;
+}
+
+static int target_write_buffer_default(struct target *target, uint32_t address, uint32_t count, const uint8_t *buffer)
+{
+	uint32_t size;
+	uint32_t chunk_size = target_buffer_chunk_size();
+
+	/* Align up to maximum 4 bytes. The loop condition makes sure the next pass
+	 * will have something to do with the size we leave to it. */
+	for (size = 1; size < 4 && count >= size * 2 + (address & size); size *= 2) {
+		if (address & size) {
+			int retval = target_write_memory(target, address, size, 1, buffer);
+			if (retval != ERROR_OK)
+				return retval;
+			address += size;
+			count -= size;
+			buffer += size;
+		}
+	}
+
+	/* Write the data with as large access size as possible. */
+	for (; size > 0; size /= 2) {
+		uint32_t aligned = count - count % size;
+		while (aligned > 0) {
+			uint32_t this_run = aligned;
+			if (this_run > chunk_size)
+				this_run = chunk_size;
+
+			int retval = target_write_memory(target, address, size, this_run / size, buffer);
+			if (retval != ERROR_OK)
+				return retval;
+			address += this_run;
+			count -= this_run;
+			buffer += this_run;
+			aligned -= this_run;
+
+			keep_alive();
+		}
+	}
+
+	return ERROR_OK;
+}
+
+/* Single aligned words are guaranteed to use 16 or 32 bit access
+ * mode respectively, otherwise data is handled as quickly as
+ * possible
+ */
+int target_read_buffer(struct target *target, uint32_t address, uint32_t size, uint8_t *buffer)
+{
+	LOG_DEBUG("reading buffer of %i byte at 0x%8.8x",
+			  (int)size, (unsigned)address);
+
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+
+	if (size == 0)
+		return ERROR_OK;
+
+	if ((address + size - 1) < address) {
+		/* GDB can request this when e.g. PC is 0xfffffffc*/
+		LOG_ERROR("address + size wrapped(0x%08" PRIx32 ", 0x%08" PRIx32 ")",
+				  address,
+				  size);
+		return ERROR_FAIL;
+	}
+
+	return target->type->read_buffer(target, address, size, buffer);
+}
+
+static int target_read_buffer_default(struct target *target, uint32_t address, uint32_t count, uint8_t *buffer)
+{
+	uint32_t size;
+	uint32_t chunk_size = target_buffer_chunk_size();
+
+	/* Align up to maximum 4 bytes. The loop condition makes sure the next pass
+	 * will have something to do with the size we leave to it. */
+	for (size = 1; size < 4 && count >= size * 2 + (address & size); size *= 2) {
+		if (address & size) {
+			int retval = target_read_memory(target, address, size, 1, buffer);
+			if (retval != ERROR_OK)
+				return retval;
+			address += size;
+			count -= size;
+			buffer += size;
+		}
+	}
+
+	/* Read the data with as large access size as possible. */
+	for (; size > 0; size /= 2) {
+		uint32_t aligned = count - count % size;
+		while (aligned > 0) {
+			uint32_t this_run = aligned;
+			if (this_run > chunk_size)
+				this_run = chunk_size;
+
+			int retval = target_read_memory(target, address, size, this_run / size, buffer);
+			if (retval != ERROR_OK)
+				return retval;
+			address += this_run;
+			count -= this_run;
+			buffer += this_run;
+			aligned -= this_run;
+
+			keep_alive();
+		}
+	}
+
+	return ERROR_OK;
+}
+
+int target_checksum_memory(struct target *target, uint32_t address, uint32_t size, uint32_t* crc)
+{
+	uint8_t *buffer;
+	int retval;
+	uint32_t i;
+	uint32_t checksum = 0;
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+
+	retval = target->type->checksum_memory(target, address, size, &checksum);
+	if (retval != ERROR_OK) {
+		buffer = malloc(size);
+		if (buffer == NULL) {
+			LOG_ERROR("error allocating buffer for section (%d bytes)", (int)size);
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		}
+		retval = target_read_buffer(target, address, size, buffer);
+		if (retval != ERROR_OK) {
+			free(buffer);
+			return retval;
+		}
+
+		/* convert to target endianness */
+		for (i = 0; i < (size/sizeof(uint32_t)); i++) {
+			uint32_t target_data;
+			target_data = target_buffer_get_u32(target, &buffer[i*sizeof(uint32_t)]);
+			target_buffer_set_u32(target, &buffer[i*sizeof(uint32_t)], target_data);
+		}
+
+		retval = image_calculate_checksum(buffer, size, &checksum);
+		free(buffer);
+	}
+
+	*crc = checksum;
+
+	return retval;
+}
+
+int target_blank_check_memory(struct target *target, uint32_t address, uint32_t size, uint32_t* blank)
+{
+	int retval;
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+
+	if (target->type->blank_check_memory == 0)
+		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+
+	retval = target->type->blank_check_memory(target, address, size, blank);
+
+	return retval;
+}
+
+int target_read_u64(struct target *target, uint64_t address, uint64_t *value)
+{
+	uint8_t value_buf[8];
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+
+	int retval = target_read_memory(target, address, 8, 1, value_buf);
+
+	if (retval == ERROR_OK) {
+		*value = target_buffer_get_u64(target, value_buf);
+		LOG_DEBUG("address: 0x%" PRIx64 ", value: 0x%16.16" PRIx64 "",
+				  address,
+				  *value);
+	} else {
+		*value = 0x0;
+		LOG_DEBUG("address: 0x%" PRIx64 " failed",
+				  address);
+	}
+
+	return retval;
+}
+
+int target_read_u32(struct target *target, uint32_t address, uint32_t *value)
+{
+	uint8_t value_buf[4];
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+
+	int retval = target_read_memory(target, address, 4, 1, value_buf);
+
+	if (retval == ERROR_OK) {
+		*value = target_buffer_get_u32(target, value_buf);
+		LOG_DEBUG("address: 0x%8.8" PRIx32 ", value: 0x%8.8" PRIx32 "",
+				  address,
+				  *value);
+	} else {
+		*value = 0x0;
+		LOG_DEBUG("address: 0x%8.8" PRIx32 " failed",
+				  address);
+	}
+
+	return retval;
+}
+
+int target_read_u16(struct target *target, uint32_t address, uint16_t *value)
+{
+	uint8_t value_buf[2];
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+
+	int retval = target_read_memory(target, address, 2, 1, value_buf);
+
+	if (retval == ERROR_OK) {
+		*value = target_buffer_get_u16(target, value_buf);
+		LOG_DEBUG("address: 0x%8.8" PRIx32 ", value: 0x%4.4x",
+				  address,
+				  *value);
+	} else {
+		*value = 0x0;
+		LOG_DEBUG("address: 0x%8.8" PRIx32 " failed",
+				  address);
+	}
+
+	return retval;
+}
+
+int target_read_u8(struct target *target, uint32_t address, uint8_t *value)
+{
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+
+	int retval = target_read_memory(target, address, 1, 1, value);
+
+	if (retval == ERROR_OK) {
+		LOG_DEBUG("address: 0x%8.8" PRIx32 ", value: 0x%2.2x",
+				  address,
+				  *value);
+	} else {
+		*value = 0x0;
+		LOG_DEBUG("address: 0x%8.8" PRIx32 " failed",
+				  address);
+	}
+
+	return retval;
+}
+
+int target_write_u64(struct target *target, uint64_t address, uint64_t value)
+{
+	int retval;
+	uint8_t value_buf[8];
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+
+	LOG_DEBUG("address: 0x%" PRIx64 ", value: 0x%16.16" PRIx64 "",
+			  address,
+			  value);
+
+	target_buffer_set_u64(target, value_buf, value);
+	retval = target_write_memory(target, address, 8, 1, value_buf);
+	if (retval != ERROR_OK)
+		LOG_DEBUG("failed: %i", retval);
+
+	return retval;
+}
+
+int target_write_u32(struct target *target, uint32_t address, uint32_t value)
+{
+	int retval;
+	uint8_t value_buf[4];
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+
+	LOG_DEBUG("address: 0x%8.8" PRIx32 ", value: 0x%8.8" PRIx32 "",
+			  address,
+			  value);
+
+	target_buffer_set_u32(target, value_buf, value);
+	retval = target_write_memory(target, address, 4, 1, value_buf);
+	if (retval != ERROR_OK)
+		LOG_DEBUG("failed: %i", retval);
+
+	return retval;
+}
+
+int target_write_u16(struct target *target, uint32_t address, uint16_t value)
+{
+	int retval;
+	uint8_t value_buf[2];
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+
+	LOG_DEBUG("address: 0x%8.8" PRIx32 ", value: 0x%8.8x",
+			  address,
+			  value);
+
+	target_buffer_set_u16(target, value_buf, value);
+	retval = target_write_memory(target, address, 2, 1, value_buf);
+	if (retval != ERROR_OK)
+		LOG_DEBUG("failed: %i", retval);
+
+	return retval;
+}
+
+int target_write_u8(struct target *target, uint32_t address, uint8_t value)
+{
+	int retval;
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+
+	LOG_DEBUG("address: 0x%8.8" PRIx32 ", value: 0x%2.2x",
+			  address, value);
+
+	retval = target_write_memory(target, address, 1, 1, &value);
+	if (retval != ERROR_OK)
+		LOG_DEBUG("failed: %i", retval);
+
+	return retval;
+}
+
+static int find_target(struct command_context *cmd_ctx, const char *name)
+{
+	struct target *target = get_target(name);
+	if (target == NULL) {
+		LOG_ERROR("Target: %s is unknown, try one of:\n", name);
+		return ERROR_FAIL;
+	}
+	if (!target->tap->enabled) {
+		LOG_USER("Target: TAP %s is disabled, "
+			 "can't be the current target\n",
+			 target->tap->dotted_name);
+		return ERROR_FAIL;
+	}
+
+	cmd_ctx->current_target = target->target_number;
+	return ERROR_OK;
+}
+
+
+COMMAND_HANDLER(handle_targets_command)
+{
+	int retval = ERROR_OK;
+	if (CMD_ARGC == 1) {
+		retval = find_target(CMD_CTX, CMD_ARGV[0]);
+		if (retval == ERROR_OK) {
+			/* we're done! */
+			return retval;
+		}
+	}
+
+	struct target *target = all_targets;
+	command_print(CMD_CTX, "    TargetName         Type       Endian TapName            State       ");
+	command_print(CMD_CTX, "--  ------------------ ---------- ------ ------------------ ------------");
+	while (target) {
+		const char *state;
+		char marker = ' ';
+
+		if (target->tap->enabled)
+			state = target_state_name(target);
+		else
+			state = "tap-disabled";
+
+		if (CMD_CTX->current_target == target->target_number)
+			marker = '*';
+
+		/* keep columns lined up to match the headers above */
+		command_print(CMD_CTX,
+				"%2d%c %-18s %-10s %-6s %-18s %s",
+				target->target_number,
+				marker,
+				target_name(target),
+				target_type_name(target),
+				Jim_Nvp_value2name_simple(nvp_target_endian,
+					target->endianness)->name,
+				target->tap->dotted_name,
+				state);
+		target = target->next;
+	}
+
+	return retval;
+}
+
+/* every 300ms we check for reset & powerdropout and issue a "reset halt" if so. */
+
+static int powerDropout;
+static int srstAsserted;
+
+static int runPowerRestore;
+static int runPowerDropout;
+static int runSrstAsserted;
+static int runSrstDeasserted;
+
+static int sense_handler(void)
+{
+	static int prevSrstAsserted;
+	static int prevPowerdropout;
+
+	int retval = jtag_power_dropout(&powerDropout);
+	if (retval != ERROR_OK)
+		return retval;
+
+	int powerRestored;
+	powerRestored = prevPowerdropout && !powerDropout;
+	if (powerRestored)
+		runPowerRestore = 1;
+
+	long long current = timeval_ms();
+	static long long lastPower;
+	int waitMore = lastPower + 2000 > current;
+	if (powerDropout && !waitMore) {
+		runPowerDropout = 1;
+		lastPower = current;
+	}
+
+	retval = jtag_srst_asserted(&srstAsserted);
+	if (retval != ERROR_OK)
+		return retval;
+
+	int srstDeasserted;
+	srstDeasserted = prevSrstAsserted && !srstAsserted;
+
+	static long long lastSrst;
+	waitMore = lastSrst + 2000 > current;
+	if (srstDeasserted && !waitMore) {
+		runSrstDeasserted = 1;
+		lastSrst = current;
+	}
+
+	if (!prevSrstAsserted && srstAsserted)
+		runSrstAsserted = 1;
+
+	prevSrstAsserted = srstAsserted;
+	prevPowerdropout = powerDropout;
+
+	if (srstDeasserted || powerRestored) {
+		/* Other than logging the event we can't do anything here.
+		 * Issuing a reset is a particularly bad idea as we might
+		 * be inside a reset already.
+		 */
+	}
+
+	return ERROR_OK;
+}
+
+/* process target state changes */
+/* Adjust the period of the polling timer callback; takes effect when the
+ * callback is re-armed after the current invocation returns. */
+static void target_polling_timer_adjust(int64_t period)
+{
+	struct target_timer_callback *callback;
+
+	if (period < 1)
+		period = 1;
+
+	for (callback = target_timer_callbacks; callback; callback = callback->next)
+		if (callback->callback == handle_target && callback->periodic)
+			callback->time_ms = period;
+}
+
+static int handle_target(void *priv)
+{
+	Jim_Interp *interp = (Jim_Interp *)priv;
+	int retval = ERROR_OK;
+
+	if (!is_jtag_poll_safe()) {
+		/* polling is disabled currently */
+		return ERROR_OK;
+	}
+
+	/* we do not want to recurse here... */
+	static int recursive;
+	if (!recursive) {
+		recursive = 1;
+		sense_handler();
+		/* danger! running these procedures can trigger srst assertions and power dropouts.
+		 * We need to avoid an infinite loop/recursion here and we do that by
+		 * clearing the flags after running these events.
+		 */
+		int did_something = 0;
+		if (runSrstAsserted) {
+			LOG_INFO("srst asserted detected, running srst_asserted proc.");
+			Jim_Eval(interp, "srst_asserted");
+			did_something = 1;
+		}
+		if (runSrstDeasserted) {
+			Jim_Eval(interp, "srst_deasserted");
+			did_something = 1;
+		}
+		if (runPowerDropout) {
+			LOG_INFO("Power dropout detected, running power_dropout proc.");
+			Jim_Eval(interp, "power_dropout");
+			did_something = 1;
+		}
+		if (runPowerRestore) {
+			Jim_Eval(interp, "power_restore");
+			did_something = 1;
+		}
+
+		if (did_something) {
+			/* clear detect flags */
+			sense_handler();
+		}
+
+		/* clear action flags */
+
+		runSrstAsserted = 0;
+		runSrstDeasserted = 0;
+		runPowerRestore = 0;
+		runPowerDropout = 0;
+
+		recursive = 0;
+	}
+
+	/* Poll targets for state changes unless that's globally disabled.
+	 * Skip targets that are currently disabled.
+	 */
+	int64_t now = timeval_ms();
+	int64_t next_poll = now + polling_interval;
+	for (struct target *target = all_targets;
+			is_jtag_poll_safe() && target;
+			target = target->next) {
+
+		if (!target_was_examined(target))
+			continue;
+
+		if (!target->tap->enabled)
+			continue;
+
+		/* not due yet? */
+		if (target->next_poll_time > now) {
+			if (target->next_poll_time < next_poll)
+				next_poll = target->next_poll_time;
+			continue;
+		}
+
+		if (target->backoff.times > target->backoff.count) {
+			/* do not poll this time as we failed previously */
+			target->backoff.count++;
+			continue;
+		}
+		target->backoff.count = 0;
+
+		/* only poll target if we've got power and srst isn't asserted */
+		if (!powerDropout && !srstAsserted) {
+			enum target_state old_state = target->state;
+
+			/* polling may fail silently until the target has been examined */
+			retval = target_poll(target);
+			if (retval != ERROR_OK) {
+				/* 100ms polling interval. Increase interval between polling up to 5000ms */
+				if (target->backoff.times * polling_interval < 5000) {
+					target->backoff.times *= 2;
+					target->backoff.times++;
+				}
+
+				/* Tell GDB to halt the debugger. This allows the user to
+				 * run monitor commands to handle the situation.
+				 */
+				target_call_event_callbacks(target, TARGET_EVENT_GDB_HALT);
+			}
+			if (target->backoff.times > 0) {
+				LOG_USER("Polling target %s failed, trying to reexamine", target_name(target));
+				target_reset_examined(target);
+				retval = target_examine_one(target);
+				/* Target examination could have failed due to unstable connection,
+				 * but we set the examined flag anyway to repoll it later */
+				if (retval != ERROR_OK) {
+					target->examined = true;
+					LOG_USER("Examination failed, GDB will be halted. Polling again in %dms",
+						 target->backoff.times * polling_interval);
+					return retval;
+				}
+			}
+
+			/* Since we succeeded, we reset backoff count */
+			target->backoff.times = 0;
+
+			/* adapt this target's poll interval: a state change pulls
+			 * it back to the fast rate, a target sitting halted (or
+			 * never seen running) backs off exponentially */
+			if (target->state != old_state)
+				target->poll_interval = polling_interval_min;
+			else if (target->state == TARGET_HALTED
+					|| target->state == TARGET_UNKNOWN) {
+				if (target->poll_interval * 2 <= target->poll_interval_max)
+					target->poll_interval *= 2;
+			} else if (target->poll_interval * 2 <= polling_interval) {
+				/* creep back to the regular rate once the fast
+				 * post-resume polls found nothing */
+				target->poll_interval *= 2;
+			}
+			if (target->poll_interval < polling_interval_min)
+				target->poll_interval = polling_interval_min;
+			target->next_poll_time = now + target->poll_interval;
+			if (target->next_poll_time < next_poll)
+				next_poll = target->next_poll_time;
+		}
+	}
+
+	/* re-arm when the next target is due instead of at the fixed period;
+	 * next_poll is capped at polling_interval so the srst/power sensing
+	 * above keeps its usual rate */
+	target_polling_timer_adjust(next_poll - now);
+
+	return retval;
+}
+
+COMMAND_HANDLER(handle_reg_command)
+{
+	struct target *target;
+	struct reg *reg = NULL;
+	unsigned count = 0;
+	char *value;
+
+	LOG_DEBUG("-");
+
+	target = get_current_target(CMD_CTX);
+
+	/* list all available registers for the current target */
+	if (CMD_ARGC == 0) {
+		struct reg_cache *cache = target->reg_cache;
+
+		count = 0;
+		while (cache) {
+			unsigned i;
+
+			command_print(CMD_CTX, "===== %s", cache->name);
+
+			for (i = 0, reg = cache->reg_list;
+					i < cache->num_regs;
+					i++, reg++, count++) {
+				/* only print cached values if they are valid */
+				if (reg->valid) {
+					value = buf_to_str(reg->value,
+							reg->size, 16);
+					command_print(CMD_CTX,
+							"(%i) %s (/%" PRIu32 "): 0x%s%s",
+							count, reg->name,
+							reg->size, value,
+							reg->dirty
+								? " (dirty)"
+								: "");
+					free(value);
+				} else {
+					command_print(CMD_CTX, "(%i) %s (/%" PRIu32 ")",
+							  count, reg->name,
+							  reg->size) ;
+				}
+			}
+			cache = cache->next;
+		}
+
+		return ERROR_OK;
+	}
+
+	/* access a single register by its ordinal number */
+	if ((CMD_ARGV[0][0] >= '0') && (CMD_ARGV[0][0] <= '9')) {
+		unsigned num;
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], num);
+
+		struct reg_cache *cache = target->reg_cache;
+		count = 0;
+		while (cache) {
+			unsigned i;
+			for (i = 0; i < cache->num_regs; i++) {
+				if (count++ == num) {
+					reg = &cache->reg_list[i];
+					break;
+				}
+			}
+			if (reg)
+				break;
+			cache = cache->next;
+		}
+
+		if (!reg) {
+			command_print(CMD_CTX, "%i is out of bounds, the current target "
+					"has only %i registers (0 - %i)", num, count, count - 1);
+			return ERROR_OK;
+		}
+	} else {
+		/* access a single register by its name */
+		reg = register_get_by_name(target->reg_cache, CMD_ARGV[0], 1);
+
+		if (!reg) {
+			command_print(CMD_CTX, "register %s not found in current target", CMD_ARGV[0]);
+			return ERROR_OK;
+		}
+	}
+
+	assert(reg != NULL); /* give clang a hint that we *know* reg is != NULL here */
+
+	/* display a register */
+	if ((CMD_ARGC == 1) || ((CMD_ARGC == 2) && !((CMD_ARGV[1][0] >= '0')
+			&& (CMD_ARGV[1][0] <= '9')))) {
+		if ((CMD_ARGC == 2) && (strcmp(CMD_ARGV[1], "force") == 0))
+			reg->valid = 0;
+
+		if (reg->valid == 0)
+			reg->type->get(reg);
+		value = buf_to_str(reg->value, reg->size, 16);
+		command_print(CMD_CTX, "%s (/%i): 0x%s", reg->name, (int)(reg->size), value);
+		free(value);
+		return ERROR_OK;
+	}
+
+	/* set register value */
+	if (CMD_ARGC == 2) {
+		uint8_t *buf = malloc(DIV_ROUND_UP(reg->size, 8));
+		if (buf == NULL)
+			return ERROR_FAIL;
+		str_to_buf(CMD_ARGV[1], strlen(CMD_ARGV[1]), buf, reg->size, 0);
+
+		reg->type->set(reg, buf);
+
+		value = buf_to_str(reg->value, reg->size, 16);
+		command_print(CMD_CTX, "%s (/%i): 0x%s", reg->name, (int)(reg->size), value);
+		free(value);
+
+		free(buf);
+
+		return ERROR_OK;
+	}
+
+	return ERROR_COMMAND_SYNTAX_ERROR;
+}
+
+COMMAND_HANDLER(handle_poll_command)
+{
+	int retval = ERROR_OK;
+	struct target *target = get_current_target(CMD_CTX);
+
+	if (CMD_ARGC == 0) {
+		command_print(CMD_CTX, "background polling: %s",
+				jtag_poll_get_enabled() ? "on" : "off");
+		command_print(CMD_CTX, "TAP: %s (%s)",
+				target->tap->dotted_name,
+				target->tap->enabled ? "enabled" : "disabled");
+		if (!target->tap->enabled)
+			return ERROR_OK;
+		retval = target_poll(target);
+		if (retval != ERROR_OK)
+			return retval;
+		retval = target_arch_state(target);
+		if (retval != ERROR_OK)
+			return retval;
+	} else if (CMD_ARGC == 1) {
+		bool enable;
+		COMMAND_PARSE_ON_OFF(CMD_ARGV[0], enable);
+		jtag_poll_set_enabled(enable);
+	} else
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	return retval;
+}
+
+COMMAND_HANDLER(handle_wait_halt_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	unsigned ms = DEFAULT_HALT_TIMEOUT;
+	if (1 == CMD_ARGC) {
+		int retval = parse_uint(CMD_ARGV[0], &ms);
+		if (ERROR_OK != retval)
+			return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+
+	struct target *target = get_current_target(CMD_CTX);
+	return target_wait_state(target, TARGET_HALTED, ms);
+}
+
+COMMAND_HANDLER(handle_await_register_command)
+{
+	if (CMD_ARGC < 3 || CMD_ARGC > 4)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	uint32_t address;
+	uint32_t mask;
+	uint32_t value;
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], address);
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], mask);
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[2], value);
+
+	unsigned timeout = 1000;
+	if (CMD_ARGC == 4) {
+		int retval = parse_uint(CMD_ARGV[3], &timeout);
+		if (ERROR_OK != retval)
+			return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+
+	struct target *target = get_current_target(CMD_CTX);
+
+	/* adaptive backoff: react within a millisecond if the bits flip
+	 * quickly, but settle to a gentle rate on long waits so the
+	 * adapter is not hammered; alive_sleep() keeps GDB fed meanwhile */
+	long long then = timeval_ms();
+	unsigned interval = 1;
+	for (;;) {
+		uint32_t current;
+		int retval = target_read_u32(target, address, &current);
+		if (retval != ERROR_OK)
+			return retval;
+
+		if ((current & mask) == value) {
+			command_print(CMD_CTX, "0x%8.8" PRIx32 ": 0x%8.8" PRIx32,
+				address, current);
+			return ERROR_OK;
+		}
+
+		if (timeval_ms() - then > timeout) {
+			LOG_ERROR("timed out while waiting for 0x%8.8" PRIx32
+				" & 0x%8.8" PRIx32 " == 0x%8.8" PRIx32
+				" (last read 0x%8.8" PRIx32 ")",
+				address, mask, value, current);
+			return ERROR_FAIL;
+		}
+
+		alive_sleep(interval);
+		if (interval < 50)
+			interval *= 2;
+	}
+}
+
+/* wait for target state to change. The trick here is to have a low
+ * latency for short waits and not to suck up all the CPU time
+ * on longer waits.
+ *
+ * After 500ms, keep_alive() is invoked
+ */
+int target_wait_state(struct target *target, enum target_state state, int ms)
+{
+	int retval;
+	long long then = 0, cur;
+	int once = 1;
+
+	for (;;) {
+		retval = target_poll(target);
+		if (retval != ERROR_OK)
+			return retval;
+		if (target->state == state)
+			break;
+		cur = timeval_ms();
+		if (once) {
+			once = 0;
+			then = timeval_ms();
+			LOG_DEBUG("waiting for target %s...",
+				Jim_Nvp_value2name_simple(nvp_target_state, state)->name);
+		}
+
+		if (cur-then > 500)
+			keep_alive();
+
+		if ((cur-then) > ms) {
+			LOG_ERROR("timed out while waiting for target %s",
+				Jim_Nvp_value2name_simple(nvp_target_state, state)->name);
+			return ERROR_FAIL;
+		}
+	}
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_halt_command)
+{
+	LOG_DEBUG("-");
+
+	struct target *target = get_current_target(CMD_CTX);
+	int retval = target_halt(target);
+	if (ERROR_OK != retval)
+		return retval;
+
+	if (CMD_ARGC == 1) {
+		unsigned wait_local;
+		retval = parse_uint(CMD_ARGV[0], &wait_local);
+		if (ERROR_OK != retval)
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		if (!wait_local)
+			return ERROR_OK;
+	}
+
+	return CALL_COMMAND_HANDLER(handle_wait_halt_command);
+}
+
+COMMAND_HANDLER(handle_soft_reset_halt_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+
+	LOG_USER("requesting target halt and executing a soft reset");
+
+	target_soft_reset_halt(target);
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_reset_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	enum target_reset_mode reset_mode = RESET_RUN;
+	if (CMD_ARGC == 1) {
+		const Jim_Nvp *n;
+		n = Jim_Nvp_name2value_simple(nvp_reset_modes, CMD_ARGV[0]);
+		if ((n->name == NULL) || (n->value == RESET_UNKNOWN))
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		reset_mode = n->value;
+	}
+
+	/* reset *all* targets */
+	return target_process_reset(CMD_CTX, reset_mode);
+}
+
+
+COMMAND_HANDLER(handle_resume_command)
+{
+	int current = 1;
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	struct target *target = get_current_target(CMD_CTX);
+
+	/* with no CMD_ARGV, resume from current pc, addr = 0,
+	 * with one arguments, addr = CMD_ARGV[0],
+	 * handle breakpoints, not debugging */
+	uint32_t addr = 0;
+	if (CMD_ARGC == 1) {
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], addr);
+		current = 0;
+	}
+
+	return target_resume(target, current, addr, 1, 0);
+}
+
+COMMAND_HANDLER(handle_step_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	LOG_DEBUG("-");
+
+	/* with no CMD_ARGV, step from current pc, addr = 0,
+	 * with one argument addr = CMD_ARGV[0],
+	 * handle breakpoints, debugging */
+	uint32_t addr = 0;
+	int current_pc = 1;
+	if (CMD_ARGC == 1) {
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], addr);
+		current_pc = 0;
+	}
+
+	struct target *target = get_current_target(CMD_CTX);
+
+	return target->type->step(target, current_pc, addr, 1);
+}
+
+static void handle_md_output(struct command_context *cmd_ctx,
+		struct target *target, uint32_t address, unsigned size,
+		unsigned count, const uint8_t *buffer)
+{
+	const unsigned line_bytecnt = 32;
+	unsigned line_modulo = line_bytecnt / size;
+
+	char output[line_bytecnt * 4 + 1];
+	unsigned output_len = 0;
+
+	const char *value_fmt;
+	switch (size) {
+	case 4:
+		value_fmt = "%8.8x ";
+		break;
+	case 2:
+		value_fmt = "%4.4x ";
+		break;
+	case 1:
+		value_fmt = "%2.2x ";
+		break;
+	default:
+		/* "can't happen", caller checked */
+		LOG_ERROR("invalid memory read size: %u", size);
+		return;
+	}
+
+	for (unsigned i = 0; i < count; i++) {
+		if (i % line_modulo == 0) {
+			output_len += snprintf(output + output_len,
+					sizeof(output) - output_len,
+					"0x%8.8x: ",
+					(unsigned)(address + (i*size)));
+		}
+
+		uint32_t value = 0;
+		const uint8_t *value_ptr = buffer + i * size;
+		switch (size) {
+		case 4:
+			value = target_buffer_get_u32(target, value_ptr);
+			break;
+		case 2:
+			value = target_buffer_get_u16(target, value_ptr);
+			break;
+		case 1:
+			value = *value_ptr;
+		}
+		output_len += snprintf(output + output_len,
+				sizeof(output) - output_len,
+				value_fmt, value);
+
+		if ((i % line_modulo == line_modulo - 1) || (i == count - 1)) {
+			command_print(cmd_ctx, "%s", output);
+			output_len = 0;
+		}
+	}
+}
+
+COMMAND_HANDLER(handle_md_command)
+{
+	if (CMD_ARGC < 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	unsigned size = 0;
+	switch (CMD_NAME[2]) {
+	case 'w':
+		size = 4;
+		break;
+	case 'h':
+		size = 2;
+		break;
+	case 'b':
+		size = 1;
+		break;
+	default:
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+
+	bool physical = strcmp(CMD_ARGV[0], "phys") == 0;
+	int (*fn)(struct target *target,
+			uint32_t address, uint32_t size_value, uint32_t count, uint8_t *buffer);
+	if (physical) {
+		CMD_ARGC--;
+		CMD_ARGV++;
+		fn = target_read_phys_memory;
+	} else
+		fn = target_read_memory;
+	if ((CMD_ARGC < 1) || (CMD_ARGC > 2))
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	uint32_t address;
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], address);
+
+	unsigned count = 1;
+	if (CMD_ARGC == 2)
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[1], count);
+
+	uint8_t *buffer = calloc(count, size);
+
+	struct target *target = get_current_target(CMD_CTX);
+	int retval = fn(target, address, size, count, buffer);
+	if (ERROR_OK == retval)
+		handle_md_output(CMD_CTX, target, address, size, count, buffer);
+
+	free(buffer);
+
+	return retval;
+}
+
+typedef int (*target_write_fn)(struct target *target,
+		uint32_t address, uint32_t size, uint32_t count, const uint8_t *buffer);
+
+static int target_fill_mem(struct target *target,
+		uint32_t address,
+		target_write_fn fn,
+		unsigned data_size,
+		/* value */
+		uint32_t b,
+		/* count */
+		unsigned c)
+{
+	/* Expanding the pattern on the target itself moves no data over the
+	 * wire at all; only available for plain memory writes, and only when
+	 * the target provides an algorithm-based implementation. */
+	if (fn == target_write_memory && target->type->fill_memory != NULL) {
+		int retval = target->type->fill_memory(target, address, data_size, c, b);
+		if (retval == ERROR_OK)
+			return retval;
+		LOG_DEBUG("on-target fill failed, falling back to host-side fill");
+	}
+
+	/* We have to write in reasonably large chunks to be able
+	 * to fill large memory areas with any sane speed */
+	const unsigned chunk_size = 16384;
+	uint8_t *target_buf = malloc(chunk_size * data_size);
+	if (target_buf == NULL) {
+		LOG_ERROR("Out of memory");
+		return ERROR_FAIL;
+	}
+
+	for (unsigned i = 0; i < chunk_size; i++) {
+		switch (data_size) {
+		case 4:
+			target_buffer_set_u32(target, target_buf + i * data_size, b);
+			break;
+		case 2:
+			target_buffer_set_u16(target, target_buf + i * data_size, b);
+			break;
+		case 1:
+			target_buffer_set_u8(target, target_buf + i * data_size, b);
+			break;
+		default:
+			exit(-1);
+		}
+	}
+
+	int retval = ERROR_OK;
+
+	for (unsigned x = 0; x < c; x += chunk_size) {
+		unsigned current;
+		current = c - x;
+		if (current > chunk_size)
+			current = chunk_size;
+		retval = fn(target, address + x * data_size, data_size, current, target_buf);
+		if (retval != ERROR_OK)
+			break;
+		/* avoid GDB timeouts */
+		keep_alive();
+	}
+	free(target_buf);
+
+	return retval;
+}
+
+
+COMMAND_HANDLER(handle_mw_command)
+{
+	if (CMD_ARGC < 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	bool physical = strcmp(CMD_ARGV[0], "phys") == 0;
+	target_write_fn fn;
+	if (physical) {
+		CMD_ARGC--;
+		CMD_ARGV++;
+		fn = target_write_phys_memory;
+	} else
+		fn = target_write_memory;
+	if ((CMD_ARGC < 2) || (CMD_ARGC > 3))
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	uint32_t address;
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], address);
+
+	uint32_t value;
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], value);
+
+	unsigned count = 1;
+	if (CMD_ARGC == 3)
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[2], count);
+
+	struct target *target = get_current_target(CMD_CTX);
+	unsigned wordsize;
+	switch (CMD_NAME[2]) {
+		case 'w':
+			wordsize = 4;
+			break;
+		case 'h':
+			wordsize = 2;
+			break;
+		case 'b':
+			wordsize = 1;
+			break;
+		default:
+			return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+
+	return target_fill_mem(target, address, fn, wordsize, value, count);
+}
+
+static COMMAND_HELPER(parse_load_image_command_CMD_ARGV, struct image *image,
+		uint32_t *min_address, uint32_t *max_address)
+{
+	if (CMD_ARGC < 1 || CMD_ARGC > 5)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	/* a base address isn't always necessary,
+	 * default to 0x0 (i.e. don't relocate) */
+	if (CMD_ARGC >= 2) {
+		uint32_t addr;
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], addr);
+		image->base_address = addr;
+		image->base_address_set = 1;
+	} else
+		image->base_address_set = 0;
+
+	image->start_address_set = 0;
+
+	if (CMD_ARGC >= 4)
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[3], *min_address);
+	if (CMD_ARGC == 5) {
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[4], *max_address);
+		/* use size (given) to find max (required) */
+		*max_address += *min_address;
+	}
+
+	if (*min_address > *max_address)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_load_image_command)
+{
+	uint8_t *buffer;
+	size_t buf_cnt;
+	uint32_t image_size;
+	uint32_t min_address = 0;
+	uint32_t max_address = 0xffffffff;
+	int i;
+	struct image image;
+
+	int retval = CALL_COMMAND_HANDLER(parse_load_image_command_CMD_ARGV,
+			&image, &min_address, &max_address);
+	if (ERROR_OK != retval)
+		return retval;
+
+	struct target *target = get_current_target(CMD_CTX);
+
+	struct duration bench;
+	duration_start(&bench);
+
+	if (image_open(&image, CMD_ARGV[0], (CMD_ARGC >= 3) ? CMD_ARGV[2] : NULL) != ERROR_OK)
+		return ERROR_OK;
+
+	uint64_t total_bytes = 0;
+	for (i = 0; i < image.num_sections; i++)
+		total_bytes += image.sections[i].size;
+	progress_start("load_image", total_bytes);
+
+	image_size = 0x0;
+	retval = ERROR_OK;
+
+	/* Stream every section through one bounded chunk buffer instead of
+	 * slurping it in whole.  While target_write_buffer() is blocked on
+	 * the adapter, the kernel readahead is already fetching the next
+	 * file chunk, so file I/O (NFS mounts in particular) overlaps the
+	 * download instead of being paid up front; it also keeps the memory
+	 * footprint flat for large sections and the progress ticking.
+	 */
+	const uint32_t chunk_size = 256 * 1024;
+	buffer = malloc(chunk_size);
+	if (buffer == NULL) {
+		command_print(CMD_CTX,
+					  "error allocating buffer for section (%d bytes)",
+					  (int)chunk_size);
+		progress_done();
+		image_close(&image);
+		return ERROR_FAIL;
+	}
+
+	for (i = 0; i < image.num_sections; i++) {
+		uint32_t offset = 0;
+		uint32_t length = image.sections[i].size;
+
+		/* DANGER!!! beware of unsigned comparision here!!! */
+
+		if ((image.sections[i].base_address + length < min_address) ||
+				(image.sections[i].base_address >= max_address))
+			continue;
+
+		if (image.sections[i].base_address < min_address) {
+			/* clip addresses below */
+			offset += min_address-image.sections[i].base_address;
+			length -= offset;
+		}
+
+		if (image.sections[i].base_address + image.sections[i].size > max_address)
+			length -= (image.sections[i].base_address + image.sections[i].size)-max_address;
+
+		uint32_t written = 0;
+		while (written < length) {
+			uint32_t chunk = length - written;
+			if (chunk > chunk_size)
+				chunk = chunk_size;
+
+			retval = image_read_section(&image, i, offset + written,
+					chunk, buffer, &buf_cnt);
+			if (retval != ERROR_OK)
+				break;
+			if (buf_cnt == 0)
+				break;
+
+			retval = target_write_buffer(target,
+					image.sections[i].base_address + offset + written,
+					buf_cnt, buffer);
+			if (retval != ERROR_OK)
+				break;
+			written += buf_cnt;
+			progress_add(buf_cnt);
+
+			/* short read ends the section */
+			if (buf_cnt < chunk)
+				break;
+		}
+		if (retval != ERROR_OK)
+			break;
+
+		image_size += written;
+		command_print(CMD_CTX, "%u bytes written at address 0x%8.8" PRIx32 "",
+				(unsigned int)written,
+				image.sections[i].base_address + offset);
+	}
+
+	free(buffer);
+	progress_done();
+
+	if ((ERROR_OK == retval) && (duration_measure(&bench) == ERROR_OK)) {
+		command_print(CMD_CTX, "downloaded %" PRIu32 " bytes "
+				"in %fs (%0.3f KiB/s)", image_size,
+				duration_elapsed(&bench), duration_kbps(&bench, image_size));
+	}
+
+	image_close(&image);
+
+	return retval;
+
+}
+
+COMMAND_HANDLER(handle_dump_image_command)
+{
+	struct fileio fileio;
+	uint8_t *buffer;
+	int retval, retvaltemp;
+	uint32_t address, size;
+	struct duration bench;
+	struct target *target = get_current_target(CMD_CTX);
+
+	if (CMD_ARGC != 3)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], address);
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[2], size);
+
+	/* Dump in large chunks: fileio_write() only copies into the page
+	 * cache and returns, so the kernel flushes chunk N to disk while
+	 * the adapter is busy reading chunk N+1, and the big chunk size
+	 * amortizes the per-transfer setup cost on the target side. */
+	uint32_t buf_size = (size > (1024 * 1024)) ? (1024 * 1024) : size;
+	buffer = malloc(buf_size);
+	if (!buffer)
+		return ERROR_FAIL;
+
+	retval = fileio_open(&fileio, CMD_ARGV[0], FILEIO_WRITE, FILEIO_BINARY);
+	if (retval != ERROR_OK) {
+		free(buffer);
+		return retval;
+	}
+
+	duration_start(&bench);
+
+	while (size > 0) {
+		size_t size_written;
+		uint32_t this_run_size = (size > buf_size) ? buf_size : size;
+		retval = target_read_buffer(target, address, this_run_size, buffer);
+		if (retval != ERROR_OK)
+			break;
+
+		retval = fileio_write(&fileio, this_run_size, buffer, &size_written);
+		if (retval != ERROR_OK)
+			break;
+
+		size -= this_run_size;
+		address += this_run_size;
+	}
+
+	free(buffer);
+
+	if ((ERROR_OK == retval) && (duration_measure(&bench) == ERROR_OK)) {
+		size_t filesize;
+		retval = fileio_size(&fileio, &filesize);
+		if (retval != ERROR_OK)
+			return retval;
+		command_print(CMD_CTX,
+				"dumped %zu bytes in %fs (%0.3f KiB/s)", filesize,
+				duration_elapsed(&bench), duration_kbps(&bench, filesize));
+	}
+
+	retvaltemp = fileio_close(&fileio);
+	if (retvaltemp != ERROR_OK)
+		return retvaltemp;
+
+	return retval;
+}
+
+static COMMAND_HELPER(handle_verify_image_command_internal, int verify)
+{
+	uint8_t *buffer;
+	size_t buf_cnt;
+	uint32_t image_size;
+	int i;
+	int retval;
+	uint32_t checksum = 0;
+	uint32_t mem_checksum = 0;
+
+	struct image image;
+
+	struct target *target = get_current_target(CMD_CTX);
+
+	if (CMD_ARGC < 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (!target) {
+		LOG_ERROR("no target selected");
+		return ERROR_FAIL;
+	}
+
+	struct duration bench;
+	duration_start(&bench);
+
+	if (CMD_ARGC >= 2) {
+		uint32_t addr;
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], addr);
+		image.base_address = addr;
+		image.base_address_set = 1;
+	} else {
+		image.base_address_set = 0;
+		image.base_address = 0x0;
+	}
+
+	image.start_address_set = 0;
+
+	retval = image_open(&image, CMD_ARGV[0], (CMD_ARGC == 3) ? CMD_ARGV[2] : NULL);
+	if (retval != ERROR_OK)
+		return retval;
+
+	image_size = 0x0;
+	int diffs = 0;
+	retval = ERROR_OK;
+
+	/* Verify in bounded blocks.  Each block is checksummed by the
+	 * on-target CRC kernel, so only the per-block result comes back
+	 * over the wire, and a mismatch reads back just the failing block
+	 * for the byte compare instead of the whole section.
+	 */
+	const uint32_t block_size = 64 * 1024;
+	buffer = malloc(block_size);
+	if (buffer == NULL) {
+		command_print(CMD_CTX,
+				"error allocating buffer for section (%d bytes)",
+				(int)block_size);
+		image_close(&image);
+		return ERROR_FAIL;
+	}
+
+	for (i = 0; i < image.num_sections; i++) {
+		uint32_t done = 0;
+
+		while (done < image.sections[i].size) {
+			uint32_t block = image.sections[i].size - done;
+			if (block > block_size)
+				block = block_size;
+
+			retval = image_read_section(&image, i, done, block, buffer, &buf_cnt);
+			if (retval != ERROR_OK)
+				break;
+			if (buf_cnt == 0)
+				break;
+
+			uint32_t address = image.sections[i].base_address + done;
+
+			if (verify) {
+				/* calculate checksum of image block */
+				retval = image_calculate_checksum(buffer, buf_cnt, &checksum);
+				if (retval != ERROR_OK)
+					break;
+
+				retval = target_checksum_memory(target, address, buf_cnt, &mem_checksum);
+				if (retval != ERROR_OK)
+					break;
+
+				if (checksum != mem_checksum) {
+					/* failed crc checksum, fall back to a binary compare */
+					uint8_t *data;
+
+					if (diffs == 0)
+						LOG_ERROR("checksum mismatch - attempting binary compare");
+
+					data = malloc(buf_cnt);
+
+					/* Can we use 32bit word accesses? */
+					int size = 1;
+					int count = buf_cnt;
+					if ((count % 4) == 0) {
+						size *= 4;
+						count /= 4;
+					}
+					retval = target_read_memory(target, address, size, count, data);
+					if (retval == ERROR_OK) {
+						uint32_t t;
+						for (t = 0; t < buf_cnt; t++) {
+							if (data[t] != buffer[t]) {
+								command_print(CMD_CTX,
+											  "diff %d address 0x%08x. Was 0x%02x instead of 0x%02x",
+											  diffs,
+											  (unsigned)(t + address),
+											  data[t],
+											  buffer[t]);
+								if (diffs++ >= 127) {
+									command_print(CMD_CTX, "More than 128 errors, the rest are not printed.");
+									free(data);
+									goto done;
+								}
+							}
+							keep_alive();
+						}
+					}
+					free(data);
+				}
+			}
+
+			image_size += buf_cnt;
+			done += buf_cnt;
+
+			/* short read ends the section */
+			if (buf_cnt < block)
+				break;
+		}
+
+		if (!verify)
+			command_print(CMD_CTX, "address 0x%08" PRIx32 " length 0x%08" PRIx32,
+						  image.sections[i].base_address,
+						  done);
+
+		if (retval != ERROR_OK)
+			break;
+	}
+	if (diffs > 0)
+		command_print(CMD_CTX, "No more differences found.");
+done:
+	free(buffer);
+	if (diffs > 0)
+		retval = ERROR_FAIL;
+	if ((ERROR_OK == retval) && (duration_measure(&bench) == ERROR_OK)) {
+		command_print(CMD_CTX, "verified %" PRIu32 " bytes "
+				"in %fs (%0.3f KiB/s)", image_size,
+				duration_elapsed(&bench), duration_kbps(&bench, image_size));
+	}
+
+	image_close(&image);
+
+	return retval;
+}
+
+COMMAND_HANDLER(handle_verify_image_command)
+{
+	return CALL_COMMAND_HANDLER(handle_verify_image_command_internal, 1);
+}
+
+COMMAND_HANDLER(handle_test_image_command)
+{
+	return CALL_COMMAND_HANDLER(handle_verify_image_command_internal, 0);
+}
+
+static int handle_bp_command_list(struct command_context *cmd_ctx)
+{
+	struct target *target = get_current_target(cmd_ctx);
+	struct breakpoint *breakpoint = target->breakpoints;
+	while (breakpoint) {
+		if (breakpoint->type == BKPT_SOFT) {
+			char *buf = buf_to_str(breakpoint->orig_instr,
+					breakpoint->length, 16);
+			command_print(cmd_ctx, "IVA breakpoint: 0x%8.8" PRIx32 ", 0x%x, %i, 0x%s",
+					breakpoint->address,
+					breakpoint->length,
+					breakpoint->set, buf);
+			free(buf);
+		} else {
+			if ((breakpoint->address == 0) && (breakpoint->asid != 0))
+				command_print(cmd_ctx, "Context breakpoint: 0x%8.8" PRIx32 ", 0x%x, %i",
+							breakpoint->asid,
+							breakpoint->length, breakpoint->set);
+			else if ((breakpoint->address != 0) && (breakpoint->asid != 0)) {
+				command_print(cmd_ctx, "Hybrid breakpoint(IVA): 0x%8.8" PRIx32 ", 0x%x, %i",
+							breakpoint->address,
+							breakpoint->length, breakpoint->set);
+				command_print(cmd_ctx, "\t|--->linked with ContextID: 0x%8.8" PRIx32,
+							breakpoint->asid);
+			} else
+				command_print(cmd_ctx, "Breakpoint(IVA): 0x%8.8" PRIx32 ", 0x%x, %i",
+							breakpoint->address,
+							breakpoint->length, breakpoint->set);
+		}
+
+		breakpoint = breakpoint->next;
+	}
+	return ERROR_OK;
+}
+
+static int handle_bp_command_set(struct command_context *cmd_ctx,
+		uint32_t addr, uint32_t asid, uint32_t length, int hw)
+{
+	struct target *target = get_current_target(cmd_ctx);
+	int retval;
+
+	if (asid == 0) {
+		retval = breakpoint_add(target, addr, length, hw);
+		if (ERROR_OK == retval)
+			command_print(cmd_ctx, "breakpoint set at 0x%8.8" PRIx32 "", addr);
+		else {
+			LOG_ERROR("Failure setting breakpoint, the same address(IVA) is already used");
+			return retval;
+		}
+	} else if (addr == 0) {
+		if (target->type->add_context_breakpoint == NULL) {
+			LOG_WARNING("Context breakpoint not available");
+			return ERROR_OK;
+		}
+		retval = context_breakpoint_add(target, asid, length, hw);
+		if (ERROR_OK == retval)
+			command_print(cmd_ctx, "Context breakpoint set at 0x%8.8" PRIx32 "", asid);
+		else {
+			LOG_ERROR("Failure setting breakpoint, the same address(CONTEXTID) is already used");
+			return retval;
+		}
+	} else {
+		if (target->type->add_hybrid_breakpoint == NULL) {
+			LOG_WARNING("Hybrid breakpoint not available");
+			return ERROR_OK;
+		}
+		retval = hybrid_breakpoint_add(target, addr, asid, length, hw);
+		if (ERROR_OK == retval)
+			command_print(cmd_ctx, "Hybrid breakpoint set at 0x%8.8" PRIx32 "", asid);
+		else {
+			LOG_ERROR("Failure setting breakpoint, the same address is already used");
+			return retval;
+		}
+	}
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_bp_command)
+{
+	uint32_t addr;
+	uint32_t asid;
+	uint32_t length;
+	int hw = BKPT_SOFT;
+
+	switch (CMD_ARGC) {
+		case 0:
+			return handle_bp_command_list(CMD_CTX);
+
+		case 2:
+			asid = 0;
+			COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], addr);
+			COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], length);
+			return handle_bp_command_set(CMD_CTX, addr, asid, length, hw);
+
+		case 3:
+			if (strcmp(CMD_ARGV[2], "hw") == 0) {
+				hw = BKPT_HARD;
+				COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], addr);
+
+				COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], length);
+
+				asid = 0;
+				return handle_bp_command_set(CMD_CTX, addr, asid, length, hw);
+			} else if (strcmp(CMD_ARGV[2], "hw_ctx") == 0) {
+				hw = BKPT_HARD;
+				COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], asid);
+				COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], length);
+				addr = 0;
+				return handle_bp_command_set(CMD_CTX, addr, asid, length, hw);
+			}
+
+		case 4:
+			hw = BKPT_HARD;
+			COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], addr);
+			COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], asid);
+			COMMAND_PARSE_NUMBER(u32, CMD_ARGV[2], length);
+			return handle_bp_command_set(CMD_CTX, addr, asid, length, hw);
+
+		default:
+			return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+}
+
+COMMAND_HANDLER(handle_rbp_command)
+{
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	uint32_t addr;
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], addr);
+
+	struct target *target = get_current_target(CMD_CTX);
+	breakpoint_remove(target, addr);
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_wp_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+
+	if (CMD_ARGC == 0) {
+		struct watchpoint *watchpoint = target->watchpoints;
+
+		while (watchpoint) {
+			command_print(CMD_CTX, "address: 0x%8.8" PRIx32
+					", len: 0x%8.8" PRIx32
+					", r/w/a: %i, value: 0x%8.8" PRIx32
+					", mask: 0x%8.8" PRIx32,
+					watchpoint->address,
+					watchpoint->length,
+					(int)watchpoint->rw,
+					watchpoint->value,
+					watchpoint->mask);
+			watchpoint = watchpoint->next;
+		}
+		return ERROR_OK;
+	}
+
+	enum watchpoint_rw type = WPT_ACCESS;
+	uint32_t addr = 0;
+	uint32_t length = 0;
+	uint32_t data_value = 0x0;
+	uint32_t data_mask = 0xffffffff;
+
+	switch (CMD_ARGC) {
+	case 5:
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[4], data_mask);
+		/* fall through */
+	case 4:
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[3], data_value);
+		/* fall through */
+	case 3:
+		switch (CMD_ARGV[2][0]) {
+		case 'r':
+			type = WPT_READ;
+			break;
+		case 'w':
+			type = WPT_WRITE;
+			break;
+		case 'a':
+			type = WPT_ACCESS;
+			break;
+		default:
+			LOG_ERROR("invalid watchpoint mode ('%c')", CMD_ARGV[2][0]);
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		}
+		/* fall through */
+	case 2:
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], length);
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], addr);
+		break;
+
+	default:
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+
+	int retval = watchpoint_add(target, addr, length, type,
+			data_value, data_mask);
+	if (ERROR_OK != retval)
+		LOG_ERROR("Failure setting watchpoints");
+
+	return retval;
+}
+
+COMMAND_HANDLER(handle_rwp_command)
+{
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	uint32_t addr;
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], addr);
+
+	struct target *target = get_current_target(CMD_CTX);
+	watchpoint_remove(target, addr);
+
+	return ERROR_OK;
+}
+
+/**
+ * Translate a virtual address to a physical address.
+ *
+ * The low-level target implementation must have logged a detailed error
+ * which is forwarded to telnet/GDB session.
+ */
+COMMAND_HANDLER(handle_virt2phys_command)
+{
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	uint32_t va;
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], va);
+	uint32_t pa;
+
+	struct target *target = get_current_target(CMD_CTX);
+	int retval = target->type->virt2phys(target, va, &pa);
+	if (retval == ERROR_OK)
+		command_print(CMD_CTX, "Physical address 0x%08" PRIx32 "", pa);
+
+	return retval;
+}
+
+static void writeData(FILE *f, const void *data, size_t len)
+{
+	size_t written = fwrite(data, 1, len, f);
+	if (written != len)
+		LOG_ERROR("failed to write %zu bytes: %s", len, strerror(errno));
+}
+
+static void writeLong(FILE *f, int l, struct target *target)
+{
+	uint8_t val[4];
+
+	target_buffer_set_u32(target, val, l);
+	writeData(f, val, 4);
+}
+
+static void writeString(FILE *f, char *s)
+{
+	writeData(f, s, strlen(s));
+}
+
+typedef unsigned char UNIT[2];  /* unit of profiling */
+
+/* Dump a gmon.out histogram file. */
+static void write_gmon(uint32_t *samples, uint32_t sampleNum, const char *filename, bool with_range,
+			uint32_t start_address, uint32_t end_address, struct target *target)
+{
+	uint32_t i;
+	FILE *f = fopen(filename, "w");
+	if (f == NULL)
+		return;
+	writeString(f, "gmon");
+	writeLong(f, 0x00000001, target); /* Version */
+	writeLong(f, 0, target); /* padding */
+	writeLong(f, 0, target); /* padding */
+	writeLong(f, 0, target); /* padding */
+
+	uint8_t zero = 0;  /* GMON_TAG_TIME_HIST */
+	writeData(f, &zero, 1);
+
+	/* figure out bucket size */
+	uint32_t min;
+	uint32_t max;
+	if (with_range) {
+		min = start_address;
+		max = end_address;
+	} else {
+		min = samples[0];
+		max = samples[0];
+		for (i = 0; i < sampleNum; i++) {
+			if (min > samples[i])
+				min = samples[i];
+			if (max < samples[i])
+				max = samples[i];
+		}
+
+		/* max should be (largest sample + 1)
+		 * Refer to binutils/gprof/hist.c (find_histogram_for_pc) */
+		max++;
+	}
+
+	int addressSpace = max - min;
+	assert(addressSpace >= 2);
+
+	/* FIXME: What is the reasonable number of buckets?
+	 * The profiling result will be more accurate if there are enough buckets. */
+	static const uint32_t maxBuckets = 128 * 1024; /* maximum buckets. */
+	uint32_t numBuckets = addressSpace / sizeof(UNIT);
+	if (numBuckets > maxBuckets)
+		numBuckets = maxBuckets;
+	int *buckets = malloc(sizeof(int) * numBuckets);
+	if (buckets == NULL) {
+		fclose(f);
+		return;
+	}
+	memset(buckets, 0, sizeof(int) * numBuckets);
+	for (i = 0; i < sampleNum; i++) {
+		uint32_t address = samples[i];
+
+		if ((address < min) || (max <= address))
+			continue;
+
+		long long a = address - min;
+		long long b = numBuckets;
+		long long c = addressSpace;
+		int index_t = (a * b) / c; /* danger!!!! int32 overflows */
+		buckets[index_t]++;
+	}
+
+	/* append binary memory gmon.out &profile_hist_hdr ((char*)&profile_hist_hdr + sizeof(struct gmon_hist_hdr)) */
+	writeLong(f, min, target);			/* low_pc */
+	writeLong(f, max, target);			/* high_pc */
+	writeLong(f, numBuckets, target);	/* # of buckets */
+	writeLong(f, 100, target);			/* KLUDGE! We lie, ca. 100Hz best case. */
+	writeString(f, "seconds");
+	for (i = 0; i < (15-strlen("seconds")); i++)
+		writeData(f, &zero, 1);
+	writeString(f, "s");
+
+	/*append binary memory gmon.out profile_hist_data (profile_hist_data + profile_hist_hdr.hist_size) */
+
+	char *data = malloc(2 * numBuckets);
+	if (data != NULL) {
+		for (i = 0; i < numBuckets; i++) {
+			int val;
+			val = buckets[i];
+			if (val > 65535)
+				val = 65535;
+			data[i * 2] = val&0xff;
+			data[i * 2 + 1] = (val >> 8) & 0xff;
+		}
+		free(buckets);
+		writeData(f, data, numBuckets * 2);
+		free(data);
+	} else
+		free(buckets);
+
+	fclose(f);
+}
+
+/* profiling samples the CPU PC as quickly as OpenOCD is able,
+ * which will be used as a random sampling of PC */
+COMMAND_HANDLER(handle_profile_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+
+	if ((CMD_ARGC != 2) && (CMD_ARGC != 4))
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	const uint32_t MAX_PROFILE_SAMPLE_NUM = 10000;
+	uint32_t offset;
+	uint32_t num_of_samples;
+	int retval = ERROR_OK;
+
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], offset);
+
+	uint32_t *samples = malloc(sizeof(uint32_t) * MAX_PROFILE_SAMPLE_NUM);
+	if (samples == NULL) {
+		LOG_ERROR("No memory to store samples.");
+		return ERROR_FAIL;
+	}
+
+	/**
+	 * Some cores let us sample the PC without the
+	 * annoying halt/resume step; for example, ARMv7 PCSR.
+	 * Provide a way to use that more efficient mechanism.
+	 */
+	retval = target_profiling(target, samples, MAX_PROFILE_SAMPLE_NUM,
+				&num_of_samples, offset);
+	if (retval != ERROR_OK) {
+		free(samples);
+		return retval;
+	}
+
+	assert(num_of_samples <= MAX_PROFILE_SAMPLE_NUM);
+
+	retval = target_poll(target);
+	if (retval != ERROR_OK) {
+		free(samples);
+		return retval;
+	}
+	if (target->state == TARGET_RUNNING) {
+		retval = target_halt(target);
+		if (retval != ERROR_OK) {
+			free(samples);
+			return retval;
+		}
+	}
+
+	retval = target_poll(target);
+	if (retval != ERROR_OK) {
+		free(samples);
+		return retval;
+	}
+
+	uint32_t start_address = 0;
+	uint32_t end_address = 0;
+	bool with_range = false;
+	if (CMD_ARGC == 4) {
+		with_range = true;
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[2], start_address);
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[3], end_address);
+	}
+
+	write_gmon(samples, num_of_samples, CMD_ARGV[1],
+		   with_range, start_address, end_address, target);
+	command_print(CMD_CTX, "Wrote %s", CMD_ARGV[1]);
+
+	free(samples);
+	return retval;
+}
+
+/* namebuf already holds the array name; only the "(%d)" suffix is
+ * (re)written here, so the caller pays for the name copy just once
+ * per transfer instead of once per element. */
+static int new_int_array_element(Jim_Interp *interp, char *namebuf,
+		size_t varlen, int idx, uint32_t val)
+{
+	Jim_Obj *nameObjPtr, *valObjPtr;
+	int result;
+	int namelen;
+
+	namelen = varlen + sprintf(namebuf + varlen, "(%d)", idx);
+
+	nameObjPtr = Jim_NewStringObj(interp, namebuf, namelen);
+	valObjPtr = Jim_NewIntObj(interp, val);
+	if (!nameObjPtr || !valObjPtr)
+		return JIM_ERR;
+
+	Jim_IncrRefCount(nameObjPtr);
+	Jim_IncrRefCount(valObjPtr);
+	result = Jim_SetVariable(interp, nameObjPtr, valObjPtr);
+	Jim_DecrRefCount(interp, nameObjPtr);
+	Jim_DecrRefCount(interp, valObjPtr);
+	/* printf("%s(%d) <= 0%08x\n", namebuf, idx, val); */
+	return result;
+}
+
+static int jim_mem2array(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	struct command_context *context;
+	struct target *target;
+
+	context = current_command_context(interp);
+	assert(context != NULL);
+
+	target = get_current_target(context);
+	if (target == NULL) {
+		LOG_ERROR("mem2array: no current target");
+		return JIM_ERR;
+	}
+
+	return target_mem2array(interp, target, argc - 1, argv + 1);
+}
+
+static int target_mem2array(Jim_Interp *interp, struct target *target, int argc, Jim_Obj *const *argv)
+{
+	long l;
+	uint32_t width;
+	int len;
+	uint32_t addr;
+	uint32_t count;
+	uint32_t v;
+	const char *varname;
+	int  n, e, retval;
+	uint32_t i;
+
+	/* argv[1] = name of array to receive the data
+	 * argv[2] = desired width
+	 * argv[3] = memory address
+	 * argv[4] = count of times to read
+	 */
+	if (argc != 4) {
+		Jim_WrongNumArgs(interp, 1, argv, "varname width addr nelems");
+		return JIM_ERR;
+	}
+	varname = Jim_GetString(argv[0], &len);
+
+	e = Jim_GetLong(interp, argv[1], &l);
+	width = l;
+	if (e != JIM_OK)
+		return e;
+
+	e = Jim_GetLong(interp, argv[2], &l);
+	addr = l;
+	if (e != JIM_OK)
+		return e;
+	e = Jim_GetLong(interp, argv[3], &l);
+	len = l;
+	if (e != JIM_OK)
+		return e;
+	switch (width) {
+		case 8:
+			width = 1;
+			break;
+		case 16:
+			width = 2;
+			break;
+		case 32:
+			width = 4;
+			break;
+		default:
+			Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+			Jim_AppendStrings(interp, Jim_GetResult(interp), "Invalid width param, must be 8/16/32", NULL);
+			return JIM_ERR;
+	}
+	if (len == 0) {
+		Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+		Jim_AppendStrings(interp, Jim_GetResult(interp), "mem2array: zero width read?", NULL);
+		return JIM_ERR;
+	}
+	if ((addr + (len * width)) < addr) {
+		Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+		Jim_AppendStrings(interp, Jim_GetResult(interp), "mem2array: addr + len - wraps to zero?", NULL);
+		return JIM_ERR;
+	}
+	/* absurd transfer size? */
+	if (len > 65536) {
+		Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+		Jim_AppendStrings(interp, Jim_GetResult(interp), "mem2array: absurd > 64K item request", NULL);
+		return JIM_ERR;
+	}
+
+	if ((width == 1) ||
+		((width == 2) && ((addr & 1) == 0)) ||
+		((width == 4) && ((addr & 3) == 0))) {
+		/* all is well */
+	} else {
+		char buf[100];
+		Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+		sprintf(buf, "mem2array address: 0x%08" PRIx32 " is not aligned for %" PRId32 " byte reads",
+				addr,
+				width);
+		Jim_AppendStrings(interp, Jim_GetResult(interp), buf , NULL);
+		return JIM_ERR;
+	}
+
+	/* Transfer loop */
+
+	/* index counter */
+	n = 0;
+
+	size_t buffersize = 4096;
+	uint8_t *buffer = malloc(buffersize);
+	if (buffer == NULL)
+		return JIM_ERR;
+
+	/* given "foo" get space for worse case "foo(%d)" .. add 20 */
+	size_t varlen = strlen(varname);
+	char *namebuf = malloc(varlen + 20);
+	if (namebuf == NULL) {
+		free(buffer);
+		return JIM_ERR;
+	}
+	memcpy(namebuf, varname, varlen);
+
+	/* assume ok */
+	e = JIM_OK;
+	while (len) {
+		/* Slurp... in buffer size chunks */
+
+		count = len; /* in objects.. */
+		if (count > (buffersize / width))
+			count = (buffersize / width);
+
+		retval = target_read_memory(target, addr, width, count, buffer);
+		if (retval != ERROR_OK) {
+			/* BOO !*/
+			LOG_ERROR("mem2array: Read @ 0x%08x, w=%d, cnt=%d, failed",
+					  (unsigned int)addr,
+					  (int)width,
+					  (int)count);
+			Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+			Jim_AppendStrings(interp, Jim_GetResult(interp), "mem2array: cannot read memory", NULL);
+			e = JIM_ERR;
+			break;
+		} else {
+			v = 0; /* shut up gcc */
+			for (i = 0; i < count ; i++, n++) {
+				switch (width) {
+					case 4:
+						v = target_buffer_get_u32(target, &buffer[i*width]);
+						break;
+					case 2:
+						v = target_buffer_get_u16(target, &buffer[i*width]);
+						break;
+					case 1:
+						v = buffer[i] & 0x0ff;
+						break;
+				}
+				new_int_array_element(interp, namebuf, varlen, n, v);
+			}
+			len -= count;
+			addr += count * width;
+		}
+	}
+
+	free(namebuf);
+	free(buffer);
+
+	Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+
+	return e;
+}
+
+static int target_mem2list(Jim_Interp *interp, struct target *target, int argc, Jim_Obj *const *argv)
+{
+	long l;
+	uint32_t width;
+	int len;
+	uint32_t addr;
+	uint32_t count;
+	uint32_t v;
+	int e, retval;
+	uint32_t i;
+	Jim_Obj *result;
+
+	/* argv[1] = desired width
+	 * argv[2] = memory address
+	 * argv[3] = count of times to read
+	 */
+	if (argc != 3) {
+		Jim_WrongNumArgs(interp, 1, argv, "width addr nelems");
+		return JIM_ERR;
+	}
+
+	e = Jim_GetLong(interp, argv[0], &l);
+	width = l;
+	if (e != JIM_OK)
+		return e;
+
+	e = Jim_GetLong(interp, argv[1], &l);
+	addr = l;
+	if (e != JIM_OK)
+		return e;
+	e = Jim_GetLong(interp, argv[2], &l);
+	len = l;
+	if (e != JIM_OK)
+		return e;
+	switch (width) {
+		case 8:
+			width = 1;
+			break;
+		case 16:
+			width = 2;
+			break;
+		case 32:
+			width = 4;
+			break;
+		default:
+			Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+			Jim_AppendStrings(interp, Jim_GetResult(interp), "Invalid width param, must be 8/16/32", NULL);
+			return JIM_ERR;
+	}
+	if (len == 0) {
+		Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+		Jim_AppendStrings(interp, Jim_GetResult(interp), "mem2list: zero width read?", NULL);
+		return JIM_ERR;
+	}
+	if ((addr + (len * width)) < addr) {
+		Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+		Jim_AppendStrings(interp, Jim_GetResult(interp), "mem2list: addr + len - wraps to zero?", NULL);
+		return JIM_ERR;
+	}
+	/* absurd transfer size? */
+	if (len > 65536) {
+		Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+		Jim_AppendStrings(interp, Jim_GetResult(interp), "mem2list: absurd > 64K item request", NULL);
+		return JIM_ERR;
+	}
+
+	if ((width == 1) ||
+		((width == 2) && ((addr & 1) == 0)) ||
+		((width == 4) && ((addr & 3) == 0))) {
+		/* all is well */
+	} else {
+		char buf[100];
+		Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+		sprintf(buf, "mem2list address: 0x%08" PRIx32 " is not aligned for %" PRId32 " byte reads",
+				addr,
+				width);
+		Jim_AppendStrings(interp, Jim_GetResult(interp), buf , NULL);
+		return JIM_ERR;
+	}
+
+	/* Transfer loop */
+
+	size_t buffersize = 4096;
+	uint8_t *buffer = malloc(buffersize);
+	if (buffer == NULL)
+		return JIM_ERR;
+
+	/* unlike mem2array there is no per-element variable to set; the
+	 * values go straight into one list object that becomes the
+	 * command result, so the interpreter cost is a single append
+	 * per element */
+	result = Jim_NewListObj(interp, NULL, 0);
+	Jim_IncrRefCount(result);
+
+	/* assume ok */
+	e = JIM_OK;
+	while (len) {
+		/* Slurp... in buffer size chunks */
+
+		count = len; /* in objects.. */
+		if (count > (buffersize / width))
+			count = (buffersize / width);
+
+		retval = target_read_memory(target, addr, width, count, buffer);
+		if (retval != ERROR_OK) {
+			/* BOO !*/
+			LOG_ERROR("mem2list: Read @ 0x%08x, w=%d, cnt=%d, failed",
+					  (unsigned int)addr,
+					  (int)width,
+					  (int)count);
+			Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+			Jim_AppendStrings(interp, Jim_GetResult(interp), "mem2list: cannot read memory", NULL);
+			e = JIM_ERR;
+			break;
+		}
+
+		v = 0; /* shut up gcc */
+		for (i = 0; i < count; i++) {
+			switch (width) {
+				case 4:
+					v = target_buffer_get_u32(target, &buffer[i*width]);
+					break;
+				case 2:
+					v = target_buffer_get_u16(target, &buffer[i*width]);
+					break;
+				case 1:
+					v = buffer[i] & 0x0ff;
+					break;
+			}
+			Jim_ListAppendElement(interp, result, Jim_NewIntObj(interp, v));
+		}
+		len -= count;
+		addr += count * width;
+	}
+
+	free(buffer);
+
+	if (e == JIM_OK)
+		Jim_SetResult(interp, result);
+	Jim_DecrRefCount(interp, result);
+
+	return e;
+}
+
+static int jim_mem2list(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	struct command_context *context;
+	struct target *target;
+
+	context = current_command_context(interp);
+	assert(context != NULL);
+
+	target = get_current_target(context);
+	if (target == NULL) {
+		LOG_ERROR("mem2list: no current target");
+		return JIM_ERR;
+	}
+
+	return target_mem2list(interp, target, argc - 1, argv + 1);
+}
+
+/* see new_int_array_element(): namebuf is a reusable element name with
+ * the array name already in place at namebuf[0..varlen) */
+static int get_int_array_element(Jim_Interp *interp, char *namebuf,
+		size_t varlen, int idx, uint32_t *val)
+{
+	Jim_Obj *nameObjPtr, *valObjPtr;
+	int result;
+	int namelen;
+	long l;
+
+	namelen = varlen + sprintf(namebuf + varlen, "(%d)", idx);
+
+	nameObjPtr = Jim_NewStringObj(interp, namebuf, namelen);
+	if (!nameObjPtr)
+		return JIM_ERR;
+
+	Jim_IncrRefCount(nameObjPtr);
+	valObjPtr = Jim_GetVariable(interp, nameObjPtr, JIM_ERRMSG);
+	Jim_DecrRefCount(interp, nameObjPtr);
+	if (valObjPtr == NULL)
+		return JIM_ERR;
+
+	result = Jim_GetLong(interp, valObjPtr, &l);
+	/* printf("%s(%d) => 0%08x\n", namebuf, idx, val); */
+	*val = l;
+	return result;
+}
+
+static int jim_array2mem(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	struct command_context *context;
+	struct target *target;
+
+	context = current_command_context(interp);
+	assert(context != NULL);
+
+	target = get_current_target(context);
+	if (target == NULL) {
+		LOG_ERROR("array2mem: no current target");
+		return JIM_ERR;
+	}
+
+	return target_array2mem(interp, target, argc-1, argv + 1);
+}
+
+static int target_array2mem(Jim_Interp *interp, struct target *target,
+		int argc, Jim_Obj *const *argv)
+{
+	long l;
+	uint32_t width;
+	int len;
+	uint32_t addr;
+	uint32_t count;
+	uint32_t v;
+	const char *varname;
+	int  n, e, retval;
+	uint32_t i;
+
+	/* argv[1] = name of array to get the data
+	 * argv[2] = desired width
+	 * argv[3] = memory address
+	 * argv[4] = count to write
+	 */
+	if (argc != 4) {
+		Jim_WrongNumArgs(interp, 0, argv, "varname width addr nelems");
+		return JIM_ERR;
+	}
+	varname = Jim_GetString(argv[0], &len);
+
+	e = Jim_GetLong(interp, argv[1], &l);
+	width = l;
+	if (e != JIM_OK)
+		return e;
+
+	e = Jim_GetLong(interp, argv[2], &l);
+	addr = l;
+	if (e != JIM_OK)
+		return e;
+	e = Jim_GetLong(interp, argv[3], &l);
+	len = l;
+	if (e != JIM_OK)
+		return e;
+	switch (width) {
+		case 8:
+			width = 1;
+			break;
+		case 16:
+			width = 2;
+			break;
+		case 32:
+			width = 4;
+			break;
+		default:
+			Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+			Jim_AppendStrings(interp, Jim_GetResult(interp),
+					"Invalid width param, must be 8/16/32", NULL);
+			return JIM_ERR;
+	}
+	if (len == 0) {
+		Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+		Jim_AppendStrings(interp, Jim_GetResult(interp),
+				"array2mem: zero width read?", NULL);
+		return JIM_ERR;
+	}
+	if ((addr + (len * width)) < addr) {
+		Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+		Jim_AppendStrings(interp, Jim_GetResult(interp),
+				"array2mem: addr + len - wraps to zero?", NULL);
+		return JIM_ERR;
+	}
+	/* absurd transfer size? */
+	if (len > 65536) {
+		Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+		Jim_AppendStrings(interp, Jim_GetResult(interp),
+				"array2mem: absurd > 64K item request", NULL);
+		return JIM_ERR;
+	}
+
+	if ((width == 1) ||
+		((width == 2) && ((addr & 1) == 0)) ||
+		((width == 4) && ((addr & 3) == 0))) {
+		/* all is well */
+	} else {
+		char buf[100];
+		Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+		sprintf(buf, "array2mem address: 0x%08x is not aligned for %d byte reads",
+				(unsigned int)addr,
+				(int)width);
+		Jim_AppendStrings(interp, Jim_GetResult(interp), buf , NULL);
+		return JIM_ERR;
+	}
+
+	/* Transfer loop */
+
+	/* index counter */
+	n = 0;
+	/* assume ok */
+	e = JIM_OK;
+
+	size_t buffersize = 4096;
+	uint8_t *buffer = malloc(buffersize);
+	if (buffer == NULL)
+		return JIM_ERR;
+
+	/* given "foo" get space for worse case "foo(%d)" .. add 20 */
+	size_t varlen = strlen(varname);
+	char *namebuf = malloc(varlen + 20);
+	if (namebuf == NULL) {
+		free(buffer);
+		return JIM_ERR;
+	}
+	memcpy(namebuf, varname, varlen);
+
+	while (len) {
+		/* Slurp... in buffer size chunks */
+
+		count = len; /* in objects.. */
+		if (count > (buffersize / width))
+			count = (buffersize / width);
+
+		v = 0; /* shut up gcc */
+		for (i = 0; i < count; i++, n++) {
+			get_int_array_element(interp, namebuf, varlen, n, &v);
+			switch (width) {
+			case 4:
+				target_buffer_set_u32(target, &buffer[i * width], v);
+				break;
+			case 2:
+				target_buffer_set_u16(target, &buffer[i * width], v);
+				break;
+			case 1:
+				buffer[i] = v & 0x0ff;
+				break;
+			}
+		}
+		len -= count;
+
+		retval = target_write_memory(target, addr, width, count, buffer);
+		if (retval != ERROR_OK) {
+			/* BOO !*/
+			LOG_ERROR("array2mem: Write @ 0x%08x, w=%d, cnt=%d, failed",
+					  (unsigned int)addr,
+					  (int)width,
+					  (int)count);
+			Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+			Jim_AppendStrings(interp, Jim_GetResult(interp), "array2mem: cannot read memory", NULL);
+			e = JIM_ERR;
+			break;
+		}
+		addr += count * width;
+	}
+
+	free(namebuf);
+	free(buffer);
+
+	Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+
+	return e;
+}
+
+static int target_list2mem(Jim_Interp *interp, struct target *target,
+		int argc, Jim_Obj *const *argv)
+{
+	long l;
+	uint32_t width;
+	int len;
+	uint32_t addr;
+	uint32_t count;
+	uint32_t v;
+	int n, e, retval;
+	uint32_t i;
+	Jim_Obj *values;
+
+	/* argv[1] = list of values to write
+	 * argv[2] = desired width
+	 * argv[3] = memory address
+	 */
+	if (argc != 3) {
+		Jim_WrongNumArgs(interp, 0, argv, "list width addr");
+		return JIM_ERR;
+	}
+	values = argv[0];
+
+	e = Jim_GetLong(interp, argv[1], &l);
+	width = l;
+	if (e != JIM_OK)
+		return e;
+
+	e = Jim_GetLong(interp, argv[2], &l);
+	addr = l;
+	if (e != JIM_OK)
+		return e;
+	len = Jim_ListLength(interp, values);
+	switch (width) {
+		case 8:
+			width = 1;
+			break;
+		case 16:
+			width = 2;
+			break;
+		case 32:
+			width = 4;
+			break;
+		default:
+			Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+			Jim_AppendStrings(interp, Jim_GetResult(interp),
+					"Invalid width param, must be 8/16/32", NULL);
+			return JIM_ERR;
+	}
+	if (len == 0) {
+		Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+		Jim_AppendStrings(interp, Jim_GetResult(interp),
+				"list2mem: empty value list?", NULL);
+		return JIM_ERR;
+	}
+	if ((addr + (len * width)) < addr) {
+		Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+		Jim_AppendStrings(interp, Jim_GetResult(interp),
+				"list2mem: addr + len - wraps to zero?", NULL);
+		return JIM_ERR;
+	}
+	/* absurd transfer size? */
+	if (len > 65536) {
+		Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+		Jim_AppendStrings(interp, Jim_GetResult(interp),
+				"list2mem: absurd > 64K item request", NULL);
+		return JIM_ERR;
+	}
+
+	if ((width == 1) ||
+		((width == 2) && ((addr & 1) == 0)) ||
+		((width == 4) && ((addr & 3) == 0))) {
+		/* all is well */
+	} else {
+		char buf[100];
+		Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+		sprintf(buf, "list2mem address: 0x%08x is not aligned for %d byte writes",
+				(unsigned int)addr,
+				(int)width);
+		Jim_AppendStrings(interp, Jim_GetResult(interp), buf , NULL);
+		return JIM_ERR;
+	}
+
+	/* Transfer loop */
+
+	/* index counter */
+	n = 0;
+	/* assume ok */
+	e = JIM_OK;
+
+	size_t buffersize = 4096;
+	uint8_t *buffer = malloc(buffersize);
+	if (buffer == NULL)
+		return JIM_ERR;
+
+	while (len) {
+		/* Slurp... in buffer size chunks */
+
+		count = len; /* in objects.. */
+		if (count > (buffersize / width))
+			count = (buffersize / width);
+
+		/* indexing a list object is a constant-time peek at its
+		 * internal vector; no variable lookups happen here */
+		for (i = 0; i < count; i++, n++) {
+			Jim_Obj *elem;
+
+			Jim_ListIndex(interp, values, n, &elem, JIM_NONE);
+			if (Jim_GetLong(interp, elem, &l) != JIM_OK) {
+				Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+				Jim_AppendStrings(interp, Jim_GetResult(interp),
+						"list2mem: list element is not an integer", NULL);
+				e = JIM_ERR;
+				break;
+			}
+			v = l;
+			switch (width) {
+			case 4:
+				target_buffer_set_u32(target, &buffer[i * width], v);
+				break;
+			case 2:
+				target_buffer_set_u16(target, &buffer[i * width], v);
+				break;
+			case 1:
+				buffer[i] = v & 0x0ff;
+				break;
+			}
+		}
+		if (e != JIM_OK)
+			break;
+		len -= count;
+
+		retval = target_write_memory(target, addr, width, count, buffer);
+		if (retval != ERROR_OK) {
+			/* BOO !*/
+			LOG_ERROR("list2mem: Write @ 0x%08x, w=%d, cnt=%d, failed",
+					  (unsigned int)addr,
+					  (int)width,
+					  (int)count);
+			Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+			Jim_AppendStrings(interp, Jim_GetResult(interp), "list2mem: cannot write memory", NULL);
+			e = JIM_ERR;
+			break;
+		}
+		addr += count * width;
+	}
+
+	free(buffer);
+
+	if (e == JIM_OK)
+		Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+
+	return e;
+}
+
+static int jim_list2mem(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	struct command_context *context;
+	struct target *target;
+
+	context = current_command_context(interp);
+	assert(context != NULL);
+
+	target = get_current_target(context);
+	if (target == NULL) {
+		LOG_ERROR("list2mem: no current target");
+		return JIM_ERR;
+	}
+
+	return target_list2mem(interp, target, argc-1, argv + 1);
+}
+
+/* FIX? should we propagate errors here rather than printing them
+ * and continuing?
+ */
+void target_handle_event(struct target *target, enum target_event e)
+{
+	struct target_event_action *teap = target->event_action_index[e];
+
+	if (teap == NULL)
+		return;
+
+	LOG_DEBUG("target: (%d) %s (%s) event: %d (%s) action: %s",
+			   target->target_number,
+			   target_name(target),
+			   target_type_name(target),
+			   e,
+			   Jim_Nvp_value2name_simple(nvp_target_event, e)->name,
+			   Jim_GetString(teap->body, NULL));
+	if (Jim_EvalObj(teap->interp, teap->body) != JIM_OK) {
+		Jim_MakeErrorMessage(teap->interp);
+		command_print(NULL, "%s\n", Jim_GetString(Jim_GetResult(teap->interp), NULL));
+	}
+}
+
+/**
+ * Returns true only if the target has a handler for the specified event.
+ */
+bool target_has_event_action(struct target *target, enum target_event event)
+{
+	return target->event_action_index[event] != NULL;
+}
+
+enum target_cfg_param {
+	TCFG_TYPE,
+	TCFG_EVENT,
+	TCFG_WORK_AREA_VIRT,
+	TCFG_WORK_AREA_PHYS,
+	TCFG_WORK_AREA_SIZE,
+	TCFG_WORK_AREA_BACKUP,
+	TCFG_ENDIAN,
+	TCFG_COREID,
+	TCFG_CHAIN_POSITION,
+	TCFG_DBGBASE,
+	TCFG_AP_NUM,
+	TCFG_POLL_MAX,
+	TCFG_RTOS,
+};
+
+static Jim_Nvp nvp_config_opts[] = {
+	{ .name = "-type",             .value = TCFG_TYPE },
+	{ .name = "-event",            .value = TCFG_EVENT },
+	{ .name = "-work-area-virt",   .value = TCFG_WORK_AREA_VIRT },
+	{ .name = "-work-area-phys",   .value = TCFG_WORK_AREA_PHYS },
+	{ .name = "-work-area-size",   .value = TCFG_WORK_AREA_SIZE },
+	{ .name = "-work-area-backup", .value = TCFG_WORK_AREA_BACKUP },
+	{ .name = "-endian" ,          .value = TCFG_ENDIAN },
+	{ .name = "-coreid",           .value = TCFG_COREID },
+	{ .name = "-chain-position",   .value = TCFG_CHAIN_POSITION },
+	{ .name = "-dbgbase",          .value = TCFG_DBGBASE },
+	{ .name = "-ap-num",           .value = TCFG_AP_NUM },
+	{ .name = "-poll-max",         .value = TCFG_POLL_MAX },
+	{ .name = "-rtos",             .value = TCFG_RTOS },
+	{ .name = NULL, .value = -1 }
+};
+
+static int target_configure(Jim_GetOptInfo *goi, struct target *target)
+{
+	Jim_Nvp *n;
+	Jim_Obj *o;
+	jim_wide w;
+	int e;
+
+	/* parse config or cget options ... */
+	while (goi->argc > 0) {
+		Jim_SetEmptyResult(goi->interp);
+		/* Jim_GetOpt_Debug(goi); */
+
+		if (target->type->target_jim_configure) {
+			/* target defines a configure function */
+			/* target gets first dibs on parameters */
+			e = (*(target->type->target_jim_configure))(target, goi);
+			if (e == JIM_OK) {
+				/* more? */
+				continue;
+			}
+			if (e == JIM_ERR) {
+				/* An error */
+				return e;
+			}
+			/* otherwise we 'continue' below */
+		}
+		e = Jim_GetOpt_Nvp(goi, nvp_config_opts, &n);
+		if (e != JIM_OK) {
+			Jim_GetOpt_NvpUnknown(goi, nvp_config_opts, 0);
+			return e;
+		}
+		switch (n->value) {
+		case TCFG_TYPE:
+			/* not setable */
+			if (goi->isconfigure) {
+				Jim_SetResultFormatted(goi->interp,
+						"not settable: %s", n->name);
+				return JIM_ERR;
+			} else {
+no_params:
+				if (goi->argc != 0) {
+					Jim_WrongNumArgs(goi->interp,
+							goi->argc, goi->argv,
+							"NO PARAMS");
+					return JIM_ERR;
+				}
+			}
+			Jim_SetResultString(goi->interp,
+					target_type_name(target), -1);
+			/* loop for more */
+			break;
+		case TCFG_EVENT:
+			if (goi->argc == 0) {
+				Jim_WrongNumArgs(goi->interp, goi->argc, goi->argv, "-event ?event-name? ...");
+				return JIM_ERR;
+			}
+
+			e = Jim_GetOpt_Nvp(goi, nvp_target_event, &n);
+			if (e != JIM_OK) {
+				Jim_GetOpt_NvpUnknown(goi, nvp_target_event, 1);
+				return e;
+			}
+
+			if (goi->isconfigure) {
+				if (goi->argc != 1) {
+					Jim_WrongNumArgs(goi->interp, goi->argc, goi->argv, "-event ?event-name? ?EVENT-BODY?");
+					return JIM_ERR;
+				}
+			} else {
+				if (goi->argc != 0) {
+					Jim_WrongNumArgs(goi->interp, goi->argc, goi->argv, "-event ?event-name?");
+					return JIM_ERR;
+				}
+			}
+
+			{
+				struct target_event_action *teap;
+
+				teap = target->event_action;
+				/* replace existing? */
+				while (teap) {
+					if (teap->event == (enum target_event)n->value)
+						break;
+					teap = teap->next;
+				}
+
+				if (goi->isconfigure) {
+					bool replace = true;
+					if (teap == NULL) {
+						/* create new */
+						teap = calloc(1, sizeof(*teap));
+						replace = false;
+					}
+					teap->event = n->value;
+					teap->interp = goi->interp;
+					Jim_GetOpt_Obj(goi, &o);
+					if (teap->body)
+						Jim_DecrRefCount(teap->interp, teap->body);
+					teap->body  = Jim_DuplicateObj(goi->interp, o);
+					/*
+					 * FIXME:
+					 *     Tcl/TK - "tk events" have a nice feature.
+					 *     See the "BIND" command.
+					 *    We should support that here.
+					 *     You can specify %X and %Y in the event code.
+					 *     The idea is: %T - target name.
+					 *     The idea is: %N - target number
+					 *     The idea is: %E - event name.
+					 */
+					Jim_IncrRefCount(teap->body);
+
+					if (!replace) {
+						/* add to head of event list */
+						teap->next = target->event_action;
+						target->event_action = teap;
+					}
+					target->event_action_index[teap->event] = teap;
+					Jim_SetEmptyResult(goi->interp);
+				} else {
+					/* get */
+					if (teap == NULL)
+						Jim_SetEmptyResult(goi->interp);
+					else
+						Jim_SetResult(goi->interp, Jim_DuplicateObj(goi->interp, teap->body));
+				}
+			}
+			/* loop for more */
+			break;
+
+		case TCFG_WORK_AREA_VIRT:
+			if (goi->isconfigure) {
+				target_free_all_working_areas(target);
+				e = Jim_GetOpt_Wide(goi, &w);
+				if (e != JIM_OK)
+					return e;
+				target->working_area_virt = w;
+				target->working_area_virt_spec = true;
+			} else {
+				if (goi->argc != 0)
+					goto no_params;
+			}
+			Jim_SetResult(goi->interp, Jim_NewIntObj(goi->interp, target->working_area_virt));
+			/* loop for more */
+			break;
+
+		case TCFG_WORK_AREA_PHYS:
+			if (goi->isconfigure) {
+				target_free_all_working_areas(target);
+				e = Jim_GetOpt_Wide(goi, &w);
+				if (e != JIM_OK)
+					return e;
+				target->working_area_phys = w;
+				target->working_area_phys_spec = true;
+			} else {
+				if (goi->argc != 0)
+					goto no_params;
+			}
+			Jim_SetResult(goi->interp, Jim_NewIntObj(goi->interp, target->working_area_phys));
+			/* loop for more */
+			break;
+
+		case TCFG_WORK_AREA_SIZE:
+			if (goi->isconfigure) {
+				target_free_all_working_areas(target);
+				e = Jim_GetOpt_Wide(goi, &w);
+				if (e != JIM_OK)
+					return e;
+				target->working_area_size = w;
+			} else {
+				if (goi->argc != 0)
+					goto no_params;
+			}
+			Jim_SetResult(goi->interp, Jim_NewIntObj(goi->interp, target->working_area_size));
+			/* loop for more */
+			break;
+
+		case TCFG_WORK_AREA_BACKUP:
+			if (goi->isconfigure) {
+				target_free_all_working_areas(target);
+				e = Jim_GetOpt_Wide(goi, &w);
+				if (e != JIM_OK)
+					return e;
+				/* make this exactly 1 or 0 */
+				target->backup_working_area = (!!w);
+			} else {
+				if (goi->argc != 0)
+					goto no_params;
+			}
+			Jim_SetResult(goi->interp, Jim_NewIntObj(goi->interp, target->backup_working_area));
+			/* loop for more e*/
+			break;
+
+
+		case TCFG_ENDIAN:
+			if (goi->isconfigure) {
+				e = Jim_GetOpt_Nvp(goi, nvp_target_endian, &n);
+				if (e != JIM_OK) {
+					Jim_GetOpt_NvpUnknown(goi, nvp_target_endian, 1);
+					return e;
+				}
+				target->endianness = n->value;
+			} else {
+				if (goi->argc != 0)
+					goto no_params;
+			}
+			n = Jim_Nvp_value2name_simple(nvp_target_endian, target->endianness);
+			if (n->name == NULL) {
+				target->endianness = TARGET_LITTLE_ENDIAN;
+				n = Jim_Nvp_value2name_simple(nvp_target_endian, target->endianness);
+			}
+			Jim_SetResultString(goi->interp, n->name, -1);
+			/* loop for more */
+			break;
+
+		case TCFG_COREID:
+			if (goi->isconfigure) {
+				e = Jim_GetOpt_Wide(goi, &w);
+				if (e != JIM_OK)
+					return e;
+				target->coreid = (int32_t)w;
+			} else {
+				if (goi->argc != 0)
+					goto no_params;
+			}
+			Jim_SetResult(goi->interp, Jim_NewIntObj(goi->interp, target->working_area_size));
+			/* loop for more */
+			break;
+
+		case TCFG_CHAIN_POSITION:
+			if (goi->isconfigure) {
+				Jim_Obj *o_t;
+				struct jtag_tap *tap;
+				target_free_all_working_areas(target);
+				e = Jim_GetOpt_Obj(goi, &o_t);
+				if (e != JIM_OK)
+					return e;
+				tap = jtag_tap_by_jim_obj(goi->interp, o_t);
+				if (tap == NULL)
+					return JIM_ERR;
+				/* make this exactly 1 or 0 */
+				target->tap = tap;
+			} else {
+				if (goi->argc != 0)
+					goto no_params;
+			}
+			Jim_SetResultString(goi->interp, target->tap->dotted_name, -1);
+			/* loop for more e*/
+			break;
+		case TCFG_DBGBASE:
+			if (goi->isconfigure) {
+				e = Jim_GetOpt_Wide(goi, &w);
+				if (e != JIM_OK)
+					return e;
+				target->dbgbase = (uint32_t)w;
+				target->dbgbase_set = true;
+			} else {
+				if (goi->argc != 0)
+					goto no_params;
+			}
+			Jim_SetResult(goi->interp, Jim_NewIntObj(goi->interp, target->dbgbase));
+			/* loop for more */
+			break;
+		case TCFG_AP_NUM:
+			if (goi->isconfigure) {
+				e = Jim_GetOpt_Wide(goi, &w);
+				if (e != JIM_OK)
+					return e;
+				if (w < 0 || w > 255) {
+					Jim_SetResultString(goi->interp, "-ap-num out of range", -1);
+					return JIM_ERR;
+				}
+				target->ap_num = (uint32_t)w;
+				target->ap_num_set = true;
+			} else {
+				if (goi->argc != 0)
+					goto no_params;
+			}
+			Jim_SetResult(goi->interp, Jim_NewIntObj(goi->interp, target->ap_num));
+			/* loop for more */
+			break;
+
+		case TCFG_POLL_MAX:
+			if (goi->isconfigure) {
+				e = Jim_GetOpt_Wide(goi, &w);
+				if (e != JIM_OK)
+					return e;
+				if (w < polling_interval_min) {
+					Jim_SetResultString(goi->interp, "-poll-max below the fast poll rate", -1);
+					return JIM_ERR;
+				}
+				target->poll_interval_max = (int)w;
+			} else {
+				if (goi->argc != 0)
+					goto no_params;
+			}
+			Jim_SetResult(goi->interp, Jim_NewIntObj(goi->interp, target->poll_interval_max));
+			/* loop for more */
+			break;
+
+		case TCFG_RTOS:
+			/* RTOS */
+			{
+				int result = rtos_create(goi, target);
+				if (result != JIM_OK)
+					return result;
+			}
+			/* loop for more */
+			break;
+		}
+	} /* while (goi->argc) */
+
+
+		/* done - we return */
+	return JIM_OK;
+}
+
+static int jim_target_configure(Jim_Interp *interp, int argc, Jim_Obj * const *argv)
+{
+	Jim_GetOptInfo goi;
+
+	Jim_GetOpt_Setup(&goi, interp, argc - 1, argv + 1);
+	goi.isconfigure = !strcmp(Jim_GetString(argv[0], NULL), "configure");
+	int need_args = 1 + goi.isconfigure;
+	if (goi.argc < need_args) {
+		Jim_WrongNumArgs(goi.interp, goi.argc, goi.argv,
+			goi.isconfigure
+				? "missing: -option VALUE ..."
+				: "missing: -option ...");
+		return JIM_ERR;
+	}
+	struct target *target = Jim_CmdPrivData(goi.interp);
+	return target_configure(&goi, target);
+}
+
+static int jim_target_mw(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	const char *cmd_name = Jim_GetString(argv[0], NULL);
+
+	Jim_GetOptInfo goi;
+	Jim_GetOpt_Setup(&goi, interp, argc - 1, argv + 1);
+
+	if (goi.argc < 2 || goi.argc > 4) {
+		Jim_SetResultFormatted(goi.interp,
+				"usage: %s [phys] <address> <data> [<count>]", cmd_name);
+		return JIM_ERR;
+	}
+
+	target_write_fn fn;
+	fn = target_write_memory;
+
+	int e;
+	if (strcmp(Jim_GetString(argv[1], NULL), "phys") == 0) {
+		/* consume it */
+		struct Jim_Obj *obj;
+		e = Jim_GetOpt_Obj(&goi, &obj);
+		if (e != JIM_OK)
+			return e;
+
+		fn = target_write_phys_memory;
+	}
+
+	jim_wide a;
+	e = Jim_GetOpt_Wide(&goi, &a);
+	if (e != JIM_OK)
+		return e;
+
+	jim_wide b;
+	e = Jim_GetOpt_Wide(&goi, &b);
+	if (e != JIM_OK)
+		return e;
+
+	jim_wide c = 1;
+	if (goi.argc == 1) {
+		e = Jim_GetOpt_Wide(&goi, &c);
+		if (e != JIM_OK)
+			return e;
+	}
+
+	/* all args must be consumed */
+	if (goi.argc != 0)
+		return JIM_ERR;
+
+	struct target *target = Jim_CmdPrivData(goi.interp);
+	unsigned data_size;
+	if (strcasecmp(cmd_name, "mww") == 0)
+		data_size = 4;
+	else if (strcasecmp(cmd_name, "mwh") == 0)
+		data_size = 2;
+	else if (strcasecmp(cmd_name, "mwb") == 0)
+		data_size = 1;
+	else {
+		LOG_ERROR("command '%s' unknown: ", cmd_name);
+		return JIM_ERR;
+	}
+
+	return (target_fill_mem(target, a, fn, data_size, b, c) == ERROR_OK) ? JIM_OK : JIM_ERR;
+}
+
+/**
+*  @brief Reads an array of words/halfwords/bytes from target memory starting at specified address.
+*
+*  Usage: mdw [phys] <address> [<count>] - for 32 bit reads
+*         mdh [phys] <address> [<count>] - for 16 bit reads
+*         mdb [phys] <address> [<count>] - for  8 bit reads
+*
+*  Count defaults to 1.
+*
+*  Calls target_read_memory or target_read_phys_memory depending on
+*  the presence of the "phys" argument
+*  Reads the target memory in blocks of max. 32 bytes, and returns an array of ints formatted
+*  to int representation in base16.
+*  Also outputs read data in a human readable form using command_print
+*
+*  @param phys if present target_read_phys_memory will be used instead of target_read_memory
+*  @param address address where to start the read. May be specified in decimal or hex using the standard "0x" prefix
+*  @param count optional count parameter to read an array of values. If not specified, defaults to 1.
+*  @returns:  JIM_ERR on error or JIM_OK on success and sets the result string to an array of ascii formatted numbers
+*  on success, with [<count>] number of elements.
+*
+*  In case of little endian target:
+*      Example1: "mdw 0x00000000"  returns "10123456"
+*      Exmaple2: "mdh 0x00000000 1" returns "3456"
+*      Example3: "mdb 0x00000000" returns "56"
+*      Example4: "mdh 0x00000000 2" returns "3456 1012"
+*      Example5: "mdb 0x00000000 3" returns "56 34 12"
+**/
+static int jim_target_md(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	const char *cmd_name = Jim_GetString(argv[0], NULL);
+
+	Jim_GetOptInfo goi;
+	Jim_GetOpt_Setup(&goi, interp, argc - 1, argv + 1);
+
+	if ((goi.argc < 1) || (goi.argc > 3)) {
+		Jim_SetResultFormatted(goi.interp,
+				"usage: %s [phys] <address> [<count>]", cmd_name);
+		return JIM_ERR;
+	}
+
+	int (*fn)(struct target *target,
+			uint32_t address, uint32_t size, uint32_t count, uint8_t *buffer);
+	fn = target_read_memory;
+
+	int e;
+	if (strcmp(Jim_GetString(argv[1], NULL), "phys") == 0) {
+		/* consume it */
+		struct Jim_Obj *obj;
+		e = Jim_GetOpt_Obj(&goi, &obj);
+		if (e != JIM_OK)
+			return e;
+
+		fn = target_read_phys_memory;
+	}
+
+	/* Read address parameter */
+	jim_wide addr;
+	e = Jim_GetOpt_Wide(&goi, &addr);
+	if (e != JIM_OK)
+		return JIM_ERR;
+
+	/* If next parameter exists, read it out as the count parameter, if not, set it to 1 (default) */
+	jim_wide count;
+	if (goi.argc == 1) {
+		e = Jim_GetOpt_Wide(&goi, &count);
+		if (e != JIM_OK)
+			return JIM_ERR;
+	} else
+		count = 1;
+
+	/* all args must be consumed */
+	if (goi.argc != 0)
+		return JIM_ERR;
+
+	jim_wide dwidth = 1; /* shut up gcc */
+	if (strcasecmp(cmd_name, "mdw") == 0)
+		dwidth = 4;
+	else if (strcasecmp(cmd_name, "mdh") == 0)
+		dwidth = 2;
+	else if (strcasecmp(cmd_name, "mdb") == 0)
+		dwidth = 1;
+	else {
+		LOG_ERROR("command '%s' unknown: ", cmd_name);
+		return JIM_ERR;
+	}
+
+	/* convert count to "bytes" */
+	int bytes = count * dwidth;
+
+	struct target *target = Jim_CmdPrivData(goi.interp);
+	uint8_t  target_buf[32];
+	jim_wide x, y, z;
+	while (bytes > 0) {
+		y = (bytes < 16) ? bytes : 16; /* y = min(bytes, 16); */
+
+		/* Try to read out next block */
+		e = fn(target, addr, dwidth, y / dwidth, target_buf);
+
+		if (e != ERROR_OK) {
+			Jim_SetResultFormatted(interp, "error reading target @ 0x%08lx", (long)addr);
+			return JIM_ERR;
+		}
+
+		command_print_sameline(NULL, "0x%08x ", (int)(addr));
+		switch (dwidth) {
+		case 4:
+			for (x = 0; x < 16 && x < y; x += 4) {
+				z = target_buffer_get_u32(target, &(target_buf[x]));
+				command_print_sameline(NULL, "%08x ", (int)(z));
+			}
+			for (; (x < 16) ; x += 4)
+				command_print_sameline(NULL, "         ");
+			break;
+		case 2:
+			for (x = 0; x < 16 && x < y; x += 2) {
+				z = target_buffer_get_u16(target, &(target_buf[x]));
+				command_print_sameline(NULL, "%04x ", (int)(z));
+			}
+			for (; (x < 16) ; x += 2)
+				command_print_sameline(NULL, "     ");
+			break;
+		case 1:
+		default:
+			for (x = 0 ; (x < 16) && (x < y) ; x += 1) {
+				z = target_buffer_get_u8(target, &(target_buf[x]));
+				command_print_sameline(NULL, "%02x ", (int)(z));
+			}
+			for (; (x < 16) ; x += 1)
+				command_print_sameline(NULL, "   ");
+			break;
+		}
+		/* ascii-ify the bytes */
+		for (x = 0 ; x < y ; x++) {
+			if ((target_buf[x] >= 0x20) &&
+				(target_buf[x] <= 0x7e)) {
+				/* good */
+			} else {
+				/* smack it */
+				target_buf[x] = '.';
+			}
+		}
+		/* space pad  */
+		while (x < 16) {
+			target_buf[x] = ' ';
+			x++;
+		}
+		/* terminate */
+		target_buf[16] = 0;
+		/* print - with a newline */
+		command_print_sameline(NULL, "%s\n", target_buf);
+		/* NEXT... */
+		bytes -= 16;
+		addr += 16;
+	}
+	return JIM_OK;
+}
+
+static int jim_target_mem2array(Jim_Interp *interp,
+		int argc, Jim_Obj *const *argv)
+{
+	struct target *target = Jim_CmdPrivData(interp);
+	return target_mem2array(interp, target, argc - 1, argv + 1);
+}
+
+static int jim_target_mem2list(Jim_Interp *interp,
+		int argc, Jim_Obj *const *argv)
+{
+	struct target *target = Jim_CmdPrivData(interp);
+	return target_mem2list(interp, target, argc - 1, argv + 1);
+}
+
+static int jim_target_list2mem(Jim_Interp *interp,
+		int argc, Jim_Obj *const *argv)
+{
+	struct target *target = Jim_CmdPrivData(interp);
+	return target_list2mem(interp, target, argc - 1, argv + 1);
+}
+
+static int jim_target_array2mem(Jim_Interp *interp,
+		int argc, Jim_Obj *const *argv)
+{
+	struct target *target = Jim_CmdPrivData(interp);
+	return target_array2mem(interp, target, argc - 1, argv + 1);
+}
+
+static int jim_target_tap_disabled(Jim_Interp *interp)
+{
+	Jim_SetResultFormatted(interp, "[TAP is disabled]");
+	return JIM_ERR;
+}
+
+static int jim_target_examine(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	if (argc != 1) {
+		Jim_WrongNumArgs(interp, 1, argv, "[no parameters]");
+		return JIM_ERR;
+	}
+	struct target *target = Jim_CmdPrivData(interp);
+	if (!target->tap->enabled)
+		return jim_target_tap_disabled(interp);
+
+	int e = target->type->examine(target);
+	if (e != ERROR_OK)
+		return JIM_ERR;
+	return JIM_OK;
+}
+
+static int jim_target_halt_gdb(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	if (argc != 1) {
+		Jim_WrongNumArgs(interp, 1, argv, "[no parameters]");
+		return JIM_ERR;
+	}
+	struct target *target = Jim_CmdPrivData(interp);
+
+	if (target_call_event_callbacks(target, TARGET_EVENT_GDB_HALT) != ERROR_OK)
+		return JIM_ERR;
+
+	return JIM_OK;
+}
+
+static int jim_target_poll(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	if (argc != 1) {
+		Jim_WrongNumArgs(interp, 1, argv, "[no parameters]");
+		return JIM_ERR;
+	}
+	struct target *target = Jim_CmdPrivData(interp);
+	if (!target->tap->enabled)
+		return jim_target_tap_disabled(interp);
+
+	int e;
+	if (!(target_was_examined(target)))
+		e = ERROR_TARGET_NOT_EXAMINED;
+	else
+		e = target->type->poll(target);
+	if (e != ERROR_OK)
+		return JIM_ERR;
+	return JIM_OK;
+}
+
+static int jim_target_reset(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	Jim_GetOptInfo goi;
+	Jim_GetOpt_Setup(&goi, interp, argc - 1, argv + 1);
+
+	if (goi.argc != 2) {
+		Jim_WrongNumArgs(interp, 0, argv,
+				"([tT]|[fF]|assert|deassert) BOOL");
+		return JIM_ERR;
+	}
+
+	Jim_Nvp *n;
+	int e = Jim_GetOpt_Nvp(&goi, nvp_assert, &n);
+	if (e != JIM_OK) {
+		Jim_GetOpt_NvpUnknown(&goi, nvp_assert, 1);
+		return e;
+	}
+	/* the halt or not param */
+	jim_wide a;
+	e = Jim_GetOpt_Wide(&goi, &a);
+	if (e != JIM_OK)
+		return e;
+
+	struct target *target = Jim_CmdPrivData(goi.interp);
+	if (!target->tap->enabled)
+		return jim_target_tap_disabled(interp);
+	if (!(target_was_examined(target))) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_TARGET_NOT_EXAMINED;
+	}
+	if (!target->type->assert_reset || !target->type->deassert_reset) {
+		Jim_SetResultFormatted(interp,
+				"No target-specific reset for %s",
+				target_name(target));
+		return JIM_ERR;
+	}
+	/* determine if we should halt or not. */
+	target->reset_halt = !!a;
+	/* When this happens - all workareas are invalid. */
+	target_free_all_working_areas_restore(target, 0);
+
+	/* do the assert */
+	if (n->value == NVP_ASSERT)
+		e = target->type->assert_reset(target);
+	else
+		e = target->type->deassert_reset(target);
+	return (e == ERROR_OK) ? JIM_OK : JIM_ERR;
+}
+
+static int jim_target_halt(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	if (argc != 1) {
+		Jim_WrongNumArgs(interp, 1, argv, "[no parameters]");
+		return JIM_ERR;
+	}
+	struct target *target = Jim_CmdPrivData(interp);
+	if (!target->tap->enabled)
+		return jim_target_tap_disabled(interp);
+	int e = target->type->halt(target);
+	return (e == ERROR_OK) ? JIM_OK : JIM_ERR;
+}
+
+static int jim_target_wait_state(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	Jim_GetOptInfo goi;
+	Jim_GetOpt_Setup(&goi, interp, argc - 1, argv + 1);
+
+	/* params:  <name>  statename timeoutmsecs */
+	if (goi.argc != 2) {
+		const char *cmd_name = Jim_GetString(argv[0], NULL);
+		Jim_SetResultFormatted(goi.interp,
+				"%s <state_name> <timeout_in_msec>", cmd_name);
+		return JIM_ERR;
+	}
+
+	Jim_Nvp *n;
+	int e = Jim_GetOpt_Nvp(&goi, nvp_target_state, &n);
+	if (e != JIM_OK) {
+		Jim_GetOpt_NvpUnknown(&goi, nvp_target_state, 1);
+		return e;
+	}
+	jim_wide a;
+	e = Jim_GetOpt_Wide(&goi, &a);
+	if (e != JIM_OK)
+		return e;
+	struct target *target = Jim_CmdPrivData(interp);
+	if (!target->tap->enabled)
+		return jim_target_tap_disabled(interp);
+
+	e = target_wait_state(target, n->value, a);
+	if (e != ERROR_OK) {
+		Jim_Obj *eObj = Jim_NewIntObj(interp, e);
+		Jim_SetResultFormatted(goi.interp,
+				"target: %s wait %s fails (%#s) %s",
+				target_name(target), n->name,
+				eObj, target_strerror_safe(e));
+		Jim_FreeNewObj(interp, eObj);
+		return JIM_ERR;
+	}
+	return JIM_OK;
+}
+/* List for human, Events defined for this target.
+ * scripts/programs should use 'name cget -event NAME'
+ */
+static int jim_target_event_list(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	struct command_context *cmd_ctx = current_command_context(interp);
+	assert(cmd_ctx != NULL);
+
+	struct target *target = Jim_CmdPrivData(interp);
+	struct target_event_action *teap = target->event_action;
+	command_print(cmd_ctx, "Event actions for target (%d) %s\n",
+				   target->target_number,
+				   target_name(target));
+	command_print(cmd_ctx, "%-25s | Body", "Event");
+	command_print(cmd_ctx, "------------------------- | "
+			"----------------------------------------");
+	while (teap) {
+		Jim_Nvp *opt = Jim_Nvp_value2name_simple(nvp_target_event, teap->event);
+		command_print(cmd_ctx, "%-25s | %s",
+				opt->name, Jim_GetString(teap->body, NULL));
+		teap = teap->next;
+	}
+	command_print(cmd_ctx, "***END***");
+	return JIM_OK;
+}
+static int jim_target_current_state(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	if (argc != 1) {
+		Jim_WrongNumArgs(interp, 1, argv, "[no parameters]");
+		return JIM_ERR;
+	}
+	struct target *target = Jim_CmdPrivData(interp);
+	Jim_SetResultString(interp, target_state_name(target), -1);
+	return JIM_OK;
+}
+static int jim_target_invoke_event(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	Jim_GetOptInfo goi;
+	Jim_GetOpt_Setup(&goi, interp, argc - 1, argv + 1);
+	if (goi.argc != 1) {
+		const char *cmd_name = Jim_GetString(argv[0], NULL);
+		Jim_SetResultFormatted(goi.interp, "%s <eventname>", cmd_name);
+		return JIM_ERR;
+	}
+	Jim_Nvp *n;
+	int e = Jim_GetOpt_Nvp(&goi, nvp_target_event, &n);
+	if (e != JIM_OK) {
+		Jim_GetOpt_NvpUnknown(&goi, nvp_target_event, 1);
+		return e;
+	}
+	struct target *target = Jim_CmdPrivData(interp);
+	target_handle_event(target, n->value);
+	return JIM_OK;
+}
+
+static const struct command_registration target_instance_command_handlers[] = {
+	{
+		.name = "configure",
+		.mode = COMMAND_CONFIG,
+		.jim_handler = jim_target_configure,
+		.help  = "configure a new target for use",
+		.usage = "[target_attribute ...]",
+	},
+	{
+		.name = "cget",
+		.mode = COMMAND_ANY,
+		.jim_handler = jim_target_configure,
+		.help  = "returns the specified target attribute",
+		.usage = "target_attribute",
+	},
+	{
+		.name = "mww",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_target_mw,
+		.help = "Write 32-bit word(s) to target memory",
+		.usage = "address data [count]",
+	},
+	{
+		.name = "mwh",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_target_mw,
+		.help = "Write 16-bit half-word(s) to target memory",
+		.usage = "address data [count]",
+	},
+	{
+		.name = "mwb",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_target_mw,
+		.help = "Write byte(s) to target memory",
+		.usage = "address data [count]",
+	},
+	{
+		.name = "mdw",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_target_md,
+		.help = "Display target memory as 32-bit words",
+		.usage = "address [count]",
+	},
+	{
+		.name = "mdh",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_target_md,
+		.help = "Display target memory as 16-bit half-words",
+		.usage = "address [count]",
+	},
+	{
+		.name = "mdb",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_target_md,
+		.help = "Display target memory as 8-bit bytes",
+		.usage = "address [count]",
+	},
+	{
+		.name = "array2mem",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_target_array2mem,
+		.help = "Writes Tcl array of 8/16/32 bit numbers "
+			"to target memory",
+		.usage = "arrayname bitwidth address count",
+	},
+	{
+		.name = "mem2array",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_target_mem2array,
+		.help = "Loads Tcl array of 8/16/32 bit numbers "
+			"from target memory",
+		.usage = "arrayname bitwidth address count",
+	},
+	{
+		.name = "list2mem",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_target_list2mem,
+		.help = "Writes Tcl list of 8/16/32 bit numbers "
+			"to target memory",
+		.usage = "list bitwidth address",
+	},
+	{
+		.name = "mem2list",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_target_mem2list,
+		.help = "Reads 8/16/32 bit numbers from target memory "
+			"and returns them as a Tcl list",
+		.usage = "bitwidth address count",
+	},
+	{
+		.name = "eventlist",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_target_event_list,
+		.help = "displays a table of events defined for this target",
+	},
+	{
+		.name = "curstate",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_target_current_state,
+		.help = "displays the current state of this target",
+	},
+	{
+		.name = "arp_examine",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_target_examine,
+		.help = "used internally for reset processing",
+	},
+	{
+		.name = "arp_halt_gdb",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_target_halt_gdb,
+		.help = "used internally for reset processing to halt GDB",
+	},
+	{
+		.name = "arp_poll",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_target_poll,
+		.help = "used internally for reset processing",
+	},
+	{
+		.name = "arp_reset",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_target_reset,
+		.help = "used internally for reset processing",
+	},
+	{
+		.name = "arp_halt",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_target_halt,
+		.help = "used internally for reset processing",
+	},
+	{
+		.name = "arp_waitstate",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_target_wait_state,
+		.help = "used internally for reset processing",
+	},
+	{
+		.name = "invoke-event",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_target_invoke_event,
+		.help = "invoke handler for specified event",
+		.usage = "event_name",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+static int target_create(Jim_GetOptInfo *goi)
+{
+	Jim_Obj *new_cmd;
+	Jim_Cmd *cmd;
+	const char *cp;
+	char *cp2;
+	int e;
+	int x;
+	struct target *target;
+	struct command_context *cmd_ctx;
+
+	cmd_ctx = current_command_context(goi->interp);
+	assert(cmd_ctx != NULL);
+
+	if (goi->argc < 3) {
+		Jim_WrongNumArgs(goi->interp, 1, goi->argv, "?name? ?type? ..options...");
+		return JIM_ERR;
+	}
+
+	/* COMMAND */
+	Jim_GetOpt_Obj(goi, &new_cmd);
+	/* does this command exist? */
+	cmd = Jim_GetCommand(goi->interp, new_cmd, JIM_ERRMSG);
+	if (cmd) {
+		cp = Jim_GetString(new_cmd, NULL);
+		Jim_SetResultFormatted(goi->interp, "Command/target: %s Exists", cp);
+		return JIM_ERR;
+	}
+
+	/* TYPE */
+	e = Jim_GetOpt_String(goi, &cp2, NULL);
+	if (e != JIM_OK)
+		return e;
+	cp = cp2;
+	struct transport *tr = get_current_transport();
+	if (tr->override_target) {
+		e = tr->override_target(&cp);
+		if (e != ERROR_OK) {
+			LOG_ERROR("The selected transport doesn't support this target");
+			return JIM_ERR;
+		}
+		LOG_INFO("The selected transport took over low-level target control. The results might differ compared to plain JTAG/SWD");
+	}
+	/* now does target type exist */
+	for (x = 0 ; target_types[x] ; x++) {
+		if (0 == strcmp(cp, target_types[x]->name)) {
+			/* found */
+			break;
+		}
+
+		/* check for deprecated name */
+		if (target_types[x]->deprecated_name) {
+			if (0 == strcmp(cp, target_types[x]->deprecated_name)) {
+				/* found */
+				LOG_WARNING("target name is deprecated use: \'%s\'", target_types[x]->name);
+				break;
+			}
+		}
+	}
+	if (target_types[x] == NULL) {
+		Jim_SetResultFormatted(goi->interp, "Unknown target type %s, try one of ", cp);
+		for (x = 0 ; target_types[x] ; x++) {
+			if (target_types[x + 1]) {
+				Jim_AppendStrings(goi->interp,
+								   Jim_GetResult(goi->interp),
+								   target_types[x]->name,
+								   ", ", NULL);
+			} else {
+				Jim_AppendStrings(goi->interp,
+								   Jim_GetResult(goi->interp),
+								   " or ",
+								   target_types[x]->name, NULL);
+			}
+		}
+		return JIM_ERR;
+	}
+
+	/* Create it */
+	target = calloc(1, sizeof(struct target));
+	target->event_action_index = calloc(TARGET_EVENT_NUM,
+			sizeof(struct target_event_action *));
+	/* set target number */
+	target->target_number = new_target_number();
+	cmd_ctx->current_target = target->target_number;
+
+	/* allocate memory for each unique target type */
+	target->type = calloc(1, sizeof(struct target_type));
+
+	memcpy(target->type, target_types[x], sizeof(struct target_type));
+
+	/* will be set by "-endian" */
+	target->endianness = TARGET_ENDIAN_UNKNOWN;
+
+	/* default to first core, override with -coreid */
+	target->coreid = 0;
+
+	target->working_area        = 0x0;
+	target->working_area_size   = 0x0;
+	target->working_areas       = NULL;
+	target->backup_working_area = 0;
+
+	target->state               = TARGET_UNKNOWN;
+	target->debug_reason        = DBG_REASON_UNDEFINED;
+	target->reg_cache           = NULL;
+	target->breakpoints         = NULL;
+	target->watchpoints         = NULL;
+	target->next                = NULL;
+	target->arch_info           = NULL;
+
+	target->display             = 1;
+
+	target->halt_issued			= false;
+
+	target->poll_interval		= polling_interval;
+	target->poll_interval_max	= polling_interval_max;
+	target->next_poll_time		= 0;
+
+	/* initialize trace information */
+	target->trace_info = malloc(sizeof(struct trace));
+	target->trace_info->num_trace_points         = 0;
+	target->trace_info->trace_points_size        = 0;
+	target->trace_info->trace_points             = NULL;
+	target->trace_info->trace_history_size       = 0;
+	target->trace_info->trace_history            = NULL;
+	target->trace_info->trace_history_pos        = 0;
+	target->trace_info->trace_history_overflowed = 0;
+
+	target->dbgmsg          = NULL;
+	target->dbg_msg_enabled = 0;
+
+	target->endianness = TARGET_ENDIAN_UNKNOWN;
+
+	target->rtos = NULL;
+	target->rtos_auto_detect = false;
+
+	/* Do the rest as "configure" options */
+	goi->isconfigure = 1;
+	e = target_configure(goi, target);
+
+	if (target->tap == NULL) {
+		Jim_SetResultString(goi->interp, "-chain-position required when creating target", -1);
+		e = JIM_ERR;
+	}
+
+	if (e != JIM_OK) {
+		free(target->type);
+		free(target);
+		return e;
+	}
+
+	if (target->endianness == TARGET_ENDIAN_UNKNOWN) {
+		/* default endian to little if not specified */
+		target->endianness = TARGET_LITTLE_ENDIAN;
+	}
+
+	cp = Jim_GetString(new_cmd, NULL);
+	target->cmd_name = strdup(cp);
+
+	/* create the target specific commands */
+	if (target->type->commands) {
+		e = register_commands(cmd_ctx, NULL, target->type->commands);
+		if (ERROR_OK != e)
+			LOG_ERROR("unable to register '%s' commands", cp);
+	}
+	if (target->type->target_create)
+		(*(target->type->target_create))(target, goi->interp);
+
+	/* append to end of list */
+	{
+		struct target **tpp;
+		tpp = &(all_targets);
+		while (*tpp)
+			tpp = &((*tpp)->next);
+		*tpp = target;
+	}
+
+	/* now - create the new target name command */
+	const struct command_registration target_subcommands[] = {
+		{
+			.chain = target_instance_command_handlers,
+		},
+		{
+			.chain = target->type->commands,
+		},
+		COMMAND_REGISTRATION_DONE
+	};
+	const struct command_registration target_commands[] = {
+		{
+			.name = cp,
+			.mode = COMMAND_ANY,
+			.help = "target command group",
+			.usage = "",
+			.chain = target_subcommands,
+		},
+		COMMAND_REGISTRATION_DONE
+	};
+	e = register_commands(cmd_ctx, NULL, target_commands);
+	if (ERROR_OK != e)
+		return JIM_ERR;
+
+	struct command *c = command_find_in_context(cmd_ctx, cp);
+	assert(c);
+	command_set_handler_data(c, target);
+
+	return (ERROR_OK == e) ? JIM_OK : JIM_ERR;
+}
+
+static int jim_target_current(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	if (argc != 1) {
+		Jim_WrongNumArgs(interp, 1, argv, "Too many parameters");
+		return JIM_ERR;
+	}
+	struct command_context *cmd_ctx = current_command_context(interp);
+	assert(cmd_ctx != NULL);
+
+	Jim_SetResultString(interp, target_name(get_current_target(cmd_ctx)), -1);
+	return JIM_OK;
+}
+
+static int jim_target_types(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	if (argc != 1) {
+		Jim_WrongNumArgs(interp, 1, argv, "Too many parameters");
+		return JIM_ERR;
+	}
+	Jim_SetResult(interp, Jim_NewListObj(interp, NULL, 0));
+	for (unsigned x = 0; NULL != target_types[x]; x++) {
+		Jim_ListAppendElement(interp, Jim_GetResult(interp),
+			Jim_NewStringObj(interp, target_types[x]->name, -1));
+	}
+	return JIM_OK;
+}
+
+static int jim_target_names(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	if (argc != 1) {
+		Jim_WrongNumArgs(interp, 1, argv, "Too many parameters");
+		return JIM_ERR;
+	}
+	Jim_SetResult(interp, Jim_NewListObj(interp, NULL, 0));
+	struct target *target = all_targets;
+	while (target) {
+		Jim_ListAppendElement(interp, Jim_GetResult(interp),
+			Jim_NewStringObj(interp, target_name(target), -1));
+		target = target->next;
+	}
+	return JIM_OK;
+}
+
+static int jim_target_smp(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	int i;
+	const char *targetname;
+	int retval, len;
+	struct target *target = (struct target *) NULL;
+	struct target_list *head, *curr, *new;
+	curr = (struct target_list *) NULL;
+	head = (struct target_list *) NULL;
+
+	retval = 0;
+	LOG_DEBUG("%d", argc);
+	/* argv[1] = target to associate in smp
+	 * argv[2] = target to assoicate in smp
+	 * argv[3] ...
+	 */
+
+	for (i = 1; i < argc; i++) {
+
+		targetname = Jim_GetString(argv[i], &len);
+		target = get_target(targetname);
+		LOG_DEBUG("%s ", targetname);
+		if (target) {
+			new = malloc(sizeof(struct target_list));
+			new->target = target;
+			new->next = (struct target_list *)NULL;
+			if (head == (struct target_list *)NULL) {
+				head = new;
+				curr = head;
+			} else {
+				curr->next = new;
+				curr = new;
+			}
+		}
+	}
+	/*  now parse the list of cpu and put the target in smp mode*/
+	curr = head;
+
+	while (curr != (struct target_list *)NULL) {
+		target = curr->target;
+		target->smp = 1;
+		target->head = head;
+		curr = curr->next;
+	}
+
+	if (target && target->rtos)
+		retval = rtos_smp_init(head->target);
+
+	return retval;
+}
+
+
+static int jim_target_create(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	Jim_GetOptInfo goi;
+	Jim_GetOpt_Setup(&goi, interp, argc - 1, argv + 1);
+	if (goi.argc < 3) {
+		Jim_WrongNumArgs(goi.interp, goi.argc, goi.argv,
+			"<name> <target_type> [<target_options> ...]");
+		return JIM_ERR;
+	}
+	return target_create(&goi);
+}
+
+static void target_bench_snapshot(uint64_t *counts, uint64_t *totals)
+{
+	for (unsigned i = 0; i < PROFILE_NUM_SCOPES; i++)
+		profile_scope_totals(i, &counts[i], &totals[i]);
+}
+
+/* Print how much of a benchmark phase was spent in the instrumented
+ * adapter scope, and how much building queues and post-processing on
+ * the host.  Scope totals can nest (the mem_ap scopes include their
+ * jtag_execute_queue time), so only the queue scope is subtracted from
+ * the wall time; the others are shown for reference. */
+static void target_bench_report_layers(struct command_context *cmd_ctx,
+		struct duration *bench, const uint64_t *counts, const uint64_t *totals)
+{
+	uint64_t counts_now[PROFILE_NUM_SCOPES], totals_now[PROFILE_NUM_SCOPES];
+	uint64_t wall_us = (uint64_t)(duration_elapsed(bench) * 1000000.0);
+
+	target_bench_snapshot(counts_now, totals_now);
+
+	uint64_t queue_calls = counts_now[PROFILE_JTAG_EXECUTE_QUEUE]
+		- counts[PROFILE_JTAG_EXECUTE_QUEUE];
+	uint64_t queue_us = totals_now[PROFILE_JTAG_EXECUTE_QUEUE]
+		- totals[PROFILE_JTAG_EXECUTE_QUEUE];
+
+	if (queue_calls == 0) {
+		command_print(cmd_ctx, "  (no instrumented adapter activity)");
+		return;
+	}
+
+	if (queue_us > wall_us)
+		queue_us = wall_us;
+
+	command_print(cmd_ctx, "  adapter: %" PRIu64 " queue executions, "
+			"%" PRIu64 ".%03" PRIu64 " ms; "
+			"queue build + post-processing: %" PRIu64 ".%03" PRIu64 " ms",
+			queue_calls, queue_us / 1000, queue_us % 1000,
+			(wall_us - queue_us) / 1000, (wall_us - queue_us) % 1000);
+
+	for (unsigned i = 0; i < PROFILE_NUM_SCOPES; i++) {
+		if (i == PROFILE_JTAG_EXECUTE_QUEUE)
+			continue;
+
+		uint64_t count = counts_now[i] - counts[i];
+		uint64_t total = totals_now[i] - totals[i];
+
+		if (count == 0)
+			continue;
+
+		command_print(cmd_ctx, "  %s: %" PRIu64 " calls, "
+				"%" PRIu64 ".%03" PRIu64 " ms",
+				profile_scope_name(i), count,
+				total / 1000, total % 1000);
+	}
+}
+
+COMMAND_HANDLER(handle_target_bench_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	uint32_t total_size;
+	uint32_t block_size = 0;
+	uint64_t counts[PROFILE_NUM_SCOPES], totals[PROFILE_NUM_SCOPES];
+	struct duration bench;
+	int retval;
+
+	if (CMD_ARGC < 1 || CMD_ARGC > 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], total_size);
+	if (CMD_ARGC == 2)
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], block_size);
+	if ((block_size == 0) || (block_size > total_size))
+		block_size = total_size;
+
+	if (target->state != TARGET_HALTED) {
+		command_print(CMD_CTX, "target must be halted to benchmark memory access");
+		return ERROR_TARGET_NOT_HALTED;
+	}
+
+	struct working_area *wa = NULL;
+	retval = target_alloc_working_area(target, block_size, &wa);
+	if (retval != ERROR_OK) {
+		LOG_ERROR("Not enough working area, reduce the block size");
+		return ERROR_FAIL;
+	}
+
+	uint8_t *buf = malloc(block_size);
+	if (buf == NULL) {
+		target_free_working_area(target, wa);
+		return ERROR_FAIL;
+	}
+
+	for (uint32_t i = 0; i < block_size; i++)
+		buf[i] = rand();
+
+	uint32_t rounds = total_size / block_size;
+
+	/* capture the per-layer counters even while 'timing' is disabled */
+	bool profiling_was_enabled = profiling_enabled;
+	profiling_enabled = true;
+
+	/* sustained writes */
+	target_bench_snapshot(counts, totals);
+	duration_start(&bench);
+	for (uint32_t round = 0; round < rounds; round++) {
+		retval = target_write_buffer(target, wa->address, block_size, buf);
+		if (retval != ERROR_OK)
+			break;
+	}
+	duration_measure(&bench);
+
+	if (retval == ERROR_OK) {
+		command_print(CMD_CTX, "write %" PRIu32 " x %" PRIu32 " bytes: "
+				"%fs (%0.3f KiB/s)",
+				rounds, block_size, duration_elapsed(&bench),
+				duration_kbps(&bench, (int64_t)rounds * block_size));
+		target_bench_report_layers(CMD_CTX, &bench, counts, totals);
+	} else
+		command_print(CMD_CTX, "write benchmark failed");
+
+	/* sustained reads */
+	if (retval == ERROR_OK) {
+		target_bench_snapshot(counts, totals);
+		duration_start(&bench);
+		for (uint32_t round = 0; round < rounds; round++) {
+			retval = target_read_buffer(target, wa->address, block_size, buf);
+			if (retval != ERROR_OK)
+				break;
+		}
+		duration_measure(&bench);
+
+		if (retval == ERROR_OK) {
+			command_print(CMD_CTX, "read %" PRIu32 " x %" PRIu32 " bytes: "
+					"%fs (%0.3f KiB/s)",
+					rounds, block_size, duration_elapsed(&bench),
+					duration_kbps(&bench, (int64_t)rounds * block_size));
+			target_bench_report_layers(CMD_CTX, &bench, counts, totals);
+		} else
+			command_print(CMD_CTX, "read benchmark failed");
+	}
+
+	/* small-access latency, one 32-bit word at a time */
+	if (retval == ERROR_OK) {
+		const unsigned accesses = 64;
+		uint32_t value = 0;
+
+		duration_start(&bench);
+		for (unsigned i = 0; (i < accesses) && (retval == ERROR_OK); i++)
+			retval = target_read_u32(target, wa->address, &value);
+		duration_measure(&bench);
+
+		if (retval == ERROR_OK)
+			command_print(CMD_CTX, "read latency: %0.1f us per 32-bit access",
+					duration_elapsed(&bench) * 1000000.0 / accesses);
+
+		if (retval == ERROR_OK) {
+			duration_start(&bench);
+			for (unsigned i = 0; (i < accesses) && (retval == ERROR_OK); i++)
+				retval = target_write_u32(target, wa->address, value);
+			duration_measure(&bench);
+
+			if (retval == ERROR_OK)
+				command_print(CMD_CTX, "write latency: %0.1f us per 32-bit access",
+						duration_elapsed(&bench) * 1000000.0 / accesses);
+		}
+
+		if (retval != ERROR_OK)
+			command_print(CMD_CTX, "latency benchmark failed");
+	}
+
+	profiling_enabled = profiling_was_enabled;
+
+	free(buf);
+	target_free_working_area(target, wa);
+
+	return retval;
+}
+
+static const struct command_registration target_subcommand_handlers[] = {
+	{
+		.name = "init",
+		.mode = COMMAND_CONFIG,
+		.handler = handle_target_init_command,
+		.help = "initialize targets",
+	},
+	{
+		.name = "create",
+		/* REVISIT this should be COMMAND_CONFIG ... */
+		.mode = COMMAND_ANY,
+		.jim_handler = jim_target_create,
+		.usage = "name type '-chain-position' name [options ...]",
+		.help = "Creates and selects a new target",
+	},
+	{
+		.name = "current",
+		.mode = COMMAND_ANY,
+		.jim_handler = jim_target_current,
+		.help = "Returns the currently selected target",
+	},
+	{
+		.name = "types",
+		.mode = COMMAND_ANY,
+		.jim_handler = jim_target_types,
+		.help = "Returns the available target types as "
+				"a list of strings",
+	},
+	{
+		.name = "names",
+		.mode = COMMAND_ANY,
+		.jim_handler = jim_target_names,
+		.help = "Returns the names of all targets as a list of strings",
+	},
+	{
+		.name = "smp",
+		.mode = COMMAND_ANY,
+		.jim_handler = jim_target_smp,
+		.usage = "targetname1 targetname2 ...",
+		.help = "gather several target in a smp list"
+	},
+	{
+		.name = "bench",
+		.mode = COMMAND_EXEC,
+		.handler = handle_target_bench_command,
+		.usage = "size [block_size]",
+		.help = "measure memory read/write throughput and access "
+			"latency against the working area",
+	},
+
+	COMMAND_REGISTRATION_DONE
+};
+
+/* CRC granularity of the resident image; chunks whose on-target CRC
+ * already matches are skipped by fast_load */
+#define FASTLOAD_CHUNK_SIZE (16 * 1024)
+
+struct FastLoad {
+	uint32_t address;
+	uint8_t *data;
+	uint32_t length;
+	/* one CRC per FASTLOAD_CHUNK_SIZE piece of data, precomputed */
+	uint32_t *chunk_crcs;
+};
+
+static int fastload_num;
+static struct FastLoad *fastload;
+
+static void free_fastload(void)
+{
+	if (fastload != NULL) {
+		int i;
+		for (i = 0; i < fastload_num; i++) {
+			if (fastload[i].data)
+				free(fastload[i].data);
+			free(fastload[i].chunk_crcs);
+		}
+		free(fastload);
+		fastload = NULL;
+		fastload_num = 0;
+	}
+}
+
+/* Append a run of image data to the resident image, coalescing
+ * sections that are contiguous in the address space so each run can
+ * later be handed to target_write_buffer() in one piece. */
+static int fastload_append(uint32_t address, const uint8_t *data, uint32_t length)
+{
+	struct FastLoad *entry = NULL;
+
+	if (fastload_num > 0) {
+		entry = &fastload[fastload_num - 1];
+		if (entry->address + entry->length != address)
+			entry = NULL;
+	}
+
+	if (entry == NULL) {
+		struct FastLoad *new_fastload = realloc(fastload,
+				sizeof(struct FastLoad) * (fastload_num + 1));
+		if (new_fastload == NULL)
+			return ERROR_FAIL;
+		fastload = new_fastload;
+		entry = &fastload[fastload_num++];
+		entry->address = address;
+		entry->data = NULL;
+		entry->length = 0;
+		entry->chunk_crcs = NULL;
+	}
+
+	uint8_t *new_data = realloc(entry->data, entry->length + length);
+	if (new_data == NULL)
+		return ERROR_FAIL;
+	memcpy(new_data + entry->length, data, length);
+	entry->data = new_data;
+	entry->length += length;
+
+	return ERROR_OK;
+}
+
+/* Precompute the per-chunk CRCs of the resident image, so fast_load
+ * only has to checksum the target side. */
+static int fastload_checksum(void)
+{
+	for (int i = 0; i < fastload_num; i++) {
+		struct FastLoad *entry = &fastload[i];
+		uint32_t num_chunks =
+			(entry->length + FASTLOAD_CHUNK_SIZE - 1) / FASTLOAD_CHUNK_SIZE;
+
+		entry->chunk_crcs = malloc(num_chunks * sizeof(uint32_t));
+		if (entry->chunk_crcs == NULL)
+			return ERROR_FAIL;
+
+		for (uint32_t c = 0; c < num_chunks; c++) {
+			uint32_t offset = c * FASTLOAD_CHUNK_SIZE;
+			uint32_t chunk_len = entry->length - offset;
+			if (chunk_len > FASTLOAD_CHUNK_SIZE)
+				chunk_len = FASTLOAD_CHUNK_SIZE;
+
+			int retval = image_calculate_checksum(entry->data + offset,
+					chunk_len, &entry->chunk_crcs[c]);
+			if (retval != ERROR_OK)
+				return retval;
+		}
+	}
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_fast_load_image_command)
+{
+	uint8_t *buffer;
+	size_t buf_cnt;
+	uint32_t image_size;
+	uint32_t min_address = 0;
+	uint32_t max_address = 0xffffffff;
+	int i;
+
+	struct image image;
+
+	int retval = CALL_COMMAND_HANDLER(parse_load_image_command_CMD_ARGV,
+			&image, &min_address, &max_address);
+	if (ERROR_OK != retval)
+		return retval;
+
+	struct duration bench;
+	duration_start(&bench);
+
+	retval = image_open(&image, CMD_ARGV[0], (CMD_ARGC >= 3) ? CMD_ARGV[2] : NULL);
+	if (retval != ERROR_OK)
+		return retval;
+
+	image_size = 0x0;
+	retval = ERROR_OK;
+	free_fastload();
+	for (i = 0; i < image.num_sections; i++) {
+		buffer = malloc(image.sections[i].size);
+		if (buffer == NULL) {
+			command_print(CMD_CTX, "error allocating buffer for section (%d bytes)",
+						  (int)(image.sections[i].size));
+			retval = ERROR_FAIL;
+			break;
+		}
+
+		retval = image_read_section(&image, i, 0x0, image.sections[i].size, buffer, &buf_cnt);
+		if (retval != ERROR_OK) {
+			free(buffer);
+			break;
+		}
+
+		uint32_t offset = 0;
+		uint32_t length = buf_cnt;
+
+		/* DANGER!!! beware of unsigned comparision here!!! */
+
+		if ((image.sections[i].base_address + buf_cnt >= min_address) &&
+				(image.sections[i].base_address < max_address)) {
+			if (image.sections[i].base_address < min_address) {
+				/* clip addresses below */
+				offset += min_address-image.sections[i].base_address;
+				length -= offset;
+			}
+
+			if (image.sections[i].base_address + buf_cnt > max_address)
+				length -= (image.sections[i].base_address + buf_cnt)-max_address;
+
+			retval = fastload_append(image.sections[i].base_address + offset,
+					buffer + offset, length);
+			if (retval != ERROR_OK) {
+				free(buffer);
+				command_print(CMD_CTX, "error allocating buffer for section (%" PRIu32 " bytes)",
+							  length);
+				break;
+			}
+
+			image_size += length;
+			command_print(CMD_CTX, "%u bytes written at address 0x%8.8x",
+						  (unsigned int)length,
+						  ((unsigned int)(image.sections[i].base_address + offset)));
+		}
+
+		free(buffer);
+	}
+
+	if (retval == ERROR_OK) {
+		retval = fastload_checksum();
+		if (retval != ERROR_OK)
+			command_print(CMD_CTX, "error checksumming image");
+	}
+
+	if ((ERROR_OK == retval) && (duration_measure(&bench) == ERROR_OK)) {
+		command_print(CMD_CTX, "Loaded %" PRIu32 " bytes "
+				"in %fs (%0.3f KiB/s)", image_size,
+				duration_elapsed(&bench), duration_kbps(&bench, image_size));
+
+		command_print(CMD_CTX,
+				"WARNING: image has not been loaded to target!"
+				"You can issue a 'fast_load' to finish loading.");
+	}
+
+	image_close(&image);
+
+	if (retval != ERROR_OK)
+		free_fastload();
+
+	return retval;
+}
+
+COMMAND_HANDLER(handle_fast_load_command)
+{
+	if (CMD_ARGC > 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	if (fastload == NULL) {
+		LOG_ERROR("No image in memory");
+		return ERROR_FAIL;
+	}
+	struct target *target = get_current_target(CMD_CTX);
+	int i;
+	int64_t ms = timeval_ms();
+	uint32_t size = 0;
+	uint32_t skipped = 0;
+	/* stop comparing after the first checksum failure (e.g. no
+	 * working area for the CRC algorithm) and just write everything */
+	bool check = true;
+	int retval = ERROR_OK;
+	for (i = 0; i < fastload_num; i++) {
+		command_print(CMD_CTX, "Write to 0x%08x, length 0x%08x",
+					  (unsigned int)(fastload[i].address),
+					  (unsigned int)(fastload[i].length));
+		for (uint32_t offset = 0; offset < fastload[i].length;
+				offset += FASTLOAD_CHUNK_SIZE) {
+			uint32_t address = fastload[i].address + offset;
+			uint32_t chunk_len = fastload[i].length - offset;
+			if (chunk_len > FASTLOAD_CHUNK_SIZE)
+				chunk_len = FASTLOAD_CHUNK_SIZE;
+
+			if (check) {
+				uint32_t crc;
+				if (target_checksum_memory(target, address,
+						chunk_len, &crc) != ERROR_OK) {
+					check = false;
+				} else if (crc == fastload[i].chunk_crcs[offset / FASTLOAD_CHUNK_SIZE]) {
+					skipped += chunk_len;
+					continue;
+				}
+			}
+
+			retval = target_write_buffer(target, address, chunk_len,
+					fastload[i].data + offset);
+			if (retval != ERROR_OK)
+				return retval;
+			size += chunk_len;
+		}
+	}
+	if (retval == ERROR_OK) {
+		int64_t after = timeval_ms();
+		if (skipped > 0)
+			command_print(CMD_CTX, "Skipped %" PRIu32 " bytes already on target",
+						  skipped);
+		command_print(CMD_CTX, "Loaded image %f kBytes/s", (float)(size/1024.0)/((float)(after-ms)/1000.0));
+	}
+	return retval;
+}
+
+static const struct command_registration target_command_handlers[] = {
+	{
+		.name = "targets",
+		.handler = handle_targets_command,
+		.mode = COMMAND_ANY,
+		.help = "change current default target (one parameter) "
+			"or prints table of all targets (no parameters)",
+		.usage = "[target]",
+	},
+	{
+		.name = "target",
+		.mode = COMMAND_CONFIG,
+		.help = "configure target",
+
+		.chain = target_subcommand_handlers,
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+int target_register_commands(struct command_context *cmd_ctx)
+{
+	return register_commands(cmd_ctx, NULL, target_command_handlers);
+}
+
+static bool target_reset_nag = true;
+
+bool get_target_reset_nag(void)
+{
+	return target_reset_nag;
+}
+
+COMMAND_HANDLER(handle_target_reset_nag)
+{
+	return CALL_COMMAND_HANDLER(handle_command_parse_bool,
+			&target_reset_nag, "Nag after each reset about options to improve "
+			"performance");
+}
+
+COMMAND_HANDLER(handle_ps_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	char *display;
+	if (target->state != TARGET_HALTED) {
+		LOG_INFO("target not halted !!");
+		return ERROR_OK;
+	}
+
+	if ((target->rtos) && (target->rtos->type)
+			&& (target->rtos->type->ps_command)) {
+		display = target->rtos->type->ps_command(target);
+		command_print(CMD_CTX, "%s", display);
+		free(display);
+		return ERROR_OK;
+	} else {
+		LOG_INFO("failed");
+		return ERROR_TARGET_FAILURE;
+	}
+}
+
+static void binprint(struct command_context *cmd_ctx, const char *text, const uint8_t *buf, int size)
+{
+	if (text != NULL)
+		command_print_sameline(cmd_ctx, "%s", text);
+	for (int i = 0; i < size; i++)
+		command_print_sameline(cmd_ctx, " %02x", buf[i]);
+	command_print(cmd_ctx, " ");
+}
+
+COMMAND_HANDLER(handle_test_mem_access_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	uint32_t test_size;
+	int retval = ERROR_OK;
+
+	if (target->state != TARGET_HALTED) {
+		LOG_INFO("target not halted !!");
+		return ERROR_FAIL;
+	}
+
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], test_size);
+
+	/* Test reads */
+	size_t num_bytes = test_size + 4;
+
+	struct working_area *wa = NULL;
+	retval = target_alloc_working_area(target, num_bytes, &wa);
+	if (retval != ERROR_OK) {
+		LOG_ERROR("Not enough working area");
+		return ERROR_FAIL;
+	}
+
+	uint8_t *test_pattern = malloc(num_bytes);
+
+	for (size_t i = 0; i < num_bytes; i++)
+		test_pattern[i] = rand();
+
+	retval = target_write_memory(target, wa->address, 1, num_bytes, test_pattern);
+	if (retval != ERROR_OK) {
+		LOG_ERROR("Test pattern write failed");
+		goto out;
+	}
+
+	for (int host_offset = 0; host_offset <= 1; host_offset++) {
+		for (int size = 1; size <= 4; size *= 2) {
+			for (int offset = 0; offset < 4; offset++) {
+				uint32_t count = test_size / size;
+				size_t host_bufsiz = (count + 2) * size + host_offset;
+				uint8_t *read_ref = malloc(host_bufsiz);
+				uint8_t *read_buf = malloc(host_bufsiz);
+
+				for (size_t i = 0; i < host_bufsiz; i++) {
+					read_ref[i] = rand();
+					read_buf[i] = read_ref[i];
+				}
+				command_print_sameline(CMD_CTX,
+						"Test read %" PRIu32 " x %d @ %d to %saligned buffer: ", count,
+						size, offset, host_offset ? "un" : "");
+
+				struct duration bench;
+				duration_start(&bench);
+
+				retval = target_read_memory(target, wa->address + offset, size, count,
+						read_buf + size + host_offset);
+
+				duration_measure(&bench);
+
+				if (retval == ERROR_TARGET_UNALIGNED_ACCESS) {
+					command_print(CMD_CTX, "Unsupported alignment");
+					goto next;
+				} else if (retval != ERROR_OK) {
+					command_print(CMD_CTX, "Memory read failed");
+					goto next;
+				}
+
+				/* replay on host */
+				memcpy(read_ref + size + host_offset, test_pattern + offset, count * size);
+
+				/* check result */
+				int result = memcmp(read_ref, read_buf, host_bufsiz);
+				if (result == 0) {
+					command_print(CMD_CTX, "Pass in %fs (%0.3f KiB/s)",
+							duration_elapsed(&bench),
+							duration_kbps(&bench, count * size));
+				} else {
+					command_print(CMD_CTX, "Compare failed");
+					binprint(CMD_CTX, "ref:", read_ref, host_bufsiz);
+					binprint(CMD_CTX, "buf:", read_buf, host_bufsiz);
+				}
+next:
+				free(read_ref);
+				free(read_buf);
+			}
+		}
+	}
+
+out:
+	free(test_pattern);
+
+	if (wa != NULL)
+		target_free_working_area(target, wa);
+
+	/* Test writes */
+	num_bytes = test_size + 4 + 4 + 4;
+
+	retval = target_alloc_working_area(target, num_bytes, &wa);
+	if (retval != ERROR_OK) {
+		LOG_ERROR("Not enough working area");
+		return ERROR_FAIL;
+	}
+
+	test_pattern = malloc(num_bytes);
+
+	for (size_t i = 0; i < num_bytes; i++)
+		test_pattern[i] = rand();
+
+	for (int host_offset = 0; host_offset <= 1; host_offset++) {
+		for (int size = 1; size <= 4; size *= 2) {
+			for (int offset = 0; offset < 4; offset++) {
+				uint32_t count = test_size / size;
+				size_t host_bufsiz = count * size + host_offset;
+				uint8_t *read_ref = malloc(num_bytes);
+				uint8_t *read_buf = malloc(num_bytes);
+				uint8_t *write_buf = malloc(host_bufsiz);
+
+				for (size_t i = 0; i < host_bufsiz; i++)
+					write_buf[i] = rand();
+				command_print_sameline(CMD_CTX,
+						"Test write %" PRIu32 " x %d @ %d from %saligned buffer: ", count,
+						size, offset, host_offset ? "un" : "");
+
+				retval = target_write_memory(target, wa->address, 1, num_bytes, test_pattern);
+				if (retval != ERROR_OK) {
+					command_print(CMD_CTX, "Test pattern write failed");
+					goto nextw;
+				}
+
+				/* replay on host */
+				memcpy(read_ref, test_pattern, num_bytes);
+				memcpy(read_ref + size + offset, write_buf + host_offset, count * size);
+
+				struct duration bench;
+				duration_start(&bench);
+
+				retval = target_write_memory(target, wa->address + size + offset, size, count,
+						write_buf + host_offset);
+
+				duration_measure(&bench);
+
+				if (retval == ERROR_TARGET_UNALIGNED_ACCESS) {
+					command_print(CMD_CTX, "Unsupported alignment");
+					goto nextw;
+				} else if (retval != ERROR_OK) {
+					command_print(CMD_CTX, "Memory write failed");
+					goto nextw;
+				}
+
+				/* read back */
+				retval = target_read_memory(target, wa->address, 1, num_bytes, read_buf);
+				if (retval != ERROR_OK) {
+					command_print(CMD_CTX, "Test pattern write failed");
+					goto nextw;
+				}
+
+				/* check result */
+				int result = memcmp(read_ref, read_buf, num_bytes);
+				if (result == 0) {
+					command_print(CMD_CTX, "Pass in %fs (%0.3f KiB/s)",
+							duration_elapsed(&bench),
+							duration_kbps(&bench, count * size));
+				} else {
+					command_print(CMD_CTX, "Compare failed");
+					binprint(CMD_CTX, "ref:", read_ref, num_bytes);
+					binprint(CMD_CTX, "buf:", read_buf, num_bytes);
+				}
+nextw:
+				free(read_ref);
+				free(read_buf);
+			}
+		}
+	}
+
+	free(test_pattern);
+
+	if (wa != NULL)
+		target_free_working_area(target, wa);
+	return retval;
+}
+
+static const struct command_registration target_exec_command_handlers[] = {
+	{
+		.name = "fast_load_image",
+		.handler = handle_fast_load_image_command,
+		.mode = COMMAND_ANY,
+		.help = "Load image into server memory for later use by "
+			"fast_load; primarily for profiling",
+		.usage = "filename address ['bin'|'ihex'|'elf'|'s19'] "
+			"[min_address [max_length]]",
+	},
+	{
+		.name = "fast_load",
+		.handler = handle_fast_load_command,
+		.mode = COMMAND_EXEC,
+		.help = "loads active fast load image to current target "
+			"- mainly for profiling purposes",
+		.usage = "",
+	},
+	{
+		.name = "profile",
+		.handler = handle_profile_command,
+		.mode = COMMAND_EXEC,
+		.usage = "seconds filename [start end]",
+		.help = "profiling samples the CPU PC",
+	},
+	/** @todo don't register virt2phys() unless target supports it */
+	{
+		.name = "virt2phys",
+		.handler = handle_virt2phys_command,
+		.mode = COMMAND_ANY,
+		.help = "translate a virtual address into a physical address",
+		.usage = "virtual_address",
+	},
+	{
+		.name = "reg",
+		.handler = handle_reg_command,
+		.mode = COMMAND_EXEC,
+		.help = "display (reread from target with \"force\") or set a register; "
+			"with no arguments, displays all registers and their values",
+		.usage = "[(register_number|register_name) [(value|'force')]]",
+	},
+	{
+		.name = "poll",
+		.handler = handle_poll_command,
+		.mode = COMMAND_EXEC,
+		.help = "poll target state; or reconfigure background polling",
+		.usage = "['on'|'off']",
+	},
+	{
+		.name = "wait_halt",
+		.handler = handle_wait_halt_command,
+		.mode = COMMAND_EXEC,
+		.help = "wait up to the specified number of milliseconds "
+			"(default 5000) for a previously requested halt",
+		.usage = "[milliseconds]",
+	},
+	{
+		.name = "await_register",
+		.handler = handle_await_register_command,
+		.mode = COMMAND_EXEC,
+		.help = "poll a 32-bit memory location with adaptive backoff "
+			"until (value & mask) == expected, or until the timeout "
+			"(default 1000 ms) expires",
+		.usage = "address mask expected [milliseconds]",
+	},
+	{
+		.name = "halt",
+		.handler = handle_halt_command,
+		.mode = COMMAND_EXEC,
+		.help = "request target to halt, then wait up to the specified"
+			"number of milliseconds (default 5000) for it to complete",
+		.usage = "[milliseconds]",
+	},
+	{
+		.name = "resume",
+		.handler = handle_resume_command,
+		.mode = COMMAND_EXEC,
+		.help =	"resume target execution from current PC or address",
+		.usage = "[address]",
+	},
+	{
+		.name = "reset",
+		.handler = handle_reset_command,
+		.mode = COMMAND_EXEC,
+		.usage = "[run|halt|init]",
+		.help = "Reset all targets into the specified mode."
+			"Default reset mode is run, if not given.",
+	},
+	{
+		.name = "soft_reset_halt",
+		.handler = handle_soft_reset_halt_command,
+		.mode = COMMAND_EXEC,
+		.usage = "",
+		.help = "halt the target and do a soft reset",
+	},
+	{
+		.name = "step",
+		.handler = handle_step_command,
+		.mode = COMMAND_EXEC,
+		.help =	"step one instruction from current PC or address",
+		.usage = "[address]",
+	},
+	{
+		.name = "mdw",
+		.handler = handle_md_command,
+		.mode = COMMAND_EXEC,
+		.help = "display memory words",
+		.usage = "['phys'] address [count]",
+	},
+	{
+		.name = "mdh",
+		.handler = handle_md_command,
+		.mode = COMMAND_EXEC,
+		.help = "display memory half-words",
+		.usage = "['phys'] address [count]",
+	},
+	{
+		.name = "mdb",
+		.handler = handle_md_command,
+		.mode = COMMAND_EXEC,
+		.help = "display memory bytes",
+		.usage = "['phys'] address [count]",
+	},
+	{
+		.name = "mww",
+		.handler = handle_mw_command,
+		.mode = COMMAND_EXEC,
+		.help = "write memory word",
+		.usage = "['phys'] address value [count]",
+	},
+	{
+		.name = "mwh",
+		.handler = handle_mw_command,
+		.mode = COMMAND_EXEC,
+		.help = "write memory half-word",
+		.usage = "['phys'] address value [count]",
+	},
+	{
+		.name = "mwb",
+		.handler = handle_mw_command,
+		.mode = COMMAND_EXEC,
+		.help = "write memory byte",
+		.usage = "['phys'] address value [count]",
+	},
+	{
+		.name = "bp",
+		.handler = handle_bp_command,
+		.mode = COMMAND_EXEC,
+		.help = "list or set hardware or software breakpoint",
+		.usage = "<address> [<asid>]<length> ['hw'|'hw_ctx']",
+	},
+	{
+		.name = "rbp",
+		.handler = handle_rbp_command,
+		.mode = COMMAND_EXEC,
+		.help = "remove breakpoint",
+		.usage = "address",
+	},
+	{
+		.name = "wp",
+		.handler = handle_wp_command,
+		.mode = COMMAND_EXEC,
+		.help = "list (no params) or create watchpoints",
+		.usage = "[address length [('r'|'w'|'a') value [mask]]]",
+	},
+	{
+		.name = "rwp",
+		.handler = handle_rwp_command,
+		.mode = COMMAND_EXEC,
+		.help = "remove watchpoint",
+		.usage = "address",
+	},
+	{
+		.name = "load_image",
+		.handler = handle_load_image_command,
+		.mode = COMMAND_EXEC,
+		.usage = "filename address ['bin'|'ihex'|'elf'|'s19'] "
+			"[min_address] [max_length]",
+	},
+	{
+		.name = "dump_image",
+		.handler = handle_dump_image_command,
+		.mode = COMMAND_EXEC,
+		.usage = "filename address size",
+	},
+	{
+		.name = "verify_image",
+		.handler = handle_verify_image_command,
+		.mode = COMMAND_EXEC,
+		.usage = "filename [offset [type]]",
+	},
+	{
+		.name = "test_image",
+		.handler = handle_test_image_command,
+		.mode = COMMAND_EXEC,
+		.usage = "filename [offset [type]]",
+	},
+	{
+		.name = "mem2array",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_mem2array,
+		.help = "read 8/16/32 bit memory and return as a TCL array "
+			"for script processing",
+		.usage = "arrayname bitwidth address count",
+	},
+	{
+		.name = "array2mem",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_array2mem,
+		.help = "convert a TCL array to memory locations "
+			"and write the 8/16/32 bit values",
+		.usage = "arrayname bitwidth address count",
+	},
+	{
+		.name = "mem2list",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_mem2list,
+		.help = "read 8/16/32 bit memory and return the values "
+			"as a TCL list, built in one pass for bulk transfers",
+		.usage = "bitwidth address count",
+	},
+	{
+		.name = "list2mem",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_list2mem,
+		.help = "write the 8/16/32 bit values of a TCL list "
+			"to memory locations",
+		.usage = "list bitwidth address",
+	},
+	{
+		.name = "reset_nag",
+		.handler = handle_target_reset_nag,
+		.mode = COMMAND_ANY,
+		.help = "Nag after each reset about options that could have been "
+				"enabled to improve performance. ",
+		.usage = "['enable'|'disable']",
+	},
+	{
+		.name = "ps",
+		.handler = handle_ps_command,
+		.mode = COMMAND_EXEC,
+		.help = "list all tasks ",
+		.usage = " ",
+	},
+	{
+		.name = "test_mem_access",
+		.handler = handle_test_mem_access_command,
+		.mode = COMMAND_EXEC,
+		.help = "Test the target's memory access functions",
+		.usage = "size",
+	},
+
+	COMMAND_REGISTRATION_DONE
+};
+static int target_register_user_commands(struct command_context *cmd_ctx)
+{
+	int retval = ERROR_OK;
+	retval = target_request_register_commands(cmd_ctx);
+	if (retval != ERROR_OK)
+		return retval;
+
+	retval = trace_register_commands(cmd_ctx);
+	if (retval != ERROR_OK)
+		return retval;
+
+
+	return register_commands(cmd_ctx, NULL, target_exec_command_handlers);
+}
@@ -198,6 +198,31 @@ static int xsvf_read_buffer(int num_bits, int fd, uint8_t *buf)
 	return ERROR_OK;
 }
 
+/* Mismatch count of XSDR/XSDRTDO scans whose compare was deferred; the
+ * completion below runs when the queue carrying the scan is flushed. */
+static int xsvf_deferred_mismatch;
+
+struct xsvf_deferred_check {
+	uint8_t *captured;
+	uint8_t *expected;
+	uint8_t *mask;
+	int bit_len;
+};
+
+static void xsvf_deferred_check_done(int retval, void *priv)
+{
+	struct xsvf_deferred_check *check = priv;
+
+	if (retval != ERROR_OK || buf_cmp_mask(check->captured,
+			check->expected, check->mask, check->bit_len))
+		xsvf_deferred_mismatch++;
+
+	free(check->captured);
+	free(check->expected);
+	free(check->mask);
+	free(check);
+}
+
 COMMAND_HANDLER(handle_xsvf_command)
 {
 	uint8_t *dr_out_buf = NULL;				/* from host to device (TDI) */
@@ -276,6 +301,8 @@ COMMAND_HANDLER(handle_xsvf_command)
 	LOG_WARNING("XSVF support in OpenOCD is limited. Consider using SVF instead");
 	LOG_USER("xsvf processing file: \"%s\"", filename);
 
+	xsvf_deferred_mismatch = 0;
+
 	while (read(xsvf_fd, &opcode, 1) > 0) {
 		/* record the position of this opcode within the file */
 		file_offset = lseek(xsvf_fd, 0, SEEK_CUR) - 1;
@@ -453,7 +480,68 @@ COMMAND_HANDLER(handle_xsvf_command)
 
 				LOG_DEBUG("%s %d", op_name, xsdrsize);
 
-				for (attempt = 0; attempt < limit; ++attempt) {
+				/* report scans that failed a deferred compare close
+				 * to where they were queued */
+				if (xsvf_deferred_mismatch) {
+					LOG_USER("%s mismatch (deferred)", op_name);
+					tdo_mismatch = 1;
+					break;
+				}
+
+				/* With no retries allowed, the flush per scan only
+				 * served to evaluate the retry condition.  Queue the
+				 * scan with a deferred compare instead and let the
+				 * core coalesce many scans per adapter round trip;
+				 * the per-attempt path below handles actual retries. */
+				if (limit == 1) {
+					struct xsvf_deferred_check *check;
+					struct scan_field field;
+					int byte_len = (xsdrsize + 7) / 8;
+
+					check = malloc(sizeof(*check));
+					if (check == NULL) {
+						do_abort = 1;
+						break;
+					}
+					check->captured = calloc(byte_len, 1);
+					check->expected = malloc(byte_len);
+					check->mask = malloc(byte_len);
+					check->bit_len = xsdrsize;
+					if (check->captured == NULL || check->expected == NULL
+							|| check->mask == NULL) {
+						free(check->captured);
+						free(check->expected);
+						free(check->mask);
+						free(check);
+						do_abort = 1;
+						break;
+					}
+					memcpy(check->expected, dr_in_buf, byte_len);
+					memcpy(check->mask, dr_in_mask, byte_len);
+
+					field.num_bits = xsdrsize;
+					field.out_value = dr_out_buf;
+					field.in_value = check->captured;
+
+					if (tap == NULL)
+						jtag_add_plain_dr_scan(field.num_bits,
+								field.out_value,
+								field.in_value,
+								TAP_DRPAUSE);
+					else
+						jtag_add_dr_scan(tap, 1, &field, TAP_DRPAUSE);
+
+					result = jtag_execute_queue_async(
+							xsvf_deferred_check_done, check);
+					if (result != ERROR_OK) {
+						do_abort = 1;
+						break;
+					}
+
+					matched = 1;
+				}
+
+				for (attempt = 0; !matched && attempt < limit; ++attempt) {
 					struct scan_field field;
 
 					if (attempt > 0) {
@@ -1006,6 +1094,20 @@ COMMAND_HANDLER(handle_xsvf_command)
 		}
 	}
 
+	/* join the queue so all deferred scan compares have run */
+	result = jtag_execute_queue();
+	if (result != ERROR_OK && !tdo_mismatch && !unsupported && !do_abort) {
+		command_print(CMD_CTX, "jtag queue execution failed, aborting");
+		return ERROR_FAIL;
+	}
+
+	if (xsvf_deferred_mismatch && !tdo_mismatch) {
+		command_print(CMD_CTX,
+			"TDO mismatch in %d deferred scan(s), aborting",
+			xsvf_deferred_mismatch);
+		return ERROR_FAIL;
+	}
+
 	if (tdo_mismatch) {
 		command_print(CMD_CTX,
 			"TDO mismatch, somewhere near offset %lu in xsvf file, aborting",
@@ -0,0 +1,44 @@
+#!/bin/sh
+# Generate an SVF benchmark corpus on stdout.
+#
+# usage: gen_svf.sh <short|long|check> <count>
+#
+#   short - <count> pairs of small SIR/SDR commands; stresses per-command
+#           parse and queue overhead
+#   long  - <count> SDR commands of 64 Kbit each; stresses hex conversion
+#           and buffer management
+#   check - <count> 32 bit SDR commands with TDO/MASK checks; stresses
+#           the check bookkeeping.  TDI equals TDO so the checks also
+#           pass in "svf nil" mode, which never fills capture buffers.
+
+if [ $# -ne 2 ]; then
+	echo "usage: $0 <short|long|check> <count>" >&2
+	exit 1
+fi
+
+awk -v type="$1" -v count="$2" 'BEGIN {
+	print "TRST OFF;";
+	print "ENDIR IDLE;";
+	print "ENDDR IDLE;";
+	print "STATE RESET;";
+	print "STATE IDLE;";
+	if (type == "short") {
+		for (i = 0; i < count; i++) {
+			print "SIR 8 TDI (a5);";
+			print "SDR 16 TDI (0f0f);";
+		}
+	} else if (type == "long") {
+		s = "";
+		for (i = 0; i < 2048; i++)
+			s = s "deadbeef";
+		for (i = 0; i < count; i++)
+			print "SDR 65536 TDI (" s ");";
+	} else if (type == "check") {
+		for (i = 0; i < count; i++)
+			print "SDR 32 TDI (89abcdef) TDO (89abcdef) MASK (ffffffff);";
+	} else {
+		print "unknown corpus type" > "/dev/stderr";
+		exit 1;
+	}
+	print "STATE IDLE;";
+}'
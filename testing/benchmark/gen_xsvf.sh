@@ -0,0 +1,32 @@
+#!/bin/sh
+# Generate an XSVF benchmark corpus on stdout.
+#
+# usage: gen_xsvf.sh <count>
+#
+# Emits <count> XSIR/XSDRTDO pairs.  XTDOMASK is all zeroes so no TDO
+# bit is actually compared; the replay is deterministic regardless of
+# what the adapter shifts back.
+
+if [ $# -ne 1 ]; then
+	echo "usage: $0 <count>" >&2
+	exit 1
+fi
+
+# XSDRSIZE 32
+printf '\010\000\000\000\040'
+# XTDOMASK 0x00000000
+printf '\001\000\000\000\000'
+# XREPEAT 0
+printf '\007\000'
+
+i=0
+while [ "$i" -lt "$1" ]; do
+	# XSIR, 8 bits, 0xA5
+	printf '\002\010\245'
+	# XSDRTDO, TDI 0x89ABCDEF, TDO 0x00000000 (masked off)
+	printf '\011\211\253\315\357\000\000\000\000'
+	i=$((i + 1))
+done
+
+# XCOMPLETE
+printf '\000'
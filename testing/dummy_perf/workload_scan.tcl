@@ -0,0 +1,7 @@
+# Worst-case batching workload: 2000 individual 32 bit DR scans, each
+# one forcing a queue flush because the result is consumed immediately.
+# This bounds the per-flush ceiling; batched code paths must come in
+# far below it.
+for {set i 0} {$i < 2000} {incr i} {
+	drscan perf.tap 32 0x12345678
+}